@@ -1,23 +1,98 @@
 #include "Application.h"
+#include "GLStateCache.h"
+#include <algorithm>
+#include <chrono>
 
 Config Application::m_Config = {};
+AppSettings Application::m_Settings = {};
 Scene Application::m_Scene = {};
 InputHandler Application::m_InputHandler = {};
 int Application::m_TargetTickrate = 0; 
 int Application::m_LastTickTime = 0;
 glm::vec2 Application::m_WindowSize = { 800, 600 };
+bool Application::m_BenchmarkMode = false;
+GLuint Application::m_BenchmarkFramebuffer = 0;
+Benchmark Application::m_Benchmark = {};
+bool Application::m_MicroBenchmarkMode = false;
+std::string Application::m_MicroBenchmarkFilter = {};
+std::string Application::m_CompileSceneInput = {};
+std::string Application::m_CompileSceneOutput = {};
+GLsync Application::m_LatencyFence = nullptr;
+FrameLimiter Application::m_FrameLimiter = {};
+int Application::m_IdleTimeout = 0;
+int Application::m_LastInputTime = 0;
+FrameCapture Application::m_FrameCapture = {};
+std::string Application::m_RecordInputPath = {};
+std::string Application::m_ReplayInputPath = {};
+InputLog Application::m_InputLog = {};
+uint32_t Application::m_Tick = 0;
+uint64_t Application::m_LatencyInputTimestamp = 0;
 
 
 
 
 bool Application::Init(int argc, char** argv)
 {
+	std::string ConfigFilename = DEFAULT_CONFIG_NAME;
+	std::vector<std::string> SettingOverrides;
+	for (int i = 1; i < argc; i++)
+	{
+		if (std::string(argv[i]) == BENCHMARK_ARGUMENT)
+			m_BenchmarkMode = true;
+		else if (std::string(argv[i]) == MICROBENCHMARK_ARGUMENT)
+		{
+			m_MicroBenchmarkMode = true;
+			if (i + 1 < argc && argv[i + 1][0] != '-')
+				m_MicroBenchmarkFilter = argv[++i];
+		}
+		else if (std::string(argv[i]) == COMPILE_SCENE_ARGUMENT)
+		{
+			if (i + 2 >= argc)
+			{
+				std::cerr << "Application::Init() => " << COMPILE_SCENE_ARGUMENT << " expects <text scene> <binary scene>" << std::endl;
+				return false;
+			}
+			m_CompileSceneInput = argv[++i];
+			m_CompileSceneOutput = argv[++i];
+		}
+		else if (std::string(argv[i]) == RECORD_INPUT_ARGUMENT || std::string(argv[i]) == REPLAY_INPUT_ARGUMENT)
+		{
+			if (i + 1 >= argc)
+			{
+				std::cerr << "Application::Init() => " << argv[i] << " expects <input log>" << std::endl;
+				return false;
+			}
+			(std::string(argv[i]) == RECORD_INPUT_ARGUMENT ? m_RecordInputPath : m_ReplayInputPath) = argv[i + 1];
+			i++;
+		}
+		else if (std::string(argv[i]) == CONFIG_ARGUMENT || std::string(argv[i]) == SET_ARGUMENT)
+		{
+			if (i + 1 >= argc)
+			{
+				std::cerr << "Application::Init() => " << argv[i] << " expects " << (std::string(argv[i]) == CONFIG_ARGUMENT ? "<config file>" : "NAME=VALUE") << std::endl;
+				return false;
+			}
+			if (std::string(argv[i]) == CONFIG_ARGUMENT)
+				ConfigFilename = argv[++i];
+			else
+				SettingOverrides.push_back(argv[++i]);
+		}
+	}
+	if (!m_ReplayInputPath.empty())
+		m_BenchmarkMode = true; // a replay renders offscreen and reports like the benchmark
+	if (m_MicroBenchmarkMode || !m_CompileSceneInput.empty())
+		return true; // micro benchmarks and scene compilation run on the CPU only, no config, window or GL context is needed
 
-	if (!m_Config.LoadConfigFromFile(DEFAULT_CONFIG_NAME)) // TODO: check for argv
+	if (!m_Config.LoadConfigFromFile(ConfigFilename))
 	{
 		std::cerr << "Application::Init() => Error loading config" << std::endl;
 		return false;
 	}
+	if (!Settings::Resolve(m_Config, SettingOverrides, m_Settings))
+	{
+		std::cerr << "Application::Init() => Error resolving settings" << std::endl;
+		return false;
+	}
 
 
 	if (!Application::InitGlut(argc, argv))
@@ -37,21 +112,41 @@ bool Application::Init(int argc, char** argv)
 		std::cerr << "Application::Init() => Error initializing pgr framework" << std::endl;
 		return false; 
 	}
-	glEnable(GL_DEPTH_TEST);
-	glClearStencil(0);
-	std::string SceneFilename; 
-	if (!m_Config.GetVariableAsString("SCENE_FILENAME", SceneFilename))
+	if (m_BenchmarkMode && !InitBenchmarkFramebuffer())
 	{
-		std::cerr << "Application::Init() => Error getting SCENE_FILENAME config variable" << std::endl;
+		std::cerr << "Application::Init() => Error creating benchmark framebuffer" << std::endl;
 		return false;
 	}
-		
+	GLStateCache::Invalidate(); // the context was just created, nothing went through the cache yet
+	GLStateCache::SetEnabled(GL_DEPTH_TEST, true);
+	glClearStencil(0);
+	StreamingSettings Streaming;
+	Streaming.CellSize = (float)m_Settings.StreamingCellSize;
+	Streaming.LoadRadius = (float)m_Settings.StreamingLoadRadius;
+	Streaming.UnloadRadius = (float)m_Settings.StreamingUnloadRadius;
+	Streaming.MemoryBudget = (size_t)m_Settings.StreamingMemoryBudgetMb * 1024 * 1024;
+	Streaming.LookAheadTime = m_Settings.StreamingLookAheadMs * 0.001f;
+	Streaming.UploadsPerFrame = m_Settings.StreamingUploadsPerFrame;
+	Streaming.Synchronous = m_BenchmarkMode || !m_RecordInputPath.empty(); // benchmark frames and recorded ticks must not depend on the loader thread timing
+	m_Scene.SetStreamingSettings(Streaming);
+	m_Scene.SetOcclusionCullingEnabled(m_Settings.OcclusionCulling);
+	m_Scene.SetDepthPrepassEnabled(m_Settings.DepthPrepass);
+	DynamicResolutionSettings Resolution;
+	Resolution.Enabled = m_Settings.DynamicResolution;
+	Resolution.TargetGpuMs = m_Settings.DynamicResolutionTargetMs;
+	Resolution.MinScale = m_Settings.DynamicResolutionMinScalePercent * 0.01f;
+	m_Scene.SetDynamicResolution(Resolution);
+	m_Scene.SetCameraControls(m_Settings.CameraSpeed, m_Settings.MouseSensitivity);
 
-	if (!m_Scene.LoadSceneFromFile(SceneFilename))
+	auto LoadStart = std::chrono::steady_clock::now();
+	if (!m_Scene.LoadSceneFromFile(m_Settings.SceneFilename))
 	{
 		std::cerr << "Application::Init() => Error loading scene" << std::endl;
 		return false;
 	}
+	std::chrono::duration<double, std::milli> LoadTime = std::chrono::steady_clock::now() - LoadStart;
+	m_Benchmark.SetLoadTime(LoadTime.count());
+	std::cout << "Scene loaded in " << LoadTime.count() << " ms" << std::endl;
 	m_Scene.SetCamerasAspectRation(m_WindowSize.x / m_WindowSize.y);
 	return true; 
 }
@@ -66,21 +161,18 @@ bool Application::InitGlut(int argc, char** argv)
 	glutInitDisplayMode(GLUT_RGB | GLUT_DOUBLE | GLUT_DEPTH | GLUT_STENCIL);
 
 	//   initial window size + title
-	int window_width, window_height;
-	std::string window_title; 
-	if (!m_Config.GetVariableAsInt("WINDOW_WIDTH", window_width)
-		|| !m_Config.GetVariableAsInt("WINDOW_HEIGHT", window_height)
-		|| !m_Config.GetVariableAsString("WINDOW_TITLE", window_title)
-		)
-	{
-		std::cerr << "Application::InitGlut() => Can't get config window variables" << std::endl; 
-		return false;
-	}
-	m_WindowSize = { window_width, window_height };
+	m_WindowSize = { m_Settings.WindowWidth, m_Settings.WindowHeight };
 
-	glutInitWindowSize(window_width, window_height);
-	glutCreateWindow(window_title.c_str());
+	glutInitWindowSize(m_Settings.WindowWidth, m_Settings.WindowHeight);
+	glutCreateWindow(m_Settings.WindowTitle.c_str());
+	if (m_BenchmarkMode)
+	{
+		// the benchmark renders to an offscreen framebuffer, the window only owns the context
+		glutHideWindow();
+		return true;
+	}
 	glutDisplayFunc(&Application::DisplayCallback); 
+	glutReshapeFunc(&Application::ReshapeCallback);
 
 	// Inputs 
 	glutKeyboardFunc( &InputHandler::KeyboardPressed );
@@ -88,6 +180,8 @@ bool Application::InitGlut(int argc, char** argv)
 	glutSpecialFunc(&InputHandler::SpecialKeyboardPressed); 
 	glutSpecialUpFunc(&InputHandler::SpecialKeyboardReleased);
 	glutPassiveMotionFunc(&InputHandler::MouseMotion);
+	glutMotionFunc(&InputHandler::MouseMotion);
+	glutIgnoreKeyRepeat(1);
 	glutMouseFunc(&InputHandler::MouseFunc);
 
 	glutCloseFunc(&Application::Exit);
@@ -97,72 +191,124 @@ bool Application::InitGlut(int argc, char** argv)
 
 void Application::HandleInput( float dt )
 {
-	if (m_InputHandler.GetIsKeyPressed('w'))
-		m_Scene.ProcessInputAction(InputAction::MoveForward, dt);
-
-	if (m_InputHandler.GetIsKeyPressed('s'))
-		m_Scene.ProcessInputAction(InputAction::MoveBackward, dt); 
-	
-	if (m_InputHandler.GetIsKeyPressed('a'))
-		m_Scene.ProcessInputAction(InputAction::MoveLeft, dt); 
-
-	if (m_InputHandler.GetIsKeyPressed('d'))
-		m_Scene.ProcessInputAction(InputAction::MoveRight, dt);
-
-	if (m_InputHandler.GetIsKeyPressed('c')) {
-		m_InputHandler.ForceKeyDown('c');
-		m_Scene.ToggleSpotlight();
-	}
-	if (m_InputHandler.GetIsKeyPressed('v')) {
-		m_InputHandler.ForceKeyDown('v');
-		m_Scene.TogglePointLights();
-	}
-	if ( m_InputHandler . GetIsKeyChordPressed ( { 'b' }, { GLUT_KEY_ALT_L } ) )
+	const std::pair<unsigned char, InputAction> MoveKeys[] = { { 'w', MoveForward }, { 's', MoveBackward }, { 'a', MoveLeft }, { 'd', MoveRight } };
+	for (const auto& Key : MoveKeys)
 	{
-		m_InputHandler.ForceKeyDown('b'); 
-		m_InputHandler.ForceSpecKeyDown(GLUT_KEY_ALT_L);
-		m_Scene.ToggleCameraMovement(); 
-	}
-	if (m_InputHandler.GetIsKeyPressed('1')) {
-		m_InputHandler.ForceKeyDown('1');
-		m_Scene.m_ActiveCameraIndex = 0;
-	}
-	else if (m_InputHandler.GetIsKeyPressed('2')) {
-		m_InputHandler.ForceKeyDown('2');
-		m_Scene.m_ActiveCameraIndex = 1;
-	}
-	else if (m_InputHandler.GetIsKeyPressed('3')) {
-		m_InputHandler.ForceKeyDown('3');
-		m_Scene.m_ActiveCameraIndex = 2;
+		if (m_InputHandler.GetIsKeyPressed(Key.first))
+			ApplyInputRecord({ InputRecordType::Action, (uint8_t)Key.second }, dt);
 	}
-	else if (m_InputHandler.GetIsKeyPressed('4')) {
-		m_InputHandler.ForceKeyDown('4');
-		m_Scene.m_ActiveCameraIndex = 3;
+
+	if (m_InputHandler.ConsumeKeyPress('c'))
+		ApplyInputRecord({ InputRecordType::ToggleSpotlight }, dt);
+	if (m_InputHandler.ConsumeKeyPress('v'))
+		ApplyInputRecord({ InputRecordType::TogglePointLights }, dt);
+	if ( m_InputHandler . ConsumeKeyChordPress ( { 'b' }, { GLUT_KEY_ALT_L } ) )
+		ApplyInputRecord({ InputRecordType::ToggleCameraMovement }, dt);
+	const unsigned char CameraKeys[] = { '1', '2', '3', '4' };
+	for (int i = 0; i < 4; i++)
+	{
+		if (m_InputHandler.ConsumeKeyPress(CameraKeys[i]))
+			ApplyInputRecord({ InputRecordType::SelectCamera, (uint8_t)i }, dt);
 	}
 
-	if (m_InputHandler.GetIsMousePressed(GLUT_LEFT_BUTTON))
+	if (m_InputHandler.ConsumeMousePress(GLUT_LEFT_BUTTON))
 	{
-		m_InputHandler.ForceMouseDown(GLUT_LEFT_BUTTON); 
-		m_Scene.ProcessInputAction(InputAction::Fire, dt); 
+		ApplyInputRecord({ InputRecordType::Action, (uint8_t)InputAction::Fire }, dt);
 		auto LMCPosition = m_InputHandler.GetLastLMCPosition();
-		m_Scene.ProcessMouseClick( { LMCPosition.x, m_WindowSize.y -  LMCPosition.y }, dt);
+		// the picked object is recorded rather than the position, so a replay does not depend on the rendered stencil
+		ApplyInputRecord({ InputRecordType::Click, m_Scene.PickObject({ LMCPosition.x, m_WindowSize.y - LMCPosition.y }) }, dt);
 	}
+}
+
+void Application::ApplyInputRecord(const InputRecord& Record, float dt)
+{
+	m_InputLog.Write(Record);
+	switch (Record.Type)
+	{
+	case InputRecordType::Action:
+		m_Scene.ProcessInputAction((InputAction)Record.Value, dt);
+		break;
+	case InputRecordType::ToggleSpotlight:
+		m_Scene.ToggleSpotlight();
+		break;
+	case InputRecordType::TogglePointLights:
+		m_Scene.TogglePointLights();
+		break;
+	case InputRecordType::ToggleCameraMovement:
+		m_Scene.ToggleCameraMovement();
+		break;
+	case InputRecordType::SelectCamera:
+		m_Scene.m_ActiveCameraIndex = Record.Value;
+		break;
+	case InputRecordType::Click:
+		m_Scene.ProcessObjectClick(Record.Value, dt);
+		break;
+	case InputRecordType::MouseMove:
+		m_Scene.ProcessMouseMovement(Record.MouseDelta, dt);
+		break;
+	default:
+		break;
+	}
+}
+
+void Application::ApplyMouseLook()
+{
+	m_InputHandler.ProcessEvents();
+	// the look used to scale the per-tick offset by the tick time, the fixed tick keeps the sensitivity of the config
+	InputRecord Look = { InputRecordType::MouseMove };
+	Look.MouseDelta = m_InputHandler.ConsumeMouseDelta();
+	if (Look.MouseDelta.x != 0.f || Look.MouseDelta.y != 0.f)
+		ApplyInputRecord(Look, m_TargetTickrate * 0.001f);
+	m_InputHandler.RecenterPointer();
+}
 
-	m_Scene.ProcessMouseMovement(m_InputHandler.GetMouseOffset(), dt);
-	glutWarpPointer((int)m_WindowSize.x / 2, (int)m_WindowSize.y / 2);
+void Application::PollLatencyFence()
+{
+	if (!m_LatencyFence)
+		return;
+	const GLenum Status = glClientWaitSync(m_LatencyFence, 0, 0);
+	if (Status != GL_ALREADY_SIGNALED && Status != GL_CONDITION_SATISFIED)
+		return;
+	m_InputHandler.AddLatencySample((InputHandler::GetTimestamp() - m_LatencyInputTimestamp) * 0.001);
+	glDeleteSync(m_LatencyFence);
+	m_LatencyFence = nullptr;
 }
 
 bool Application::StartMainLoop()
 {
-	int TargetTickRate; 
-	if ( !m_Config.GetVariableAsInt("TARGET_TICKRATE", TargetTickRate) )
+	if (m_MicroBenchmarkMode)
+		return MicroBenchmark::RunAll(m_MicroBenchmarkFilter);
+	if (!m_CompileSceneInput.empty())
+		return BinarySceneFile::Compile(m_CompileSceneInput, m_CompileSceneOutput);
+	if (m_BenchmarkMode)
+		return m_ReplayInputPath.empty() ? RunBenchmark() : RunReplay();
+
+	const int TargetTickRate = m_Settings.TargetTickrate;
+	Application::m_TargetTickrate = TargetTickRate; 
+	m_FrameLimiter.SetMaxFps(m_Settings.MaxFps);
+	m_IdleTimeout = m_Settings.IdleTimeoutMs;
+	m_LastInputTime = glutGet(GLUT_ELAPSED_TIME);
+
+	CaptureFormat Capture = CaptureFormat::None;
+	if (!FrameCapture::ParseFormat(m_Settings.CaptureFormat, Capture))
+		std::cerr << "Application::StartMainLoop() => Unknown CAPTURE_FORMAT " << m_Settings.CaptureFormat << ", expected png or y4m" << std::endl;
+	if (Capture != CaptureFormat::None)
 	{
-		std::cerr << "Application::StartMainLoop() => Can't get config target tickrate" << std::endl;
-		return false;
+		// a captured frame is rendered every tick, unless the frame limiter is slower
+		int CaptureFps = 1000 / std::max(TargetTickRate, 1);
+		if (m_FrameLimiter.GetMaxFps() > 0)
+			CaptureFps = std::min(CaptureFps, m_FrameLimiter.GetMaxFps());
+		m_FrameCapture.Start(m_Settings.CapturePath, Capture, (int)m_WindowSize.x, (int)m_WindowSize.y, CaptureFps);
+		m_IdleTimeout = 0;
+	}
+	if (!m_RecordInputPath.empty())
+	{
+		if (!m_InputLog.OpenForRecording(m_RecordInputPath, TargetTickRate * 0.001f))
+			return false;
+		m_IdleTimeout = 0; // the recorded ticks must be continuous
 	}
-	Application::m_TargetTickrate = TargetTickRate; 
 	std::cout << "Starting glut main loop" << std::endl; 
-	glutWarpPointer((int)m_WindowSize.x / 2, (int)m_WindowSize.y / 2);
+	InputHandler::RecenterPointer();
 	glutTimerFunc(TargetTickRate, &Application::Update, 0);
 	glutMainLoop(); 
 	return true;
@@ -170,31 +316,185 @@ bool Application::StartMainLoop()
 
 void Application::Update( int Value )
 {
-	float dt = (glutGet(GLUT_ELAPSED_TIME) - m_LastTickTime) * 0.001f; 
-	if (dt < 0.1)
+	const int Now = glutGet(GLUT_ELAPSED_TIME);
+	// a recording runs with the fixed tick, so the replay reproduces it exactly
+	float dt = m_InputLog.GetIsRecording() ? m_TargetTickrate * 0.001f : (Now - m_LastTickTime) * 0.001f; 
+	PollLatencyFence();
+	m_InputHandler.ProcessEvents();
+	// the recording needs a frame every tick, so it plays back at a constant rate
+	if (m_InputHandler.ConsumeActivity() || m_FrameCapture.GetIsCapturing())
+	{
+		m_LastInputTime = Now;
+		m_Scene.Invalidate();
+	}
+	// without input for the idle timeout the simulation pauses, so nothing changes and no frames are rendered
+	const bool IsIdle = m_IdleTimeout > 0 && Now - m_LastInputTime >= m_IdleTimeout;
+	if (dt < 0.1 && !IsIdle)
 	{
 		Application::HandleInput(dt);
 		m_Scene.Update(dt);
+		if (m_InputLog.GetIsRecording())
+		{
+			InputRecord EndTick;
+			EndTick.Tick = m_Tick++;
+			EndTick.StateHash = m_Scene.GetStateHash();
+			m_InputLog.Write(EndTick);
+		}
 	}
 	
 
 
 	// and plan a new even
-	glutTimerFunc(Application::m_TargetTickrate, &Application::Update, 0);
+	glutTimerFunc(IsIdle ? IDLE_TICK_MS : Application::m_TargetTickrate, &Application::Update, 0);
 
-	// create display event
-	glutPostRedisplay();
+	// create display event only when something on screen changed
+	if (!IsIdle && m_Scene.ConsumeRedraw())
+		glutPostRedisplay();
 	m_LastTickTime = glutGet(GLUT_ELAPSED_TIME);
 }
 
 void Application::DisplayCallback()
 {
+	// the wait comes before the input is sampled, so the frame shows the newest input
+	m_FrameLimiter.WaitForNextFrame();
+	PollLatencyFence();
+	// the camera rotation is applied right before rendering, so mouse motion since the last tick is not a tick late
+	ApplyMouseLook();
+	const uint64_t InputTimestamp = m_InputHandler.TakeFrameInputTimestamp();
 	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT | GL_STENCIL_BUFFER_BIT );
 	m_Scene.Render(); 
+	m_FrameCapture.CaptureFrame();
 	glutSwapBuffers();
+	// the fence signals when the GPU finished the frame, one frame is measured at a time
+	if (InputTimestamp && !m_LatencyFence)
+	{
+		m_LatencyFence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+		m_LatencyInputTimestamp = InputTimestamp;
+	}
 }
 
-void Application::Exit()
+void Application::ReshapeCallback(int Width, int Height)
+{
+	glViewport(0, 0, Width, Height);
+	m_FrameCapture.HandleResize(Width, Height);
+}
+
+bool Application::InitBenchmarkFramebuffer()
+{
+	GLuint ColorBuffer, DepthStencilBuffer;
+	glGenFramebuffers(1, &m_BenchmarkFramebuffer);
+	glGenRenderbuffers(1, &ColorBuffer);
+	glGenRenderbuffers(1, &DepthStencilBuffer);
+
+	glBindRenderbuffer(GL_RENDERBUFFER, ColorBuffer);
+	glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, (GLsizei)m_WindowSize.x, (GLsizei)m_WindowSize.y);
+	glBindRenderbuffer(GL_RENDERBUFFER, DepthStencilBuffer);
+	glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH24_STENCIL8, (GLsizei)m_WindowSize.x, (GLsizei)m_WindowSize.y);
+	glBindRenderbuffer(GL_RENDERBUFFER, 0);
+
+	glBindFramebuffer(GL_FRAMEBUFFER, m_BenchmarkFramebuffer);
+	glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, ColorBuffer);
+	glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER, DepthStencilBuffer);
+	if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+	{
+		std::cerr << "Application::InitBenchmarkFramebuffer() => Framebuffer is not complete" << std::endl;
+		return false;
+	}
+	glViewport(0, 0, (GLsizei)m_WindowSize.x, (GLsizei)m_WindowSize.y);
+	CHECK_GL_ERROR();
+	return true;
+}
+
+bool Application::RunBenchmark()
+{
+	const int Frames = m_Settings.BenchmarkFrames;
+	const int WarmupFrames = m_Settings.BenchmarkWarmupFrames;
+	const float dt = m_Settings.BenchmarkDtMs * 0.001f;
+	const std::string& CameraPath = m_Settings.BenchmarkCameraPath;
+	const std::string& Output = m_Settings.BenchmarkOutput;
+
+	if (!m_Benchmark.LoadCameraPath(CameraPath))
+	{
+		std::cerr << "Application::RunBenchmark() => Can't load benchmark camera path" << std::endl;
+		return false;
+	}
+	m_Benchmark.SetRunInfo(m_Settings.SceneFilename, dt);
+
+	m_Scene.m_ActiveCameraIndex = 0;
+	auto Camera = m_Scene.GetActiveCamera().lock();
+	if (!Camera)
+	{
+		std::cerr << "Application::RunBenchmark() => Scene has no camera to drive" << std::endl;
+		return false;
+	}
+
+	std::cout << "Running benchmark: " << Frames << " frames, dt " << dt * 1000.f << " ms" << std::endl;
+	for (int Frame = 0; Frame < WarmupFrames + Frames; Frame++)
+	{
+		CameraPathKey Key = m_Benchmark.EvaluateCameraPath(Frame * dt);
+		Camera->SetWorldLocation(Key.Location);
+		Camera->SetOrientation(Key.Pitch, Key.Yaw);
+
+		auto FrameStart = std::chrono::steady_clock::now();
+		MeshGeometry::ResetRenderStats();
+		m_Scene.Update(dt);
+		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT | GL_STENCIL_BUFFER_BIT);
+		m_Scene.Render();
+		glFinish(); // wait for the GPU so the frame time covers the whole frame
+		std::chrono::duration<double, std::milli> FrameTime = std::chrono::steady_clock::now() - FrameStart;
+
+		if (Frame >= WarmupFrames)
+			m_Benchmark.AddFrame(FrameTime.count(), MeshGeometry::GetRenderStats());
+	}
+	CHECK_GL_ERROR();
+
+	return m_Benchmark.WriteReport(Output);
+}
+
+bool Application::RunReplay()
 {
+	if (!m_InputLog.LoadForReplay(m_ReplayInputPath))
+		return false;
+	const float dt = m_InputLog.GetTickTime();
+	m_Benchmark.SetRunInfo(m_Settings.SceneFilename, dt);
+	m_Scene.m_ActiveCameraIndex = 0;
+
+	std::cout << "Replaying " << m_ReplayInputPath << ", dt " << dt * 1000.f << " ms" << std::endl;
+	uint32_t Tick = 0;
+	bool HasDiverged = false;
+	InputRecord Record;
+	while (m_InputLog.Read(Record))
+	{
+		// the records of a tick are applied as they come, its EndTick runs the tick
+		if (Record.Type != InputRecordType::EndTick)
+		{
+			ApplyInputRecord(Record, dt);
+			continue;
+		}
 
+		auto FrameStart = std::chrono::steady_clock::now();
+		MeshGeometry::ResetRenderStats();
+		m_Scene.Update(dt);
+		if (!HasDiverged && (Record.Tick != Tick || Record.StateHash != m_Scene.GetStateHash()))
+		{
+			std::cerr << "Application::RunReplay() => State diverged from the recording at tick " << Tick << std::endl;
+			HasDiverged = true;
+		}
+		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT | GL_STENCIL_BUFFER_BIT);
+		m_Scene.Render();
+		glFinish(); // wait for the GPU so the frame time covers the whole frame
+		std::chrono::duration<double, std::milli> FrameTime = std::chrono::steady_clock::now() - FrameStart;
+		m_Benchmark.AddFrame(FrameTime.count(), MeshGeometry::GetRenderStats());
+		Tick++;
+	}
+	CHECK_GL_ERROR();
+	std::cout << "Replayed " << Tick << " ticks" << (HasDiverged ? ", the state diverged" : ", the state matched the recording") << std::endl;
+
+	return m_Benchmark.WriteReport(m_Settings.ReplayOutput) && !HasDiverged && Tick > 0;
+}
+
+void Application::Exit()
+{
+	m_FrameCapture.Stop();
+	m_InputLog.Close();
 }
\ No newline at end of file
@@ -2,12 +2,33 @@
 #include "InputHandler.h"
 #include "Scene.h" 
 #include "Config.h"
+#include "Settings.h"
+#include "Benchmark.h"
+#include "MicroBenchmark.h"
+#include "FrameLimiter.h"
+#include "FrameCapture.h"
+#include "InputLog.h"
 #include <exception>
 #include <iostream>
 #include "Misc.h"
 #include "pgr.h"
 
-#define DEFAULT_CONFIG_NAME "config.txt" // TODO: move to argc argv
+#define DEFAULT_CONFIG_NAME "config.txt"
+#define CONFIG_ARGUMENT "--config" // followed by the config file to load instead of DEFAULT_CONFIG_NAME
+#define SET_ARGUMENT "--set" // followed by NAME=VALUE overriding a setting, may be repeated
+#define BENCHMARK_ARGUMENT "--benchmark"
+#define MICROBENCHMARK_ARGUMENT "--microbench" // optional next argument filters benchmarks by name
+#define COMPILE_SCENE_ARGUMENT "--compile-scene" // followed by the text scene and the output binary scene
+#define RECORD_INPUT_ARGUMENT "--record-input" // followed by the input log to write
+#define REPLAY_INPUT_ARGUMENT "--replay-input" // followed by the input log to replay offscreen in a hidden window
+#define REPLAY_DEFAULT_OUTPUT "replay.json"
+#define BENCHMARK_DEFAULT_FRAMES 1200
+#define BENCHMARK_DEFAULT_WARMUP_FRAMES 60
+#define BENCHMARK_DEFAULT_DT_MS 16
+#define BENCHMARK_DEFAULT_CAMERA_PATH "resources/benchmark/camera_path.txt"
+#define BENCHMARK_DEFAULT_OUTPUT "benchmark.json"
+#define IDLE_DEFAULT_TIMEOUT_MS 0 // 0 keeps the simulation running without input
+#define IDLE_TICK_MS 50 // interval of the input polling while idle
 
 class Application
 {
@@ -45,6 +66,14 @@ public:
 	 */
 	static void DisplayCallback();
 
+	/**
+	 * @brief Callback function for resizing the application's window.
+	 *
+	 * @param Width The new width of the window.
+	 * @param Height The new height of the window.
+	 */
+	static void ReshapeCallback(int Width, int Height);
+
 private:
 	/**
 	 * @brief Initializes the GLUT library and creates the application's window.
@@ -62,11 +91,68 @@ private:
 	 */
 	static void HandleInput(float dt);
 
+	/**
+	 * @brief Applies an input record to the scene and appends it to the input log when recording.
+	 *
+	 * @param Record The input to apply.
+	 * @param dt The time elapsed since the last tick.
+	 */
+	static void ApplyInputRecord(const InputRecord& Record, float dt);
+
+	/**
+	 * @brief Drains the input queue and rotates the active camera by the mouse movement, called right before rendering.
+	 */
+	static void ApplyMouseLook();
+
+	/**
+	 * @brief Records the input latency of the last measured frame once the GPU finished it.
+	 */
+	static void PollLatencyFence();
+
+	/**
+	 * @brief Creates the offscreen framebuffer the benchmark mode renders into.
+	 *
+	 * @return True if the framebuffer is complete, false otherwise.
+	 */
+	static bool InitBenchmarkFramebuffer();
+
+	/**
+	 * @brief Runs the benchmark: drives the active camera along the scripted path with fixed dt and writes the report.
+	 *
+	 * @return True if the benchmark finished and the report was written, false otherwise.
+	 */
+	static bool RunBenchmark();
+
+	/**
+	 * @brief Replays an input log with its fixed dt, checks the state hash of every tick and writes the frame timings.
+	 *
+	 * @return True if the whole log was replayed without divergence and the report was written, false otherwise.
+	 */
+	static bool RunReplay();
+
 	static InputHandler m_InputHandler;  /**< The input handler for the application. */
-	static Config m_Config;  /**< The configuration settings for the application. */
+	static Config m_Config;  /**< The loaded config file. */
+	static AppSettings m_Settings;  /**< The settings resolved from the command line, environment, config file and defaults. */
 	static Scene m_Scene;  /**< The scene of the application. */
 	static int m_TargetTickrate;  /**< The target tick rate of the application. */
 	static int m_LastTickTime;  /**< The time of the last tick in milliseconds. */
 	static glm::vec2 m_WindowSize;  /**< The size of the application's window. */
+	static bool m_BenchmarkMode;  /**< Flag indicating the application runs the benchmark in a hidden window instead of the main loop. */
+	static GLuint m_BenchmarkFramebuffer;  /**< Offscreen framebuffer used in benchmark mode. */
+	static Benchmark m_Benchmark;  /**< Collected benchmark results. */
+	static bool m_MicroBenchmarkMode;  /**< Flag indicating the application only runs the CPU micro benchmarks. */
+	static std::string m_MicroBenchmarkFilter;  /**< Name filter of the micro benchmarks to run. */
+	static std::string m_CompileSceneInput;  /**< Text scene to compile, empty when not compiling. */
+	static std::string m_CompileSceneOutput;  /**< Output binary scene of the scene compilation. */
+	static GLsync m_LatencyFence;  /**< Fence after the frame whose input latency is measured, nullptr if none. */
+	static uint64_t m_LatencyInputTimestamp;  /**< Oldest input event shown by the measured frame in microseconds. */
+	static FrameLimiter m_FrameLimiter;  /**< Paces the rendered frames to the MAX_FPS config value. */
+	static int m_IdleTimeout;  /**< Time without input in milliseconds after which the simulation pauses, 0 never pauses. */
+	static int m_LastInputTime;  /**< Time of the last input activity in milliseconds. */
+	static FrameCapture m_FrameCapture;  /**< Writes the rendered frames to disk when CAPTURE_FORMAT is set. */
+	static std::string m_RecordInputPath;  /**< Input log to record, empty when not recording. */
+	static std::string m_ReplayInputPath;  /**< Input log to replay in benchmark mode, empty when not replaying. */
+	static InputLog m_InputLog;  /**< The recorded or replayed input log. */
+	static uint32_t m_Tick;  /**< Number of simulation ticks run while recording. */
 };
 
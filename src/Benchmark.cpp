@@ -0,0 +1,160 @@
+#include "Benchmark.h"
+#include "FrameAllocator.h"
+#include <algorithm>
+#include <cmath>
+
+bool Benchmark::LoadCameraPath(const std::string& Filename)
+{
+	std::ifstream f(Filename);
+	if (!f)
+	{
+		std::cerr << "Benchmark::LoadCameraPath() => Can't open camera path file with given name: " << Filename << std::endl;
+		return false;
+	}
+
+	m_CameraPath.clear();
+	CameraPathKey Key;
+	while (f >> Key.Time >> Key.Location.x >> Key.Location.y >> Key.Location.z >> Key.Pitch >> Key.Yaw)
+	{
+		m_CameraPath.push_back(Key);
+	}
+	if (!f.eof())
+	{
+		std::cerr << "Benchmark::LoadCameraPath() => Error during camera path read. Didn't reach eof" << std::endl;
+		return false;
+	}
+	if (m_CameraPath.empty())
+	{
+		std::cerr << "Benchmark::LoadCameraPath() => Camera path is empty: " << Filename << std::endl;
+		return false;
+	}
+
+	std::sort(m_CameraPath.begin(), m_CameraPath.end(), [](const CameraPathKey& a, const CameraPathKey& b) { return a.Time < b.Time; });
+	return true;
+}
+
+CameraPathKey Benchmark::EvaluateCameraPath(float Time) const
+{
+	if (m_CameraPath.empty())
+		return {};
+	if (m_CameraPath.size() == 1 || m_CameraPath.back().Time <= 0.f)
+		return m_CameraPath.front();
+
+	Time = std::fmod(Time, m_CameraPath.back().Time);
+	size_t Next = 1;
+	while (Next < m_CameraPath.size() - 1 && m_CameraPath[Next].Time < Time)
+		Next++;
+
+	const CameraPathKey& a = m_CameraPath[Next - 1];
+	const CameraPathKey& b = m_CameraPath[Next];
+	float Span = b.Time - a.Time;
+	float Alpha = Span > 0.f ? glm::clamp((Time - a.Time) / Span, 0.f, 1.f) : 0.f;
+
+	CameraPathKey Result;
+	Result.Time = Time;
+	Result.Location = a.Location * (1.f - Alpha) + b.Location * Alpha;
+	Result.Pitch = a.Pitch * (1.f - Alpha) + b.Pitch * Alpha;
+	Result.Yaw = a.Yaw * (1.f - Alpha) + b.Yaw * Alpha;
+	return Result;
+}
+
+void Benchmark::SetRunInfo(const std::string& SceneName, float FixedDt)
+{
+	m_SceneName = SceneName;
+	m_FixedDt = FixedDt;
+}
+
+void Benchmark::SetLoadTime(double Milliseconds)
+{
+	m_LoadTime = Milliseconds;
+}
+
+void Benchmark::AddFrame(double FrameTimeMs, const RenderStats& Stats)
+{
+	m_FrameTimes.push_back(FrameTimeMs);
+	m_TotalStats.DrawCalls += Stats.DrawCalls;
+	m_TotalStats.Triangles += Stats.Triangles;
+	m_TotalStats.Objects += Stats.Objects;
+	m_TotalStats.BufferStalls += Stats.BufferStalls;
+	m_TotalStats.BufferStallTimeMs += Stats.BufferStallTimeMs;
+	m_TotalStats.OccludedObjects += Stats.OccludedObjects;
+	m_TotalStats.DepthPrepassGpuMs += Stats.DepthPrepassGpuMs;
+	m_TotalStats.MainPassGpuMs += Stats.MainPassGpuMs;
+	m_TotalStats.SceneGpuMs += Stats.SceneGpuMs;
+	m_TotalStats.ResolutionScale += Stats.ResolutionScale;
+	m_TotalStats.StateChanges += Stats.StateChanges;
+	m_TotalStats.ElidedStateChanges += Stats.ElidedStateChanges;
+	m_TotalStats.HeapAllocations += Stats.HeapAllocations;
+	m_TotalStats.FrameAllocatorBytes = std::max(m_TotalStats.FrameAllocatorBytes, Stats.FrameAllocatorBytes);
+}
+
+double Benchmark::GetFrameTimePercentile(double Percentile) const
+{
+	if (m_FrameTimes.empty())
+		return 0.0;
+	std::vector<double> Sorted = m_FrameTimes;
+	std::sort(Sorted.begin(), Sorted.end());
+	size_t Rank = (size_t)std::ceil(Percentile / 100.0 * Sorted.size());
+	Rank = std::min(std::max(Rank, (size_t)1), Sorted.size());
+	return Sorted[Rank - 1];
+}
+
+bool Benchmark::WriteReport(const std::string& Filename) const
+{
+	std::ofstream f(Filename);
+	if (!f)
+	{
+		std::cerr << "Benchmark::WriteReport() => Can't open output file with given name: " << Filename << std::endl;
+		return false;
+	}
+
+	const size_t Frames = m_FrameTimes.size();
+	double Sum = 0.0;
+	for (double FrameTime : m_FrameTimes)
+		Sum += FrameTime;
+	const double Mean = Frames ? Sum / Frames : 0.0;
+	const double PerFrame = Frames ? 1.0 / Frames : 0.0;
+
+	f << "{\n";
+	f << "  \"scene\": \"" << m_SceneName << "\",\n";
+	f << "  \"frames\": " << Frames << ",\n";
+	f << "  \"fixed_dt_ms\": " << m_FixedDt * 1000.0 << ",\n";
+	f << "  \"load_time_ms\": " << m_LoadTime << ",\n";
+	f << "  \"frame_time_ms\": {\n";
+	f << "    \"mean\": " << Mean << ",\n";
+	f << "    \"min\": " << GetFrameTimePercentile(0.0) << ",\n";
+	f << "    \"p50\": " << GetFrameTimePercentile(50.0) << ",\n";
+	f << "    \"p95\": " << GetFrameTimePercentile(95.0) << ",\n";
+	f << "    \"p99\": " << GetFrameTimePercentile(99.0) << ",\n";
+	f << "    \"max\": " << GetFrameTimePercentile(100.0) << "\n";
+	f << "  },\n";
+	f << "  \"draw_stats\": {\n";
+	f << "    \"draw_calls_per_frame\": " << m_TotalStats.DrawCalls * PerFrame << ",\n";
+	f << "    \"triangles_per_frame\": " << m_TotalStats.Triangles * PerFrame << ",\n";
+	f << "    \"objects_per_frame\": " << m_TotalStats.Objects * PerFrame << ",\n";
+	f << "    \"occluded_objects_per_frame\": " << m_TotalStats.OccludedObjects * PerFrame << ",\n";
+	f << "    \"state_changes_per_frame\": " << m_TotalStats.StateChanges * PerFrame << ",\n";
+	f << "    \"elided_state_changes_per_frame\": " << m_TotalStats.ElidedStateChanges * PerFrame << ",\n";
+	f << "    \"buffer_stalls\": " << m_TotalStats.BufferStalls << ",\n";
+	f << "    \"buffer_stall_time_ms\": " << m_TotalStats.BufferStallTimeMs << "\n";
+	f << "  },\n";
+	f << "  \"frame_memory\": {\n";
+#if FRAME_ALLOCATOR_COUNT_HEAP_ALLOCATIONS
+	f << "    \"heap_allocations_per_frame\": " << m_TotalStats.HeapAllocations * PerFrame << ",\n";
+#else
+	f << "    \"heap_allocations_per_frame\": null,\n"; // not counted in this build
+#endif
+	f << "    \"max_frame_allocator_bytes\": " << m_TotalStats.FrameAllocatorBytes << "\n";
+	f << "  },\n";
+	f << "  \"gpu_time_ms\": {\n";
+	f << "    \"depth_prepass\": " << m_TotalStats.DepthPrepassGpuMs * PerFrame << ",\n";
+	f << "    \"main_pass\": " << m_TotalStats.MainPassGpuMs * PerFrame << ",\n";
+	f << "    \"scene\": " << m_TotalStats.SceneGpuMs * PerFrame << "\n";
+	f << "  },\n";
+	f << "  \"mean_resolution_scale\": " << m_TotalStats.ResolutionScale * PerFrame << "\n";
+	f << "}\n";
+
+	std::cout << "Benchmark results written to " << Filename << " (p50 " << GetFrameTimePercentile(50.0)
+		<< " ms, p95 " << GetFrameTimePercentile(95.0) << " ms, p99 " << GetFrameTimePercentile(99.0) << " ms)" << std::endl;
+	return true;
+}
@@ -0,0 +1,91 @@
+#pragma once
+#include "pgr.h"
+#include "Misc.h"
+#include <string>
+#include <vector>
+#include <iostream>
+#include <fstream>
+
+/**
+ * @brief Single key of a scripted camera path.
+ */
+struct CameraPathKey
+{
+	float Time = 0.f; /**< Time of the key in seconds from the path start. */
+	glm::vec3 Location = glm::vec3(0.f); /**< World location of the camera. */
+	float Pitch = 0.f; /**< Pitch of the camera in degrees. */
+	float Yaw = 0.f; /**< Yaw of the camera in degrees. */
+};
+
+/**
+ * @brief Collects frame timings of a scripted, fixed time step run and writes them as JSON.
+ *
+ * Used by the benchmark mode of the Application. The camera path is read from a text file where
+ * every line holds: time x y z pitch yaw.
+ */
+class Benchmark
+{
+public:
+	/**
+	 * @brief Loads the scripted camera path from a file.
+	 *
+	 * @param Filename The name of the camera path file.
+	 * @return True if at least one key was loaded, false otherwise.
+	 */
+	bool LoadCameraPath(const std::string& Filename);
+
+	/**
+	 * @brief Evaluates the camera path at the given time. The path loops after its last key.
+	 *
+	 * @param Time Time in seconds from the path start.
+	 * @return The interpolated camera key.
+	 */
+	CameraPathKey EvaluateCameraPath(float Time) const;
+
+	/**
+	 * @brief Sets the run parameters reported in the output.
+	 *
+	 * @param SceneName The name of the benchmarked scene file.
+	 * @param FixedDt The fixed time step in seconds.
+	 */
+	void SetRunInfo(const std::string& SceneName, float FixedDt);
+
+	/**
+	 * @brief Sets the scene load time.
+	 *
+	 * @param Milliseconds The scene load time in milliseconds.
+	 */
+	void SetLoadTime(double Milliseconds);
+
+	/**
+	 * @brief Records a single measured frame.
+	 *
+	 * @param FrameTimeMs The frame time in milliseconds.
+	 * @param Stats Draw statistics of the frame.
+	 */
+	void AddFrame(double FrameTimeMs, const RenderStats& Stats);
+
+	/**
+	 * @brief Returns the frame time at the given percentile (nearest rank).
+	 *
+	 * @param Percentile Percentile in range [0, 100].
+	 * @return The frame time in milliseconds, 0 if no frame was recorded.
+	 */
+	double GetFrameTimePercentile(double Percentile) const;
+
+	/**
+	 * @brief Writes the collected results as JSON.
+	 *
+	 * @param Filename The name of the output file.
+	 * @return True if the report was written, false otherwise.
+	 */
+	bool WriteReport(const std::string& Filename) const;
+
+private:
+	std::vector<CameraPathKey> m_CameraPath; /**< Keys of the camera path sorted by time. */
+	std::vector<double> m_FrameTimes; /**< Measured frame times in milliseconds. */
+	RenderStats m_TotalStats; /**< Draw statistics summed over all recorded frames, the frame allocator bytes are the maximum. */
+	std::string m_SceneName; /**< The name of the benchmarked scene. */
+	float m_FixedDt = 0.f; /**< The fixed time step of the run in seconds. */
+	double m_LoadTime = 0.0; /**< Scene load time in milliseconds. */
+};
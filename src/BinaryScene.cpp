@@ -0,0 +1,314 @@
+#include "BinaryScene.h"
+#include "MaterialLibrary.h"
+#include "Scene.h"
+#include <unordered_map>
+#include <cstring>
+#ifdef _WIN32
+#include "Windows.h"
+#endif
+
+namespace
+{
+	/**
+	 * @brief Builds the string table, equal strings share one entry.
+	 */
+	class StringTableBuilder
+	{
+	public:
+		uint32_t Add(const std::string& String)
+		{
+			auto It = m_Offsets.find(String);
+			if (It != m_Offsets.end())
+				return It->second;
+			uint32_t Offset = (uint32_t)m_Data.size();
+			m_Data.insert(m_Data.end(), String.begin(), String.end());
+			m_Data.push_back('\0');
+			m_Offsets[String] = Offset;
+			return Offset;
+		}
+
+		const std::vector<char>& GetData() const { return m_Data; }
+
+	private:
+		std::vector<char> m_Data;
+		std::unordered_map<std::string, uint32_t> m_Offsets;
+	};
+
+	void CopyVec3(float* Destination, const glm::vec3& Source)
+	{
+		Destination[0] = Source.x;
+		Destination[1] = Source.y;
+		Destination[2] = Source.z;
+	}
+
+	template <class T>
+	void WriteSection(std::ofstream& f, const std::vector<T>& Records)
+	{
+		if (!Records.empty())
+			f.write(reinterpret_cast<const char*>(Records.data()), Records.size() * sizeof(T));
+	}
+}
+
+BinarySceneFile::~BinarySceneFile()
+{
+	Close();
+}
+
+bool BinarySceneFile::IsBinarySceneFilename(const std::string& Filename)
+{
+	const std::string Extension = BINARY_SCENE_EXTENSION;
+	return Filename.size() >= Extension.size()
+		&& Filename.compare(Filename.size() - Extension.size(), Extension.size(), Extension) == 0;
+}
+
+bool BinarySceneFile::Compile(const std::string& TextFilename, const std::string& BinaryFilename)
+{
+	std::ifstream In(TextFilename);
+	if (!In)
+	{
+		std::cerr << "BinarySceneFile::Compile() => Can't open scene file with given name: " << TextFilename << std::endl;
+		return false;
+	}
+	std::vector<SceneObjectDesc> ObjectDescs;
+	if (!Scene::ParseSceneFile(In, ObjectDescs))
+	{
+		std::cerr << "BinarySceneFile::Compile() => Error parsing scene file: " << TextFilename << std::endl;
+		return false;
+	}
+
+	if (!MaterialLibrary::LoadFromFile(MATERIAL_LIBRARY_FILE))
+		return false;
+
+	StringTableBuilder Strings;
+	std::vector<BinarySceneObject> Objects;
+	std::vector<BinarySceneMesh> Meshes;
+	std::vector<BinarySceneMaterial> MaterialRecords;
+	std::vector<BinarySceneCamera> Cameras;
+	std::vector<BinarySceneLight> Lights;
+	std::unordered_map<std::string, uint32_t> MeshIndices;
+	std::unordered_map<std::string, uint32_t> MaterialIndices;
+
+	Objects.reserve(ObjectDescs.size());
+	for (const SceneObjectDesc& Desc : ObjectDescs)
+	{
+		auto MeshIt = MeshIndices.find(Desc.ModelName);
+		if (MeshIt == MeshIndices.end())
+		{
+			MeshIt = MeshIndices.emplace(Desc.ModelName, (uint32_t)Meshes.size()).first;
+			Meshes.push_back({ Strings.Add(Desc.ModelName) });
+		}
+
+		const std::string& MaterialName = MaterialLibrary::GetMaterialForObject(Desc.Name).m_Name;
+		auto MaterialIt = MaterialIndices.find(MaterialName);
+		if (MaterialIt == MaterialIndices.end())
+		{
+			MaterialIt = MaterialIndices.emplace(MaterialName, (uint32_t)MaterialRecords.size()).first;
+			MaterialRecords.push_back({ Strings.Add(MaterialName) });
+		}
+
+		Transform ObjectTransform(Desc.Location, Desc.Rotation, Desc.Scale);
+		BinarySceneObject Record = {};
+		Record.Name = Strings.Add(Desc.Name);
+		Record.Mesh = MeshIt->second;
+		Record.Material = MaterialIt->second;
+		CopyVec3(Record.Location, ObjectTransform.Location);
+		Record.Rotation[0] = ObjectTransform.Rotation.x;
+		Record.Rotation[1] = ObjectTransform.Rotation.y;
+		Record.Rotation[2] = ObjectTransform.Rotation.z;
+		Record.Rotation[3] = ObjectTransform.Rotation.w;
+		CopyVec3(Record.Scale, ObjectTransform.Scale);
+		Objects.push_back(Record);
+	}
+
+	for (const SceneCameraDesc& Desc : Scene::GetDefaultCameras())
+	{
+		BinarySceneCamera Record = {};
+		Record.Name = Strings.Add(Desc.Name);
+		CopyVec3(Record.Location, Desc.Location);
+		Record.Pitch = Desc.Pitch;
+		Record.Yaw = Desc.Yaw;
+		Record.Movable = Desc.Movable ? 1u : 0u;
+		Record.AttachTo = Desc.AttachTo.empty() ? BINARY_SCENE_NO_PARENT : Strings.Add(Desc.AttachTo);
+		Cameras.push_back(Record);
+	}
+
+	for (const SceneLightDesc& Desc : Scene::GetDefaultLights())
+	{
+		BinarySceneLight Record = {};
+		Record.Type = (uint32_t)Desc.Type;
+		CopyVec3(Record.Vector, Desc.Vector);
+		Record.Active = Desc.Active ? 1u : 0u;
+		Lights.push_back(Record);
+	}
+
+	BinarySceneHeader Header = {};
+	Header.Magic = BINARY_SCENE_MAGIC;
+	Header.Version = BINARY_SCENE_VERSION;
+	uint32_t Offset = sizeof(BinarySceneHeader);
+	Header.ObjectCount = (uint32_t)Objects.size();
+	Header.ObjectOffset = Offset;
+	Offset += Header.ObjectCount * sizeof(BinarySceneObject);
+	Header.MeshCount = (uint32_t)Meshes.size();
+	Header.MeshOffset = Offset;
+	Offset += Header.MeshCount * sizeof(BinarySceneMesh);
+	Header.MaterialCount = (uint32_t)MaterialRecords.size();
+	Header.MaterialOffset = Offset;
+	Offset += Header.MaterialCount * sizeof(BinarySceneMaterial);
+	Header.CameraCount = (uint32_t)Cameras.size();
+	Header.CameraOffset = Offset;
+	Offset += Header.CameraCount * sizeof(BinarySceneCamera);
+	Header.LightCount = (uint32_t)Lights.size();
+	Header.LightOffset = Offset;
+	Offset += Header.LightCount * sizeof(BinarySceneLight);
+	Header.StringTableSize = (uint32_t)Strings.GetData().size();
+	Header.StringTableOffset = Offset;
+
+	std::ofstream Out(BinaryFilename, std::ios::binary);
+	if (!Out)
+	{
+		std::cerr << "BinarySceneFile::Compile() => Can't open output file with given name: " << BinaryFilename << std::endl;
+		return false;
+	}
+	Out.write(reinterpret_cast<const char*>(&Header), sizeof(Header));
+	WriteSection(Out, Objects);
+	WriteSection(Out, Meshes);
+	WriteSection(Out, MaterialRecords);
+	WriteSection(Out, Cameras);
+	WriteSection(Out, Lights);
+	WriteSection(Out, Strings.GetData());
+	if (!Out)
+	{
+		std::cerr << "BinarySceneFile::Compile() => Error writing output file: " << BinaryFilename << std::endl;
+		return false;
+	}
+
+	std::cout << "Compiled scene " << TextFilename << " -> " << BinaryFilename << ": " << Objects.size() << " objects, "
+		<< Meshes.size() << " meshes, " << MaterialRecords.size() << " materials, " << Cameras.size() << " cameras, "
+		<< Lights.size() << " lights" << std::endl;
+	return true;
+}
+
+bool BinarySceneFile::Open(const std::string& Filename)
+{
+	Close();
+#ifdef _WIN32
+	HANDLE File = CreateFileA(Filename.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+	if (File == INVALID_HANDLE_VALUE)
+	{
+		std::cerr << "BinarySceneFile::Open() => Can't open binary scene with given name: " << Filename << std::endl;
+		return false;
+	}
+	m_FileHandle = File;
+	LARGE_INTEGER FileSize;
+	if (!GetFileSizeEx(File, &FileSize) || FileSize.QuadPart == 0)
+	{
+		std::cerr << "BinarySceneFile::Open() => Binary scene is empty: " << Filename << std::endl;
+		Close();
+		return false;
+	}
+	m_MappingHandle = CreateFileMappingA(File, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	if (!m_MappingHandle)
+	{
+		std::cerr << "BinarySceneFile::Open() => Can't map binary scene: " << Filename << std::endl;
+		Close();
+		return false;
+	}
+	m_Data = static_cast<const char*>(MapViewOfFile(m_MappingHandle, FILE_MAP_READ, 0, 0, 0));
+	m_Size = (size_t)FileSize.QuadPart;
+#else
+	std::ifstream f(Filename, std::ios::binary | std::ios::ate);
+	if (!f)
+	{
+		std::cerr << "BinarySceneFile::Open() => Can't open binary scene with given name: " << Filename << std::endl;
+		return false;
+	}
+	m_Buffer.resize((size_t)f.tellg());
+	f.seekg(0);
+	f.read(m_Buffer.data(), m_Buffer.size());
+	m_Data = m_Buffer.data();
+	m_Size = m_Buffer.size();
+#endif
+	if (!m_Data || !Validate())
+	{
+		std::cerr << "BinarySceneFile::Open() => Invalid binary scene: " << Filename << std::endl;
+		Close();
+		return false;
+	}
+	return true;
+}
+
+void BinarySceneFile::Close()
+{
+#ifdef _WIN32
+	if (m_Data && m_MappingHandle)
+		UnmapViewOfFile(m_Data);
+	if (m_MappingHandle)
+		CloseHandle(m_MappingHandle);
+	if (m_FileHandle)
+		CloseHandle(m_FileHandle);
+#endif
+	m_MappingHandle = nullptr;
+	m_FileHandle = nullptr;
+	m_Data = nullptr;
+	m_Size = 0;
+	m_Buffer.clear();
+}
+
+const char* BinarySceneFile::GetString(uint32_t Offset) const
+{
+	return m_Data + GetHeader().StringTableOffset + Offset;
+}
+
+bool BinarySceneFile::Validate() const
+{
+	if (m_Size < sizeof(BinarySceneHeader))
+		return false;
+	const BinarySceneHeader& Header = GetHeader();
+	if (Header.Magic != BINARY_SCENE_MAGIC)
+		return false;
+	if (Header.Version != BINARY_SCENE_VERSION)
+	{
+		std::cerr << "BinarySceneFile::Validate() => Unsupported binary scene version " << Header.Version
+			<< ", expected " << BINARY_SCENE_VERSION << ". Recompile the scene." << std::endl;
+		return false;
+	}
+
+	auto SectionFits = [this](uint64_t Offset, uint64_t Count, uint64_t RecordSize)
+	{
+		return Offset % 4 == 0 && Offset + Count * RecordSize <= m_Size;
+	};
+	if (!SectionFits(Header.ObjectOffset, Header.ObjectCount, sizeof(BinarySceneObject))
+		|| !SectionFits(Header.MeshOffset, Header.MeshCount, sizeof(BinarySceneMesh))
+		|| !SectionFits(Header.MaterialOffset, Header.MaterialCount, sizeof(BinarySceneMaterial))
+		|| !SectionFits(Header.CameraOffset, Header.CameraCount, sizeof(BinarySceneCamera))
+		|| !SectionFits(Header.LightOffset, Header.LightCount, sizeof(BinarySceneLight))
+		|| (uint64_t)Header.StringTableOffset + Header.StringTableSize > m_Size
+		|| Header.StringTableSize == 0
+		|| m_Data[Header.StringTableOffset + Header.StringTableSize - 1] != '\0')
+		return false;
+
+	// every reference is checked once here, so loading can index the sections without checks
+	auto StringValid = [&Header](uint32_t Offset) { return Offset < Header.StringTableSize; };
+	for (uint32_t i = 0; i < Header.ObjectCount; i++)
+	{
+		const BinarySceneObject& Object = GetObjects()[i];
+		if (!StringValid(Object.Name) || Object.Mesh >= Header.MeshCount || Object.Material >= Header.MaterialCount)
+			return false;
+	}
+	for (uint32_t i = 0; i < Header.MeshCount; i++)
+		if (!StringValid(GetMeshes()[i].Path))
+			return false;
+	for (uint32_t i = 0; i < Header.MaterialCount; i++)
+		if (!StringValid(GetMaterials()[i].Name))
+			return false;
+	for (uint32_t i = 0; i < Header.CameraCount; i++)
+	{
+		const BinarySceneCamera& Camera = GetCameras()[i];
+		if (!StringValid(Camera.Name) || (Camera.AttachTo != BINARY_SCENE_NO_PARENT && !StringValid(Camera.AttachTo)))
+			return false;
+	}
+	for (uint32_t i = 0; i < Header.LightCount; i++)
+		if (GetLights()[i].Type > (uint32_t)SceneLightType::Point)
+			return false;
+	return true;
+}
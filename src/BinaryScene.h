@@ -0,0 +1,169 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <iostream>
+#include <fstream>
+
+#define BINARY_SCENE_MAGIC 0x42534357u // "WCSB" in little endian
+#define BINARY_SCENE_VERSION 2u // 2: material records only reference the material by name
+#define BINARY_SCENE_EXTENSION ".wcsb"
+#define BINARY_SCENE_NO_PARENT 0xFFFFFFFFu
+
+/*
+ * Binary scene layout (little endian, every field 4 bytes wide):
+ *   BinarySceneHeader
+ *   BinarySceneObject   [ObjectCount]
+ *   BinarySceneMesh     [MeshCount]
+ *   BinarySceneMaterial [MaterialCount]
+ *   BinarySceneCamera   [CameraCount]
+ *   BinarySceneLight    [LightCount]
+ *   string table        [StringTableSize] - zero terminated strings referenced by byte offset
+ * Every section offset is stored in the header and checked against the file size on open.
+ */
+
+/**
+ * @brief Header of a compiled binary scene.
+ */
+struct BinarySceneHeader
+{
+	uint32_t Magic;
+	uint32_t Version;
+	uint32_t ObjectCount, ObjectOffset;
+	uint32_t MeshCount, MeshOffset;
+	uint32_t MaterialCount, MaterialOffset;
+	uint32_t CameraCount, CameraOffset;
+	uint32_t LightCount, LightOffset;
+	uint32_t StringTableSize, StringTableOffset;
+};
+
+/**
+ * @brief Object record. Rotation is stored as quaternion (x, y, z, w).
+ */
+struct BinarySceneObject
+{
+	uint32_t Name;
+	uint32_t Mesh;
+	uint32_t Material;
+	float Location[3];
+	float Rotation[4];
+	float Scale[3];
+};
+
+/**
+ * @brief Mesh record, the model file name of a mesh shared by objects.
+ */
+struct BinarySceneMesh
+{
+	uint32_t Path;
+};
+
+/**
+ * @brief Material record, the name of a material of the material library shared by objects.
+ */
+struct BinarySceneMaterial
+{
+	uint32_t Name;
+};
+
+/**
+ * @brief Camera record. AttachTo is a string offset or BINARY_SCENE_NO_PARENT.
+ */
+struct BinarySceneCamera
+{
+	uint32_t Name;
+	float Location[3];
+	float Pitch;
+	float Yaw;
+	uint32_t Movable;
+	uint32_t AttachTo;
+};
+
+/**
+ * @brief Light record. Type matches SceneLightType.
+ */
+struct BinarySceneLight
+{
+	uint32_t Type;
+	float Vector[3];
+	uint32_t Active;
+};
+
+static_assert(sizeof(BinarySceneHeader) == 56, "BinarySceneHeader must not be padded");
+static_assert(sizeof(BinarySceneObject) == 52, "BinarySceneObject must not be padded");
+static_assert(sizeof(BinarySceneCamera) == 32, "BinarySceneCamera must not be padded");
+static_assert(sizeof(BinarySceneLight) == 20, "BinarySceneLight must not be padded");
+
+/**
+ * @brief Read only view of a compiled binary scene file.
+ *
+ * The file is memory mapped (read into memory on platforms without mapping support), validated once on open
+ * and then accessed in place through flat record arrays and the string table, without any parsing.
+ */
+class BinarySceneFile
+{
+public:
+	BinarySceneFile() = default;
+	~BinarySceneFile();
+	BinarySceneFile(const BinarySceneFile&) = delete;
+	BinarySceneFile& operator=(const BinarySceneFile&) = delete;
+
+	/**
+	 * @brief Checks if the file name has the binary scene extension.
+	 */
+	static bool IsBinarySceneFilename(const std::string& Filename);
+
+	/**
+	 * @brief Compiles a text scene file into a binary scene file.
+	 *
+	 * Materials are resolved with the object name prefixes of the material file, cameras and lights are the scene defaults.
+	 *
+	 * @param TextFilename The name of the source text scene.
+	 * @param BinaryFilename The name of the output binary scene.
+	 * @return True if the scene was compiled, false otherwise.
+	 */
+	static bool Compile(const std::string& TextFilename, const std::string& BinaryFilename);
+
+	/**
+	 * @brief Maps and validates a binary scene file.
+	 *
+	 * @param Filename The name of the binary scene file.
+	 * @return True if the file is a valid binary scene of the supported version, false otherwise.
+	 */
+	bool Open(const std::string& Filename);
+
+	/**
+	 * @brief Unmaps the file.
+	 */
+	void Close();
+
+	const BinarySceneHeader& GetHeader() const { return *reinterpret_cast<const BinarySceneHeader*>(m_Data); }
+	const BinarySceneObject* GetObjects() const { return Section<BinarySceneObject>(GetHeader().ObjectOffset); }
+	const BinarySceneMesh* GetMeshes() const { return Section<BinarySceneMesh>(GetHeader().MeshOffset); }
+	const BinarySceneMaterial* GetMaterials() const { return Section<BinarySceneMaterial>(GetHeader().MaterialOffset); }
+	const BinarySceneCamera* GetCameras() const { return Section<BinarySceneCamera>(GetHeader().CameraOffset); }
+	const BinarySceneLight* GetLights() const { return Section<BinarySceneLight>(GetHeader().LightOffset); }
+
+	/**
+	 * @brief Returns a string of the string table.
+	 *
+	 * @param Offset Byte offset of the string in the string table.
+	 * @return The zero terminated string.
+	 */
+	const char* GetString(uint32_t Offset) const;
+
+private:
+	template <class T>
+	const T* Section(uint32_t Offset) const { return reinterpret_cast<const T*>(m_Data + Offset); }
+
+	/**
+	 * @brief Validates the header, section bounds and string references.
+	 */
+	bool Validate() const;
+
+	const char* m_Data = nullptr; /**< Start of the mapped file. */
+	size_t m_Size = 0; /**< Size of the mapped file in bytes. */
+	std::vector<char> m_Buffer; /**< File contents on platforms without memory mapping. */
+	void* m_FileHandle = nullptr; /**< Handle of the mapped file. */
+	void* m_MappingHandle = nullptr; /**< Handle of the file mapping. */
+};
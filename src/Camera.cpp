@@ -57,6 +57,12 @@ float Camera::GetMouseSensitivity() const
     return m_MouseSensitivity;
 }
 
+void Camera::SetControls(float Speed, float MouseSensitivity)
+{
+    m_Speed = Speed;
+    m_MouseSensitivity = MouseSensitivity;
+}
+
 void Camera::ProcessMouseMovement(const glm::vec2 & offset )
 {
     glm::quat ResultRotation; 
@@ -80,3 +86,12 @@ void Camera::ProcessMouseMovement(const glm::vec2 & offset )
     SetWorldRotation ( glm::quat(EulerAngles) ); 
 
 }
+
+void Camera::SetOrientation(float Pitch, float Yaw)
+{
+    m_Pitch = glm::clamp(Pitch, -89.f, 89.f);
+    m_Yaw = Yaw;
+
+    glm::vec3 EulerAngles = glm::radians(glm::vec3(m_Pitch, m_Yaw, 0.f));
+    SetWorldRotation(glm::quat(EulerAngles));
+}
@@ -4,8 +4,8 @@
 #include "SceneObject.h"
 #include <iostream>
 
-#define CAMERA_MOVE_SPEED 4.f; // TODO: move to config 
-#define MOUSE_SENSIBILITY 1.f;
+#define CAMERA_MOVE_SPEED 4.f // default of the CAMERA_SPEED setting
+#define MOUSE_SENSIBILITY 1.f // default of the MOUSE_SENSITIVITY setting
 
 /**
  * @brief Represents a camera in the scene.
@@ -78,12 +78,26 @@ public:
      */
     float GetMouseSensitivity() const;
 
+    /**
+     * @brief Sets the movement speed and the mouse sensitivity of the camera.
+     * @param Speed The movement speed in world units per second.
+     * @param MouseSensitivity The rotation per pixel of mouse movement.
+     */
+    void SetControls(float Speed, float MouseSensitivity);
+
     /**
      * @brief Processes mouse movement to update the camera's orientation.
      * @param offset The mouse movement offset.
      */
     void ProcessMouseMovement(const glm::vec2& offset);
 
+    /**
+     * @brief Sets the camera orientation directly.
+     * @param Pitch The new pitch angle in degrees.
+     * @param Yaw The new yaw angle in degrees.
+     */
+    void SetOrientation(float Pitch, float Yaw);
+
 private:
     glm::mat4 ProjectionMat; /**< The projection matrix of the camera. */
     float m_Speed = CAMERA_MOVE_SPEED; /**< The movement speed of the camera. */
@@ -0,0 +1,206 @@
+#include "ClusteredLighting.h"
+#include "GLStateCache.h"
+#include <cmath>
+#include <algorithm>
+#include <limits>
+#if defined(_M_X64) || defined(_M_IX86) || defined(__SSE__)
+#include <xmmintrin.h>
+#define CLUSTER_USE_SSE 1
+#endif
+
+#define CLUSTERS_PER_SLICE (CLUSTER_GRID_X * CLUSTER_GRID_Y)
+#define CLUSTER_COUNT (CLUSTERS_PER_SLICE * CLUSTER_GRID_Z)
+
+static_assert(CLUSTERS_PER_SLICE % 4 == 0, "Clusters of a slice are tested four at a time");
+
+bool ClusteredLighting::Init()
+{
+	GLuint* Buffers[] = { &m_LightBuffer, &m_GridBuffer, &m_IndexBuffer };
+	GLuint* Textures[] = { &m_LightTexture, &m_GridTexture, &m_IndexTexture };
+	const GLenum Formats[] = { GL_RGBA32F, GL_RG32UI, GL_R32UI };
+	for (int i = 0; i < 3; i++)
+	{
+		glGenBuffers(1, Buffers[i]);
+		GLStateCache::BindBuffer(GL_TEXTURE_BUFFER, *Buffers[i]);
+		glBufferData(GL_TEXTURE_BUFFER, 16, nullptr, GL_STREAM_DRAW);
+		glGenTextures(1, Textures[i]);
+		GLStateCache::BindTexture(0, GL_TEXTURE_BUFFER, *Textures[i]);
+		glTexBuffer(GL_TEXTURE_BUFFER, Formats[i], *Buffers[i]);
+	}
+	CHECK_GL_ERROR();
+
+	m_ClusterCounts.resize(CLUSTER_COUNT);
+	m_ClusterLights.resize((size_t)CLUSTER_COUNT * CLUSTER_MAX_LIGHTS);
+	m_Grid.resize(CLUSTER_COUNT * 2);
+	return m_LightTexture && m_GridTexture && m_IndexTexture;
+}
+
+void ClusteredLighting::Update(const glm::mat4& View, const glm::mat4& Projection, ConstSpan<ClusterLight> Lights)
+{
+	if (Projection != m_Projection)
+		BuildClusterBounds(Projection);
+
+	std::fill(m_ClusterCounts.begin(), m_ClusterCounts.end(), 0u);
+	m_LightData.clear();
+	for (const ClusterLight& Light : Lights)
+	{
+		glm::vec3 Center = glm::vec3(View * glm::vec4(Light.Position, 1.f));
+		float Depth = -Center.z;
+		if (Depth + Light.Radius < m_Near || Depth - Light.Radius > m_Far)
+			continue;
+
+		uint32_t LightIndex = (uint32_t)m_LightData.size();
+		m_LightData.push_back(glm::vec4(Center, Light.Radius));
+		int FirstSlice = GetDepthSlice(Depth - Light.Radius);
+		int LastSlice = GetDepthSlice(Depth + Light.Radius);
+		for (int Slice = FirstSlice; Slice <= LastSlice; Slice++)
+			AssignLightToSlice(LightIndex, Center, Light.Radius, Slice);
+	}
+
+	m_Indices.clear();
+	for (uint32_t Cluster = 0; Cluster < CLUSTER_COUNT; Cluster++)
+	{
+		m_Grid[Cluster * 2] = (uint32_t)m_Indices.size();
+		m_Grid[Cluster * 2 + 1] = m_ClusterCounts[Cluster];
+		const uint32_t* First = &m_ClusterLights[(size_t)Cluster * CLUSTER_MAX_LIGHTS];
+		m_Indices.insert(m_Indices.end(), First, First + m_ClusterCounts[Cluster]);
+	}
+	// texture buffers must not be empty
+	if (m_LightData.empty())
+		m_LightData.push_back(glm::vec4(0.f));
+	if (m_Indices.empty())
+		m_Indices.push_back(0);
+
+	GLStateCache::BindBuffer(GL_TEXTURE_BUFFER, m_LightBuffer);
+	glBufferData(GL_TEXTURE_BUFFER, m_LightData.size() * sizeof(glm::vec4), m_LightData.data(), GL_STREAM_DRAW);
+	GLStateCache::BindBuffer(GL_TEXTURE_BUFFER, m_GridBuffer);
+	glBufferData(GL_TEXTURE_BUFFER, m_Grid.size() * sizeof(uint32_t), m_Grid.data(), GL_STREAM_DRAW);
+	GLStateCache::BindBuffer(GL_TEXTURE_BUFFER, m_IndexBuffer);
+	glBufferData(GL_TEXTURE_BUFFER, m_Indices.size() * sizeof(uint32_t), m_Indices.data(), GL_STREAM_DRAW);
+	CHECK_GL_ERROR();
+}
+
+void ClusteredLighting::Bind(const Shader& shader, const glm::vec2& Viewport) const
+{
+	GLStateCache::BindTexture(CLUSTER_LIGHT_DATA_TEXTURE_UNIT, GL_TEXTURE_BUFFER, m_LightTexture);
+	GLStateCache::BindTexture(CLUSTER_GRID_TEXTURE_UNIT, GL_TEXTURE_BUFFER, m_GridTexture);
+	GLStateCache::BindTexture(CLUSTER_INDEX_TEXTURE_UNIT, GL_TEXTURE_BUFFER, m_IndexTexture);
+
+	shader.SetIntParameter("clusterLightData", CLUSTER_LIGHT_DATA_TEXTURE_UNIT);
+	shader.SetIntParameter("clusterGrid", CLUSTER_GRID_TEXTURE_UNIT);
+	shader.SetIntParameter("clusterLightIndices", CLUSTER_INDEX_TEXTURE_UNIT);
+	shader.SetVec3Parameter("clusterScale", glm::vec3(CLUSTER_GRID_X / Viewport.x, CLUSTER_GRID_Y / Viewport.y, m_SliceScale));
+	shader.SetFloatParameter("clusterSliceBias", m_SliceBias);
+}
+
+float ClusteredLighting::ComputeLightRadius(float Constant, float Linear, float Quadratic, float MaxIntensity)
+{
+	// solve MaxIntensity / (Constant + Linear * d + Quadratic * d^2) = CLUSTER_LIGHT_CUTOFF for d
+	const float c = Constant - MaxIntensity / CLUSTER_LIGHT_CUTOFF;
+	if (Quadratic > 0.f)
+		return (-Linear + std::sqrt(Linear * Linear - 4.f * Quadratic * c)) / (2.f * Quadratic);
+	if (Linear > 0.f)
+		return -c / Linear;
+	return std::numeric_limits<float>::max();
+}
+
+size_t ClusteredLighting::GetAssignedLightCount() const
+{
+	size_t Count = 0;
+	for (uint32_t ClusterCount : m_ClusterCounts)
+		Count += ClusterCount;
+	return Count;
+}
+
+void ClusteredLighting::BuildClusterBounds(const glm::mat4& Projection)
+{
+	m_Projection = Projection;
+	// near and far planes of a glm::perspective matrix
+	m_Near = Projection[3][2] / (Projection[2][2] - 1.f);
+	m_Far = Projection[3][2] / (Projection[2][2] + 1.f);
+	m_SliceScale = CLUSTER_GRID_Z / std::log(m_Far / m_Near);
+	m_SliceBias = -CLUSTER_GRID_Z * std::log(m_Near) / std::log(m_Far / m_Near);
+
+	m_MinX.resize(CLUSTER_COUNT); m_MinY.resize(CLUSTER_COUNT); m_MinZ.resize(CLUSTER_COUNT);
+	m_MaxX.resize(CLUSTER_COUNT); m_MaxY.resize(CLUSTER_COUNT); m_MaxZ.resize(CLUSTER_COUNT);
+
+	const glm::mat4 InverseProjection = glm::inverse(Projection);
+	for (int y = 0; y < CLUSTER_GRID_Y; y++)
+	{
+		for (int x = 0; x < CLUSTER_GRID_X; x++)
+		{
+			// view rays through the tile corners, scaled to unit depth
+			glm::vec3 Rays[4];
+			for (int Corner = 0; Corner < 4; Corner++)
+			{
+				float NdcX = -1.f + 2.f * (x + (Corner & 1)) / CLUSTER_GRID_X;
+				float NdcY = -1.f + 2.f * (y + (Corner >> 1)) / CLUSTER_GRID_Y;
+				glm::vec4 Point = InverseProjection * glm::vec4(NdcX, NdcY, -1.f, 1.f);
+				glm::vec3 ViewPoint = glm::vec3(Point) / Point.w;
+				Rays[Corner] = ViewPoint / -ViewPoint.z;
+			}
+			for (int z = 0; z < CLUSTER_GRID_Z; z++)
+			{
+				const float NearDepth = m_Near * std::pow(m_Far / m_Near, (float)z / CLUSTER_GRID_Z);
+				const float FarDepth = m_Near * std::pow(m_Far / m_Near, (float)(z + 1) / CLUSTER_GRID_Z);
+				glm::vec3 Min(std::numeric_limits<float>::max()), Max(std::numeric_limits<float>::lowest());
+				for (const glm::vec3& Ray : Rays)
+				{
+					Min = glm::min(Min, glm::min(Ray * NearDepth, Ray * FarDepth));
+					Max = glm::max(Max, glm::max(Ray * NearDepth, Ray * FarDepth));
+				}
+				const int Cluster = x + y * CLUSTER_GRID_X + z * CLUSTERS_PER_SLICE;
+				m_MinX[Cluster] = Min.x; m_MinY[Cluster] = Min.y; m_MinZ[Cluster] = Min.z;
+				m_MaxX[Cluster] = Max.x; m_MaxY[Cluster] = Max.y; m_MaxZ[Cluster] = Max.z;
+			}
+		}
+	}
+}
+
+int ClusteredLighting::GetDepthSlice(float Depth) const
+{
+	if (Depth <= m_Near)
+		return 0;
+	int Slice = (int)std::floor(std::log(Depth) * m_SliceScale + m_SliceBias);
+	return std::min(std::max(Slice, 0), CLUSTER_GRID_Z - 1);
+}
+
+void ClusteredLighting::AssignLightToSlice(uint32_t LightIndex, const glm::vec3& Center, float Radius, int Slice)
+{
+	const int First = Slice * CLUSTERS_PER_SLICE;
+	auto AddLight = [this, LightIndex](int Cluster)
+	{
+		uint32_t& Count = m_ClusterCounts[Cluster];
+		if (Count < CLUSTER_MAX_LIGHTS)
+			m_ClusterLights[(size_t)Cluster * CLUSTER_MAX_LIGHTS + Count++] = LightIndex;
+	};
+
+#ifdef CLUSTER_USE_SSE
+	// squared distance from the sphere center to the box, per axis max(0, min - c, c - max)
+	const __m128 Zero = _mm_setzero_ps();
+	const __m128 Cx = _mm_set1_ps(Center.x), Cy = _mm_set1_ps(Center.y), Cz = _mm_set1_ps(Center.z);
+	const __m128 RadiusSquared = _mm_set1_ps(Radius * Radius);
+	for (int i = First; i < First + CLUSTERS_PER_SLICE; i += 4)
+	{
+		__m128 Dx = _mm_max_ps(Zero, _mm_max_ps(_mm_sub_ps(_mm_loadu_ps(&m_MinX[i]), Cx), _mm_sub_ps(Cx, _mm_loadu_ps(&m_MaxX[i]))));
+		__m128 Dy = _mm_max_ps(Zero, _mm_max_ps(_mm_sub_ps(_mm_loadu_ps(&m_MinY[i]), Cy), _mm_sub_ps(Cy, _mm_loadu_ps(&m_MaxY[i]))));
+		__m128 Dz = _mm_max_ps(Zero, _mm_max_ps(_mm_sub_ps(_mm_loadu_ps(&m_MinZ[i]), Cz), _mm_sub_ps(Cz, _mm_loadu_ps(&m_MaxZ[i]))));
+		__m128 DistanceSquared = _mm_add_ps(_mm_add_ps(_mm_mul_ps(Dx, Dx), _mm_mul_ps(Dy, Dy)), _mm_mul_ps(Dz, Dz));
+		int Mask = _mm_movemask_ps(_mm_cmple_ps(DistanceSquared, RadiusSquared));
+		for (int j = 0; Mask; j++, Mask >>= 1)
+		{
+			if (Mask & 1)
+				AddLight(i + j);
+		}
+	}
+#else
+	for (int i = First; i < First + CLUSTERS_PER_SLICE; i++)
+	{
+		float Dx = std::max(0.f, std::max(m_MinX[i] - Center.x, Center.x - m_MaxX[i]));
+		float Dy = std::max(0.f, std::max(m_MinY[i] - Center.y, Center.y - m_MaxY[i]));
+		float Dz = std::max(0.f, std::max(m_MinZ[i] - Center.z, Center.z - m_MaxZ[i]));
+		if (Dx * Dx + Dy * Dy + Dz * Dz <= Radius * Radius)
+			AddLight(i);
+	}
+#endif
+}
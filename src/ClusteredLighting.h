@@ -0,0 +1,115 @@
+#pragma once
+#include "pgr.h"
+#include "Shader.h"
+#include "Misc.h"
+#include <vector>
+#include <cstdint>
+#include <iostream>
+
+#define CLUSTER_GRID_X 16
+#define CLUSTER_GRID_Y 9
+#define CLUSTER_GRID_Z 24
+#define CLUSTER_MAX_LIGHTS 256 // per cluster, further lights of a cluster are dropped
+#define CLUSTER_LIGHT_CUTOFF (1.f / 256.f) // lights are culled where their contribution falls below this
+#define CLUSTER_LIGHT_DATA_TEXTURE_UNIT 8
+#define CLUSTER_GRID_TEXTURE_UNIT 9
+#define CLUSTER_INDEX_TEXTURE_UNIT 10
+
+/**
+ * @brief Point light assigned to the clusters.
+ */
+struct ClusterLight
+{
+	glm::vec3 Position; /**< World position of the light. */
+	float Radius; /**< Distance where the light contribution falls below CLUSTER_LIGHT_CUTOFF. */
+};
+
+/**
+ * @brief Clustered forward lighting: assigns point lights to a 3D grid of view frustum clusters.
+ *
+ * The frustum is split into CLUSTER_GRID_X x CLUSTER_GRID_Y screen tiles and CLUSTER_GRID_Z exponential depth slices.
+ * Every frame the lights are transformed to view space, tested against the cluster bounds (four clusters at a time with SSE)
+ * and the light data, cluster offsets and light index lists are uploaded to texture buffers, so a fragment only
+ * evaluates the lights of its own cluster.
+ */
+class ClusteredLighting
+{
+public:
+	ClusteredLighting() = default;
+	ClusteredLighting(const ClusteredLighting&) = delete;
+	ClusteredLighting& operator=(const ClusteredLighting&) = delete;
+
+	/**
+	 * @brief Creates the texture buffers.
+	 *
+	 * @return True if the buffers were created, false otherwise.
+	 */
+	bool Init();
+
+	/**
+	 * @brief Assigns the lights to clusters and uploads the result.
+	 *
+	 * @param View The view matrix of the camera.
+	 * @param Projection The perspective projection matrix of the camera.
+	 * @param Lights The active point lights.
+	 */
+	void Update(const glm::mat4& View, const glm::mat4& Projection, ConstSpan<ClusterLight> Lights);
+
+	/**
+	 * @brief Binds the texture buffers and sets the cluster uniforms of a shader.
+	 *
+	 * @param shader The shader to bind to.
+	 * @param Viewport Size of the viewport in pixels.
+	 */
+	void Bind(const Shader& shader, const glm::vec2& Viewport) const;
+
+	/**
+	 * @brief Returns the distance where the contribution of a light with the given attenuation falls below CLUSTER_LIGHT_CUTOFF.
+	 *
+	 * @param Constant The constant attenuation term.
+	 * @param Linear The linear attenuation term.
+	 * @param Quadratic The quadratic attenuation term.
+	 * @param MaxIntensity The largest color component the light contributes without attenuation.
+	 */
+	static float ComputeLightRadius(float Constant, float Linear, float Quadratic, float MaxIntensity);
+
+	/**
+	 * @brief Returns the number of light references in all clusters of the last update.
+	 */
+	size_t GetAssignedLightCount() const;
+
+private:
+	/**
+	 * @brief Recomputes the view space bounds of the clusters for a projection.
+	 */
+	void BuildClusterBounds(const glm::mat4& Projection);
+
+	/**
+	 * @brief Returns the depth slice containing the view space depth, clamped to the grid.
+	 */
+	int GetDepthSlice(float Depth) const;
+
+	/**
+	 * @brief Adds a light to every cluster of a depth slice its sphere overlaps.
+	 */
+	void AssignLightToSlice(uint32_t LightIndex, const glm::vec3& Center, float Radius, int Slice);
+
+	GLuint m_LightBuffer = 0, m_LightTexture = 0; /**< Per light view space position and radius, RGBA32F. */
+	GLuint m_GridBuffer = 0, m_GridTexture = 0; /**< Per cluster offset into the index list and light count, RG32UI. */
+	GLuint m_IndexBuffer = 0, m_IndexTexture = 0; /**< Light indices of all clusters, R32UI. */
+
+	glm::mat4 m_Projection = glm::mat4(0.f); /**< Projection the cluster bounds were built for. */
+	float m_Near = 0.1f; /**< Near plane of the projection. */
+	float m_Far = 1.f; /**< Far plane of the projection. */
+	float m_SliceScale = 0.f; /**< Maps log(depth) to the depth slice. */
+	float m_SliceBias = 0.f; /**< Maps log(depth) to the depth slice. */
+
+	// cluster bounds in view space as structure of arrays, x + y * CLUSTER_GRID_X + z * CLUSTER_GRID_X * CLUSTER_GRID_Y
+	std::vector<float> m_MinX, m_MinY, m_MinZ, m_MaxX, m_MaxY, m_MaxZ;
+
+	std::vector<uint32_t> m_ClusterCounts; /**< Number of lights in every cluster. */
+	std::vector<uint32_t> m_ClusterLights; /**< CLUSTER_MAX_LIGHTS slots per cluster, compacted before the upload. */
+	std::vector<glm::vec4> m_LightData; /**< Uploaded light data. */
+	std::vector<uint32_t> m_Grid; /**< Uploaded offset and count pairs. */
+	std::vector<uint32_t> m_Indices; /**< Uploaded light index list. */
+};
@@ -0,0 +1,319 @@
+#include "CollisionWorld.h"
+#include <algorithm>
+#include <cmath>
+#include <cfloat>
+
+void CollisionWorld::Add(EntityHandle Entity, const glm::vec3& LocalMin, const glm::vec3& LocalMax)
+{
+	const EntityStore& Entities = EntityStore::Get();
+	if (!Entities.GetIsAlive(Entity))
+	{
+		std::cerr << "CollisionWorld::Add() => Entity " << Entity.Index << " does not exist" << std::endl;
+		return;
+	}
+	Remove(Entity);
+
+	uint32_t Id = (uint32_t)m_Colliders.size();
+	if (!m_FreeColliders.empty())
+	{
+		Id = m_FreeColliders.back();
+		m_FreeColliders.pop_back();
+	}
+	else
+		m_Colliders.emplace_back();
+	Collider& NewCollider = m_Colliders[Id];
+	NewCollider = Collider();
+	NewCollider.Entity = Entity;
+	NewCollider.LocalMin = LocalMin;
+	NewCollider.LocalMax = LocalMax;
+	// the cached world matrix of a new entity may not be computed yet
+	NewCollider.World = Entities.GetWorldModelMatrix(Entity);
+	ComputeWorldBounds(NewCollider, NewCollider.World);
+	InsertIntoCells(Id);
+
+	if (Entity.Index >= m_EntityColliders.size())
+		m_EntityColliders.resize(Entity.Index + 1, ENTITY_INVALID_INDEX);
+	m_EntityColliders[Entity.Index] = Id;
+}
+
+void CollisionWorld::Remove(EntityHandle Entity)
+{
+	if (Entity.Index >= m_EntityColliders.size() || m_EntityColliders[Entity.Index] == ENTITY_INVALID_INDEX)
+		return;
+	const uint32_t Id = m_EntityColliders[Entity.Index];
+	if (m_Colliders[Id].Entity == Entity)
+		FreeCollider(Id);
+}
+
+void CollisionWorld::Clear()
+{
+	m_Colliders.clear();
+	m_FreeColliders.clear();
+	m_EntityColliders.clear();
+	m_Cells.clear();
+	m_Oversized.clear();
+	m_RebinnedCount = 0;
+}
+
+void CollisionWorld::Update()
+{
+	const EntityStore& Entities = EntityStore::Get();
+	m_RebinnedCount = 0;
+	for (uint32_t Id = 0; Id < (uint32_t)m_Colliders.size(); Id++)
+	{
+		Collider& Current = m_Colliders[Id];
+		if (Current.Entity.Index == ENTITY_INVALID_INDEX)
+			continue;
+		const TransformComponent* Transform = Entities.GetTransform(Current.Entity);
+		if (!Transform)
+		{
+			FreeCollider(Id);
+			continue;
+		}
+		if (Transform->World == Current.World)
+			continue;
+
+		// the bounds always follow the entity, the cell lists only change when the box crosses a cell border
+		Collider Moved = Current;
+		ComputeWorldBounds(Moved, Transform->World);
+		Moved.World = Transform->World;
+		if (Moved.CellMin == Current.CellMin && Moved.CellMax == Current.CellMax && Moved.IsOversized == Current.IsOversized)
+		{
+			Current = Moved;
+			continue;
+		}
+		RemoveFromCells(Id);
+		Current = Moved;
+		InsertIntoCells(Id);
+		m_RebinnedCount++;
+	}
+}
+
+bool CollisionWorld::SweepSphere(const SphereSweep& Sweep, CollisionHit& Hit) const
+{
+	const glm::vec3 End = Sweep.Start + Sweep.Delta;
+	GatherCandidates(glm::min(Sweep.Start, End) - glm::vec3(Sweep.Radius), glm::max(Sweep.Start, End) + glm::vec3(Sweep.Radius));
+	return SweepCandidates(Sweep, Hit);
+}
+
+void CollisionWorld::SweepSpheres(const std::vector<SphereSweep>& Sweeps, std::vector<CollisionHit>& Hits) const
+{
+	Hits.resize(Sweeps.size());
+	for (size_t i = 0; i < Sweeps.size(); i++)
+		SweepSphere(Sweeps[i], Hits[i]);
+}
+
+glm::vec3 CollisionWorld::MoveSphere(const glm::vec3& Start, float Radius, const glm::vec3& Delta) const
+{
+	glm::vec3 Location = Start;
+	glm::vec3 Remaining = Delta;
+	for (int i = 0; i < COLLISION_SLIDE_ITERATIONS; i++)
+	{
+		const float Length = glm::length(Remaining);
+		if (Length <= COLLISION_SKIN)
+			break;
+		SphereSweep Sweep;
+		Sweep.Start = Location;
+		Sweep.Delta = Remaining;
+		Sweep.Radius = Radius;
+		CollisionHit Hit;
+		if (!SweepSphere(Sweep, Hit))
+		{
+			Location = Location + Remaining;
+			break;
+		}
+		const float Time = std::max(Hit.Time - COLLISION_SKIN / Length, 0.f);
+		Location = Location + Remaining * Time;
+		Remaining = Remaining * (1.f - Time);
+		Remaining = Remaining - Hit.Normal * glm::dot(Remaining, Hit.Normal);
+	}
+	return Location - Start;
+}
+
+void CollisionWorld::QueryAabb(const glm::vec3& Min, const glm::vec3& Max, std::vector<EntityHandle>& Entities) const
+{
+	GatherCandidates(Min, Max);
+	for (uint32_t Id : m_Candidates)
+	{
+		const Collider& Candidate = m_Colliders[Id];
+		if (Candidate.WorldMin.x <= Max.x && Candidate.WorldMax.x >= Min.x && Candidate.WorldMin.y <= Max.y
+			&& Candidate.WorldMax.y >= Min.y && Candidate.WorldMin.z <= Max.z && Candidate.WorldMax.z >= Min.z)
+			Entities.push_back(Candidate.Entity);
+	}
+}
+
+void CollisionWorld::FreeCollider(uint32_t Id)
+{
+	const uint32_t Entity = m_Colliders[Id].Entity.Index;
+	// the slot of a destroyed entity may already belong to a new entity with its own collider
+	if (m_EntityColliders[Entity] == Id)
+		m_EntityColliders[Entity] = ENTITY_INVALID_INDEX;
+	RemoveFromCells(Id);
+	m_Colliders[Id].Entity = EntityHandle();
+	m_FreeColliders.push_back(Id);
+}
+
+glm::ivec3 CollisionWorld::GetCell(const glm::vec3& Location)
+{
+	return glm::ivec3((int)std::floor(Location.x / COLLISION_CELL_SIZE), (int)std::floor(Location.y / COLLISION_CELL_SIZE), (int)std::floor(Location.z / COLLISION_CELL_SIZE));
+}
+
+uint64_t CollisionWorld::GetCellKey(int x, int y, int z)
+{
+	const uint64_t Mask = (1u << 21) - 1;
+	return ((uint64_t)(x & Mask) << 42) | ((uint64_t)(y & Mask) << 21) | (uint64_t)(z & Mask);
+}
+
+void CollisionWorld::ComputeWorldBounds(Collider& Collider, const glm::mat4& World)
+{
+	// box of the transformed box: the center is transformed, the extent grows by the absolute rotation and scale
+	const glm::vec3 Center = (Collider.LocalMin + Collider.LocalMax) * 0.5f;
+	const glm::vec3 Extent = (Collider.LocalMax - Collider.LocalMin) * 0.5f;
+	for (int i = 0; i < 3; i++)
+	{
+		float WorldCenter = World[3][i];
+		float WorldExtent = 0.f;
+		for (int j = 0; j < 3; j++)
+		{
+			WorldCenter += World[j][i] * Center[j];
+			WorldExtent += std::abs(World[j][i]) * Extent[j];
+		}
+		Collider.WorldMin[i] = WorldCenter - WorldExtent;
+		Collider.WorldMax[i] = WorldCenter + WorldExtent;
+	}
+	Collider.CellMin = GetCell(Collider.WorldMin);
+	Collider.CellMax = GetCell(Collider.WorldMax);
+	int64_t CellCount = 1;
+	for (int i = 0; i < 3; i++)
+		CellCount *= (int64_t)Collider.CellMax[i] - Collider.CellMin[i] + 1;
+	Collider.IsOversized = CellCount > COLLISION_MAX_CELLS_PER_COLLIDER;
+}
+
+void CollisionWorld::InsertIntoCells(uint32_t Id)
+{
+	const Collider& Inserted = m_Colliders[Id];
+	if (Inserted.IsOversized)
+	{
+		m_Oversized.push_back(Id);
+		return;
+	}
+	for (int x = Inserted.CellMin.x; x <= Inserted.CellMax.x; x++)
+		for (int y = Inserted.CellMin.y; y <= Inserted.CellMax.y; y++)
+			for (int z = Inserted.CellMin.z; z <= Inserted.CellMax.z; z++)
+				m_Cells[GetCellKey(x, y, z)].push_back(Id);
+}
+
+void CollisionWorld::RemoveFromCells(uint32_t Id)
+{
+	const Collider& Removed = m_Colliders[Id];
+	if (Removed.IsOversized)
+	{
+		m_Oversized.erase(std::find(m_Oversized.begin(), m_Oversized.end(), Id));
+		return;
+	}
+	for (int x = Removed.CellMin.x; x <= Removed.CellMax.x; x++)
+		for (int y = Removed.CellMin.y; y <= Removed.CellMax.y; y++)
+			for (int z = Removed.CellMin.z; z <= Removed.CellMax.z; z++)
+			{
+				auto Cell = m_Cells.find(GetCellKey(x, y, z));
+				if (Cell == m_Cells.end())
+					continue;
+				std::vector<uint32_t>& Ids = Cell->second;
+				auto Found = std::find(Ids.begin(), Ids.end(), Id);
+				if (Found != Ids.end())
+				{
+					*Found = Ids.back();
+					Ids.pop_back();
+				}
+				if (Ids.empty())
+					m_Cells.erase(Cell);
+			}
+}
+
+void CollisionWorld::GatherCandidates(const glm::vec3& Min, const glm::vec3& Max) const
+{
+	m_Candidates.clear();
+	m_QueryMarks.resize(m_Colliders.size(), 0);
+	if (++m_QueryCounter == 0) // wrapped around, old marks could match again
+	{
+		std::fill(m_QueryMarks.begin(), m_QueryMarks.end(), 0);
+		m_QueryCounter = 1;
+	}
+	m_Candidates.insert(m_Candidates.end(), m_Oversized.begin(), m_Oversized.end());
+
+	const glm::ivec3 CellMin = GetCell(Min);
+	const glm::ivec3 CellMax = GetCell(Max);
+	int64_t CellCount = 1;
+	for (int i = 0; i < 3; i++)
+		CellCount *= (int64_t)CellMax[i] - CellMin[i] + 1;
+	if (CellCount > (int64_t)m_Cells.size())
+	{
+		// a query larger than the occupied grid is cheaper as a pass over all colliders
+		for (uint32_t Id = 0; Id < (uint32_t)m_Colliders.size(); Id++)
+		{
+			if (m_Colliders[Id].Entity.Index != ENTITY_INVALID_INDEX && !m_Colliders[Id].IsOversized)
+				m_Candidates.push_back(Id);
+		}
+		return;
+	}
+	for (int x = CellMin.x; x <= CellMax.x; x++)
+		for (int y = CellMin.y; y <= CellMax.y; y++)
+			for (int z = CellMin.z; z <= CellMax.z; z++)
+			{
+				auto Cell = m_Cells.find(GetCellKey(x, y, z));
+				if (Cell == m_Cells.end())
+					continue;
+				for (uint32_t Id : Cell->second)
+				{
+					if (m_QueryMarks[Id] == m_QueryCounter)
+						continue;
+					m_QueryMarks[Id] = m_QueryCounter;
+					m_Candidates.push_back(Id);
+				}
+			}
+}
+
+bool CollisionWorld::SweepCandidates(const SphereSweep& Sweep, CollisionHit& Hit) const
+{
+	Hit = CollisionHit();
+	bool IsHit = false;
+	for (uint32_t Id : m_Candidates)
+	{
+		const Collider& Candidate = m_Colliders[Id];
+		// slab test of the center ray against the box grown by the radius
+		float Enter = -FLT_MAX;
+		float Exit = FLT_MAX;
+		int EnterAxis = -1;
+		bool IsMissed = false;
+		for (int i = 0; i < 3 && !IsMissed; i++)
+		{
+			const float Min = Candidate.WorldMin[i] - Sweep.Radius;
+			const float Max = Candidate.WorldMax[i] + Sweep.Radius;
+			if (std::abs(Sweep.Delta[i]) < 1e-8f)
+			{
+				IsMissed = Sweep.Start[i] < Min || Sweep.Start[i] > Max;
+				continue;
+			}
+			float t0 = (Min - Sweep.Start[i]) / Sweep.Delta[i];
+			float t1 = (Max - Sweep.Start[i]) / Sweep.Delta[i];
+			if (t0 > t1)
+				std::swap(t0, t1);
+			if (t0 > Enter)
+			{
+				Enter = t0;
+				EnterAxis = i;
+			}
+			Exit = std::min(Exit, t1);
+			IsMissed = Enter > Exit;
+		}
+		// Enter < 0 means the sphere starts inside the box, it is ignored so the sphere can leave
+		if (IsMissed || EnterAxis < 0 || Enter < 0.f || Enter > Hit.Time || (IsHit && Enter == Hit.Time))
+			continue;
+		Hit.Entity = Candidate.Entity;
+		Hit.Time = Enter;
+		Hit.Normal = glm::vec3(0.f);
+		Hit.Normal[EnterAxis] = Sweep.Delta[EnterAxis] > 0.f ? -1.f : 1.f;
+		IsHit = true;
+	}
+	return IsHit;
+}
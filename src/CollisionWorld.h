@@ -0,0 +1,180 @@
+#pragma once
+#include "pgr.h"
+#include "EntityStore.h"
+#include <vector>
+#include <unordered_map>
+#include <cstdint>
+
+#define COLLISION_CELL_SIZE 4.f // edge length of a spatial hash cell in world units
+#define COLLISION_MAX_CELLS_PER_COLLIDER 64 // larger colliders skip the grid and are tested by every query
+#define COLLISION_CAMERA_RADIUS 0.25f
+#define COLLISION_SKIN 0.001f // distance kept from the hit surface, so the next sweep does not start touching it
+#define COLLISION_SLIDE_ITERATIONS 3 // sweeps of MoveSphere, each slides the rest of the movement along the hit surface
+
+/**
+ * @brief Movement of a sphere tested by CollisionWorld::SweepSphere.
+ */
+struct SphereSweep
+{
+	glm::vec3 Start = glm::vec3(0.f); /**< Center of the sphere before the movement. */
+	glm::vec3 Delta = glm::vec3(0.f); /**< Movement of the center. */
+	float Radius = 0.f;
+};
+
+/**
+ * @brief First collider hit by a sphere sweep.
+ */
+struct CollisionHit
+{
+	EntityHandle Entity; /**< Entity of the hit collider, invalid if nothing was hit. */
+	float Time = 1.f; /**< Fraction of the movement at the contact. */
+	glm::vec3 Normal = glm::vec3(0.f); /**< Normal of the hit box face. */
+};
+
+/**
+ * @brief Axis aligned bounding boxes of entities in a uniform grid spatial hash.
+ *
+ * Every collider is the world box of the local bounds of its entity, listed in all grid cells the box overlaps.
+ * Update only rebins colliders whose world matrix changed, so static buildings cost one matrix compare per update and
+ * a query only tests the colliders of the cells it touches, independently of the number of objects in the scene.
+ * Sweeps treat the sphere as a box of its radius, which is conservative only at the box edges and corners.
+ */
+class CollisionWorld
+{
+public:
+	/**
+	 * @brief Adds the collider of an entity, replacing its previous one.
+	 *
+	 * @param Entity The entity whose world matrix places the collider.
+	 * @param LocalMin The minimal corner of the bounds in the local space of the entity.
+	 * @param LocalMax The maximal corner of the bounds in the local space of the entity.
+	 */
+	void Add(EntityHandle Entity, const glm::vec3& LocalMin, const glm::vec3& LocalMax);
+
+	/**
+	 * @brief Removes the collider of an entity if it has one.
+	 */
+	void Remove(EntityHandle Entity);
+
+	/**
+	 * @brief Removes all colliders.
+	 */
+	void Clear();
+
+	/**
+	 * @brief Rebins the colliders whose entities moved and removes the colliders of destroyed entities.
+	 * Reads the world matrices cached by EntityStore::UpdateWorldMatrices.
+	 */
+	void Update();
+
+	/**
+	 * @brief Finds the first collider hit by a moving sphere. Colliders the sphere starts inside are ignored, so an
+	 * overlapping sphere can always move out.
+	 *
+	 * @param Sweep The sphere and its movement.
+	 * @param Hit The first hit.
+	 * @return True if a collider was hit, false otherwise.
+	 */
+	bool SweepSphere(const SphereSweep& Sweep, CollisionHit& Hit) const;
+
+	/**
+	 * @brief Sweeps a batch of spheres, reusing the candidate buffers for all of them.
+	 *
+	 * @param Sweeps The spheres and their movements.
+	 * @param Hits The first hit of every sweep, with an invalid entity and Time 1 where nothing was hit.
+	 */
+	void SweepSpheres(const std::vector<SphereSweep>& Sweeps, std::vector<CollisionHit>& Hits) const;
+
+	/**
+	 * @brief Moves a sphere as far as the colliders allow, sliding along the hit surfaces.
+	 *
+	 * @param Start The center of the sphere.
+	 * @param Radius The radius of the sphere.
+	 * @param Delta The requested movement.
+	 * @return The allowed movement.
+	 */
+	glm::vec3 MoveSphere(const glm::vec3& Start, float Radius, const glm::vec3& Delta) const;
+
+	/**
+	 * @brief Appends the entities whose colliders overlap a box.
+	 *
+	 * @param Min The minimal corner of the box in world space.
+	 * @param Max The maximal corner of the box in world space.
+	 * @param Entities The overlapping entities, each once.
+	 */
+	void QueryAabb(const glm::vec3& Min, const glm::vec3& Max, std::vector<EntityHandle>& Entities) const;
+
+	/**
+	 * @brief Returns the number of colliders.
+	 */
+	size_t GetColliderCount() const { return m_Colliders.size() - m_FreeColliders.size(); }
+
+	/**
+	 * @brief Returns the number of colliders rebinned by the last Update.
+	 */
+	size_t GetRebinnedCount() const { return m_RebinnedCount; }
+
+private:
+	struct Collider
+	{
+		EntityHandle Entity; /**< Owner, invalid if the slot is free. */
+		glm::vec3 LocalMin;
+		glm::vec3 LocalMax;
+		glm::vec3 WorldMin;
+		glm::vec3 WorldMax;
+		glm::mat4 World; /**< World matrix the world bounds were computed from. */
+		glm::ivec3 CellMin; /**< First grid cell the world bounds overlap. */
+		glm::ivec3 CellMax; /**< Last grid cell the world bounds overlap. */
+		bool IsOversized = false; /**< The collider is in m_Oversized instead of the grid. */
+	};
+
+	/**
+	 * @brief Returns the grid cell of a world location.
+	 */
+	static glm::ivec3 GetCell(const glm::vec3& Location);
+
+	/**
+	 * @brief Packs grid cell coordinates into a hash key, 21 bits per axis.
+	 */
+	static uint64_t GetCellKey(int x, int y, int z);
+
+	/**
+	 * @brief Computes the world bounds and cell range of a collider from a world matrix.
+	 */
+	static void ComputeWorldBounds(Collider& Collider, const glm::mat4& World);
+
+	/**
+	 * @brief Removes a collider from the grid and frees its slot.
+	 */
+	void FreeCollider(uint32_t Id);
+
+	/**
+	 * @brief Lists a collider in the cells of its cell range, or as oversized.
+	 */
+	void InsertIntoCells(uint32_t Id);
+
+	/**
+	 * @brief Removes a collider from the cells of its cell range.
+	 */
+	void RemoveFromCells(uint32_t Id);
+
+	/**
+	 * @brief Collects the colliders of the cells overlapping a box into m_Candidates, each once.
+	 */
+	void GatherCandidates(const glm::vec3& Min, const glm::vec3& Max) const;
+
+	/**
+	 * @brief Sweeps a sphere against the gathered candidates.
+	 */
+	bool SweepCandidates(const SphereSweep& Sweep, CollisionHit& Hit) const;
+
+	std::vector<Collider> m_Colliders; /**< Colliders by id, including free slots. */
+	std::vector<uint32_t> m_FreeColliders; /**< Ids of the free slots. */
+	std::vector<uint32_t> m_EntityColliders; /**< Collider id by entity slot, ENTITY_INVALID_INDEX if the entity has none. */
+	std::unordered_map<uint64_t, std::vector<uint32_t>> m_Cells; /**< Collider ids of the non empty cells by cell key. */
+	std::vector<uint32_t> m_Oversized; /**< Ids of the colliders spanning more than COLLISION_MAX_CELLS_PER_COLLIDER cells. */
+	size_t m_RebinnedCount = 0;
+	mutable std::vector<uint32_t> m_Candidates; /**< Colliders gathered by the running query. */
+	mutable std::vector<uint32_t> m_QueryMarks; /**< Query counter value which last gathered each collider. */
+	mutable uint32_t m_QueryCounter = 0;
+};
@@ -2,12 +2,13 @@
 
 bool Config::GetVariableByName(const std::string& Name, std::string & Variable) const
 {
-    if (m_Variables.count ( Name ) == 0 )
+    const auto Found = m_Variables.find(Name);
+    if (Found == m_Variables.end())
     {
         std::cerr << "Config :: GetVariableByName () => can't get variable with given name : " + Name << std::endl; // TODO:: consider deleting
         return false;
     }
-    Variable = m_Variables . at ( Name );
+    Variable = Found->second;
     return true; 
 }
 
@@ -30,6 +31,11 @@ bool Config::GetVariableAsString(const std::string& Name, std::string & Variable
 
 }
 
+bool Config::HasVariable(const std::string& Name) const
+{
+    return m_Variables.count(Name) != 0;
+}
+
 bool Config::LoadConfigFromFile(const std::string& filename)
 {
     std::fstream f(filename); 
@@ -8,6 +8,8 @@
 
 #define CONFIG_EMPTY_VARIABLE std::string("")
 class Application; 
+class MicroBenchmarkAccess; 
+class Settings;
 /**
  * @brief A class representing configuration settings.
  *
@@ -33,6 +35,13 @@ public:
 	 */
 	bool GetVariableAsString(const std::string& Name, std::string& Variable) const;
 
+	/**
+	 * @brief Checks if a configuration variable is present.
+	 * @param Name The name of the configuration variable.
+	 * @return True if the variable was found, false otherwise.
+	 */
+	bool HasVariable(const std::string& Name) const;
+
 private:
 	/**
 	 * @brief Loads the configuration settings from a file.
@@ -52,4 +61,6 @@ private:
 	std::map<std::string, std::string> m_Variables; /**< The map storing the configuration variables. */
 
 	friend Application;
+	friend MicroBenchmarkAccess;
+	friend Settings;
 };
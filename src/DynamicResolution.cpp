@@ -0,0 +1,143 @@
+#include "DynamicResolution.h"
+#include <algorithm>
+#include <cmath>
+
+DynamicResolution::~DynamicResolution()
+{
+	DeleteTarget();
+}
+
+void DynamicResolution::SetSettings(const DynamicResolutionSettings& Settings)
+{
+	m_Settings = Settings;
+	m_Settings.MaxScale = glm::clamp(m_Settings.MaxScale, 0.1f, 1.f);
+	m_Settings.MinScale = glm::clamp(m_Settings.MinScale, 0.1f, m_Settings.MaxScale);
+	m_Scale = m_Settings.MaxScale;
+	m_FilteredGpuMs = 0.0;
+	m_FramesSinceAdjust = 0;
+}
+
+void DynamicResolution::BeginScene()
+{
+	m_Timer.Begin();
+	m_IsRendering = false;
+	if (!m_Settings.Enabled)
+		return;
+
+	glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &m_OutputFramebuffer);
+	glGetIntegerv(GL_VIEWPORT, m_OutputViewport);
+	const GLsizei Width = m_OutputViewport[2];
+	const GLsizei Height = m_OutputViewport[3];
+	if ((Width != m_Width || Height != m_Height) && !CreateTarget(Width, Height))
+		return;
+
+	m_RenderedScale = m_Scale;
+	glBindFramebuffer(GL_FRAMEBUFFER, m_Framebuffer);
+	glViewport(0, 0, std::max((GLsizei)(Width * m_Scale), 1), std::max((GLsizei)(Height * m_Scale), 1));
+	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT | GL_STENCIL_BUFFER_BIT);
+	m_IsRendering = true;
+}
+
+void DynamicResolution::EndScene()
+{
+	if (m_IsRendering)
+	{
+		GLint Viewport[4];
+		glGetIntegerv(GL_VIEWPORT, Viewport);
+		glBindFramebuffer(GL_READ_FRAMEBUFFER, m_Framebuffer);
+		glBindFramebuffer(GL_DRAW_FRAMEBUFFER, m_OutputFramebuffer);
+		glBlitFramebuffer(0, 0, Viewport[2], Viewport[3], m_OutputViewport[0], m_OutputViewport[1],
+			m_OutputViewport[0] + m_OutputViewport[2], m_OutputViewport[1] + m_OutputViewport[3], GL_COLOR_BUFFER_BIT, GL_LINEAR);
+		glBindFramebuffer(GL_FRAMEBUFFER, m_OutputFramebuffer);
+		glViewport(m_OutputViewport[0], m_OutputViewport[1], m_OutputViewport[2], m_OutputViewport[3]);
+		m_IsRendering = false;
+	}
+	m_Timer.End();
+	if (m_Settings.Enabled)
+		AdjustScale();
+	CHECK_GL_ERROR();
+}
+
+GLubyte DynamicResolution::ReadStencil(const glm::vec2& Position) const
+{
+	GLubyte Stencil = 0;
+	if (!m_Settings.Enabled || !m_Framebuffer)
+	{
+		glReadPixels((int)Position.x, (int)Position.y, 1, 1, GL_STENCIL_INDEX, GL_UNSIGNED_BYTE, &Stencil);
+		return Stencil;
+	}
+	GLint ReadFramebuffer = 0;
+	glGetIntegerv(GL_READ_FRAMEBUFFER_BINDING, &ReadFramebuffer);
+	glBindFramebuffer(GL_READ_FRAMEBUFFER, m_Framebuffer);
+	const int X = (int)((Position.x - m_OutputViewport[0]) * m_RenderedScale);
+	const int Y = (int)((Position.y - m_OutputViewport[1]) * m_RenderedScale);
+	glReadPixels(X, Y, 1, 1, GL_STENCIL_INDEX, GL_UNSIGNED_BYTE, &Stencil);
+	glBindFramebuffer(GL_READ_FRAMEBUFFER, ReadFramebuffer);
+	return Stencil;
+}
+
+bool DynamicResolution::CreateTarget(GLsizei Width, GLsizei Height)
+{
+	DeleteTarget();
+	glGenFramebuffers(1, &m_Framebuffer);
+	glGenRenderbuffers(1, &m_ColorBuffer);
+	glGenRenderbuffers(1, &m_DepthStencilBuffer);
+
+	glBindRenderbuffer(GL_RENDERBUFFER, m_ColorBuffer);
+	glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, Width, Height);
+	glBindRenderbuffer(GL_RENDERBUFFER, m_DepthStencilBuffer);
+	glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH24_STENCIL8, Width, Height);
+	glBindRenderbuffer(GL_RENDERBUFFER, 0);
+
+	glBindFramebuffer(GL_FRAMEBUFFER, m_Framebuffer);
+	glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, m_ColorBuffer);
+	glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER, m_DepthStencilBuffer);
+	const bool IsComplete = glCheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE;
+	glBindFramebuffer(GL_FRAMEBUFFER, m_OutputFramebuffer);
+	if (!IsComplete)
+	{
+		std::cerr << "DynamicResolution::CreateTarget() => Framebuffer is not complete, rendering at full resolution" << std::endl;
+		DeleteTarget();
+		m_Settings.Enabled = false;
+		return false;
+	}
+	m_Width = Width;
+	m_Height = Height;
+	return true;
+}
+
+void DynamicResolution::DeleteTarget()
+{
+	if (m_Framebuffer)
+		glDeleteFramebuffers(1, &m_Framebuffer);
+	if (m_ColorBuffer)
+		glDeleteRenderbuffers(1, &m_ColorBuffer);
+	if (m_DepthStencilBuffer)
+		glDeleteRenderbuffers(1, &m_DepthStencilBuffer);
+	m_Framebuffer = m_ColorBuffer = m_DepthStencilBuffer = 0;
+	m_Width = m_Height = 0;
+}
+
+void DynamicResolution::AdjustScale()
+{
+	const double GpuMs = m_Timer.GetLastTimeMs();
+	if (GpuMs <= 0.0)
+		return;
+	m_FilteredGpuMs = m_FilteredGpuMs > 0.0 ? m_FilteredGpuMs + (GpuMs - m_FilteredGpuMs) * DYNAMIC_RESOLUTION_SMOOTHING : GpuMs;
+	if (++m_FramesSinceAdjust < DYNAMIC_RESOLUTION_ADJUST_FRAMES)
+		return;
+
+	// between the headroom and the target the scale is kept, so it does not oscillate around the target
+	const double Target = m_Settings.TargetGpuMs;
+	if (m_FilteredGpuMs <= Target && m_FilteredGpuMs >= Target * (1.0 - DYNAMIC_RESOLUTION_HEADROOM))
+		return;
+	// the GPU time is assumed to follow the pixel count, the square of the scale, aim for the middle of the band
+	const double Desired = m_Scale * std::sqrt(Target * (1.0 - DYNAMIC_RESOLUTION_HEADROOM * 0.5) / m_FilteredGpuMs);
+	const float Step = glm::clamp((float)Desired - m_Scale, -DYNAMIC_RESOLUTION_MAX_STEP, DYNAMIC_RESOLUTION_MAX_STEP);
+	const float Scale = glm::clamp(m_Scale + Step, m_Settings.MinScale, m_Settings.MaxScale);
+	if (Scale != m_Scale)
+	{
+		m_Scale = Scale;
+		m_FramesSinceAdjust = 0;
+	}
+}
@@ -0,0 +1,106 @@
+#pragma once
+#include "pgr.h"
+#include "GpuTimer.h"
+#include <iostream>
+
+#define DYNAMIC_RESOLUTION_DEFAULT_ENABLED 0
+#define DYNAMIC_RESOLUTION_DEFAULT_TARGET_MS 16 // GPU time of the scene the scale is adjusted to hold
+#define DYNAMIC_RESOLUTION_DEFAULT_MIN_SCALE_PERCENT 50
+#define DYNAMIC_RESOLUTION_MAX_STEP 0.05f // largest change of the scale per adjustment
+#define DYNAMIC_RESOLUTION_HEADROOM 0.1f // fraction of the target below which the scale grows again
+#define DYNAMIC_RESOLUTION_SMOOTHING 0.2f // weight of the newest GPU time in the filtered time
+#define DYNAMIC_RESOLUTION_ADJUST_FRAMES (GPU_TIMER_QUERIES + 1) // frames between adjustments, measurements lag the scale by up to GPU_TIMER_QUERIES frames
+
+/**
+ * @brief Parameters of the dynamic resolution.
+ */
+struct DynamicResolutionSettings
+{
+	bool Enabled = DYNAMIC_RESOLUTION_DEFAULT_ENABLED; /**< Renders the scene offscreen at an adaptive scale. */
+	float TargetGpuMs = DYNAMIC_RESOLUTION_DEFAULT_TARGET_MS; /**< GPU time of the scene to hold in milliseconds. */
+	float MinScale = DYNAMIC_RESOLUTION_DEFAULT_MIN_SCALE_PERCENT * 0.01f; /**< Smallest scale of the width and height. */
+	float MaxScale = 1.f; /**< Largest scale of the width and height. */
+};
+
+/**
+ * @brief Renders the scene into an offscreen target at a fraction of the output size and upscales it.
+ *
+ * The target is allocated at the full output size and the scene renders into its lower left part, so a scale
+ * change costs no reallocation. The GPU time of the scene is measured every frame with GL_TIMESTAMP queries, which
+ * may enclose the GL_TIME_ELAPSED timers of the passes. Every few frames the scale moves toward the size expected to
+ * meet the target, assuming the GPU time follows the pixel count. Whatever is drawn after EndScene, like a user
+ * interface, renders at the native resolution.
+ */
+class DynamicResolution
+{
+public:
+	DynamicResolution() = default;
+	~DynamicResolution();
+	DynamicResolution(const DynamicResolution&) = delete;
+	DynamicResolution& operator=(const DynamicResolution&) = delete;
+
+	/**
+	 * @brief Sets the parameters. Takes effect with the next frame.
+	 */
+	void SetSettings(const DynamicResolutionSettings& Settings);
+
+	/**
+	 * @brief Starts the scene of a frame. When enabled, binds and clears the target and sets the scaled viewport.
+	 * The framebuffer and viewport bound before are the output.
+	 */
+	void BeginScene();
+
+	/**
+	 * @brief Ends the scene of a frame, upscales the target into the output and adjusts the scale.
+	 */
+	void EndScene();
+
+	/**
+	 * @brief Reads the stencil value the last frame wrote under a window position.
+	 *
+	 * @param Position The position in output pixels with the origin in the lower left corner.
+	 * @return The stencil value.
+	 */
+	GLubyte ReadStencil(const glm::vec2& Position) const;
+
+	/**
+	 * @brief Returns the scale of the width and height the next frame renders at.
+	 */
+	float GetScale() const { return m_Settings.Enabled ? m_Scale : 1.f; }
+
+	/**
+	 * @brief Returns the GPU time of the scene measured a few frames earlier in milliseconds.
+	 */
+	double GetGpuTimeMs() const { return m_Timer.GetLastTimeMs(); }
+
+private:
+	/**
+	 * @brief Creates the target at the output size.
+	 */
+	bool CreateTarget(GLsizei Width, GLsizei Height);
+
+	/**
+	 * @brief Deletes the target.
+	 */
+	void DeleteTarget();
+
+	/**
+	 * @brief Moves the scale toward the size expected to meet the target GPU time.
+	 */
+	void AdjustScale();
+
+	DynamicResolutionSettings m_Settings;
+	GpuTimer m_Timer{ true }; /**< GPU time of the scene, timestamps because the passes use their own timers. */
+	GLuint m_Framebuffer = 0;
+	GLuint m_ColorBuffer = 0;
+	GLuint m_DepthStencilBuffer = 0;
+	GLsizei m_Width = 0; /**< Width of the target. */
+	GLsizei m_Height = 0; /**< Height of the target. */
+	GLint m_OutputFramebuffer = 0; /**< Framebuffer bound when the scene began. */
+	GLint m_OutputViewport[4] = {}; /**< Viewport set when the scene began. */
+	bool m_IsRendering = false; /**< Flag indicating the current scene renders into the target. */
+	float m_Scale = 1.f; /**< Scale of the next frame. */
+	float m_RenderedScale = 1.f; /**< Scale of the last frame, ReadStencil maps positions with it. */
+	double m_FilteredGpuMs = 0.0; /**< Exponentially smoothed GPU time of the scene. */
+	int m_FramesSinceAdjust = 0;
+};
@@ -1,4 +1,6 @@
 #include "Eagle.h"
+#include "GLStateCache.h"
+#include <algorithm>
 
 void Eagle::Update(float dt)
 {
@@ -17,7 +19,8 @@ void Eagle::Update(float dt)
 	SetWorldLocation(newPosition);
 
 
-	float currentTime = (float)glutGet(GLUT_ELAPSED_TIME) * 0.001f; 
+	AnimationTime += dt; 
+	float currentTime = AnimationTime; 
 	float elapsedTime = currentTime - FrameStartTime; 
 	if (elapsedTime >= FrameLength)
 	{
@@ -47,10 +50,11 @@ bool Eagle::LoadFromFile(const std::string& baseName, const std::vector<std::str
 	SetName("Eagle"); 
 	Transform EagleTransform = { {0.f, 5.f, 0.f}, {0.f, 0.f, 0.f}, {0.2f, 0.2f, 0.2f } };
 	SetWorldTransform(EagleTransform);
+	// the frames are only read on the CPU, the animation buffer below holds all of them
 	for (auto& suff : suffixes)
 	{
 		std::shared_ptr <Mesh> frameMesh = std::make_shared<Mesh>();
-		if (!frameMesh->LoadFromFile(baseName + suff))
+		if (!frameMesh->LoadDataFromFile(baseName + suff) || frameMesh->GetMeshGeometry().empty())
 		{
 			std::cerr << "Eagle::LoadFromFile() Error => can't load animation frame with given path: " << baseName + suff << std::endl; 
 			return false;
@@ -67,33 +71,27 @@ bool Eagle::LoadFromFile(const std::string& baseName, const std::vector<std::str
 		std::cerr << "Eagle::LoadFromFile Error => invalid mesh" << std::endl; 
 		return false;
 	}
-	m_EagleTextures = m_Meshes.begin()->get()->GetMeshGeometry().begin()->GetTextureData();
-	nOfVertices = m_Meshes.begin()->get()->GetMeshGeometry().begin()->GetVerticisData().size();
-	std::vector <unsigned int> Indicis = m_Meshes.begin()->get()->GetMeshGeometry().begin()->GetIndicisData();
+	const MeshGeometry& FirstFrame = *m_Meshes.begin()->get()->GetMeshGeometry().begin();
+	nOfVertices = FirstFrame.GetVerticisData().size();
+	ConstSpan<unsigned int> Indicis = FirstFrame.GetIndicisData();
 	nOfFaces = Indicis.size();
-	std::vector <Vertex> Verticis; 
-
-
-	for (auto Mesh : m_Meshes)
-	{
-		if (Mesh)
-		{
-			auto VertexData = Mesh->GetMeshGeometry().begin()->GetVerticisData();
-			Verticis.insert( Verticis.end(), VertexData.begin(), VertexData.end() ); 
-		}
-	}
 
 	glGenVertexArrays(1, &m_EagleVAO);
 	glGenBuffers(1, &m_EagleEBO);
 	glGenBuffers(1, &m_EagleVBO);
-	glBindVertexArray(m_EagleVAO);
+	GLStateCache::BindVertexArray(m_EagleVAO);
 	
 	
-	glBindBuffer(GL_ARRAY_BUFFER, m_EagleVBO);
-	glBufferData(GL_ARRAY_BUFFER, Verticis.size() * sizeof ( Vertex ), &Verticis[0], GL_STATIC_DRAW);
+	GLStateCache::BindBuffer(GL_ARRAY_BUFFER, m_EagleVBO);
+	glBufferData(GL_ARRAY_BUFFER, m_Meshes.size() * nOfVertices * sizeof ( Vertex ), nullptr, GL_STATIC_DRAW);
+	for (size_t Frame = 0; Frame < m_Meshes.size(); Frame++)
+	{
+		ConstSpan<Vertex> VertexData = m_Meshes[Frame]->GetMeshGeometry().begin()->GetVerticisData();
+		glBufferSubData(GL_ARRAY_BUFFER, Frame * nOfVertices * sizeof(Vertex), std::min<size_t>(VertexData.size(), nOfVertices) * sizeof(Vertex), VertexData.begin());
+	}
 	// generate and initialize the element buffer object -> variable resources.ebo
 	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_EagleEBO);
-	glBufferData(GL_ELEMENT_ARRAY_BUFFER, Indicis.size() * sizeof ( unsigned int ), &Indicis[0], GL_STATIC_DRAW);
+	glBufferData(GL_ELEMENT_ARRAY_BUFFER, Indicis.size() * sizeof ( unsigned int ), Indicis.begin(), GL_STATIC_DRAW);
 	// enable and initialize the position attribute array
 	
 	glEnableVertexAttribArray(0);
@@ -116,6 +114,13 @@ bool Eagle::LoadFromFile(const std::string& baseName, const std::vector<std::str
 	glBindBuffer(GL_ARRAY_BUFFER, 0);
 	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);*/
 	CHECK_GL_ERROR(); 
+
+	// only the textures of the first frame are used, the vertices of all frames live in the eagle buffer
+	m_Meshes.begin()->get()->UploadTexturesOnly();
+	ConstSpan<Texture> Textures = m_Meshes.begin()->get()->GetMeshGeometry().begin()->GetTextureData();
+	m_EagleTextures.assign(Textures.begin(), Textures.end());
+	for (size_t Frame = 1; Frame < m_Meshes.size(); Frame++)
+		m_Meshes[Frame]->Unload();
 		
 	return true;
 }
@@ -138,10 +143,9 @@ void Eagle::Render(const Shader& shader)
 	//std::cout << "Current Frame:" << CurrentAnimationFrame << std::endl; 
 	//std::cout << "Next Frame:" << NextAnimationFrame << std::endl; 
 	//std::cout << "Animation Alpha: " << CurrentAnimationAlpha << std::endl; 
-	shader.SetFloatParameter("AnimationAlpha", CurrentAnimationAlpha);
 
 	// update animation geometry
-	glBindVertexArray(m_EagleVAO);
+	GLStateCache::BindVertexArray(m_EagleVAO);
 	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)(CurrentAnimationFrame * sizeof(Vertex) * nOfVertices + 0) );
 	glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)(NextAnimationFrame * sizeof(Vertex) * nOfVertices + 0));
 	glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)(offsetof(Vertex, TextureCoords)));
@@ -156,16 +160,18 @@ void Eagle::Render(const Shader& shader)
 	
 
 	// bind texture
-	glActiveTexture(GL_TEXTURE0);
-	CHECK_GL_ERROR();
 	shader.SetIntParameter("texture_diffuse1", 0);
-	glBindTexture(GL_TEXTURE_2D, m_EagleTextures.begin()->Id);
+	shader.SetIntParameter("textureLayer", m_EagleTextures.begin()->Layer);
+	GLStateCache::BindTexture(0, GL_TEXTURE_2D_ARRAY, m_EagleTextures.begin()->Id);
 	CHECK_GL_ERROR();
 
 	// draw
 	glDrawElements(GL_TRIANGLES, nOfFaces, GL_UNSIGNED_INT, (void*)0);
-
-	// unbind texture
-	glBindTexture(GL_TEXTURE_2D, 0);
+	MeshGeometry::CountDrawCall(nOfFaces / 3, 1);
 	CHECK_GL_ERROR();
-}
\ No newline at end of file
+}
+
+bool Eagle::GetLocalBounds(glm::vec3& Min, glm::vec3& Max) const
+{
+	return !m_Meshes.empty() && m_Meshes.front()->GetBounds(Min, Max);
+}
@@ -42,6 +42,11 @@ public:
      */
     void Render(const Shader& shader) override;
 
+    /**
+     * @brief Returns the bounds of the first animation frame, the only frame kept on the CPU after the upload.
+     */
+    bool GetLocalBounds(glm::vec3& Min, glm::vec3& Max) const override;
+
     /**
      * @brief Loads the Eagle object from file with the specified base name and suffixes.
      * @param baseName The base name of the file.
@@ -50,12 +55,18 @@ public:
      */
     bool LoadFromFile(const std::string& baseName, const std::vector<std::string>& suffixes);
 
+    /**
+     * @brief Returns the blend factor between the current and the next animation frame.
+     */
+    float GetAnimationAlpha() const { return CurrentAnimationAlpha; }
+
 private:
     size_t CurrentAnimationFrame = 0; /**< The index of the current animation frame. */
     size_t NextAnimationFrame = 1; /**< The index of the next animation frame. */
-    float CurrentAnimationAlpha; /**< The alpha value for blending between animation frames. */
+    float CurrentAnimationAlpha = 0.f; /**< The alpha value for blending between animation frames. */
     float FrameLength = 0.3f; /**< The length of each animation frame. */
     float FrameStartTime = 0.f; /**< The start time of the current frame. */
+    float AnimationTime = 0.f; /**< Animation clock advanced by Update, so fixed-dt runs animate deterministically. */
     std::vector<std::shared_ptr<Mesh>> m_Meshes; /**< The vector of Mesh objects representing different parts of the Eagle. */
     size_t nOfFaces; /**< The number of faces in the Eagle mesh. */
     size_t nOfVertices; /**< The number of vertices in the Eagle mesh. */
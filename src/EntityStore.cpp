@@ -0,0 +1,124 @@
+#include "EntityStore.h"
+
+EntityStore& EntityStore::Get()
+{
+	static EntityStore* Store = new EntityStore();
+	return *Store;
+}
+
+EntityHandle EntityStore::Create(const Transform& Local)
+{
+	EntityHandle Entity;
+	if (!m_FreeSlots.empty())
+	{
+		Entity.Index = m_FreeSlots.back();
+		m_FreeSlots.pop_back();
+	}
+	else
+	{
+		Entity.Index = (uint32_t)m_Generations.size();
+		m_Generations.push_back(0);
+	}
+	Entity.Generation = m_Generations[Entity.Index];
+	TransformComponent Component;
+	Component.Local = Local;
+	m_Transforms.Add(Entity.Index, Component);
+	return Entity;
+}
+
+void EntityStore::Destroy(EntityHandle Entity)
+{
+	if (!GetIsAlive(Entity))
+		return;
+	m_Transforms.Remove(Entity.Index);
+	m_Renders.Remove(Entity.Index);
+	m_Pickables.Remove(Entity.Index);
+	m_Generations[Entity.Index]++;
+	m_FreeSlots.push_back(Entity.Index);
+}
+
+bool EntityStore::GetIsAlive(EntityHandle Entity) const
+{
+	return Entity.Index < m_Generations.size() && m_Generations[Entity.Index] == Entity.Generation;
+}
+
+TransformComponent* EntityStore::GetTransform(EntityHandle Entity)
+{
+	return GetIsAlive(Entity) ? m_Transforms.Get(Entity.Index) : nullptr;
+}
+
+const TransformComponent* EntityStore::GetTransform(EntityHandle Entity) const
+{
+	return GetIsAlive(Entity) ? m_Transforms.Get(Entity.Index) : nullptr;
+}
+
+EntityHandle EntityStore::GetParent(EntityHandle Entity) const
+{
+	const TransformComponent* Component = GetTransform(Entity);
+	return Component && GetIsAlive(Component->Parent) ? Component->Parent : EntityHandle();
+}
+
+Transform EntityStore::GetWorldTransform(EntityHandle Entity) const
+{
+	const TransformComponent* Component = GetTransform(Entity);
+	if (!Component)
+		return Transform();
+	const EntityHandle Parent = GetParent(Entity);
+	return Parent.Index != ENTITY_INVALID_INDEX ? GetWorldTransform(Parent) * Component->Local : Component->Local;
+}
+
+glm::vec3 EntityStore::GetWorldLocation(EntityHandle Entity) const
+{
+	const TransformComponent* Component = GetTransform(Entity);
+	if (!Component)
+		return glm::vec3(0.f);
+	const EntityHandle Parent = GetParent(Entity);
+	return Parent.Index != ENTITY_INVALID_INDEX ? Component->Local.Location + GetWorldLocation(Parent) : Component->Local.Location;
+}
+
+glm::quat EntityStore::GetWorldRotation(EntityHandle Entity) const
+{
+	const TransformComponent* Component = GetTransform(Entity);
+	if (!Component)
+		return glm::quat();
+	const EntityHandle Parent = GetParent(Entity);
+	return Parent.Index != ENTITY_INVALID_INDEX ? GetWorldRotation(Parent) * Component->Local.Rotation : Component->Local.Rotation;
+}
+
+glm::mat4 EntityStore::GetWorldModelMatrix(EntityHandle Entity) const
+{
+	const TransformComponent* Component = GetTransform(Entity);
+	if (!Component)
+		return glm::mat4(1.f);
+	const EntityHandle Parent = GetParent(Entity);
+	return Parent.Index != ENTITY_INVALID_INDEX ? GetWorldModelMatrix(Parent) * Component->Local.ToMat4() : Component->Local.ToMat4();
+}
+
+void EntityStore::UpdateWorldMatrices()
+{
+	m_WorldPass++;
+	for (size_t Dense = 0; Dense < m_Transforms.size(); Dense++)
+		ResolveWorldMatrix(Dense);
+}
+
+const glm::mat4& EntityStore::ResolveWorldMatrix(size_t Dense)
+{
+	TransformComponent& Component = m_Transforms[Dense];
+	if (Component.WorldPass == m_WorldPass)
+		return Component.World;
+	// the pass is set before the parent is resolved, so a parent cycle ends instead of recursing forever
+	Component.WorldPass = m_WorldPass;
+	Component.World = Component.Local.ToMat4();
+	if (GetIsAlive(Component.Parent))
+	{
+		const TransformComponent* Parent = m_Transforms.Get(Component.Parent.Index);
+		Component.World = ResolveWorldMatrix(Parent - &m_Transforms[0]) * Component.World;
+	}
+	return Component.World;
+}
+
+size_t EntityStore::GetMemoryUsage() const
+{
+	return (m_Generations.capacity() + m_FreeSlots.capacity()) * sizeof(uint32_t) + m_Transforms.GetMemoryUsage()
+		+ m_Renders.GetMemoryUsage() + m_Pickables.GetMemoryUsage();
+}
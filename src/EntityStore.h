@@ -0,0 +1,220 @@
+#pragma once
+#include "pgr.h"
+#include "Misc.h"
+#include <vector>
+#include <cstdint>
+
+class Mesh;
+
+#define ENTITY_INVALID_INDEX UINT32_MAX
+
+#define RENDER_VISIBLE 1 // the entity is drawn
+#define RENDER_OWN_PASS 2 // the entity is drawn by a dedicated pass, the main pass skips it
+#define RENDER_WATER 4 // the entity gets the animated water texture transform
+
+/**
+ * @brief Generational handle of an entity. A handle of a destroyed entity stays invalid even when its slot is reused.
+ */
+struct EntityHandle
+{
+	uint32_t Index = ENTITY_INVALID_INDEX; /**< Slot of the entity. */
+	uint32_t Generation = 0; /**< Generation of the slot the handle was created in. */
+
+	bool operator==(const EntityHandle& Other) const { return Index == Other.Index && Generation == Other.Generation; }
+	bool operator!=(const EntityHandle& Other) const { return !(*this == Other); }
+};
+
+/**
+ * @brief Placement of an entity relative to its attach parent.
+ */
+struct TransformComponent
+{
+	Transform Local; /**< Transform relative to the parent, the world transform if there is none. */
+	EntityHandle Parent; /**< Attach parent, invalid or destroyed if the entity is in world space. */
+	glm::mat4 World = glm::mat4(1.f); /**< Model matrix computed by UpdateWorldMatrices. */
+	uint32_t WorldPass = 0; /**< Pass of UpdateWorldMatrices which computed World. */
+};
+
+/**
+ * @brief Data the main pass draws an entity with.
+ */
+struct RenderComponent
+{
+	Mesh* Geometry = nullptr; /**< Mesh of the entity, owned by its game object. */
+	uint16_t MaterialId = 0; /**< Material of the mesh. */
+	uint8_t Flags = RENDER_VISIBLE; /**< RENDER_* flags. */
+};
+
+/**
+ * @brief Entity the mouse can pick through the stencil buffer.
+ */
+struct PickableComponent
+{
+	uint8_t StencilId = 0; /**< Value written to the stencil buffer where the entity is drawn. */
+};
+
+/**
+ * @brief Components of one type packed densely, indexed by entity slot through a sparse table.
+ * Removal moves the last component into the hole, so iteration always runs over contiguous memory.
+ */
+template<typename T>
+class ComponentArray
+{
+public:
+	/**
+	 * @brief Adds or replaces the component of an entity.
+	 */
+	T& Add(uint32_t Entity, const T& Component)
+	{
+		if (Entity >= m_Sparse.size())
+			m_Sparse.resize(Entity + 1, ENTITY_INVALID_INDEX);
+		if (m_Sparse[Entity] != ENTITY_INVALID_INDEX)
+			return m_Data[m_Sparse[Entity]] = Component;
+		m_Sparse[Entity] = (uint32_t)m_Data.size();
+		m_Entities.push_back(Entity);
+		m_Data.push_back(Component);
+		return m_Data.back();
+	}
+
+	/**
+	 * @brief Removes the component of an entity if it has one.
+	 */
+	void Remove(uint32_t Entity)
+	{
+		if (!Has(Entity))
+			return;
+		const uint32_t Dense = m_Sparse[Entity];
+		m_Data[Dense] = m_Data.back();
+		m_Entities[Dense] = m_Entities.back();
+		m_Sparse[m_Entities[Dense]] = Dense;
+		m_Sparse[Entity] = ENTITY_INVALID_INDEX;
+		m_Data.pop_back();
+		m_Entities.pop_back();
+	}
+
+	bool Has(uint32_t Entity) const { return Entity < m_Sparse.size() && m_Sparse[Entity] != ENTITY_INVALID_INDEX; }
+	T* Get(uint32_t Entity) { return Has(Entity) ? &m_Data[m_Sparse[Entity]] : nullptr; }
+	const T* Get(uint32_t Entity) const { return Has(Entity) ? &m_Data[m_Sparse[Entity]] : nullptr; }
+
+	/**
+	 * @brief Returns the number of components.
+	 */
+	size_t size() const { return m_Data.size(); }
+	T& operator[](size_t Dense) { return m_Data[Dense]; }
+	const T& operator[](size_t Dense) const { return m_Data[Dense]; }
+
+	/**
+	 * @brief Returns the entity slot owning the component at a dense index.
+	 */
+	uint32_t GetEntity(size_t Dense) const { return m_Entities[Dense]; }
+
+	/**
+	 * @brief Returns the memory of the arrays in bytes.
+	 */
+	size_t GetMemoryUsage() const
+	{
+		return m_Data.capacity() * sizeof(T) + (m_Entities.capacity() + m_Sparse.capacity()) * sizeof(uint32_t);
+	}
+
+private:
+	std::vector<T> m_Data; /**< Packed components. */
+	std::vector<uint32_t> m_Entities; /**< Entity slot of every packed component. */
+	std::vector<uint32_t> m_Sparse; /**< Dense index of every entity slot, ENTITY_INVALID_INDEX if it has no component. */
+};
+
+/**
+ * @brief Entities with their components stored in dense per-component arrays.
+ *
+ * Scene objects keep a handle to their entity; their transform, attach parent and render state live here, so the
+ * per-frame passes over transforms and render data iterate contiguous memory instead of following object pointers.
+ * Attach parents are referenced by handle, a child of a destroyed parent falls back to world space.
+ */
+class EntityStore
+{
+public:
+	/**
+	 * @brief Returns the store of the scene objects. It is never destroyed, so objects with static lifetime can release their entities.
+	 */
+	static EntityStore& Get();
+
+	/**
+	 * @brief Creates an entity with a transform component.
+	 */
+	EntityHandle Create(const Transform& Local);
+
+	/**
+	 * @brief Removes an entity and its components. The handle and all its copies become invalid.
+	 */
+	void Destroy(EntityHandle Entity);
+
+	/**
+	 * @brief Checks if a handle refers to an existing entity.
+	 */
+	bool GetIsAlive(EntityHandle Entity) const;
+
+	/**
+	 * @brief Returns the transform of an entity, nullptr if it is destroyed.
+	 */
+	TransformComponent* GetTransform(EntityHandle Entity);
+	const TransformComponent* GetTransform(EntityHandle Entity) const;
+
+	/**
+	 * @brief Returns the attach parent of an entity, an invalid handle if it has none or the parent was destroyed.
+	 */
+	EntityHandle GetParent(EntityHandle Entity) const;
+
+	/**
+	 * @brief Returns the world transform of an entity, following its attach parents.
+	 */
+	Transform GetWorldTransform(EntityHandle Entity) const;
+
+	/**
+	 * @brief Returns the local location of an entity plus the world location of its parent, ignoring the parent rotation.
+	 */
+	glm::vec3 GetWorldLocation(EntityHandle Entity) const;
+
+	/**
+	 * @brief Returns the world rotation of an entity, following its attach parents.
+	 */
+	glm::quat GetWorldRotation(EntityHandle Entity) const;
+
+	/**
+	 * @brief Returns the model matrix of an entity, following its attach parents. Always up to date, unlike the cached World.
+	 */
+	glm::mat4 GetWorldModelMatrix(EntityHandle Entity) const;
+
+	/**
+	 * @brief Recomputes the cached world matrices of all transforms, every parent once.
+	 */
+	void UpdateWorldMatrices();
+
+	ComponentArray<TransformComponent>& GetTransforms() { return m_Transforms; }
+	ComponentArray<RenderComponent>& GetRenders() { return m_Renders; }
+	ComponentArray<PickableComponent>& GetPickables() { return m_Pickables; }
+	const ComponentArray<TransformComponent>& GetTransforms() const { return m_Transforms; }
+	const ComponentArray<RenderComponent>& GetRenders() const { return m_Renders; }
+	const ComponentArray<PickableComponent>& GetPickables() const { return m_Pickables; }
+
+	/**
+	 * @brief Returns the number of existing entities.
+	 */
+	size_t GetEntityCount() const { return m_Generations.size() - m_FreeSlots.size(); }
+
+	/**
+	 * @brief Returns the memory of the slots and component arrays in bytes.
+	 */
+	size_t GetMemoryUsage() const;
+
+private:
+	/**
+	 * @brief Returns the world matrix of a dense transform, computing its parents first.
+	 */
+	const glm::mat4& ResolveWorldMatrix(size_t Dense);
+
+	std::vector<uint32_t> m_Generations; /**< Current generation of every slot. */
+	std::vector<uint32_t> m_FreeSlots; /**< Slots of destroyed entities. */
+	ComponentArray<TransformComponent> m_Transforms;
+	ComponentArray<RenderComponent> m_Renders;
+	ComponentArray<PickableComponent> m_Pickables;
+	uint32_t m_WorldPass = 0; /**< Counter of UpdateWorldMatrices calls. */
+};
@@ -0,0 +1,124 @@
+#include "FrameAllocator.h"
+#include <algorithm>
+#include <cstdlib>
+#include <new>
+
+LinearAllocator FrameAllocator::s_Allocator(FRAME_ALLOCATOR_CHUNK_BYTES);
+size_t FrameAllocator::s_HeapAllocationsAtReset = 0;
+thread_local ScopedArena* ScopedArena::s_Current = nullptr;
+
+namespace
+{
+	thread_local size_t t_HeapAllocations = 0;
+}
+
+#if FRAME_ALLOCATOR_COUNT_HEAP_ALLOCATIONS
+// the array and nothrow forms call these
+void* operator new(std::size_t Size)
+{
+	t_HeapAllocations++;
+	// like the standard operator, the new handler gets to free memory until it gives up
+	while (true)
+	{
+		if (void* Pointer = std::malloc(Size ? Size : 1))
+			return Pointer;
+		std::new_handler Handler = std::get_new_handler();
+		if (!Handler)
+			throw std::bad_alloc();
+		Handler();
+	}
+}
+
+void operator delete(void* Pointer) noexcept
+{
+	std::free(Pointer);
+}
+
+void operator delete(void* Pointer, std::size_t) noexcept
+{
+	std::free(Pointer);
+}
+#endif
+
+LinearAllocator::LinearAllocator(size_t ChunkBytes)
+	: m_ChunkBytes(ChunkBytes)
+{
+}
+
+void* LinearAllocator::Allocate(size_t Bytes, size_t Alignment)
+{
+	while (m_ChunkIndex < m_Chunks.size())
+	{
+		Chunk& chunk = m_Chunks[m_ChunkIndex];
+		const size_t Address = reinterpret_cast<size_t>(chunk.Data.get()) + m_Offset;
+		const size_t Padding = (Alignment - Address % Alignment) % Alignment;
+		if (m_Offset + Padding + Bytes <= chunk.Size)
+		{
+			void* Pointer = chunk.Data.get() + m_Offset + Padding;
+			m_Offset += Padding + Bytes;
+			m_UsedBytes += Padding + Bytes;
+			return Pointer;
+		}
+		m_UsedBytes += chunk.Size - m_Offset;
+		m_ChunkIndex++;
+		m_Offset = 0;
+	}
+
+	// new chunks are allocated with operator new[], aligned for any fundamental type
+	Chunk chunk;
+	chunk.Size = std::max(m_ChunkBytes, Bytes + Alignment);
+	chunk.Data.reset(new char[chunk.Size]);
+	m_Chunks.push_back(std::move(chunk));
+	return Allocate(Bytes, Alignment);
+}
+
+void LinearAllocator::Reset()
+{
+	if (m_Chunks.size() > 1)
+	{
+		const size_t Capacity = GetCapacity();
+		m_Chunks.clear();
+		Chunk chunk;
+		chunk.Size = Capacity;
+		chunk.Data.reset(new char[chunk.Size]);
+		m_Chunks.push_back(std::move(chunk));
+	}
+	m_ChunkIndex = 0;
+	m_Offset = 0;
+	m_UsedBytes = 0;
+}
+
+size_t LinearAllocator::GetCapacity() const
+{
+	size_t Capacity = 0;
+	for (const Chunk& chunk : m_Chunks)
+		Capacity += chunk.Size;
+	return Capacity;
+}
+
+void FrameAllocator::Reset()
+{
+	s_Allocator.Reset();
+	s_HeapAllocationsAtReset = t_HeapAllocations;
+}
+
+size_t FrameAllocator::GetHeapAllocations()
+{
+	return t_HeapAllocations - s_HeapAllocationsAtReset;
+}
+
+ScopedArena::ScopedArena(size_t ChunkBytes)
+	: m_Allocator(ChunkBytes), m_Previous(s_Current)
+{
+	s_Current = this;
+}
+
+ScopedArena::~ScopedArena()
+{
+	s_Current = m_Previous;
+}
+
+LinearAllocator* ScopedArena::GetCurrent()
+{
+	return s_Current ? &s_Current->m_Allocator : nullptr;
+}
@@ -0,0 +1,172 @@
+#pragma once
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+#define FRAME_ALLOCATOR_CHUNK_BYTES (1 << 20) // initial capacity of the frame allocator
+#define LOAD_ARENA_CHUNK_BYTES (4 << 20) // capacity added by a load arena whenever it runs out
+#ifndef FRAME_ALLOCATOR_COUNT_HEAP_ALLOCATIONS
+#define FRAME_ALLOCATOR_COUNT_HEAP_ALLOCATIONS 0 // 1 replaces the global operator new to count heap allocations per thread, defined by the debug builds
+#endif
+
+/**
+ * @brief Bump allocator handing out memory from large chunks. Single allocations are never freed, Reset releases all of them at once.
+ *
+ * When a chunk runs out a new one is appended. Reset merges the chunks into one chunk of their total size,
+ * so an allocator reset every frame stops touching the heap once it has seen its largest frame.
+ */
+class LinearAllocator
+{
+public:
+	explicit LinearAllocator(size_t ChunkBytes);
+	LinearAllocator(const LinearAllocator&) = delete;
+	LinearAllocator& operator=(const LinearAllocator&) = delete;
+
+	/**
+	 * @brief Allocates uninitialized memory.
+	 *
+	 * @param Bytes The size of the allocation.
+	 * @param Alignment The alignment of the allocation, a power of two.
+	 * @return The allocated memory, valid until the next Reset.
+	 */
+	void* Allocate(size_t Bytes, size_t Alignment);
+
+	/**
+	 * @brief Releases all allocations.
+	 */
+	void Reset();
+
+	/**
+	 * @brief Returns the bytes allocated since the last reset, including alignment padding.
+	 */
+	size_t GetUsedBytes() const { return m_UsedBytes; }
+
+	/**
+	 * @brief Returns the total size of the chunks in bytes.
+	 */
+	size_t GetCapacity() const;
+
+private:
+	struct Chunk
+	{
+		std::unique_ptr<char[]> Data;
+		size_t Size = 0;
+	};
+
+	std::vector<Chunk> m_Chunks; /**< Chunks in allocation order. */
+	size_t m_ChunkIndex = 0; /**< Chunk the next allocation is taken from. */
+	size_t m_Offset = 0; /**< Offset of the free memory in the current chunk. */
+	size_t m_UsedBytes = 0; /**< Bytes allocated since the last reset. */
+	size_t m_ChunkBytes = 0; /**< Minimal size of an appended chunk. */
+};
+
+/**
+ * @brief Standard allocator taking its memory from a LinearAllocator, so standard containers can opt in.
+ * Deallocation is a no-op, the memory is released with the allocator. Without an allocator it falls back to the heap.
+ */
+template<typename T>
+class LinearAllocatorAdapter
+{
+public:
+	using value_type = T;
+
+	LinearAllocatorAdapter(LinearAllocator* Allocator = nullptr) noexcept : m_Allocator(Allocator) {}
+	template<typename U>
+	LinearAllocatorAdapter(const LinearAllocatorAdapter<U>& Other) noexcept : m_Allocator(Other.GetAllocator()) {}
+
+	T* allocate(size_t Count)
+	{
+		if (!m_Allocator)
+			return static_cast<T*>(::operator new(Count * sizeof(T)));
+		return static_cast<T*>(m_Allocator->Allocate(Count * sizeof(T), alignof(T)));
+	}
+
+	void deallocate(T* Pointer, size_t) noexcept
+	{
+		if (!m_Allocator)
+			::operator delete(Pointer);
+	}
+
+	LinearAllocator* GetAllocator() const noexcept { return m_Allocator; }
+
+	template<typename U>
+	bool operator==(const LinearAllocatorAdapter<U>& Other) const noexcept { return m_Allocator == Other.GetAllocator(); }
+	template<typename U>
+	bool operator!=(const LinearAllocatorAdapter<U>& Other) const noexcept { return m_Allocator != Other.GetAllocator(); }
+
+private:
+	LinearAllocator* m_Allocator; /**< Source of the memory, nullptr for the heap. */
+};
+
+/**
+ * @brief Vector whose memory comes from a LinearAllocator.
+ */
+template<typename T>
+using LinearVector = std::vector<T, LinearAllocatorAdapter<T>>;
+
+/**
+ * @brief Per frame scratch memory of the main thread, reset at the end of every rendered frame.
+ *
+ * Temporaries living within the update and render of one frame take their memory from here instead of the heap.
+ * The heap allocations of the main thread are counted between resets to verify the frame stays off the heap.
+ */
+class FrameAllocator
+{
+public:
+	/**
+	 * @brief Returns the frame allocator.
+	 */
+	static LinearAllocator& Get() { return s_Allocator; }
+
+	/**
+	 * @brief Returns an adapter for standard containers using the frame allocator.
+	 */
+	template<typename T>
+	static LinearAllocatorAdapter<T> GetAdapter() { return LinearAllocatorAdapter<T>(&s_Allocator); }
+
+	/**
+	 * @brief Releases the memory of the frame and restarts the heap allocation count.
+	 */
+	static void Reset();
+
+	/**
+	 * @brief Returns the heap allocations of the main thread since the last Reset, 0 if they are not counted.
+	 * Must be called on the thread calling Reset, allocations of other threads are not included.
+	 */
+	static size_t GetHeapAllocations();
+
+private:
+	static LinearAllocator s_Allocator;
+	static size_t s_HeapAllocationsAtReset; /**< Allocation count of the main thread at the last reset. */
+};
+
+/**
+ * @brief Arena for temporaries of a loading scope, released when the scope ends.
+ *
+ * Arenas nest, the innermost arena of the thread is current. Code deep in the loading path takes its temporaries
+ * from GetAdapter and falls back to the heap when it runs outside of any arena.
+ */
+class ScopedArena
+{
+public:
+	explicit ScopedArena(size_t ChunkBytes = LOAD_ARENA_CHUNK_BYTES);
+	~ScopedArena();
+	ScopedArena(const ScopedArena&) = delete;
+	ScopedArena& operator=(const ScopedArena&) = delete;
+
+	/**
+	 * @brief Returns the allocator of the current arena of the thread, nullptr if there is none.
+	 */
+	static LinearAllocator* GetCurrent();
+
+	/**
+	 * @brief Returns an adapter for standard containers using the current arena, or the heap if there is none.
+	 */
+	template<typename T>
+	static LinearAllocatorAdapter<T> GetAdapter() { return LinearAllocatorAdapter<T>(GetCurrent()); }
+
+private:
+	LinearAllocator m_Allocator;
+	ScopedArena* m_Previous; /**< Arena which was current before this one. */
+	static thread_local ScopedArena* s_Current;
+};
@@ -0,0 +1,290 @@
+#include "FrameCapture.h"
+#include "GLStateCache.h"
+#include <algorithm>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#define STB_IMAGE_WRITE_IMPLEMENTATION
+#include "stb_image_write.h"
+
+FrameCapture::~FrameCapture()
+{
+	if (m_Encoder.joinable())
+	{
+		{
+			std::lock_guard<std::mutex> Lock(m_Mutex);
+			m_StopEncoder = true;
+		}
+		m_Condition.notify_all();
+		m_Encoder.join();
+	}
+}
+
+bool FrameCapture::ParseFormat(const std::string& Name, CaptureFormat& Format)
+{
+	if (Name.empty())
+		Format = CaptureFormat::None;
+	else if (Name == "png")
+		Format = CaptureFormat::Png;
+	else if (Name == "y4m")
+		Format = CaptureFormat::Y4m;
+	else
+		return false;
+	return true;
+}
+
+bool FrameCapture::Start(const std::string& Path, CaptureFormat Format, int Width, int Height, int Fps)
+{
+	if (Format == CaptureFormat::None || Width <= 0 || Height <= 0)
+		return false;
+	if (GetIsCapturing())
+		Stop();
+
+	if (Format == CaptureFormat::Y4m)
+	{
+		m_Stream.open(Path + ".y4m", std::ios::binary);
+		if (!m_Stream)
+		{
+			std::cerr << "FrameCapture::Start() => Can't open " << Path << ".y4m" << std::endl;
+			return false;
+		}
+		m_Stream << "YUV4MPEG2 W" << Width << " H" << Height << " F" << std::max(Fps, 1) << ":1 Ip A1:1 C420jpeg\n";
+		m_Planes.resize((size_t)Width * Height + 2 * (size_t)((Width + 1) / 2) * ((Height + 1) / 2));
+	}
+	else
+	{
+		// glReadPixels returns the rows from the bottom up
+		stbi_flip_vertically_on_write(1);
+	}
+
+	m_Format = Format;
+	m_Path = Path;
+	m_Width = Width;
+	m_Height = Height;
+	m_FrameSize = (size_t)Width * Height * 3;
+	m_Next = m_Oldest = 0;
+	m_FramesCollected = m_ReadbackWaits = m_EncoderWaits = 0;
+
+	glGenBuffers(FRAME_CAPTURE_READBACK_BUFFERS, m_Buffers);
+	for (GLuint Buffer : m_Buffers)
+	{
+		GLStateCache::BindBuffer(GL_PIXEL_PACK_BUFFER, Buffer);
+		glBufferData(GL_PIXEL_PACK_BUFFER, m_FrameSize, nullptr, GL_STREAM_READ);
+	}
+	GLStateCache::BindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+	CHECK_GL_ERROR();
+
+	m_StopEncoder = false;
+	m_HasEncoderFailed = false;
+	m_Encoder = std::thread(&FrameCapture::EncoderLoop, this);
+	std::cout << "FrameCapture::Start() => Capturing " << Width << "x" << Height << " to " << Path
+		<< (Format == CaptureFormat::Y4m ? ".y4m" : "_*.png") << std::endl;
+	return true;
+}
+
+void FrameCapture::CaptureFrame()
+{
+	if (!GetIsCapturing())
+		return;
+
+	if (m_Fences[m_Next] && !CollectOldest(false))
+	{
+		// the ring is full and the GPU is behind, the oldest readback must finish before its buffer is reused
+		m_ReadbackWaits++;
+		CollectOldest(true);
+	}
+
+	GLStateCache::BindBuffer(GL_PIXEL_PACK_BUFFER, m_Buffers[m_Next]);
+	glPixelStorei(GL_PACK_ALIGNMENT, 1);
+	glReadPixels(0, 0, m_Width, m_Height, GL_RGB, GL_UNSIGNED_BYTE, nullptr);
+	glPixelStorei(GL_PACK_ALIGNMENT, 4);
+	GLStateCache::BindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+	m_Fences[m_Next] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+	m_Next = (m_Next + 1) % FRAME_CAPTURE_READBACK_BUFFERS;
+
+	while (CollectOldest(false))
+		;
+	CHECK_GL_ERROR();
+}
+
+void FrameCapture::Stop()
+{
+	if (!GetIsCapturing())
+		return;
+
+	while (m_Fences[m_Oldest])
+		CollectOldest(true);
+	{
+		std::lock_guard<std::mutex> Lock(m_Mutex);
+		m_StopEncoder = true;
+	}
+	m_Condition.notify_all();
+	m_Encoder.join();
+
+	GLStateCache::DeleteBuffers(FRAME_CAPTURE_READBACK_BUFFERS, m_Buffers);
+	std::fill(std::begin(m_Buffers), std::end(m_Buffers), 0);
+	m_Stream.close();
+	m_Queue.clear();
+	m_FreeFrames.clear();
+	m_FrameCount = 0;
+	m_Planes.clear();
+	m_Planes.shrink_to_fit();
+	m_Format = CaptureFormat::None;
+	std::cout << "FrameCapture::Stop() => " << m_FramesCollected << " frames captured, waited " << m_ReadbackWaits
+		<< " times for the GPU and " << m_EncoderWaits << " times for the encoder"
+		<< (m_HasEncoderFailed ? ", writing failed" : "") << std::endl;
+}
+
+void FrameCapture::HandleResize(int Width, int Height)
+{
+	if (!GetIsCapturing() || (Width == m_Width && Height == m_Height))
+		return;
+	std::cerr << "FrameCapture::HandleResize() => The window was resized to " << Width << "x" << Height
+		<< ", stopping the " << m_Width << "x" << m_Height << " capture" << std::endl;
+	Stop();
+}
+
+bool FrameCapture::CollectOldest(bool Wait)
+{
+	GLsync& Fence = m_Fences[m_Oldest];
+	if (!Fence)
+		return false;
+	GLenum Result = glClientWaitSync(Fence, 0, 0);
+	while (Wait && Result == GL_TIMEOUT_EXPIRED)
+		Result = glClientWaitSync(Fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000);
+	if (Result == GL_TIMEOUT_EXPIRED)
+		return false;
+	if (Result == GL_WAIT_FAILED)
+		std::cerr << "FrameCapture::CollectOldest() => Waiting for the readback fence failed" << std::endl;
+
+	Frame CapturedFrame;
+	{
+		std::unique_lock<std::mutex> Lock(m_Mutex);
+		if (m_FreeFrames.empty() && m_FrameCount >= FRAME_CAPTURE_QUEUE_FRAMES)
+		{
+			// the encoder is behind, wait for it to free a frame rather than drop this one
+			m_EncoderWaits++;
+			m_Condition.wait(Lock, [this]() { return !m_FreeFrames.empty(); });
+		}
+		if (!m_FreeFrames.empty())
+		{
+			CapturedFrame = std::move(m_FreeFrames.back());
+			m_FreeFrames.pop_back();
+		}
+		else
+			m_FrameCount++;
+	}
+	CapturedFrame.Pixels.resize(m_FrameSize);
+	CapturedFrame.Index = m_FramesCollected++;
+
+	GLStateCache::BindBuffer(GL_PIXEL_PACK_BUFFER, m_Buffers[m_Oldest]);
+	const void* Mapped = glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, m_FrameSize, GL_MAP_READ_BIT);
+	if (Mapped)
+	{
+		memcpy(CapturedFrame.Pixels.data(), Mapped, m_FrameSize);
+		glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+	}
+	else
+		std::cerr << "FrameCapture::CollectOldest() => Can't map the readback buffer" << std::endl;
+	GLStateCache::BindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+	glDeleteSync(Fence);
+	Fence = nullptr;
+	m_Oldest = (m_Oldest + 1) % FRAME_CAPTURE_READBACK_BUFFERS;
+
+	{
+		std::lock_guard<std::mutex> Lock(m_Mutex);
+		m_Queue.push_back(std::move(CapturedFrame));
+	}
+	m_Condition.notify_all();
+	return true;
+}
+
+void FrameCapture::EncoderLoop()
+{
+	while (true)
+	{
+		Frame CapturedFrame;
+		{
+			std::unique_lock<std::mutex> Lock(m_Mutex);
+			m_Condition.wait(Lock, [this]() { return m_StopEncoder || !m_Queue.empty(); });
+			if (m_Queue.empty())
+				return;
+			CapturedFrame = std::move(m_Queue.front());
+			m_Queue.pop_front();
+		}
+		// after a failed write the frames are still taken, so the render thread never waits for a stuck encoder
+		if (!m_HasEncoderFailed)
+		{
+			const bool IsWritten = m_Format == CaptureFormat::Y4m ? WriteY4m(CapturedFrame) : WritePng(CapturedFrame);
+			m_HasEncoderFailed = !IsWritten;
+		}
+		{
+			std::lock_guard<std::mutex> Lock(m_Mutex);
+			m_FreeFrames.push_back(std::move(CapturedFrame));
+		}
+		m_Condition.notify_all();
+	}
+}
+
+bool FrameCapture::WritePng(const Frame& CapturedFrame) const
+{
+	std::ostringstream Filename;
+	Filename << m_Path << "_" << std::setw(6) << std::setfill('0') << CapturedFrame.Index << ".png";
+	if (!stbi_write_png(Filename.str().c_str(), m_Width, m_Height, 3, CapturedFrame.Pixels.data(), m_Width * 3))
+	{
+		std::cerr << "FrameCapture::WritePng() => Can't write " << Filename.str() << std::endl;
+		return false;
+	}
+	return true;
+}
+
+bool FrameCapture::WriteY4m(const Frame& CapturedFrame)
+{
+	const int ChromaWidth = (m_Width + 1) / 2;
+	const int ChromaHeight = (m_Height + 1) / 2;
+	uint8_t* const Y = m_Planes.data();
+	uint8_t* const U = Y + (size_t)m_Width * m_Height;
+	uint8_t* const V = U + (size_t)ChromaWidth * ChromaHeight;
+	const uint8_t* const Pixels = CapturedFrame.Pixels.data();
+	const size_t Stride = (size_t)m_Width * 3;
+
+	// full range BT.601 in 8 bit fixed point, the Y4M rows go from the top down
+	for (int Row = 0; Row < m_Height; Row++)
+	{
+		const uint8_t* Source = Pixels + (m_Height - 1 - Row) * Stride;
+		uint8_t* Target = Y + (size_t)Row * m_Width;
+		for (int Column = 0; Column < m_Width; Column++, Source += 3)
+			Target[Column] = (uint8_t)((77 * Source[0] + 150 * Source[1] + 29 * Source[2] + 128) >> 8);
+	}
+	for (int Row = 0; Row < ChromaHeight; Row++)
+	{
+		// the chroma of a 2x2 block is taken from its average color, odd sizes repeat the last row and column
+		const int Top = m_Height - 1 - 2 * Row;
+		const uint8_t* Rows[2] = { Pixels + Top * Stride, Pixels + std::max(Top - 1, 0) * Stride };
+		for (int Column = 0; Column < ChromaWidth; Column++)
+		{
+			const size_t Left = (size_t)2 * Column * 3;
+			const size_t Right = (size_t)std::min(2 * Column + 1, m_Width - 1) * 3;
+			int R = 0, G = 0, B = 0;
+			for (const uint8_t* Source : Rows)
+			{
+				R += Source[Left] + Source[Right];
+				G += Source[Left + 1] + Source[Right + 1];
+				B += Source[Left + 2] + Source[Right + 2];
+			}
+			// the sums are four times the average, the offset keeps the shifted values positive, pure blue and red round up to 256
+			U[(size_t)Row * ChromaWidth + Column] = (uint8_t)std::min((-43 * R - 85 * G + 128 * B + (128 << 10) + 512) >> 10, 255);
+			V[(size_t)Row * ChromaWidth + Column] = (uint8_t)std::min((128 * R - 107 * G - 21 * B + (128 << 10) + 512) >> 10, 255);
+		}
+	}
+
+	m_Stream << "FRAME\n";
+	m_Stream.write(reinterpret_cast<const char*>(m_Planes.data()), m_Planes.size());
+	if (!m_Stream)
+	{
+		std::cerr << "FrameCapture::WriteY4m() => Can't write " << m_Path << ".y4m" << std::endl;
+		return false;
+	}
+	return true;
+}
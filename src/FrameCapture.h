@@ -0,0 +1,141 @@
+#pragma once
+#include "pgr.h"
+#include <string>
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <fstream>
+#include <cstdint>
+
+#define FRAME_CAPTURE_READBACK_BUFFERS 3 // pixel buffers in flight, a frame is mapped this many frames after it was rendered
+#define FRAME_CAPTURE_QUEUE_FRAMES 8 // copied frames waiting for the encoder before the render thread waits for it
+#define FRAME_CAPTURE_DEFAULT_PATH "capture"
+
+/**
+ * @brief File format written by the frame capture.
+ */
+enum class CaptureFormat
+{
+	None,
+	Png, /**< One PNG file per frame, <path>_000000.png and onward. */
+	Y4m /**< One uncompressed YUV4MPEG2 stream with 4:2:0 chroma, <path>.y4m. */
+};
+
+/**
+ * @brief Captures the rendered frames to disk without stalling the render thread on the readback.
+ *
+ * Each frame is read into the next pixel buffer object of a ring, so glReadPixels only queues a copy on the GPU.
+ * A fence after the copy tells when the buffer may be mapped, which is checked without waiting on later frames.
+ * Mapped pixels are copied into a recycled frame and handed to an encoder thread. No frame is dropped: when the ring
+ * or the encoder queue is full, the render thread waits, and the waits are reported when the capture stops.
+ */
+class FrameCapture
+{
+public:
+	FrameCapture() = default;
+	/**
+	 * @brief Only joins the encoder thread, the GL objects must be released by Stop while the context exists.
+	 */
+	~FrameCapture();
+	FrameCapture(const FrameCapture&) = delete;
+	FrameCapture& operator=(const FrameCapture&) = delete;
+
+	/**
+	 * @brief Parses a format name of the config.
+	 *
+	 * @param Name "png", "y4m" or an empty string.
+	 * @param Format The parsed format, CaptureFormat::None for an empty name.
+	 * @return True if the name is known, false otherwise.
+	 */
+	static bool ParseFormat(const std::string& Name, CaptureFormat& Format);
+
+	/**
+	 * @brief Creates the pixel buffers, opens the output and starts the encoder thread.
+	 *
+	 * @param Path Output path without the extension.
+	 * @param Format The output format.
+	 * @param Width Width of the captured frames.
+	 * @param Height Height of the captured frames.
+	 * @param Fps Frame rate written into the Y4M header.
+	 * @return True if the capture started, false otherwise.
+	 */
+	bool Start(const std::string& Path, CaptureFormat Format, int Width, int Height, int Fps);
+
+	/**
+	 * @brief Queues the readback of the current read framebuffer and hands finished readbacks to the encoder.
+	 * Called after the frame is rendered and before the buffers are swapped.
+	 */
+	void CaptureFrame();
+
+	/**
+	 * @brief Finishes the pending readbacks, waits for the encoder to write them and closes the output.
+	 */
+	void Stop();
+
+	/**
+	 * @brief Stops the capture if the window no longer matches the captured size, the frames of a capture keep one size.
+	 */
+	void HandleResize(int Width, int Height);
+
+	bool GetIsCapturing() const { return m_Format != CaptureFormat::None; }
+
+private:
+	/**
+	 * @brief Captured pixels of one frame.
+	 */
+	struct Frame
+	{
+		std::vector<uint8_t> Pixels; /**< RGB rows from the bottom up. */
+		size_t Index = 0; /**< Index of the frame within the capture. */
+	};
+
+	/**
+	 * @brief Maps the oldest readback and queues its frame for the encoder.
+	 *
+	 * @param Wait True to wait for the GPU to finish the readback, false to return if it did not.
+	 * @return True if a frame was queued, false otherwise.
+	 */
+	bool CollectOldest(bool Wait);
+
+	/**
+	 * @brief Loop of the encoder thread.
+	 */
+	void EncoderLoop();
+
+	/**
+	 * @brief Writes a frame as a PNG file.
+	 */
+	bool WritePng(const Frame& CapturedFrame) const;
+
+	/**
+	 * @brief Converts a frame to full range BT.601 4:2:0 and appends it to the Y4M stream.
+	 */
+	bool WriteY4m(const Frame& CapturedFrame);
+
+	CaptureFormat m_Format = CaptureFormat::None;
+	std::string m_Path;
+	int m_Width = 0;
+	int m_Height = 0;
+	size_t m_FrameSize = 0; /**< Bytes of one RGB frame. */
+	GLuint m_Buffers[FRAME_CAPTURE_READBACK_BUFFERS] = {}; /**< Ring of the pixel pack buffers. */
+	GLsync m_Fences[FRAME_CAPTURE_READBACK_BUFFERS] = {}; /**< Fences after the readbacks in flight, nullptr if the buffer is free. */
+	int m_Next = 0; /**< Buffer of the next readback. */
+	int m_Oldest = 0; /**< Oldest buffer which may be in flight. */
+	size_t m_FramesCollected = 0; /**< Frames handed to the encoder. */
+	size_t m_ReadbackWaits = 0; /**< Times the render thread waited for a readback. */
+	size_t m_EncoderWaits = 0; /**< Times the render thread waited for the encoder. */
+
+	std::thread m_Encoder; /**< The encoder thread. */
+	std::mutex m_Mutex; /**< Guards the frame queues and the stop flag. */
+	std::condition_variable m_Condition; /**< Signals queued, freed and stopped frames. */
+	std::deque<Frame> m_Queue; /**< Frames waiting for the encoder. */
+	std::vector<Frame> m_FreeFrames; /**< Written frames whose memory is reused. */
+	size_t m_FrameCount = 0; /**< Frames allocated, queued, being written or free. */
+	bool m_StopEncoder = false;
+	bool m_HasEncoderFailed = false; /**< An output write failed, further frames are discarded. */
+
+	std::ofstream m_Stream; /**< Output of the Y4M format. */
+	std::vector<uint8_t> m_Planes; /**< Y, U and V planes of the frame being written. */
+};
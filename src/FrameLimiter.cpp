@@ -0,0 +1,44 @@
+#include "FrameLimiter.h"
+#include <algorithm>
+#include <cmath>
+#include <thread>
+
+void FrameLimiter::SetMaxFps(int MaxFps)
+{
+	m_MaxFps = std::max(MaxFps, 0);
+	m_FrameTime = m_MaxFps > 0 ? std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(1.0 / m_MaxFps)) : Clock::duration::zero();
+	m_NextFrame = Clock::now();
+}
+
+void FrameLimiter::WaitForNextFrame()
+{
+	if (m_MaxFps <= 0)
+		return;
+
+	Clock::time_point Now = Clock::now();
+	while (Now < m_NextFrame)
+	{
+		// a sleep may overshoot by its mean plus two standard deviations, only sleep when that still ends before the deadline
+		const double RemainingUs = std::chrono::duration<double, std::micro>(m_NextFrame - Now).count();
+		const double SleepBoundUs = std::max(m_SleepMeanUs + 2.0 * std::sqrt(m_SleepVarianceUs), (double)FRAME_LIMITER_SLEEP_US + FRAME_LIMITER_MIN_SPIN_US);
+		if (RemainingUs > SleepBoundUs)
+			Sleep();
+		else
+			std::this_thread::yield();
+		Now = Clock::now();
+	}
+	m_NextFrame = std::max(m_NextFrame + m_FrameTime, Now);
+}
+
+void FrameLimiter::Sleep()
+{
+	const Clock::time_point Start = Clock::now();
+	std::this_thread::sleep_for(std::chrono::microseconds(FRAME_LIMITER_SLEEP_US));
+	const double SleptUs = std::chrono::duration<double, std::micro>(Clock::now() - Start).count();
+
+	// Welford's running mean and variance, the sample count is capped so the estimate follows changes of the timer resolution
+	m_SleepSamples = std::min(m_SleepSamples + 1, 64);
+	const double Delta = SleptUs - m_SleepMeanUs;
+	m_SleepMeanUs += Delta / m_SleepSamples;
+	m_SleepVarianceUs += (Delta * (SleptUs - m_SleepMeanUs) - m_SleepVarianceUs) / m_SleepSamples;
+}
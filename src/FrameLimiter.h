@@ -0,0 +1,47 @@
+#pragma once
+#include <chrono>
+
+#define FRAME_LIMITER_DEFAULT_MAX_FPS 0 // 0 renders frames as soon as they are requested
+#define FRAME_LIMITER_MIN_SPIN_US 500 // the last part of a wait is always spent spinning
+#define FRAME_LIMITER_SLEEP_US 1000 // length of one sleep request while waiting
+
+/**
+ * @brief Paces frames to a maximal frame rate.
+ *
+ * Waits sleep in short steps while the deadline is further away than the expected sleep overshoot, then spin for
+ * the rest. The overshoot is measured from the sleeps themselves, so the limiter adapts to the timer resolution
+ * of the system and wakes up close to the deadline without spinning for most of the frame.
+ */
+class FrameLimiter
+{
+public:
+	/**
+	 * @brief Sets the maximal frame rate.
+	 *
+	 * @param MaxFps Frames per second, 0 disables the limit.
+	 */
+	void SetMaxFps(int MaxFps);
+
+	/**
+	 * @brief Waits until the next frame may start and schedules the one after it.
+	 * A frame which started late does not shorten the following frames.
+	 */
+	void WaitForNextFrame();
+
+	int GetMaxFps() const { return m_MaxFps; }
+
+private:
+	using Clock = std::chrono::steady_clock;
+
+	/**
+	 * @brief Sleeps once for FRAME_LIMITER_SLEEP_US and updates the overshoot estimate.
+	 */
+	void Sleep();
+
+	int m_MaxFps = FRAME_LIMITER_DEFAULT_MAX_FPS;
+	Clock::duration m_FrameTime = Clock::duration::zero(); /**< Minimal time between two frames. */
+	Clock::time_point m_NextFrame; /**< Earliest start of the next frame. */
+	double m_SleepMeanUs = FRAME_LIMITER_SLEEP_US; /**< Mean measured length of a sleep. */
+	double m_SleepVarianceUs = 0.0; /**< Variance of the measured sleep lengths. */
+	int m_SleepSamples = 0;
+};
@@ -1,40 +1,54 @@
 #pragma once 
 #include "FunctionLibrary.h"
+#include "GLStateCache.h"
 
 unsigned int TextureFromFile(const char* path, bool gamma)
 {
-	std::string filename = std::string(path);
-
-
-	int width, height, nrComponents;
-	unsigned char* data = stbi_load(filename.c_str(), &width, &height, &nrComponents, 0);
+	TextureImage Image;
+	if (!LoadTextureImage(path, Image))
+		return 0;
+	unsigned int textureID = TextureFromImage(Image);
+	FreeTextureImage(Image);
+	return textureID;
+}
 
-	
-	if (!data)
+bool LoadTextureImage(const char* path, TextureImage& Image)
+{
+	std::string filename = std::string(path);
+	Image.Data = stbi_load(filename.c_str(), &Image.Width, &Image.Height, &Image.Components, 0);
+	if (!Image.Data)
 	{
 		std::cerr << "FunctionLibrary::TextureFromFile() Error loading texture: " << filename << std::endl; 
-		stbi_image_free(data);
+		return false;
 	}
+	return true;
+}
+
+unsigned int TextureFromImage(const TextureImage& Image)
+{
 	unsigned int textureID;
 	glGenTextures(1, &textureID);
 	GLenum format = GL_RGB;
-	if (nrComponents == 1)
+	if (Image.Components == 1)
 		format = GL_RED;
-	else if (nrComponents == 3)
+	else if (Image.Components == 3)
 		format = GL_RGB;
-	else if (nrComponents == 4)
+	else if (Image.Components == 4)
 		format = GL_RGBA;
 
-	glBindTexture(GL_TEXTURE_2D, textureID);
-	glTexImage2D(GL_TEXTURE_2D, 0, format, width, height, 0, format, GL_UNSIGNED_BYTE, data);
+	GLStateCache::BindTexture(0, GL_TEXTURE_2D, textureID);
+	glTexImage2D(GL_TEXTURE_2D, 0, format, Image.Width, Image.Height, 0, format, GL_UNSIGNED_BYTE, Image.Data);
 	glGenerateMipmap(GL_TEXTURE_2D);
 
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-	glBindTexture(GL_TEXTURE_2D, 0);
-
-	stbi_image_free(data);
 	return textureID;
-}
\ No newline at end of file
+}
+
+void FreeTextureImage(TextureImage& Image)
+{
+	stbi_image_free(Image.Data);
+	Image.Data = nullptr;
+}
@@ -13,4 +13,37 @@
  * @param gamma Flag indicating whether gamma correction should be applied to the texture.
  * @return The OpenGL ID of the loaded texture.
  */
-unsigned int TextureFromFile(const char* path, bool gamma = false);
\ No newline at end of file
+unsigned int TextureFromFile(const char* path, bool gamma = false);
+
+/**
+ * @brief Decoded texture image in CPU memory.
+ */
+struct TextureImage
+{
+	int Width = 0;
+	int Height = 0;
+	int Components = 0;
+	unsigned char* Data = nullptr; /**< Pixels allocated by stb_image, released by FreeTextureImage. */
+};
+
+/**
+ * @brief Reads and decodes a texture image. Doesn't touch GL, so it can run on a worker thread.
+ *
+ * @param path The file path of the texture.
+ * @param Image The decoded image.
+ * @return True if the image was decoded, false otherwise.
+ */
+bool LoadTextureImage(const char* path, TextureImage& Image);
+
+/**
+ * @brief Creates a mipmapped texture from a decoded image.
+ *
+ * @param Image The decoded image.
+ * @return The OpenGL ID of the texture.
+ */
+unsigned int TextureFromImage(const TextureImage& Image);
+
+/**
+ * @brief Releases the pixels of a decoded image.
+ */
+void FreeTextureImage(TextureImage& Image);
\ No newline at end of file
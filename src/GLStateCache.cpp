@@ -0,0 +1,298 @@
+#include "GLStateCache.h"
+#include "MeshGeometry.h"
+
+namespace
+{
+	const GLuint Unknown = 0xffffffffu; // never a GL name nor enum
+}
+
+GLuint GLStateCache::s_Program = Unknown;
+GLuint GLStateCache::s_VertexArray = Unknown;
+GLuint GLStateCache::s_Buffers[BufferTargets];
+GLuint GLStateCache::s_UniformBuffers[GL_STATE_UNIFORM_BINDINGS];
+GLintptr GLStateCache::s_UniformOffsets[GL_STATE_UNIFORM_BINDINGS];
+GLsizeiptr GLStateCache::s_UniformSizes[GL_STATE_UNIFORM_BINDINGS];
+GLuint GLStateCache::s_ActiveUnit = Unknown;
+GLuint GLStateCache::s_Textures[GL_STATE_TEXTURE_UNITS][TextureTargets];
+GLuint GLStateCache::s_Samplers[GL_STATE_TEXTURE_UNITS];
+GLint GLStateCache::s_Enabled[Capabilities];
+GLenum GLStateCache::s_DepthFunc = Unknown;
+GLint GLStateCache::s_DepthMask = -1;
+GLint GLStateCache::s_ColorMask = -1;
+GLenum GLStateCache::s_BlendFunc[2] = { Unknown, Unknown };
+GLenum GLStateCache::s_StencilFunc = Unknown;
+GLint GLStateCache::s_StencilReference = -1;
+GLuint GLStateCache::s_StencilMask = Unknown;
+GLenum GLStateCache::s_StencilOp[3] = { Unknown, Unknown, Unknown };
+
+template<typename T>
+bool GLStateCache::Update(T& Tracked, const T& Value)
+{
+	const bool IsChanged = !(Tracked == Value);
+	MeshGeometry::CountStateChange(!IsChanged);
+	Tracked = Value;
+	return IsChanged;
+}
+
+void GLStateCache::Invalidate()
+{
+	s_Program = Unknown;
+	s_VertexArray = Unknown;
+	for (GLuint& Buffer : s_Buffers)
+		Buffer = Unknown;
+	for (int i = 0; i < GL_STATE_UNIFORM_BINDINGS; i++)
+	{
+		s_UniformBuffers[i] = Unknown;
+		s_UniformOffsets[i] = -1;
+		s_UniformSizes[i] = -1;
+	}
+	s_ActiveUnit = Unknown;
+	for (int Unit = 0; Unit < GL_STATE_TEXTURE_UNITS; Unit++)
+	{
+		for (GLuint& Texture : s_Textures[Unit])
+			Texture = Unknown;
+		s_Samplers[Unit] = Unknown;
+	}
+	for (GLint& Enabled : s_Enabled)
+		Enabled = -1;
+	s_DepthFunc = Unknown;
+	s_DepthMask = -1;
+	s_ColorMask = -1;
+	s_BlendFunc[0] = s_BlendFunc[1] = Unknown;
+	s_StencilFunc = Unknown;
+	s_StencilReference = -1;
+	s_StencilMask = Unknown;
+	s_StencilOp[0] = s_StencilOp[1] = s_StencilOp[2] = Unknown;
+}
+
+void GLStateCache::UseProgram(GLuint Program)
+{
+	if (Update(s_Program, Program))
+		glUseProgram(Program);
+}
+
+void GLStateCache::BindVertexArray(GLuint VertexArray)
+{
+	if (Update(s_VertexArray, VertexArray))
+		glBindVertexArray(VertexArray);
+}
+
+void GLStateCache::BindBuffer(GLenum Target, GLuint Buffer)
+{
+	const int Slot = GetBufferTargetSlot(Target);
+	if (Slot < 0)
+	{
+		MeshGeometry::CountStateChange(false);
+		glBindBuffer(Target, Buffer);
+	}
+	else if (Update(s_Buffers[Slot], Buffer))
+		glBindBuffer(Target, Buffer);
+}
+
+void GLStateCache::BindUniformBufferRange(GLuint Binding, GLuint Buffer, GLintptr Offset, GLsizeiptr Size)
+{
+	if (Binding >= GL_STATE_UNIFORM_BINDINGS)
+	{
+		MeshGeometry::CountStateChange(false);
+		glBindBufferRange(GL_UNIFORM_BUFFER, Binding, Buffer, Offset, Size);
+		s_Buffers[GetBufferTargetSlot(GL_UNIFORM_BUFFER)] = Buffer;
+		return;
+	}
+	const bool IsChanged = s_UniformBuffers[Binding] != Buffer || s_UniformOffsets[Binding] != Offset || s_UniformSizes[Binding] != Size;
+	MeshGeometry::CountStateChange(!IsChanged);
+	if (!IsChanged)
+		return;
+	s_UniformBuffers[Binding] = Buffer;
+	s_UniformOffsets[Binding] = Offset;
+	s_UniformSizes[Binding] = Size;
+	glBindBufferRange(GL_UNIFORM_BUFFER, Binding, Buffer, Offset, Size);
+	s_Buffers[GetBufferTargetSlot(GL_UNIFORM_BUFFER)] = Buffer; // the indexed bind also binds the generic target
+}
+
+void GLStateCache::BindTexture(GLuint Unit, GLenum Target, GLuint Texture)
+{
+	const int Slot = GetTextureTargetSlot(Target);
+	if (Unit >= GL_STATE_TEXTURE_UNITS || Slot < 0)
+	{
+		MeshGeometry::CountStateChange(false);
+		glActiveTexture(GL_TEXTURE0 + Unit);
+		glBindTexture(Target, Texture);
+		s_ActiveUnit = Unit;
+		return;
+	}
+	if (!Update(s_Textures[Unit][Slot], Texture))
+		return;
+	if (s_ActiveUnit != Unit)
+	{
+		glActiveTexture(GL_TEXTURE0 + Unit);
+		s_ActiveUnit = Unit;
+	}
+	glBindTexture(Target, Texture);
+}
+
+void GLStateCache::BindSampler(GLuint Unit, GLuint Sampler)
+{
+	if (Unit >= GL_STATE_TEXTURE_UNITS)
+	{
+		MeshGeometry::CountStateChange(false);
+		glBindSampler(Unit, Sampler);
+	}
+	else if (Update(s_Samplers[Unit], Sampler))
+		glBindSampler(Unit, Sampler);
+}
+
+void GLStateCache::SetEnabled(GLenum Capability, bool Enabled)
+{
+	const int Slot = GetCapabilitySlot(Capability);
+	if (Slot >= 0 && !Update(s_Enabled[Slot], (GLint)Enabled))
+		return;
+	if (Slot < 0)
+		MeshGeometry::CountStateChange(false);
+	Enabled ? glEnable(Capability) : glDisable(Capability);
+}
+
+void GLStateCache::SetDepthFunc(GLenum Func)
+{
+	if (Update(s_DepthFunc, Func))
+		glDepthFunc(Func);
+}
+
+void GLStateCache::SetDepthMask(bool Enabled)
+{
+	if (Update(s_DepthMask, (GLint)Enabled))
+		glDepthMask(Enabled ? GL_TRUE : GL_FALSE);
+}
+
+void GLStateCache::SetColorMask(bool Enabled)
+{
+	if (!Update(s_ColorMask, (GLint)Enabled))
+		return;
+	const GLboolean Mask = Enabled ? GL_TRUE : GL_FALSE;
+	glColorMask(Mask, Mask, Mask, Mask);
+}
+
+void GLStateCache::SetBlendFunc(GLenum Source, GLenum Destination)
+{
+	const bool IsChanged = s_BlendFunc[0] != Source || s_BlendFunc[1] != Destination;
+	MeshGeometry::CountStateChange(!IsChanged);
+	if (!IsChanged)
+		return;
+	s_BlendFunc[0] = Source;
+	s_BlendFunc[1] = Destination;
+	glBlendFunc(Source, Destination);
+}
+
+void GLStateCache::SetStencilFunc(GLenum Func, GLint Reference, GLuint Mask)
+{
+	const bool IsChanged = s_StencilFunc != Func || s_StencilReference != Reference || s_StencilMask != Mask;
+	MeshGeometry::CountStateChange(!IsChanged);
+	if (!IsChanged)
+		return;
+	s_StencilFunc = Func;
+	s_StencilReference = Reference;
+	s_StencilMask = Mask;
+	glStencilFunc(Func, Reference, Mask);
+}
+
+void GLStateCache::SetStencilOp(GLenum StencilFail, GLenum DepthFail, GLenum DepthPass)
+{
+	const bool IsChanged = s_StencilOp[0] != StencilFail || s_StencilOp[1] != DepthFail || s_StencilOp[2] != DepthPass;
+	MeshGeometry::CountStateChange(!IsChanged);
+	if (!IsChanged)
+		return;
+	s_StencilOp[0] = StencilFail;
+	s_StencilOp[1] = DepthFail;
+	s_StencilOp[2] = DepthPass;
+	glStencilOp(StencilFail, DepthFail, DepthPass);
+}
+
+void GLStateCache::DeleteTextures(GLsizei Count, const GLuint* Textures)
+{
+	// GL unbinds deleted textures from the units of the context
+	for (GLsizei i = 0; i < Count; i++)
+	{
+		for (auto& Unit : s_Textures)
+		{
+			for (GLuint& Texture : Unit)
+			{
+				if (Texture == Textures[i])
+					Texture = 0;
+			}
+		}
+	}
+	glDeleteTextures(Count, Textures);
+}
+
+void GLStateCache::DeleteBuffers(GLsizei Count, const GLuint* Buffers)
+{
+	for (GLsizei i = 0; i < Count; i++)
+	{
+		for (GLuint& Buffer : s_Buffers)
+		{
+			if (Buffer == Buffers[i])
+				Buffer = 0;
+		}
+		for (GLuint& Buffer : s_UniformBuffers)
+		{
+			if (Buffer == Buffers[i])
+				Buffer = 0;
+		}
+	}
+	glDeleteBuffers(Count, Buffers);
+}
+
+void GLStateCache::DeleteVertexArrays(GLsizei Count, const GLuint* VertexArrays)
+{
+	for (GLsizei i = 0; i < Count; i++)
+	{
+		if (s_VertexArray == VertexArrays[i])
+			s_VertexArray = 0;
+	}
+	glDeleteVertexArrays(Count, VertexArrays);
+}
+
+void GLStateCache::DeleteProgram(GLuint Program)
+{
+	// a current program is only flagged for deletion, it stays in use
+	if (s_Program == Program)
+		s_Program = Unknown;
+	glDeleteProgram(Program);
+}
+
+int GLStateCache::GetTextureTargetSlot(GLenum Target)
+{
+	switch (Target)
+	{
+	case GL_TEXTURE_2D: return 0;
+	case GL_TEXTURE_2D_ARRAY: return 1;
+	case GL_TEXTURE_CUBE_MAP: return 2;
+	case GL_TEXTURE_BUFFER: return 3;
+	default: return -1;
+	}
+}
+
+int GLStateCache::GetBufferTargetSlot(GLenum Target)
+{
+	switch (Target)
+	{
+	case GL_ARRAY_BUFFER: return 0;
+	case GL_COPY_WRITE_BUFFER: return 1;
+	case GL_TEXTURE_BUFFER: return 2;
+	case GL_UNIFORM_BUFFER: return 3;
+	case GL_PIXEL_PACK_BUFFER: return 4;
+	case GL_PIXEL_UNPACK_BUFFER: return 5;
+	default: return -1;
+	}
+}
+
+int GLStateCache::GetCapabilitySlot(GLenum Capability)
+{
+	switch (Capability)
+	{
+	case GL_DEPTH_TEST: return 0;
+	case GL_BLEND: return 1;
+	case GL_STENCIL_TEST: return 2;
+	case GL_CULL_FACE: return 3;
+	default: return -1;
+	}
+}
@@ -0,0 +1,159 @@
+#pragma once
+#include "pgr.h"
+#include <iostream>
+
+#define GL_STATE_TEXTURE_UNITS 32 // texture units tracked, binds to higher units are always issued
+#define GL_STATE_UNIFORM_BINDINGS 16 // uniform buffer binding points tracked
+
+/**
+ * @brief Thin state tracking layer over the GL calls of the renderer.
+ *
+ * Every setter compares the value with the value it set last and skips the GL call when it is already in place.
+ * Issued and elided calls are counted in the draw statistics of MeshGeometry. All GL state changes of the covered
+ * kinds must go through the cache, otherwise it must be invalidated. Objects must be deleted through the cache,
+ * so names reused by the driver are not mistaken for the deleted objects which were bound.
+ */
+class GLStateCache
+{
+public:
+	/**
+	 * @brief Forgets all tracked state, the next setters issue their GL calls.
+	 */
+	static void Invalidate();
+
+	/**
+	 * @brief Makes a program current (glUseProgram).
+	 */
+	static void UseProgram(GLuint Program);
+
+	/**
+	 * @brief Binds a vertex array (glBindVertexArray).
+	 */
+	static void BindVertexArray(GLuint VertexArray);
+
+	/**
+	 * @brief Binds a buffer to a target (glBindBuffer). GL_ELEMENT_ARRAY_BUFFER is vertex array state and is not cached.
+	 */
+	static void BindBuffer(GLenum Target, GLuint Buffer);
+
+	/**
+	 * @brief Binds a range of a buffer to an indexed uniform buffer binding point (glBindBufferRange).
+	 */
+	static void BindUniformBufferRange(GLuint Binding, GLuint Buffer, GLintptr Offset, GLsizeiptr Size);
+
+	/**
+	 * @brief Binds a texture to a texture unit, switching the active unit only if needed.
+	 *
+	 * @param Unit The index of the texture unit.
+	 * @param Target GL_TEXTURE_2D, GL_TEXTURE_2D_ARRAY, GL_TEXTURE_CUBE_MAP or GL_TEXTURE_BUFFER.
+	 * @param Texture The texture.
+	 */
+	static void BindTexture(GLuint Unit, GLenum Target, GLuint Texture);
+
+	/**
+	 * @brief Binds a sampler object to a texture unit (glBindSampler).
+	 */
+	static void BindSampler(GLuint Unit, GLuint Sampler);
+
+	/**
+	 * @brief Enables or disables GL_DEPTH_TEST, GL_BLEND, GL_STENCIL_TEST or GL_CULL_FACE.
+	 */
+	static void SetEnabled(GLenum Capability, bool Enabled);
+
+	/**
+	 * @brief Sets the depth comparison (glDepthFunc).
+	 */
+	static void SetDepthFunc(GLenum Func);
+
+	/**
+	 * @brief Enables or disables depth writes (glDepthMask).
+	 */
+	static void SetDepthMask(bool Enabled);
+
+	/**
+	 * @brief Enables or disables writes of all color channels (glColorMask).
+	 */
+	static void SetColorMask(bool Enabled);
+
+	/**
+	 * @brief Sets the blend factors (glBlendFunc).
+	 */
+	static void SetBlendFunc(GLenum Source, GLenum Destination);
+
+	/**
+	 * @brief Sets the stencil test (glStencilFunc).
+	 */
+	static void SetStencilFunc(GLenum Func, GLint Reference, GLuint Mask);
+
+	/**
+	 * @brief Sets the stencil operations (glStencilOp).
+	 */
+	static void SetStencilOp(GLenum StencilFail, GLenum DepthFail, GLenum DepthPass);
+
+	/**
+	 * @brief Deletes textures and forgets their bindings.
+	 */
+	static void DeleteTextures(GLsizei Count, const GLuint* Textures);
+
+	/**
+	 * @brief Deletes buffers and forgets their bindings.
+	 */
+	static void DeleteBuffers(GLsizei Count, const GLuint* Buffers);
+
+	/**
+	 * @brief Deletes vertex arrays and forgets their binding.
+	 */
+	static void DeleteVertexArrays(GLsizei Count, const GLuint* VertexArrays);
+
+	/**
+	 * @brief Deletes a program and forgets its use.
+	 */
+	static void DeleteProgram(GLuint Program);
+
+private:
+	/**
+	 * @brief Returns the tracking slot of a texture target, -1 if the target is not tracked.
+	 */
+	static int GetTextureTargetSlot(GLenum Target);
+
+	/**
+	 * @brief Returns the tracking slot of a buffer target, -1 if the target is not tracked.
+	 */
+	static int GetBufferTargetSlot(GLenum Target);
+
+	/**
+	 * @brief Returns the tracking slot of a capability, -1 if the capability is not tracked.
+	 */
+	static int GetCapabilitySlot(GLenum Capability);
+
+	/**
+	 * @brief Updates a tracked value and counts the call as issued or elided.
+	 *
+	 * @return True if the value changed and the GL call must be issued.
+	 */
+	template<typename T>
+	static bool Update(T& Tracked, const T& Value);
+
+	static const int TextureTargets = 4;
+	static const int BufferTargets = 6;
+	static const int Capabilities = 4;
+
+	static GLuint s_Program; /**< Current program. */
+	static GLuint s_VertexArray; /**< Bound vertex array. */
+	static GLuint s_Buffers[BufferTargets]; /**< Bound buffer of every tracked target. */
+	static GLuint s_UniformBuffers[GL_STATE_UNIFORM_BINDINGS]; /**< Buffer of every uniform binding point. */
+	static GLintptr s_UniformOffsets[GL_STATE_UNIFORM_BINDINGS]; /**< Offset of the bound uniform range. */
+	static GLsizeiptr s_UniformSizes[GL_STATE_UNIFORM_BINDINGS]; /**< Size of the bound uniform range. */
+	static GLuint s_ActiveUnit; /**< Active texture unit. */
+	static GLuint s_Textures[GL_STATE_TEXTURE_UNITS][TextureTargets]; /**< Bound texture of every unit and target. */
+	static GLuint s_Samplers[GL_STATE_TEXTURE_UNITS]; /**< Bound sampler of every unit. */
+	static GLint s_Enabled[Capabilities]; /**< Tracked capabilities, -1 if unknown. */
+	static GLenum s_DepthFunc; /**< Depth comparison. */
+	static GLint s_DepthMask; /**< Depth writes, -1 if unknown. */
+	static GLint s_ColorMask; /**< Color writes, -1 if unknown. */
+	static GLenum s_BlendFunc[2]; /**< Source and destination blend factors. */
+	static GLenum s_StencilFunc; /**< Stencil comparison. */
+	static GLint s_StencilReference; /**< Stencil reference value. */
+	static GLuint s_StencilMask; /**< Stencil comparison mask. */
+	static GLenum s_StencilOp[3]; /**< Stencil operations. */
+};
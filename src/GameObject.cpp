@@ -4,15 +4,22 @@ GameObject::GameObject(const std::string& Name, const std::shared_ptr<Mesh>& mes
 	: SceneObject ( Name, transform ),
 	  m_Mesh(mesh)
 {
+	// every game object has a render component holding its visibility, the main pass skips the ones without a mesh
+	RenderComponent Render;
+	Render.Geometry = mesh.get();
+	Render.MaterialId = mesh ? mesh->GetMaterial().m_Id : 0;
+	EntityStore::Get().GetRenders().Add(GetEntity().Index, Render);
+}
 
-
+GameObject::GameObject()
+	: GameObject(std::string(), nullptr, Transform())
+{
 }
 
 void GameObject::Render(const Shader& shader)
 {
 	if (m_Mesh.get())
 	{
-		shader.BindMaterial(m_Mesh->GetMaterial()); 
 		m_Mesh->Render(shader); 
 	}
 }
@@ -26,12 +33,18 @@ void GameObject::Render()
 
 void GameObject::SetVisibility(bool isVisible)
 {
-	m_IsVisible = isVisible; 
+	RenderComponent* Render = EntityStore::Get().GetRenders().Get(GetEntity().Index);
+	Render->Flags = (uint8_t)(isVisible ? Render->Flags | RENDER_VISIBLE : Render->Flags & ~RENDER_VISIBLE);
 }
 
 bool GameObject::GetIsVisible() const
 {
-	return m_IsVisible;
+	return (EntityStore::Get().GetRenders().Get(GetEntity().Index)->Flags & RENDER_VISIBLE) != 0;
+}
+
+bool GameObject::GetLocalBounds(glm::vec3& Min, glm::vec3& Max) const
+{
+	return m_Mesh && m_Mesh->GetBounds(Min, Max);
 }
 
 
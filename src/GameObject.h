@@ -22,7 +22,7 @@ public:
 	/**
 	 * @brief Default constructor for the GameObject class.
 	 */
-	GameObject() = default;
+	GameObject();
 
 	/**
 	 * @brief Constructor for the GameObject class.
@@ -32,6 +32,12 @@ public:
 	 */
 	GameObject(const std::string& Name, const std::shared_ptr<Mesh>& Mesh, const Transform& transform);
 
+	/**
+	 * @brief Game objects are not copied, their render component refers to the mesh they own.
+	 */
+	GameObject(const GameObject&) = delete;
+	GameObject& operator=(const GameObject&) = delete;
+
 	/**
 	 * @brief Renders the game object using the specified shader.
 	 * @param shader The shader used for rendering.
@@ -44,7 +50,7 @@ public:
 	virtual void Render();
 
 	/**
-	 * @brief Sets the visibility of the game object.
+	 * @brief Sets the visibility of the game object, stored in its render component.
 	 * @param isVisible Boolean value indicating the visibility status.
 	 */
 	void SetVisibility(bool isVisible);
@@ -55,8 +61,15 @@ public:
 	 */
 	bool GetIsVisible() const;
 
+	/**
+	 * @brief Returns the bounds of the mesh in the local space of the game object.
+	 * @param Min The minimal corner of the bounds.
+	 * @param Max The maximal corner of the bounds.
+	 * @return True if the game object has a mesh with vertices, false otherwise.
+	 */
+	virtual bool GetLocalBounds(glm::vec3& Min, glm::vec3& Max) const;
+
 private:
-	bool m_IsVisible = true; /**< Flag indicating whether the game object is visible. */
 	std::shared_ptr<Mesh> m_Mesh; /**< The shared pointer to the mesh associated with the game object. */
 };
 
@@ -0,0 +1,58 @@
+#include "GpuTimer.h"
+
+GpuTimer::~GpuTimer()
+{
+	if (m_Queries[0])
+		glDeleteQueries(GPU_TIMER_QUERIES * 2, m_Queries);
+}
+
+void GpuTimer::Begin()
+{
+	if (!m_Queries[0])
+		glGenQueries(GPU_TIMER_QUERIES * 2, m_Queries);
+	if (m_IsPending[m_Next])
+	{
+		// the GPU is more than GPU_TIMER_QUERIES frames behind, drop the oldest measurement
+		m_IsPending[m_Next] = false;
+		m_Oldest = (m_Next + 1) % GPU_TIMER_QUERIES;
+	}
+	if (m_UseTimestamps)
+		glQueryCounter(m_Queries[m_Next], GL_TIMESTAMP);
+	else
+		glBeginQuery(GL_TIME_ELAPSED, m_Queries[m_Next]);
+}
+
+void GpuTimer::End()
+{
+	if (m_UseTimestamps)
+		glQueryCounter(m_Queries[GPU_TIMER_QUERIES + m_Next], GL_TIMESTAMP);
+	else
+		glEndQuery(GL_TIME_ELAPSED);
+	m_IsPending[m_Next] = true;
+	m_Next = (m_Next + 1) % GPU_TIMER_QUERIES;
+	CollectResults();
+}
+
+void GpuTimer::CollectResults()
+{
+	while (m_IsPending[m_Oldest])
+	{
+		// the end timestamp is issued last, once it is available the start is too
+		const GLuint Query = m_UseTimestamps ? m_Queries[GPU_TIMER_QUERIES + m_Oldest] : m_Queries[m_Oldest];
+		GLint Available = 0;
+		glGetQueryObjectiv(Query, GL_QUERY_RESULT_AVAILABLE, &Available);
+		if (!Available)
+			return;
+		GLuint64 Nanoseconds = 0;
+		glGetQueryObjectui64v(Query, GL_QUERY_RESULT, &Nanoseconds);
+		if (m_UseTimestamps)
+		{
+			GLuint64 Start = 0;
+			glGetQueryObjectui64v(m_Queries[m_Oldest], GL_QUERY_RESULT, &Start);
+			Nanoseconds -= Start;
+		}
+		m_LastTimeMs = Nanoseconds * 1e-6;
+		m_IsPending[m_Oldest] = false;
+		m_Oldest = (m_Oldest + 1) % GPU_TIMER_QUERIES;
+	}
+}
@@ -0,0 +1,52 @@
+#pragma once
+#include "pgr.h"
+#include <iostream>
+
+#define GPU_TIMER_QUERIES 4 // frames a result may lag behind, results are read without waiting for the GPU
+
+/**
+ * @brief Measures the GPU time of a part of the frame with GL_TIME_ELAPSED queries.
+ *
+ * Every frame uses the next query of a small ring, and the result of a query is read once the GPU made it
+ * available, a few frames later. Timers must not overlap, GL allows only one active GL_TIME_ELAPSED query.
+ * A timer using GL_TIMESTAMP pairs instead may enclose other timers.
+ */
+class GpuTimer
+{
+public:
+	/**
+	 * @param UseTimestamps True to measure with a pair of GL_TIMESTAMP queries, which may enclose GL_TIME_ELAPSED timers.
+	 */
+	explicit GpuTimer(bool UseTimestamps = false) : m_UseTimestamps(UseTimestamps) {}
+	~GpuTimer();
+	GpuTimer(const GpuTimer&) = delete;
+	GpuTimer& operator=(const GpuTimer&) = delete;
+
+	/**
+	 * @brief Starts timing the commands issued until End.
+	 */
+	void Begin();
+
+	/**
+	 * @brief Stops timing and collects the finished results of the previous frames.
+	 */
+	void End();
+
+	/**
+	 * @brief Returns the GPU time of the latest finished measurement in milliseconds.
+	 */
+	double GetLastTimeMs() const { return m_LastTimeMs; }
+
+private:
+	/**
+	 * @brief Reads the results of the queries the GPU finished.
+	 */
+	void CollectResults();
+
+	GLuint m_Queries[GPU_TIMER_QUERIES * 2] = {}; /**< Ring of the queries, followed by the ring of the end timestamps. */
+	bool m_UseTimestamps = false; /**< Measures with GL_TIMESTAMP pairs instead of GL_TIME_ELAPSED. */
+	bool m_IsPending[GPU_TIMER_QUERIES] = {}; /**< The query was issued and its result not read yet. */
+	int m_Next = 0; /**< Query used by the next Begin. */
+	int m_Oldest = 0; /**< Oldest query which may be pending. */
+	double m_LastTimeMs = 0.0; /**< Latest finished measurement. */
+};
@@ -1,73 +1,176 @@
 #include "InputHandler.h"
+#include "Application.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
 
 
+SpscRing<InputEvent, INPUT_QUEUE_CAPACITY> InputHandler::m_Events;
+std::atomic<size_t> InputHandler::m_DroppedEvents{ 0 };
+std::bitset<INPUT_MOUSE_BUTTON_COUNT> InputHandler::m_MouseKeys;
+std::bitset<INPUT_MOUSE_BUTTON_COUNT> InputHandler::m_MousePresses;
+std::bitset<INPUT_KEY_COUNT> InputHandler::m_Keys;
+std::bitset<INPUT_KEY_COUNT> InputHandler::m_KeyPresses;
+std::bitset<INPUT_KEY_COUNT> InputHandler::m_SpecKeys;
+std::bitset<INPUT_KEY_COUNT> InputHandler::m_SpecKeyPresses;
 glm::vec2 InputHandler::m_WindowSize = { 800, 600 };
-glm::vec2 InputHandler::m_CurrentMousePosition = {};
 glm::vec2 InputHandler::m_LastMousePosition = {};
+bool InputHandler::m_HasMousePosition = false;
+bool InputHandler::m_IsWarpPending = false;
+glm::vec2 InputHandler::m_MouseDelta = {};
 glm::vec2 InputHandler::m_LastLMCPosition = {};
-std::map <int, bool> InputHandler::m_Keys = {};
-std::map <int, bool> InputHandler::m_SpecKeys = {};
-std::map <int, bool> InputHandler::m_MouseKeys = {}; 
-void InputHandler::ForceKeyDown(unsigned char key)
+uint64_t InputHandler::m_OldestEventTimestamp = 0;
+bool InputHandler::m_HasActivity = false;
+double InputHandler::m_LastLatencyMs = 0.0;
+double InputHandler::m_LatencySumMs = 0.0;
+double InputHandler::m_LatencyMaxMs = 0.0;
+int InputHandler::m_LatencySamples = 0;
+
+uint64_t InputHandler::GetTimestamp()
 {
-	m_Keys[key] = false;
+	return (uint64_t)std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
 }
-void InputHandler::ForceSpecKeyDown(int specKey)
+
+void InputHandler::PushEvent(InputEventType Type, int Code, int X, int Y)
 {
-	m_SpecKeys[specKey] = false;
+	InputEvent Event;
+	Event.Type = Type;
+	Event.Code = Code;
+	Event.Position = { X, Y };
+	Event.Timestamp = GetTimestamp();
+	if (!m_Events.Push(Event))
+		m_DroppedEvents.fetch_add(1, std::memory_order_relaxed);
 }
+
 void InputHandler::KeyboardPressed(unsigned char keyPressed, int mouseX, int mouseY)
 {
 	if (keyPressed == 27) {
+		// exit skips the close callback, the capture must finish its pending readbacks while the context is alive
+		Application::Exit();
 		glutLeaveMainLoop();
 		exit(EXIT_SUCCESS);
 	}
 
-	m_Keys[keyPressed] = true; 
-
-}
-glm::vec2 InputHandler::GetMouseOffset()
-{
-	glm::vec2 WindowCenter = { m_WindowSize.x / 2, m_WindowSize.y / 2 };
-	return m_CurrentMousePosition - WindowCenter; 
+	PushEvent(InputEventType::KeyDown, keyPressed, mouseX, mouseY);
 }
 
 void InputHandler::KeyboardReleased(unsigned char keyReleased, int mouseX, int mouseY)
 {
-	m_Keys[keyReleased] = false;
+	PushEvent(InputEventType::KeyUp, keyReleased, mouseX, mouseY);
 }
 void InputHandler::SpecialKeyboardPressed(int specKeyPressed, int mouseX, int mouseY)
 {
-	m_SpecKeys[specKeyPressed] = true; 
+	PushEvent(InputEventType::SpecKeyDown, specKeyPressed, mouseX, mouseY);
 }
 void InputHandler::SpecialKeyboardReleased(int specKeyReleased, int mouseX, int mouseY)
 {
-	m_SpecKeys[specKeyReleased] = false;
-
+	PushEvent(InputEventType::SpecKeyUp, specKeyReleased, mouseX, mouseY);
 }
 
 void InputHandler::MouseMotion(int X, int Y)
 {
-	m_LastMousePosition = m_CurrentMousePosition; 
-	m_CurrentMousePosition = { X, Y };
+	PushEvent(InputEventType::MouseMove, 0, X, Y);
 }
 
-glm::vec2 InputHandler::GetLastLMCPosition()
+void InputHandler::MouseFunc(int buttonPressed, int buttonState, int mouseX, int mouseY)
 {
-	return m_LastLMCPosition;
+	PushEvent(buttonState == GLUT_DOWN ? InputEventType::MouseDown : InputEventType::MouseUp, buttonPressed, mouseX, mouseY);
 }
 
-void InputHandler::MouseFunc(int buttonPressed, int buttonState, int mouseX, int mouseY)
+void InputHandler::ProcessEvents()
+{
+	InputEvent Event;
+	while (m_Events.Pop(Event))
+	{
+		m_HasActivity = true;
+		if (!m_OldestEventTimestamp)
+			m_OldestEventTimestamp = Event.Timestamp;
+		const bool IsKeyValid = Event.Code >= 0 && Event.Code < INPUT_KEY_COUNT;
+		const bool IsButtonValid = Event.Code >= 0 && Event.Code < INPUT_MOUSE_BUTTON_COUNT;
+		switch (Event.Type)
+		{
+		case InputEventType::KeyDown:
+			// a key down of a held key is a repeat, not a press
+			if (IsKeyValid && !m_Keys[Event.Code])
+				m_KeyPresses[Event.Code] = true;
+			if (IsKeyValid)
+				m_Keys[Event.Code] = true;
+			break;
+		case InputEventType::KeyUp:
+			if (IsKeyValid)
+				m_Keys[Event.Code] = false;
+			break;
+		case InputEventType::SpecKeyDown:
+			if (IsKeyValid && !m_SpecKeys[Event.Code])
+				m_SpecKeyPresses[Event.Code] = true;
+			if (IsKeyValid)
+				m_SpecKeys[Event.Code] = true;
+			break;
+		case InputEventType::SpecKeyUp:
+			if (IsKeyValid)
+				m_SpecKeys[Event.Code] = false;
+			break;
+		case InputEventType::MouseDown:
+			if (IsButtonValid)
+			{
+				m_MousePresses[Event.Code] = true;
+				m_MouseKeys[Event.Code] = true;
+			}
+			if (Event.Code == GLUT_LEFT_BUTTON)
+				m_LastLMCPosition = Event.Position;
+			break;
+		case InputEventType::MouseUp:
+			if (IsButtonValid)
+				m_MouseKeys[Event.Code] = false;
+			break;
+		case InputEventType::MouseMove:
+		{
+			const glm::vec2 WindowCenter = { (int)m_WindowSize.x / 2, (int)m_WindowSize.y / 2 };
+			if (m_IsWarpPending && Event.Position == WindowCenter)
+				m_IsWarpPending = false;
+			else if (m_HasMousePosition)
+				m_MouseDelta = m_MouseDelta + (Event.Position - m_LastMousePosition);
+			m_LastMousePosition = Event.Position;
+			m_HasMousePosition = true;
+			break;
+		}
+		}
+	}
+
+	const size_t Dropped = m_DroppedEvents.exchange(0, std::memory_order_relaxed);
+	if (Dropped)
+		std::cerr << "InputHandler::ProcessEvents() => Input queue full, dropped " << Dropped << " events" << std::endl;
+}
+
+bool InputHandler::ConsumeActivity()
+{
+	const bool HasActivity = m_HasActivity || m_Keys.any() || m_SpecKeys.any() || m_MouseKeys.any();
+	m_HasActivity = false;
+	return HasActivity;
+}
+
+glm::vec2 InputHandler::ConsumeMouseDelta()
 {
-	m_LastLMCPosition = { mouseX, mouseY };
-	m_MouseKeys[buttonPressed] = buttonState == GLUT_DOWN ? true : false; 
+	glm::vec2 Delta = m_MouseDelta;
+	m_MouseDelta = {};
+	return Delta;
+}
 
+void InputHandler::RecenterPointer()
+{
+	const glm::vec2 WindowCenter = { (int)m_WindowSize.x / 2, (int)m_WindowSize.y / 2 };
+	const glm::vec2 Distance = m_LastMousePosition - WindowCenter;
+	if (m_HasMousePosition && std::abs(Distance.x) <= m_WindowSize.x * INPUT_RECENTER_MARGIN && std::abs(Distance.y) <= m_WindowSize.y * INPUT_RECENTER_MARGIN)
+		return;
+	glutWarpPointer((int)WindowCenter.x, (int)WindowCenter.y);
+	m_IsWarpPending = true;
 }
 
-void InputHandler::ForceMouseDown(int button)
+glm::vec2 InputHandler::GetLastLMCPosition()
 {
-	m_MouseKeys[button] = false; 
+	return m_LastLMCPosition;
 }
+
 void InputHandler::SetWindowSize(int Width, int Height)
 {
 	m_WindowSize = { Width, Height };
@@ -75,9 +178,7 @@ void InputHandler::SetWindowSize(int Width, int Height)
 
 bool InputHandler::GetIsMousePressed(int button)
 {
-	if (m_MouseKeys.count(button) == 0)
-		return false; 
-	return m_MouseKeys.at(button); 
+	return button >= 0 && button < INPUT_MOUSE_BUTTON_COUNT && m_MouseKeys[button];
 }
 
 bool InputHandler::Init(int windowWidth, int windowHeight)
@@ -88,16 +189,12 @@ bool InputHandler::Init(int windowWidth, int windowHeight)
 
 bool InputHandler::GetIsKeyPressed(unsigned char Key)
 {
-	if (m_Keys.count(Key) == 0)
-		return false;
-	return m_Keys.at(Key); 
+	return m_Keys[Key];
 }
 
 bool InputHandler::GetIsSpecKeyPressed(int Key)
 {
-	if (m_SpecKeys.count(Key) == 0)
-		return false;
-	return m_SpecKeys.at(Key); 
+	return Key >= 0 && Key < INPUT_KEY_COUNT && m_SpecKeys[Key];
 }
 
 bool InputHandler::GetIsKeyChordPressed(const std::vector<unsigned char>& Chord, const std::vector <int>& SpecKeyChord)
@@ -117,7 +214,57 @@ bool InputHandler::GetIsKeyChordPressed(const std::vector<unsigned char>& Chord,
 			return false;
 	}
 
-	return true; 
+	return true;
 }
 
+bool InputHandler::ConsumeKeyPress(unsigned char Key)
+{
+	const bool IsPressed = m_KeyPresses[Key];
+	m_KeyPresses[Key] = false;
+	return IsPressed;
+}
 
+bool InputHandler::ConsumeKeyChordPress(const std::vector<unsigned char>& Chord, const std::vector<int>& SpecKeyChord)
+{
+	if (!GetIsKeyChordPressed(Chord, SpecKeyChord))
+		return false;
+	bool IsPressed = false;
+	for (auto Key : Chord)
+		IsPressed = ConsumeKeyPress(Key) || IsPressed;
+	for (auto SpecKey : SpecKeyChord)
+	{
+		IsPressed = IsPressed || m_SpecKeyPresses[SpecKey];
+		m_SpecKeyPresses[SpecKey] = false;
+	}
+	return IsPressed;
+}
+
+bool InputHandler::ConsumeMousePress(int Button)
+{
+	if (Button < 0 || Button >= INPUT_MOUSE_BUTTON_COUNT)
+		return false;
+	const bool IsPressed = m_MousePresses[Button];
+	m_MousePresses[Button] = false;
+	return IsPressed;
+}
+
+uint64_t InputHandler::TakeFrameInputTimestamp()
+{
+	const uint64_t Timestamp = m_OldestEventTimestamp;
+	m_OldestEventTimestamp = 0;
+	return Timestamp;
+}
+
+void InputHandler::AddLatencySample(double LatencyMs)
+{
+	m_LastLatencyMs = LatencyMs;
+	m_LatencySumMs += LatencyMs;
+	m_LatencyMaxMs = std::max(m_LatencyMaxMs, LatencyMs);
+	if (++m_LatencySamples < INPUT_LATENCY_REPORT_SAMPLES)
+		return;
+	std::cout << "InputHandler::AddLatencySample() => Input latency over " << m_LatencySamples << " frames: average "
+		<< m_LatencySumMs / m_LatencySamples << " ms, max " << m_LatencyMaxMs << " ms" << std::endl;
+	m_LatencySumMs = 0.0;
+	m_LatencyMaxMs = 0.0;
+	m_LatencySamples = 0;
+}
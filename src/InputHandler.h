@@ -1,13 +1,55 @@
 #pragma once
 #include "pgr.h"
+#include "SpscRing.h"
 #include <vector>
-#include <map>
+#include <bitset>
+#include <cstdint>
 #include <iostream>
-class Application; 
 
+#define INPUT_QUEUE_CAPACITY 1024 // events buffered between two drains, further events are dropped
+#define INPUT_KEY_COUNT 256 // regular and special key codes tracked, larger codes are ignored
+#define INPUT_MOUSE_BUTTON_COUNT 8 // mouse buttons tracked, GLUT reports the wheel as buttons 3 and 4
+#define INPUT_RECENTER_MARGIN 0.25f // fraction of the window size the pointer may leave the center by before it is warped back
+#define INPUT_LATENCY_REPORT_SAMPLES 600 // latency samples averaged by one report
+class Application;
+
+/**
+ * @brief Kind of an input event.
+ */
+enum class InputEventType : uint8_t
+{
+	KeyDown,
+	KeyUp,
+	SpecKeyDown,
+	SpecKeyUp,
+	MouseDown,
+	MouseUp,
+	MouseMove
+};
+
+/**
+ * @brief Input event recorded by a GLUT callback.
+ */
+struct InputEvent
+{
+	InputEventType Type = InputEventType::MouseMove;
+	int Code = 0; /**< Key, special key or mouse button. */
+	glm::vec2 Position = glm::vec2(0.f); /**< Pointer position in window coordinates. */
+	uint64_t Timestamp = 0; /**< Time of the callback in microseconds, see InputHandler::GetTimestamp. */
+};
+
+/**
+ * @brief Collects the input of the window.
+ *
+ * The GLUT callbacks only push timestamped events into a lock-free ring. ProcessEvents drains it on the main loop
+ * into key bitsets, pending presses and an accumulated relative mouse delta. Presses are consumed once by whoever
+ * handles them, so key repeats and long ticks neither repeat nor drop actions. The mouse delta is consumed late,
+ * right before the frame is rendered, and the time from the oldest applied event to the end of the frame on the GPU
+ * is reported as the input latency.
+ */
 class InputHandler
 {
-	friend Application; 
+	friend Application;
 	/**
  * @brief Handles the event when a regular key is pressed.
  *
@@ -35,24 +77,6 @@ class InputHandler
 	 */
 	static void SpecialKeyboardPressed(int specKeyPressed, int mouseX, int mouseY);
 
-	/**
-	 * @brief Forces a regular key to be considered as released.
-	 *
-	 * This function is used to simulate a key release event programmatically.
-	 *
-	 * @param key The ASCII value of the key to be forced down.
-	 */
-	static void ForceKeyDown(unsigned char key);
-
-	/**
-	 * @brief Forces a special key to be considered as released.
-	 *
-	 * This function is used to simulate a special key release event programmatically.
-	 *
-	 * @param specKey The code of the special key to be forced down.
-	 */
-	static void ForceSpecKeyDown(int specKey);
-
 	/**
 	 * @brief Handles the event when a special key is released.
 	 *
@@ -63,7 +87,7 @@ class InputHandler
 	static void SpecialKeyboardReleased(int specKeyReleased, int mouseX, int mouseY);
 
 	/**
-	 * @brief Handles the event when the mouse cursor moves.
+	 * @brief Handles the event when the mouse cursor moves, with or without a pressed button.
 	 *
 	 * @param X The x-coordinate of the new mouse position.
 	 * @param Y The y-coordinate of the new mouse position.
@@ -101,15 +125,31 @@ class InputHandler
 	static void MouseFunc(int buttonPressed, int buttonState, int mouseX, int mouseY);
 
 	/**
-	 * @brief Forces a mouse button to be considered as released.
-	 *
-	 * This function is used to simulate a mouse button released event programmatically.
-	 *
-	 * @param button The code of the mouse button to be forced down.
+	 * @brief Queues an event, dropping it if the ring is full.
 	 */
-	static void ForceMouseDown(int button);
+	static void PushEvent(InputEventType Type, int Code, int X, int Y);
+
 public:
 	/**
+	 * @brief Returns the current time in microseconds of a monotonic clock.
+	 */
+	static uint64_t GetTimestamp();
+
+	/**
+	 * @brief Applies the queued events to the key state, the pending presses and the mouse delta.
+	 * Called on the main loop, as often as the input should be sampled.
+	 */
+	static void ProcessEvents();
+
+	/**
+	 * @brief Checks if events were applied since the last call or a key or mouse button is held, and resets the event flag.
+	 * Held keys keep changing the scene without new events.
+	 *
+	 * @return True if the input may have changed the scene, false otherwise.
+	 */
+	static bool ConsumeActivity();
+
+	/**
  * @brief Checks if a mouse button is currently pressed.
  *
  * @param button The code of the mouse button to check.
@@ -145,13 +185,42 @@ public:
 	static bool GetIsKeyChordPressed(const std::vector<unsigned char>& KeyChord, const std::vector<int>& SpecKeyChord = {});
 
 	/**
-	 * @brief Retrieves the offset of the mouse cursor from the last frame.
+	 * @brief Consumes a press of a regular key. Key repeats are not presses.
+	 *
+	 * @param Key The ASCII value of the key.
+	 * @return True if the key was pressed since its press was last consumed, false otherwise.
+	 */
+	static bool ConsumeKeyPress(unsigned char Key);
+
+	/**
+	 * @brief Consumes a press of a key chord: all keys are held and at least one of them has an unconsumed press.
 	 *
-	 * The offset represents the change in mouse position since the last frame.
+	 * @param KeyChord The ASCII values of the regular keys in the key chord.
+	 * @param SpecKeyChord The special key codes in the key chord.
+	 * @return True if the chord was completed since it was last consumed, false otherwise.
+	 */
+	static bool ConsumeKeyChordPress(const std::vector<unsigned char>& KeyChord, const std::vector<int>& SpecKeyChord = {});
+
+	/**
+	 * @brief Consumes a press of a mouse button.
+	 *
+	 * @param Button The code of the mouse button.
+	 * @return True if the button was pressed since its press was last consumed, false otherwise.
+	 */
+	static bool ConsumeMousePress(int Button);
+
+	/**
+	 * @brief Returns the mouse movement accumulated since the last call and resets it.
 	 *
-	 * @return The offset of the mouse cursor as a 2D vector.
+	 * @return The relative movement of the pointer in pixels.
 	 */
-	static glm::vec2 GetMouseOffset();
+	static glm::vec2 ConsumeMouseDelta();
+
+	/**
+	 * @brief Warps the pointer back to the window center once it strays more than INPUT_RECENTER_MARGIN from it.
+	 * The motion event caused by the warp is not counted as movement.
+	 */
+	static void RecenterPointer();
 
 	/**
 	 * @brief Retrieves the last position of the left mouse click (LMC).
@@ -161,13 +230,45 @@ public:
 	 * @return The last position of the LMC as a 2D vector.
 	 */
 	static glm::vec2 GetLastLMCPosition();
+
+	/**
+	 * @brief Returns the timestamp of the oldest event applied since the last call, 0 if no event was applied.
+	 * The frame rendered next is the first one showing the effect of that event.
+	 */
+	static uint64_t TakeFrameInputTimestamp();
+
+	/**
+	 * @brief Records the latency of a frame from its oldest input event until the GPU finished it.
+	 * Prints the average and the maximum every INPUT_LATENCY_REPORT_SAMPLES samples.
+	 *
+	 * @param LatencyMs The latency in milliseconds.
+	 */
+	static void AddLatencySample(double LatencyMs);
+
+	/**
+	 * @brief Returns the latency of the last measured frame in milliseconds, 0 before the first measurement.
+	 */
+	static double GetLastLatencyMs() { return m_LastLatencyMs; }
+
 private:
-	static std::map <int, bool> m_MouseKeys; 
-	static std::map <int, bool> m_Keys; 
-	static std::map <int, bool> m_SpecKeys; 
+	static SpscRing<InputEvent, INPUT_QUEUE_CAPACITY> m_Events; /**< Events pushed by the callbacks. */
+	static std::atomic<size_t> m_DroppedEvents; /**< Events lost because the ring was full. */
+	static std::bitset<INPUT_MOUSE_BUTTON_COUNT> m_MouseKeys;
+	static std::bitset<INPUT_MOUSE_BUTTON_COUNT> m_MousePresses; /**< Unconsumed mouse button presses. */
+	static std::bitset<INPUT_KEY_COUNT> m_Keys;
+	static std::bitset<INPUT_KEY_COUNT> m_KeyPresses; /**< Unconsumed key presses. */
+	static std::bitset<INPUT_KEY_COUNT> m_SpecKeys;
+	static std::bitset<INPUT_KEY_COUNT> m_SpecKeyPresses; /**< Unconsumed special key presses. */
 	static glm::vec2 m_WindowSize;
-	static glm::vec2 m_CurrentMousePosition; 
-	static glm::vec2 m_LastMousePosition; 
-	static glm::vec2 m_LastLMCPosition; 
+	static glm::vec2 m_LastMousePosition;
+	static bool m_HasMousePosition; /**< Flag indicating m_LastMousePosition holds a received position. */
+	static bool m_IsWarpPending; /**< Flag indicating the pointer was warped and the resulting motion is not movement. */
+	static glm::vec2 m_MouseDelta; /**< Unconsumed relative mouse movement. */
+	static glm::vec2 m_LastLMCPosition;
+	static uint64_t m_OldestEventTimestamp; /**< Oldest event applied since the last TakeFrameInputTimestamp, 0 if none. */
+	static bool m_HasActivity; /**< Flag indicating events were applied since the last ConsumeActivity. */
+	static double m_LastLatencyMs;
+	static double m_LatencySumMs; /**< Sum of the latency samples of the current report. */
+	static double m_LatencyMaxMs; /**< Maximal latency sample of the current report. */
+	static int m_LatencySamples; /**< Number of latency samples of the current report. */
 };
-
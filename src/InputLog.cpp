@@ -0,0 +1,116 @@
+#include "InputLog.h"
+#include <cstring>
+#include <iterator>
+
+bool InputLog::OpenForRecording(const std::string& Filename, float TickTime)
+{
+	m_Stream.open(Filename, std::ios::binary);
+	if (!m_Stream)
+	{
+		std::cerr << "InputLog::OpenForRecording() => Can't create " << Filename << std::endl;
+		return false;
+	}
+	m_TickUs = (uint32_t)(TickTime * 1e6f + 0.5f);
+	const uint32_t Header[3] = { INPUT_LOG_MAGIC, INPUT_LOG_VERSION, m_TickUs };
+	m_Stream.write(reinterpret_cast<const char*>(Header), sizeof(Header));
+	std::cout << "InputLog::OpenForRecording() => Recording input to " << Filename << std::endl;
+	return true;
+}
+
+void InputLog::Write(const InputRecord& Record)
+{
+	if (!m_Stream.is_open())
+		return;
+	m_Stream.put((char)Record.Type);
+	switch (Record.Type)
+	{
+	case InputRecordType::Action:
+	case InputRecordType::SelectCamera:
+	case InputRecordType::Click:
+		m_Stream.put((char)Record.Value);
+		break;
+	case InputRecordType::MouseMove:
+		m_Stream.write(reinterpret_cast<const char*>(&Record.MouseDelta.x), sizeof(float));
+		m_Stream.write(reinterpret_cast<const char*>(&Record.MouseDelta.y), sizeof(float));
+		break;
+	case InputRecordType::EndTick:
+		m_Stream.write(reinterpret_cast<const char*>(&Record.Tick), sizeof(Record.Tick));
+		m_Stream.write(reinterpret_cast<const char*>(&Record.StateHash), sizeof(Record.StateHash));
+		break;
+	default:
+		break;
+	}
+}
+
+void InputLog::Close()
+{
+	if (m_Stream.is_open())
+		m_Stream.close();
+}
+
+bool InputLog::LoadForReplay(const std::string& Filename)
+{
+	std::ifstream f(Filename, std::ios::binary);
+	if (!f)
+	{
+		std::cerr << "InputLog::LoadForReplay() => Can't open " << Filename << std::endl;
+		return false;
+	}
+	m_Data.assign(std::istreambuf_iterator<char>(f), std::istreambuf_iterator<char>());
+	m_ReadOffset = 0;
+
+	uint32_t Header[3] = {};
+	if (!ReadBytes(Header, sizeof(Header)) || Header[0] != INPUT_LOG_MAGIC)
+	{
+		std::cerr << "InputLog::LoadForReplay() => " << Filename << " is not an input log" << std::endl;
+		return false;
+	}
+	if (Header[1] != INPUT_LOG_VERSION)
+	{
+		std::cerr << "InputLog::LoadForReplay() => " << Filename << " has version " << Header[1] << ", expected " << INPUT_LOG_VERSION << std::endl;
+		return false;
+	}
+	m_TickUs = Header[2];
+	if (!m_TickUs)
+	{
+		std::cerr << "InputLog::LoadForReplay() => " << Filename << " has no tick time" << std::endl;
+		return false;
+	}
+	return true;
+}
+
+bool InputLog::Read(InputRecord& Record)
+{
+	uint8_t Type = 0;
+	if (!ReadBytes(&Type, sizeof(Type)))
+		return false;
+	Record = InputRecord();
+	Record.Type = (InputRecordType)Type;
+	switch (Record.Type)
+	{
+	case InputRecordType::Action:
+	case InputRecordType::SelectCamera:
+	case InputRecordType::Click:
+		return ReadBytes(&Record.Value, sizeof(Record.Value));
+	case InputRecordType::ToggleSpotlight:
+	case InputRecordType::TogglePointLights:
+	case InputRecordType::ToggleCameraMovement:
+		return true;
+	case InputRecordType::MouseMove:
+		return ReadBytes(&Record.MouseDelta.x, sizeof(float)) && ReadBytes(&Record.MouseDelta.y, sizeof(float));
+	case InputRecordType::EndTick:
+		return ReadBytes(&Record.Tick, sizeof(Record.Tick)) && ReadBytes(&Record.StateHash, sizeof(Record.StateHash));
+	default:
+		std::cerr << "InputLog::Read() => Unknown record type " << (int)Type << " at offset " << m_ReadOffset - 1 << std::endl;
+		return false;
+	}
+}
+
+bool InputLog::ReadBytes(void* Data, size_t Size)
+{
+	if (m_ReadOffset + Size > m_Data.size())
+		return false;
+	memcpy(Data, m_Data.data() + m_ReadOffset, Size);
+	m_ReadOffset += Size;
+	return true;
+}
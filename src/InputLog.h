@@ -0,0 +1,112 @@
+#pragma once
+#include "pgr.h"
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <iostream>
+#include <fstream>
+
+#define INPUT_LOG_MAGIC 0x4C4E4957u // "WINL" in little endian
+#define INPUT_LOG_VERSION 1u
+
+/*
+ * Input log layout (little endian):
+ *   uint32 Magic, uint32 Version, uint32 TickUs - fixed simulation step in microseconds
+ *   records until the end of the file, each a uint8 InputRecordType followed by its payload:
+ *     Action, SelectCamera, Click       uint8 Value
+ *     Toggle*                           nothing
+ *     MouseMove                         float DeltaX, float DeltaY
+ *     EndTick                           uint32 Tick, uint64 StateHash
+ * The records of a tick precede its EndTick record, in the order they were applied.
+ */
+
+/**
+ * @brief Kind of a recorded input record.
+ */
+enum class InputRecordType : uint8_t
+{
+	Action, /**< InputAction applied for one tick, Value holds the action. */
+	ToggleSpotlight,
+	TogglePointLights,
+	ToggleCameraMovement,
+	SelectCamera, /**< Value holds the camera index. */
+	Click, /**< Value holds the stencil id of the picked object, 0 if nothing pickable was hit. */
+	MouseMove, /**< Relative pointer movement applied to the active camera. */
+	EndTick /**< Closes a tick with the scene state hash after its update. */
+};
+
+/**
+ * @brief Input applied to the scene, as recorded to and replayed from an input log.
+ */
+struct InputRecord
+{
+	InputRecordType Type = InputRecordType::EndTick;
+	uint8_t Value = 0; /**< Action, camera index or picked stencil id. */
+	glm::vec2 MouseDelta = glm::vec2(0.f); /**< Pointer movement in pixels of MouseMove. */
+	uint32_t Tick = 0; /**< Simulation tick closed by EndTick. */
+	uint64_t StateHash = 0; /**< Scene::GetStateHash after the update of the tick closed by EndTick. */
+};
+
+/**
+ * @brief Binary log of the input applied per simulation tick.
+ *
+ * The log stores what the input did, not the raw events: held keys become one action per tick and a click stores
+ * the object it picked, so a replay does not depend on window events, timing or the rendered stencil. Every tick
+ * ends with a hash of the scene state, which lets a replay detect the first tick it diverges at.
+ */
+class InputLog
+{
+public:
+	/**
+	 * @brief Creates a log file and writes its header.
+	 *
+	 * @param Filename The name of the log file.
+	 * @param TickTime The fixed simulation step in seconds.
+	 * @return True if the file was created, false otherwise.
+	 */
+	bool OpenForRecording(const std::string& Filename, float TickTime);
+
+	/**
+	 * @brief Appends a record. Does nothing if the log is not recording.
+	 */
+	void Write(const InputRecord& Record);
+
+	/**
+	 * @brief Flushes and closes a recorded log.
+	 */
+	void Close();
+
+	/**
+	 * @brief Reads a whole log for replay and validates its header.
+	 *
+	 * @param Filename The name of the log file.
+	 * @return True if the log was loaded, false otherwise.
+	 */
+	bool LoadForReplay(const std::string& Filename);
+
+	/**
+	 * @brief Reads the next record of a loaded log.
+	 *
+	 * @param Record The read record.
+	 * @return True if a record was read, false at the end of the log or on a truncated record.
+	 */
+	bool Read(InputRecord& Record);
+
+	bool GetIsRecording() const { return m_Stream.is_open(); }
+
+	/**
+	 * @brief Returns the fixed simulation step of the log in seconds.
+	 */
+	float GetTickTime() const { return m_TickUs * 1e-6f; }
+
+private:
+	/**
+	 * @brief Copies the next bytes of the loaded log.
+	 */
+	bool ReadBytes(void* Data, size_t Size);
+
+	std::ofstream m_Stream; /**< Output of a recorded log. */
+	std::vector<char> m_Data; /**< Contents of a replayed log. */
+	size_t m_ReadOffset = 0; /**< Offset of the next record in m_Data. */
+	uint32_t m_TickUs = 0;
+};
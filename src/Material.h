@@ -1,9 +1,14 @@
 #pragma once
 #include "glm/vec3.hpp"
+#include <string>
+#include <cstdint>
+
+#define MATERIAL_DEFAULT_SHADER "light" // program of the lit pass used by materials which name none
 /**
  * @brief Represents the material properties of an object.
  *
  * The material determines how light interacts with the object's surface.
+ * Materials are defined in the material file and owned by MaterialLibrary, meshes keep copies.
  */
 class Material
 {
@@ -31,5 +36,11 @@ public:
 	glm::vec3 m_DiffuseColor;    /**< The diffuse color of the material. */
 	glm::vec3 m_SpecularColor;   /**< The specular color of the material. */
 	float m_Shininess;           /**< The shininess coefficient of the material. */
+
+	std::string m_Name = "Default"; /**< The name of the material in the material file. */
+	uint16_t m_Id = 0;              /**< Stable ID, index into the material uniform buffer and part of the draw sort keys. */
+	std::string m_ShaderName = MATERIAL_DEFAULT_SHADER; /**< The program of the lit pass. */
+	std::string m_DiffuseTexture;   /**< Texture file replacing the diffuse textures of the model, empty if none. */
+	std::string m_SpecularTexture;  /**< Texture file replacing the specular textures of the model, empty if none. */
 };
 
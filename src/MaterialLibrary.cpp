@@ -0,0 +1,219 @@
+#include "MaterialLibrary.h"
+#include "GLStateCache.h"
+#include <fstream>
+#include <sstream>
+#include <algorithm>
+#include <cstring>
+
+std::vector<Material> MaterialLibrary::s_Materials = { MaterialLibrary::GetBuiltinDefault() };
+std::vector<std::pair<std::string, uint16_t>> MaterialLibrary::s_ObjectPrefixes = {};
+std::vector<std::string> MaterialLibrary::s_ShaderNames = { MATERIAL_DEFAULT_SHADER };
+std::vector<uint8_t> MaterialLibrary::s_ShaderIndices = { 0 };
+std::vector<std::vector<Texture>> MaterialLibrary::s_Textures = {};
+std::vector<TextureArrayLayer> MaterialLibrary::s_Layers = {};
+GLuint MaterialLibrary::s_UniformBuffer = 0;
+const std::string MaterialLibrary::s_TexturesFolder = "resources/textures/";
+
+bool MaterialLibrary::LoadFromFile(const std::string& Filename)
+{
+	std::ifstream f(Filename);
+	if (!f)
+	{
+		std::cerr << "MaterialLibrary::LoadFromFile() => Can't open material file: " << Filename << std::endl;
+		return false;
+	}
+
+	std::vector<Material> Materials = { GetBuiltinDefault() };
+	std::vector<std::pair<std::string, uint16_t>> ObjectPrefixes;
+	Material* Current = nullptr;
+	std::string Line;
+	for (int LineNumber = 1; std::getline(f, Line); LineNumber++)
+	{
+		Line = Line.substr(0, Line.find('#'));
+		std::istringstream Stream(Line);
+		std::string Keyword;
+		if (!(Stream >> Keyword))
+			continue;
+
+		bool IsValid = true;
+		if (Keyword == "material")
+		{
+			std::string Name;
+			IsValid = (bool)(Stream >> Name);
+			auto Existing = std::find_if(Materials.begin() + 1, Materials.end(), [&Name](const Material& Mat) { return Mat.m_Name == Name; });
+			if (IsValid && Existing != Materials.end())
+			{
+				std::cerr << "MaterialLibrary::LoadFromFile() => Material defined twice: " << Name << std::endl;
+				return false;
+			}
+			if (IsValid && Name == MATERIAL_DEFAULT_NAME)
+				Current = &Materials[0];
+			else if (IsValid)
+			{
+				if (Materials.size() >= MATERIAL_MAX_COUNT)
+				{
+					std::cerr << "MaterialLibrary::LoadFromFile() => More than " << MATERIAL_MAX_COUNT << " materials in " << Filename << std::endl;
+					return false;
+				}
+				Material Mat = Materials[0];
+				Mat.m_Name = Name;
+				Mat.m_Id = (uint16_t)Materials.size();
+				Mat.m_DiffuseTexture.clear();
+				Mat.m_SpecularTexture.clear();
+				Materials.push_back(Mat);
+				Current = &Materials.back();
+			}
+		}
+		else if (!Current)
+			IsValid = false;
+		else if (Keyword == "ambient")
+			IsValid = ReadColor(Stream, Current->m_AmbientColor);
+		else if (Keyword == "diffuse")
+			IsValid = ReadColor(Stream, Current->m_DiffuseColor);
+		else if (Keyword == "specular")
+			IsValid = ReadColor(Stream, Current->m_SpecularColor);
+		else if (Keyword == "shininess")
+			IsValid = (bool)(Stream >> Current->m_Shininess);
+		else if (Keyword == "shader")
+			IsValid = (bool)(Stream >> Current->m_ShaderName);
+		else if (Keyword == "diffuse_texture")
+			IsValid = (bool)(Stream >> Current->m_DiffuseTexture);
+		else if (Keyword == "specular_texture")
+			IsValid = (bool)(Stream >> Current->m_SpecularTexture);
+		else if (Keyword == "objects")
+		{
+			std::string Prefix;
+			while (Stream >> Prefix)
+				ObjectPrefixes.push_back({ Prefix, Current->m_Id });
+		}
+		else
+			IsValid = false;
+
+		if (!IsValid)
+		{
+			std::cerr << "MaterialLibrary::LoadFromFile() => Error in " << Filename << " line " << LineNumber << ": " << Line << std::endl;
+			return false;
+		}
+	}
+
+	s_Materials = std::move(Materials);
+	s_ObjectPrefixes = std::move(ObjectPrefixes);
+	s_ShaderNames.clear();
+	s_ShaderIndices.clear();
+	for (const Material& Mat : s_Materials)
+	{
+		auto Shader = std::find(s_ShaderNames.begin(), s_ShaderNames.end(), Mat.m_ShaderName);
+		s_ShaderIndices.push_back((uint8_t)(Shader - s_ShaderNames.begin()));
+		if (Shader == s_ShaderNames.end())
+			s_ShaderNames.push_back(Mat.m_ShaderName);
+	}
+	std::cout << "MaterialLibrary::LoadFromFile() => Loaded " << s_Materials.size() << " materials from " << Filename << std::endl;
+	return true;
+}
+
+const Material& MaterialLibrary::GetMaterialForObject(const std::string& ObjectName)
+{
+	size_t MatchLength = 0;
+	uint16_t Id = 0;
+	for (const auto& Prefix : s_ObjectPrefixes)
+	{
+		if (Prefix.first.size() > MatchLength && ObjectName.compare(0, Prefix.first.size(), Prefix.first) == 0)
+		{
+			MatchLength = Prefix.first.size();
+			Id = Prefix.second;
+		}
+	}
+	return s_Materials[Id];
+}
+
+const Material* MaterialLibrary::FindMaterial(const std::string& Name)
+{
+	for (const Material& Mat : s_Materials)
+	{
+		if (Mat.m_Name == Name)
+			return &Mat;
+	}
+	return nullptr;
+}
+
+bool MaterialLibrary::UploadToGPU()
+{
+	std::vector<MaterialUniforms> Uniforms(MATERIAL_MAX_COUNT, MaterialUniforms{});
+	for (const Material& Mat : s_Materials)
+	{
+		MaterialUniforms& Constants = Uniforms[Mat.m_Id];
+		Constants.AmbientColor = Mat.m_AmbientColor;
+		Constants.DiffuseColor = Mat.m_DiffuseColor;
+		Constants.SpecularColor = Mat.m_SpecularColor;
+		Constants.Shininess = Mat.m_Shininess;
+	}
+	if (!s_UniformBuffer)
+		glGenBuffers(1, &s_UniformBuffer);
+	if (!s_UniformBuffer)
+	{
+		std::cerr << "MaterialLibrary::UploadToGPU() => Can't create material uniform buffer" << std::endl;
+		return false;
+	}
+	// the whole array is allocated, the shader declares all MATERIAL_MAX_COUNT elements
+	GLStateCache::BindBuffer(GL_UNIFORM_BUFFER, s_UniformBuffer);
+	glBufferData(GL_UNIFORM_BUFFER, Uniforms.size() * sizeof(MaterialUniforms), Uniforms.data(), GL_STATIC_DRAW);
+
+	for (const TextureArrayLayer& Layer : s_Layers)
+		TextureArrayPool::Release(Layer);
+	s_Layers.clear();
+	s_Textures.assign(s_Materials.size(), {});
+	for (const Material& Mat : s_Materials)
+	{
+		const std::pair<std::string, std::string> Files[] = {
+			{ "texture_diffuse", Mat.m_DiffuseTexture },
+			{ "texture_specular", Mat.m_SpecularTexture } };
+		for (const auto& File : Files)
+		{
+			TextureImage Image;
+			if (File.second.empty() || !LoadTextureImage((s_TexturesFolder + File.second).c_str(), Image))
+				continue;
+			TextureArrayLayer Layer = TextureArrayPool::Acquire(s_TexturesFolder + File.second, Image);
+			FreeTextureImage(Image);
+			if (!Layer.Texture)
+				continue;
+			s_Textures[Mat.m_Id].push_back({ Layer.Texture, File.first, File.second, Layer.Layer });
+			s_Layers.push_back(Layer);
+		}
+	}
+	TextureArrayPool::UpdateMipmaps();
+	CHECK_GL_ERROR();
+	return true;
+}
+
+void MaterialLibrary::Bind()
+{
+	GLStateCache::BindUniformBufferRange(MATERIAL_UNIFORM_BINDING, s_UniformBuffer, 0, MATERIAL_MAX_COUNT * sizeof(MaterialUniforms));
+}
+
+const std::vector<Texture>& MaterialLibrary::GetTextures(uint16_t Id)
+{
+	static const std::vector<Texture> None;
+	return Id < s_Textures.size() ? s_Textures[Id] : None;
+}
+
+uint64_t MaterialLibrary::GetSortKey(uint16_t MaterialId, float Depth)
+{
+	// the bit patterns of non-negative floats grow with their values, the top 24 of the 31 used bits keep the order
+	uint32_t DepthBits;
+	Depth = std::max(Depth, 0.0f);
+	std::memcpy(&DepthBits, &Depth, sizeof(DepthBits));
+	const uint64_t Shader = MaterialId < s_ShaderIndices.size() ? s_ShaderIndices[MaterialId] : 0;
+	return Shader << 56 | (uint64_t)MaterialId << 40 | (uint64_t)(DepthBits >> 7) << 16;
+}
+
+Material MaterialLibrary::GetBuiltinDefault()
+{
+	Material Mat(glm::vec3(0.15f), glm::vec3(0.75f), glm::vec3(0.5f), 48);
+	Mat.m_Name = MATERIAL_DEFAULT_NAME;
+	return Mat;
+}
+
+bool MaterialLibrary::ReadColor(std::istream& Stream, glm::vec3& Color)
+{
+	return (bool)(Stream >> Color.x >> Color.y >> Color.z);
+}
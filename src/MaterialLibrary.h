@@ -0,0 +1,104 @@
+#pragma once
+#include "pgr.h"
+#include "Material.h"
+#include "MeshGeometry.h"
+#include "TextureArrayPool.h"
+#include <string>
+#include <vector>
+#include <iostream>
+
+#define MATERIAL_LIBRARY_FILE "resources/materials/material.txt"
+#define MATERIAL_MAX_COUNT 256 // elements of the MaterialData uniform block, 48 bytes each
+#define MATERIAL_DEFAULT_NAME "Default" // material with ID 0, used by objects no other material claims
+
+/**
+ * @brief Materials loaded from the material file.
+ *
+ * The file lists blocks starting with "material <name>" followed by the keywords ambient, diffuse and specular with
+ * three components, shininess, shader, diffuse_texture, specular_texture and objects, a list of object name
+ * prefixes which use the material. The default material always has ID 0, the other materials get IDs in the order
+ * of the file, so the IDs are stable as long as new materials are appended.
+ * The constants of all materials live in one uniform buffer indexed by the material ID the draws pass in their
+ * object data, switching materials between draws changes no uniforms.
+ */
+class MaterialLibrary
+{
+public:
+	/**
+	 * @brief Loads the materials from a file, replacing the loaded materials.
+	 *
+	 * @param Filename The path to the material file.
+	 * @return True if the file was parsed successfully, false otherwise.
+	 */
+	static bool LoadFromFile(const std::string& Filename);
+
+	/**
+	 * @brief Returns the material of an object: the material with the longest object name prefix matching the name,
+	 * the default material if none does.
+	 */
+	static const Material& GetMaterialForObject(const std::string& ObjectName);
+
+	/**
+	 * @brief Returns the material with the given name, nullptr if there is none.
+	 */
+	static const Material* FindMaterial(const std::string& Name);
+
+	/**
+	 * @brief Returns the names of the shaders used by the materials, indexed by the shader bits of the sort keys.
+	 */
+	static const std::vector<std::string>& GetShaderNames() { return s_ShaderNames; }
+
+	/**
+	 * @brief Fills the material uniform buffer and packs the material textures. Must be called on the GL thread.
+	 *
+	 * @return True if the uniform buffer was created, false otherwise.
+	 */
+	static bool UploadToGPU();
+
+	/**
+	 * @brief Binds the material uniform buffer to MATERIAL_UNIFORM_BINDING.
+	 */
+	static void Bind();
+
+	/**
+	 * @brief Returns the textures replacing the model textures of a material, empty if the material has none.
+	 */
+	static const std::vector<Texture>& GetTextures(uint16_t Id);
+
+	/**
+	 * @brief Builds the draw sort key of a material.
+	 *
+	 * The shader index takes the top 8 bits and the material ID the next 16, so sorted draws switch programs and
+	 * materials as rarely as possible. The low 24 bits order the draws of a material front to back.
+	 *
+	 * @param MaterialId The material ID of the draw.
+	 * @param Depth The distance of the draw from the camera.
+	 * @return The sort key.
+	 */
+	static uint64_t GetSortKey(uint16_t MaterialId, float Depth);
+
+	/**
+	 * @brief Returns the shader index stored in a sort key.
+	 */
+	static size_t GetSortKeyShader(uint64_t SortKey) { return (size_t)(SortKey >> 56); }
+
+private:
+	/**
+	 * @brief Returns the material used when the file doesn't define the default material.
+	 */
+	static Material GetBuiltinDefault();
+
+	/**
+	 * @brief Reads three components of a color keyword.
+	 */
+	static bool ReadColor(std::istream& Stream, glm::vec3& Color);
+
+	static std::vector<Material> s_Materials; /**< Loaded materials indexed by ID. */
+	static std::vector<std::pair<std::string, uint16_t>> s_ObjectPrefixes; /**< Object name prefixes with their material. */
+	static std::vector<std::string> s_ShaderNames; /**< Distinct shaders of the materials in ID order. */
+	static std::vector<uint8_t> s_ShaderIndices; /**< Index into s_ShaderNames of every material. */
+	static std::vector<std::vector<Texture>> s_Textures; /**< Packed texture replacements of every material. */
+	static std::vector<TextureArrayLayer> s_Layers; /**< Texture array layers acquired for the materials. */
+	static GLuint s_UniformBuffer; /**< The MaterialData uniform buffer. */
+	const static std::string s_TexturesFolder;
+};
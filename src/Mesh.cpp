@@ -1,7 +1,16 @@
 #include "Mesh.h"
+#include "MaterialLibrary.h"
 
 
 bool Mesh::LoadFromFile(const std::string & filename )
+{
+	if (!LoadDataFromFile(filename))
+		return false;
+	UploadToGPU();
+	return true;
+}
+
+bool Mesh::LoadDataFromFile(const std::string& filename)
 {
 	Assimp::Importer importer;
 	m_Path = m_ModelsFolder + filename;
@@ -22,6 +31,91 @@ bool Mesh::LoadFromFile(const std::string & filename )
     return true;
 }
 
+void Mesh::UploadToGPU()
+{
+	for (auto& MeshGeometry : m_Geometry)
+	{
+		MeshGeometry.SetCPURetention(m_Retention);
+		MeshGeometry.UploadToGPU();
+	}
+}
+
+void Mesh::UploadTexturesOnly()
+{
+	for (auto& MeshGeometry : m_Geometry)
+	{
+		MeshGeometry.SetCPURetention(m_Retention);
+		MeshGeometry.UploadTexturesOnly();
+	}
+}
+
+void Mesh::SetCPURetention(CPURetention Retention)
+{
+	m_Retention = Retention;
+	for (auto& MeshGeometry : m_Geometry)
+		MeshGeometry.SetCPURetention(Retention);
+}
+
+void Mesh::Unload()
+{
+	for (auto& MeshGeometry : m_Geometry)
+		MeshGeometry.Unload();
+	m_Geometry.clear();
+}
+
+size_t Mesh::GetMemoryUsage() const
+{
+	size_t Bytes = 0;
+	for (const auto& MeshGeometry : m_Geometry)
+		Bytes += MeshGeometry.GetMemoryUsage();
+	return Bytes;
+}
+
+size_t Mesh::GetCPUMemoryUsage() const
+{
+	size_t Bytes = 0;
+	for (const auto& MeshGeometry : m_Geometry)
+		Bytes += MeshGeometry.GetCPUMemoryUsage();
+	return Bytes;
+}
+
+size_t Mesh::GetGPUMemoryUsage() const
+{
+	size_t Bytes = 0;
+	for (const auto& MeshGeometry : m_Geometry)
+		Bytes += MeshGeometry.GetGPUMemoryUsage();
+	return Bytes;
+}
+
+bool Mesh::GetBounds(glm::vec3& Min, glm::vec3& Max) const
+{
+	bool HasBounds = false;
+	for (const auto& MeshGeometry : m_Geometry)
+	{
+		glm::vec3 GeometryMin, GeometryMax;
+		if (!MeshGeometry.GetBounds(GeometryMin, GeometryMax))
+			continue;
+		Min = HasBounds ? glm::min(Min, GeometryMin) : GeometryMin;
+		Max = HasBounds ? glm::max(Max, GeometryMax) : GeometryMax;
+		HasBounds = true;
+	}
+	return HasBounds;
+}
+
+size_t Mesh::GetTriangleCount() const
+{
+	size_t Triangles = 0;
+	for (const auto& MeshGeometry : m_Geometry)
+		Triangles += MeshGeometry.GetTriangleCount();
+	return Triangles;
+}
+
+void Mesh::AppendTriangles(std::vector<glm::vec3>& Triangles) const
+{
+	for (const auto& MeshGeometry : m_Geometry)
+		MeshGeometry.AppendTriangles(Triangles);
+}
+
 std::string Mesh::GetPath() const
 {
 	return m_Path;
@@ -31,7 +125,7 @@ void Mesh::Render(const Shader& shader)
 {
 	for (auto& MeshGeometry : m_Geometry)
 	{
-		MeshGeometry.Render(shader); 
+		MeshGeometry.Render(shader, MaterialLibrary::GetTextures(m_Material.m_Id)); 
 	}
 }
 
@@ -41,12 +135,18 @@ void Mesh::Render() const
 		MeshGeometry.Render(); 
 }
 
+void Mesh::RenderDepth() const
+{
+	for (auto& MeshGeometry : m_Geometry)
+		MeshGeometry.RenderDepth();
+}
+
 void Mesh::SetMaterial(const Material& material)
 {
 	m_Material = material; 
 }
 
-Material Mesh::GetMaterial() const
+const Material& Mesh::GetMaterial() const
 {
 	return m_Material;
 }
@@ -57,7 +157,7 @@ bool Mesh::LoadGeometryFromAINode( const aiNode* Node, const aiScene* Scene )
 	{
 		aiMesh* _aiMesh = Scene ->mMeshes[Node ->mMeshes[i]];
 		MeshGeometry meshGeometry ; 
-		if (!meshGeometry.LoadFromAiMesh(_aiMesh, Scene))
+		if (!meshGeometry.LoadDataFromAiMesh(_aiMesh, Scene))
 		{
 			// TODO: print error 
 			continue; 
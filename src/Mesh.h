@@ -37,6 +37,51 @@ public:
 	 */
 	bool LoadFromFile(const std::string& filename);
 
+	/**
+	 * @brief Loads the mesh data from a file into CPU memory only. Doesn't touch GL, so it can run on a worker thread.
+	 *
+	 * @param filename The path to the mesh file.
+	 * @return True if the mesh data was loaded successfully, false otherwise.
+	 */
+	bool LoadDataFromFile(const std::string& filename);
+
+	/**
+	 * @brief Creates the GPU resources of data loaded by LoadDataFromFile. Must be called on the GL thread.
+	 */
+	void UploadToGPU();
+
+	/**
+	 * @brief Creates only the textures of data loaded by LoadDataFromFile, for meshes whose vertices are uploaded by their owner.
+	 * The CPU copies the retention doesn't keep are released as by UploadToGPU.
+	 */
+	void UploadTexturesOnly();
+
+	/**
+	 * @brief Releases the GPU resources and decoded textures of the mesh.
+	 */
+	void Unload();
+
+	/**
+	 * @brief Sets the data the geometry keeps in system memory after the upload, see CPURetention.
+	 * Picking and collision must request it before UploadToGPU, by default the CPU copies are released.
+	 */
+	void SetCPURetention(CPURetention Retention);
+
+	/**
+	 * @brief Returns the approximate memory used by the mesh in bytes.
+	 */
+	size_t GetMemoryUsage() const;
+
+	/**
+	 * @brief Returns the system memory held by the geometry of the mesh in bytes.
+	 */
+	size_t GetCPUMemoryUsage() const;
+
+	/**
+	 * @brief Returns the GPU memory of the geometry of the mesh in bytes, including its texture layers.
+	 */
+	size_t GetGPUMemoryUsage() const;
+
 	/**
 	 * @brief Gets the path of the mesh file.
 	 *
@@ -56,6 +101,11 @@ public:
 	 */
 	virtual void Render() const;
 
+	/**
+	 * @brief Renders the position-only vertex streams of the mesh, for depth-only passes.
+	 */
+	void RenderDepth() const;
+
 	/**
 	 * @brief Sets the material properties for the mesh.
 	 *
@@ -68,7 +118,7 @@ public:
 	 *
 	 * @return The material properties of the mesh.
 	 */
-	Material GetMaterial() const;
+	const Material& GetMaterial() const;
 
 	/**
 	 * @brief Gets the geometry data of the mesh.
@@ -77,6 +127,28 @@ public:
 	 */
 	const std::vector<MeshGeometry>& GetMeshGeometry() const;
 
+	/**
+	 * @brief Returns the local axis aligned bounds of all geometry of the mesh.
+	 *
+	 * @param Min The minimal corner.
+	 * @param Max The maximal corner.
+	 * @return False if the mesh has no vertices.
+	 */
+	bool GetBounds(glm::vec3& Min, glm::vec3& Max) const;
+
+	/**
+	 * @brief Returns the number of triangles of all geometry of the mesh.
+	 */
+	size_t GetTriangleCount() const;
+
+	/**
+	 * @brief Appends the vertex locations of all triangles of the mesh, three per triangle. Appends nothing for
+	 * geometry which released its triangles after the upload.
+	 *
+	 * @param Triangles The triangle list to append to.
+	 */
+	void AppendTriangles(std::vector<glm::vec3>& Triangles) const;
+
 private:
 	/**
 	 * @brief Loads the geometry data from an aiNode.
@@ -88,6 +160,7 @@ private:
 	bool LoadGeometryFromAINode(const aiNode* Node, const aiScene* Scene);
 
 	std::vector<MeshGeometry> m_Geometry;   /**< The geometry data of the mesh. */
+	CPURetention m_Retention = CPURetention::None; /**< Data the geometry keeps after the upload. */
 	Material m_Material;                    /**< The material properties of the mesh. */
 	std::string m_Path;                     /**< The path of the mesh file. */
 	const std::string m_ModelsFolder = "resources/models/";     /**< The folder path for model files. */
@@ -1,29 +1,131 @@
 #include "MeshGeometry.h"
+#include "GLStateCache.h"
+#include "FrameAllocator.h"
 #define STB_IMAGE_IMPLEMENTATION
 #include "stb_image.h"
 
-std::vector <Texture> MeshGeometry::LoadedTextures = {};
+RenderStats MeshGeometry::s_RenderStats = {};
 
 
-std::vector<Texture> MeshGeometry::GetTextureData() const
+ConstSpan<Texture> MeshGeometry::GetTextureData() const
 {
 	return m_Textures; 
 }
 
-std::vector<Vertex> MeshGeometry::GetVerticisData() const
+ConstSpan<Vertex> MeshGeometry::GetVerticisData() const
 {
 	return m_Vertices; 
 }
 
-std::vector <unsigned int> MeshGeometry::GetIndicisData() const
+ConstSpan<unsigned int> MeshGeometry::GetIndicisData() const
 {
 	return m_Indicis;
 }
 
+const RenderStats& MeshGeometry::GetRenderStats()
+{
+	return s_RenderStats;
+}
+
+void MeshGeometry::ResetRenderStats()
+{
+	s_RenderStats = {};
+}
+
+void MeshGeometry::CountDrawCall(size_t Triangles, size_t Objects)
+{
+	s_RenderStats.DrawCalls++;
+	s_RenderStats.Triangles += Triangles;
+	s_RenderStats.Objects += Objects;
+}
+
+void MeshGeometry::CountObject()
+{
+	s_RenderStats.Objects++;
+}
+
+void MeshGeometry::CountBufferStall(double Milliseconds)
+{
+	s_RenderStats.BufferStalls++;
+	s_RenderStats.BufferStallTimeMs += Milliseconds;
+}
+
+void MeshGeometry::CountOccludedObject()
+{
+	s_RenderStats.OccludedObjects++;
+}
+
+void MeshGeometry::CountStateChange(bool IsElided)
+{
+	if (IsElided)
+		s_RenderStats.ElidedStateChanges++;
+	else
+		s_RenderStats.StateChanges++;
+}
+
+void MeshGeometry::CountFrameMemory(size_t HeapAllocations, size_t FrameAllocatorBytes)
+{
+	s_RenderStats.HeapAllocations = HeapAllocations;
+	s_RenderStats.FrameAllocatorBytes = FrameAllocatorBytes;
+}
+
+void MeshGeometry::CountPassGpuTime(double DepthPrepassMs, double MainPassMs)
+{
+	s_RenderStats.DepthPrepassGpuMs = DepthPrepassMs;
+	s_RenderStats.MainPassGpuMs = MainPassMs;
+}
+
+void MeshGeometry::CountSceneGpuTime(double SceneMs, double ResolutionScale)
+{
+	s_RenderStats.SceneGpuMs = SceneMs;
+	s_RenderStats.ResolutionScale = ResolutionScale;
+}
+
+bool MeshGeometry::GetBounds(glm::vec3& Min, glm::vec3& Max) const
+{
+	if (!m_VertexCount)
+		return false;
+	Min = m_BoundsMin;
+	Max = m_BoundsMax;
+	return true;
+}
+
+void MeshGeometry::AppendTriangles(std::vector<glm::vec3>& Triangles) const
+{
+	const bool HasVertices = !m_Vertices.empty();
+	if (!HasVertices && m_Locations.empty())
+		return;
+	if (!m_Indicis.empty())
+	{
+		for (unsigned int Index : m_Indicis)
+			Triangles.push_back(HasVertices ? m_Vertices[Index].Location : m_Locations[Index]);
+	}
+	else if (HasVertices)
+	{
+		for (const Vertex& vertex : m_Vertices)
+			Triangles.push_back(vertex.Location);
+	}
+	else
+		Triangles.insert(Triangles.end(), m_Locations.begin(), m_Locations.end());
+}
+
+size_t MeshGeometry::GetTriangleCount() const
+{
+	return (m_IndexCount ? m_IndexCount : m_VertexCount) / 3;
+}
+
 bool MeshGeometry::LoadFromAiMesh(const aiMesh* Mesh, const aiScene* Scene)
 {
 	if ( m_IsLoaded ) 
 		return true;
+	if (!LoadDataFromAiMesh(Mesh, Scene))
+		return false;
+	UploadToGPU(); 
+	return true;
+}
+
+bool MeshGeometry::LoadDataFromAiMesh(const aiMesh* Mesh, const aiScene* Scene)
+{
 	if (!LoadGeometryFromAiMesh ( Mesh ) )
 	{
 		return false;
@@ -33,86 +135,171 @@ bool MeshGeometry::LoadFromAiMesh(const aiMesh* Mesh, const aiScene* Scene)
 	{
 		return false;
 	}
-	
-	LoadGeometryToGPU(); 
+	return true;
+}
 
+void MeshGeometry::UploadToGPU()
+{
+	if (m_IsLoaded)
+		return;
+	UploadPendingTextures();
+	LoadGeometryToGPU(); 
 	m_IsLoaded = true;
-	return true;
 }
 
-bool MeshGeometry::GetIsTextureLoaded(const std::string & Path, size_t & Index )
+void MeshGeometry::UploadTexturesOnly()
+{
+	UploadPendingTextures();
+	ReleaseCPUData();
+}
+
+void MeshGeometry::UploadPendingTextures()
 {
-	for (size_t i = 0; i < MeshGeometry::LoadedTextures.size(); i ++ )
+	for (auto& Pending : m_PendingTextures)
 	{
-		if ( Path == MeshGeometry::LoadedTextures[i].Path )
-		{
-			Index = i; 
-			return true;
-		} 
+		Texture texture = Pending.first;
+		// the pool shares layers between geometries using the same texture file
+		TextureArrayLayer Layer = TextureArrayPool::Acquire(m_TexturesFolder + texture.Path, Pending.second);
+		FreeTextureImage(Pending.second);
+		if (!Layer.Texture)
+			continue;
+		texture.Id = Layer.Texture;
+		texture.Layer = Layer.Layer;
+		m_OwnedLayers.push_back(Layer);
+		m_TextureBytes += TextureArrayPool::GetLayerBytes(Layer);
+		m_Textures.push_back(texture);
+	}
+	TextureArrayPool::UpdateMipmaps();
+	m_PendingTextures.clear();
+}
+
+void MeshGeometry::Unload()
+{
+	for (auto& Pending : m_PendingTextures)
+		FreeTextureImage(Pending.second);
+	m_PendingTextures.clear();
+	for (const TextureArrayLayer& Layer : m_OwnedLayers)
+		TextureArrayPool::Release(Layer);
+	m_OwnedLayers.clear();
+	m_Textures.clear();
+	m_TextureBytes = 0;
+	if (VAO)
+	{
+		GLStateCache::DeleteVertexArrays(1, &VAO);
+		GLStateCache::DeleteBuffers(1, &VBO);
+		GLStateCache::DeleteBuffers(1, &EBO);
+		VAO = VBO = EBO = 0;
 	}
-	Index = -1; 
-	return false;
+	if (m_DepthVAO)
+	{
+		GLStateCache::DeleteVertexArrays(1, &m_DepthVAO);
+		GLStateCache::DeleteBuffers(1, &m_DepthVBO);
+		m_DepthVAO = m_DepthVBO = 0;
+	}
+	m_IsLoaded = false;
+}
+
+void MeshGeometry::SetCPURetention(CPURetention Retention)
+{
+	m_Retention = Retention;
+	if (m_IsLoaded)
+		ReleaseCPUData();
+}
+
+size_t MeshGeometry::GetMemoryUsage() const
+{
+	return GetCPUMemoryUsage() + GetGPUMemoryUsage();
+}
+
+size_t MeshGeometry::GetCPUMemoryUsage() const
+{
+	size_t Bytes = m_Vertices.capacity() * sizeof(Vertex) + m_Locations.capacity() * sizeof(glm::vec3) + m_Indicis.capacity() * sizeof(unsigned int);
+	for (const auto& Pending : m_PendingTextures)
+		Bytes += (size_t)Pending.second.Width * Pending.second.Height * Pending.second.Components;
+	return Bytes;
+}
+
+size_t MeshGeometry::GetGPUMemoryUsage() const
+{
+	// vertex buffer, depth-only location buffer and index buffer
+	const size_t GeometryBytes = VAO ? m_VertexCount * (sizeof(Vertex) + sizeof(glm::vec3)) + m_IndexCount * sizeof(unsigned int) : 0;
+	return GeometryBytes + m_TextureBytes;
 }
 
-void MeshGeometry::Render(const Shader& shader) const
+void MeshGeometry::Render(const Shader& shader, const std::vector<Texture>& MaterialTextures) const
 {
 	
-	BindTextures( shader ); 
+	BindTextures( shader, MaterialTextures ); 
 	Render(); 
-	UnbindTextures(); 
 	
 	
 }
-void MeshGeometry::BindTextures( const Shader & shader ) const
+void MeshGeometry::BindTextures( const Shader & shader, const std::vector<Texture>& MaterialTextures ) const
 {
-	unsigned int diffuseNr = 1;
-	unsigned int specularNr = 1;
-	for (unsigned int i = 0; i < m_Textures.size(); i++)
+	// the first diffuse and specular textures go to units 0 and 1, consecutive draws mostly sample the same arrays
+	// and only the layer uniforms change
+	int DiffuseLayer = -1;
+	int SpecularLayer = -1;
+	auto BindFirst = [&DiffuseLayer, &SpecularLayer](const std::vector<Texture>& Textures)
 	{
-		glActiveTexture(GL_TEXTURE0 + i);
-		std::string number;
-		std::string type = m_Textures[i].Type;
-		if (type == "texture_diffuse")
-			number = std::to_string(diffuseNr++);
-		else if (type == "texture_specular")
-			number = std::to_string(specularNr++);
+		for (const Texture& texture : Textures)
+		{
+			if (texture.Type == "texture_diffuse" && DiffuseLayer < 0)
+			{
+				DiffuseLayer = texture.Layer;
+				GLStateCache::BindTexture(0, GL_TEXTURE_2D_ARRAY, texture.Id);
+			}
+			else if (texture.Type == "texture_specular" && SpecularLayer < 0)
+			{
+				SpecularLayer = texture.Layer;
+				GLStateCache::BindTexture(1, GL_TEXTURE_2D_ARRAY, texture.Id);
+			}
+		}
+	};
+	BindFirst(MaterialTextures);
+	BindFirst(m_Textures);
+	// a missing map must not sample the arrays left bound by the previous draw
+	if (DiffuseLayer < 0)
+		GLStateCache::BindTexture(0, GL_TEXTURE_2D_ARRAY, 0);
+	if (SpecularLayer < 0)
+		GLStateCache::BindTexture(1, GL_TEXTURE_2D_ARRAY, 0);
+	shader.SetIntParameter("material.texture_diffuse1", 0);
+	shader.SetIntParameter("material.texture_specular1", 1);
+	shader.SetIntParameter("material.diffuseLayer", DiffuseLayer);
+	shader.SetIntParameter("material.specularLayer", SpecularLayer);
+	shader.SetBoolParameter("material.hasSpecular", SpecularLayer >= 0);
+	CHECK_GL_ERROR();
+}
 
-		shader.SetIntParameter(("material." + type + number).c_str(), i);
-		glBindTexture(GL_TEXTURE_2D, m_Textures[i].Id);
-		CHECK_GL_ERROR();
-	}
-	if (specularNr > 1)
+void MeshGeometry::Render() const
+{
+	GLStateCache::BindVertexArray(VAO); 
+	if ( m_IndexCount )
 	{
-		shader.SetBoolParameter("material.hasSpecular", true);
+		glDrawElements(GL_TRIANGLES, (GLsizei)m_IndexCount, GL_UNSIGNED_INT, 0); 
+		CountDrawCall(m_IndexCount / 3);
 	}
 	else
-		shader.SetBoolParameter("material.hasSpecular", false);
-
+	{
+		glDrawArrays(GL_TRIANGLES, 0, (GLsizei)m_VertexCount); 
+		CountDrawCall(m_VertexCount / 3);
+	}
 	CHECK_GL_ERROR();
-
 }
 
-void MeshGeometry::UnbindTextures() const
+void MeshGeometry::RenderDepth() const
 {
-	for (unsigned int i = 0; i < m_Textures.size(); i++)
+	GLStateCache::BindVertexArray(m_DepthVAO);
+	if (m_IndexCount)
 	{
-		glActiveTexture(GL_TEXTURE0 + i);
-		glBindTexture(GL_TEXTURE_2D, 0);
+		glDrawElements(GL_TRIANGLES, (GLsizei)m_IndexCount, GL_UNSIGNED_INT, 0);
+		CountDrawCall(m_IndexCount / 3);
 	}
-	CHECK_GL_ERROR(); 
-
-}
-
-void MeshGeometry::Render() const
-{
-	glBindVertexArray(VAO); 
-	if ( !m_Indicis.empty() )
-		glDrawElements(GL_TRIANGLES, m_Indicis.size(), GL_UNSIGNED_INT, 0); 
 	else
 	{
-		glDrawArrays(GL_TRIANGLES, 0, m_Vertices.size()); 
+		glDrawArrays(GL_TRIANGLES, 0, (GLsizei)m_VertexCount);
+		CountDrawCall(m_VertexCount / 3);
 	}
-	glBindVertexArray(0); 
 	CHECK_GL_ERROR();
 }
 
@@ -146,6 +333,8 @@ bool MeshGeometry::LoadGeometryFromAiMesh( const aiMesh* Mesh )
 			vertex.TextureCoords = glm::vec2(0.0f);
 
 		m_Vertices.push_back(vertex);
+		m_BoundsMin = i ? glm::min(m_BoundsMin, vertex.Location) : vertex.Location;
+		m_BoundsMax = i ? glm::max(m_BoundsMax, vertex.Location) : vertex.Location;
 	}
 
 	/* Load indecis  */
@@ -155,6 +344,8 @@ bool MeshGeometry::LoadGeometryFromAiMesh( const aiMesh* Mesh )
 		for (unsigned int j = 0; j < face.mNumIndices; j++)
 			m_Indicis.push_back(face.mIndices[j]);
 	}
+	m_VertexCount = m_Vertices.size();
+	m_IndexCount = m_Indicis.size();
 
 	
 	return true;
@@ -188,21 +379,17 @@ void MeshGeometry::LoadMaterialTexturesFromAiMaterial(const aiMaterial* Material
 	unsigned int TextureCount = Material->GetTextureCount(TextureType); 
 	for (unsigned int i = 0; i < TextureCount; i++)
 	{
-		size_t LoadedIndex; 
 		aiString str;
 		Material ->GetTexture(TextureType, i, &str);
 		Texture texture;
 		std::string TexturePath = m_TexturesFolder + std::string(str.C_Str()); 
-		if (GetIsTextureLoaded(TexturePath, LoadedIndex) )
-		{
-			texture = MeshGeometry::LoadedTextures[i]; 
-			m_Textures.push_back(texture); 
-			continue; 
-		}
-		texture.Id = TextureFromFile(TexturePath.c_str()); // TODO: rewrite texture from file func 
+		TextureImage Image;
+		if (!LoadTextureImage(TexturePath.c_str(), Image))
+			continue;
+		texture.Id = 0; // created by UploadToGPU
 		texture.Type = TypeName;
 		texture.Path = str.C_Str();
-		m_Textures.push_back ( texture );
+		m_PendingTextures.push_back({ texture, Image });
 	}
 }
 
@@ -210,13 +397,15 @@ void MeshGeometry::LoadGeometryToGPU()
 {
 	if (m_Vertices.empty())
 		return;
+	m_VertexCount = m_Vertices.size();
+	m_IndexCount = m_Indicis.size();
 
 	glGenVertexArrays(1, &VAO);
 	glGenBuffers(1, &VBO);
 	glGenBuffers(1, &EBO);
 
-	glBindVertexArray(VAO);
-	glBindBuffer(GL_ARRAY_BUFFER, VBO);
+	GLStateCache::BindVertexArray(VAO);
+	GLStateCache::BindBuffer(GL_ARRAY_BUFFER, VBO);
 	glBufferData(GL_ARRAY_BUFFER, m_Vertices.size() * sizeof(Vertex), &m_Vertices[0], GL_STATIC_DRAW);
 
 
@@ -233,8 +422,40 @@ void MeshGeometry::LoadGeometryToGPU()
 	glEnableVertexAttribArray(2);
 	glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, TextureCoords));
 
-	glBindVertexArray(0);
+	// the depth-only stream fetches 12 bytes per vertex instead of the whole Vertex
+	LinearVector<glm::vec3> Locations(ScopedArena::GetAdapter<glm::vec3>());
+	Locations.reserve(m_Vertices.size());
+	for (const Vertex& vertex : m_Vertices)
+		Locations.push_back(vertex.Location);
+	glGenVertexArrays(1, &m_DepthVAO);
+	glGenBuffers(1, &m_DepthVBO);
+	GLStateCache::BindVertexArray(m_DepthVAO);
+	GLStateCache::BindBuffer(GL_ARRAY_BUFFER, m_DepthVBO);
+	glBufferData(GL_ARRAY_BUFFER, Locations.size() * sizeof(glm::vec3), Locations.data(), GL_STATIC_DRAW);
+	if (!m_Indicis.empty())
+		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
+	glEnableVertexAttribArray(0);
+	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(glm::vec3), (void*)0);
+
+	GLStateCache::BindVertexArray(0);
 
 	CHECK_GL_ERROR(); 
 
+	ReleaseCPUData();
+}
+
+void MeshGeometry::ReleaseCPUData()
+{
+	if (m_Retention == CPURetention::Triangles && m_Locations.empty())
+	{
+		m_Locations.reserve(m_Vertices.size());
+		for (const Vertex& vertex : m_Vertices)
+			m_Locations.push_back(vertex.Location);
+	}
+	if (m_Retention != CPURetention::All)
+		std::vector<Vertex>().swap(m_Vertices);
+	if (m_Retention != CPURetention::Triangles)
+		std::vector<glm::vec3>().swap(m_Locations);
+	if (m_Retention == CPURetention::None)
+		std::vector<unsigned int>().swap(m_Indicis);
 }
@@ -3,6 +3,7 @@
 #include "Shader.h"
 #include "Misc.h"
 #include "FunctionLibrary.h"
+#include "TextureArrayPool.h"
 #include <iostream>
 
 struct Vertex
@@ -14,20 +15,33 @@ struct Vertex
 
 struct Texture
 {
-	unsigned int Id; 
+	unsigned int Id; /**< The GL_TEXTURE_2D_ARRAY holding the texture. */
 	std::string Type;
 	std::string Path; 
+	int Layer = -1; /**< Layer of the texture in the array. */
 };
+/**
+ * @brief Data a geometry keeps in system memory after its upload to the GPU.
+ */
+enum class CPURetention
+{
+	None, /**< Nothing, the default. Counts and bounds stay available. */
+	Triangles, /**< Vertex locations and indices, for occluders and collision. */
+	All /**< Full vertices and indices, for picking and tools reading the vertex attributes. */
+};
+
 class Mesh;
 class Scene; 
 class GameObject; 
 class Eagle; 
+class MicroBenchmarkAccess; 
 class MeshGeometry
 {
 	friend Mesh;
 	friend Scene;
 	friend GameObject;
 	friend Eagle;
+	friend MicroBenchmarkAccess;
 
 public:
 	/**
@@ -46,59 +60,185 @@ public:
 	bool LoadFromAiMesh(const aiMesh* Mesh, const aiScene* Scene);
 
 	/**
-	 * @brief Checks if a texture is loaded.
+	 * @brief Loads the geometry data and decodes the textures of an aiMesh into CPU memory, without touching GL.
 	 *
-	 * @param Path The path to the texture.
-	 * @param Index The index of the loaded texture if found.
-	 * @return True if the texture is loaded, false otherwise.
+	 * @param Mesh The aiMesh to load the data from.
+	 * @param Scene The aiScene containing the mesh.
+	 * @return True if the loading is successful, false otherwise.
+	 */
+	bool LoadDataFromAiMesh(const aiMesh* Mesh, const aiScene* Scene);
+
+	/**
+	 * @brief Creates the textures and buffers of data loaded by LoadDataFromAiMesh. Must be called on the GL thread.
+	 */
+	void UploadToGPU();
+
+	/**
+	 * @brief Creates only the textures of data loaded by LoadDataFromAiMesh and releases the CPU copies the retention
+	 * doesn't keep, for geometry drawn from buffers owned elsewhere. Must be called on the GL thread.
+	 */
+	void UploadTexturesOnly();
+
+	/**
+	 * @brief Releases the GPU resources and decoded textures of the geometry.
 	 */
-	static bool GetIsTextureLoaded(const std::string& Path, size_t& Index);
+	void Unload();
+
+	/**
+	 * @brief Sets the data kept in system memory after the upload. Data already released can't be retained anymore.
+	 */
+	void SetCPURetention(CPURetention Retention);
+
+	/**
+	 * @brief Returns the approximate memory used by the geometry in bytes, the sum of its CPU and GPU memory.
+	 */
+	size_t GetMemoryUsage() const;
+
+	/**
+	 * @brief Returns the system memory held by the geometry: vertex and index copies and decoded textures not yet uploaded.
+	 */
+	size_t GetCPUMemoryUsage() const;
+
+	/**
+	 * @brief Returns the GPU memory of the geometry: vertex and index buffers, texture layers with mipmaps.
+	 */
+	size_t GetGPUMemoryUsage() const;
 
 	/**
 	 * @brief Renders the mesh geometry using the specified shader.
 	 *
 	 * @param shader The shader to use for rendering.
+	 * @param MaterialTextures Textures of the material replacing the textures of the same type of the geometry.
 	 */
-	void Render(const Shader& shader) const;
+	void Render(const Shader& shader, const std::vector<Texture>& MaterialTextures) const;
 
 	/**
 	 * @brief Renders the mesh geometry.
 	 */
 	void Render() const;
 
+	/**
+	 * @brief Renders the mesh geometry from the position-only vertex stream, for depth-only passes.
+	 */
+	void RenderDepth() const;
+
 	/**
 	 * @brief Retrieves the vertex data of the mesh geometry.
 	 *
-	 * @return The vector of vertices.
+	 * @return The vertices, empty after the upload unless CPURetention::All is set.
 	 */
-	std::vector<Vertex> GetVerticisData() const;
+	ConstSpan<Vertex> GetVerticisData() const;
 
 	/**
 	 * @brief Retrieves the index data of the mesh geometry.
 	 *
-	 * @return The vector of indices.
+	 * @return The indices, empty after the upload unless CPURetention::Triangles or All is set.
 	 */
-	std::vector<unsigned int> GetIndicisData() const;
+	ConstSpan<unsigned int> GetIndicisData() const;
 
 	/**
 	 * @brief Retrieves the texture data of the mesh geometry.
 	 *
-	 * @return The vector of textures.
+	 * @return The textures.
 	 */
-	std::vector<Texture> GetTextureData() const;
+	ConstSpan<Texture> GetTextureData() const;
 
-private:
 	/**
-	 * @brief Binds the textures of the mesh geometry to the specified shader.
+	 * @brief Returns the local axis aligned bounds of the vertices.
 	 *
-	 * @param shader The shader to bind the textures to.
+	 * @param Min The minimal corner.
+	 * @param Max The maximal corner.
+	 * @return False if the geometry has no vertices.
+	 */
+	bool GetBounds(glm::vec3& Min, glm::vec3& Max) const;
+
+	/**
+	 * @brief Appends the vertex locations of all triangles, three per triangle. Appends nothing if the triangles
+	 * were released after the upload.
+	 *
+	 * @param Triangles The triangle list to append to.
+	 */
+	void AppendTriangles(std::vector<glm::vec3>& Triangles) const;
+
+	/**
+	 * @brief Returns the number of triangles.
+	 */
+	size_t GetTriangleCount() const;
+
+	/**
+	 * @brief Returns draw statistics accumulated since the last reset.
 	 */
-	void BindTextures(const Shader& shader) const;
+	static const RenderStats& GetRenderStats();
 
 	/**
-	 * @brief Unbinds the textures of the mesh geometry.
+	 * @brief Resets accumulated draw statistics. Called at the start of each frame.
 	 */
-	void UnbindTextures() const;
+	static void ResetRenderStats();
+
+	/**
+	 * @brief Adds a draw call to the accumulated draw statistics.
+	 *
+	 * @param Triangles The number of triangles submitted by the draw call.
+	 * @param Objects The number of game objects rendered by the draw call.
+	 */
+	static void CountDrawCall(size_t Triangles, size_t Objects = 0);
+
+	/**
+	 * @brief Adds a game object to the accumulated draw statistics, for objects whose draw calls are counted by their geometry.
+	 */
+	static void CountObject();
+
+	/**
+	 * @brief Adds a wait for the GPU to release stream buffer memory to the accumulated draw statistics.
+	 *
+	 * @param Milliseconds The duration of the wait.
+	 */
+	static void CountBufferStall(double Milliseconds);
+
+	/**
+	 * @brief Adds an object skipped by occlusion culling to the accumulated draw statistics.
+	 */
+	static void CountOccludedObject();
+
+	/**
+	 * @brief Sets the GPU times of the depth pre-pass and the lit pass in the accumulated draw statistics.
+	 *
+	 * @param DepthPrepassMs GPU time of the depth pre-pass, 0 if it is disabled.
+	 * @param MainPassMs GPU time of the lit pass.
+	 */
+	static void CountPassGpuTime(double DepthPrepassMs, double MainPassMs);
+
+	/**
+	 * @brief Sets the GPU time of the whole scene and its resolution scale in the accumulated draw statistics.
+	 *
+	 * @param SceneMs GPU time of the scene.
+	 * @param ResolutionScale Scale of the width and height the scene was rendered at.
+	 */
+	static void CountSceneGpuTime(double SceneMs, double ResolutionScale);
+
+	/**
+	 * @brief Adds a GL state call of GLStateCache to the accumulated draw statistics.
+	 *
+	 * @param IsElided True if the call was skipped because the value was already in place.
+	 */
+	static void CountStateChange(bool IsElided);
+
+	/**
+	 * @brief Sets the memory use of the frame in the accumulated draw statistics.
+	 *
+	 * @param HeapAllocations The heap allocations of the main thread during the frame.
+	 * @param FrameAllocatorBytes The bytes taken from the frame allocator during the frame.
+	 */
+	static void CountFrameMemory(size_t HeapAllocations, size_t FrameAllocatorBytes);
+
+private:
+	/**
+	 * @brief Binds the textures of the mesh geometry to the specified shader.
+	 *
+	 * @param shader The shader to bind the textures to.
+	 * @param MaterialTextures Textures of the material, they take precedence over the textures of the geometry.
+	 */
+	void BindTextures(const Shader& shader, const std::vector<Texture>& MaterialTextures) const;
 
 	/**
 	 * @brief Loads the geometry data from an aiMesh.
@@ -127,20 +267,41 @@ private:
 	void LoadMaterialTexturesFromAiMaterial(const aiMaterial* Material, aiTextureType TextureType, const std::string& TypeName);
 
 	/**
-	 * @brief Loads the geometry data to the GPU.
+	 * @brief Creates the textures decoded by LoadDataFromAiMesh.
+	 */
+	void UploadPendingTextures();
+
+	/**
+	 * @brief Loads the geometry data to the GPU and releases the CPU copies the retention doesn't keep.
 	 */
 	void LoadGeometryToGPU();
+
+	/**
+	 * @brief Frees the CPU copies of the geometry the retention doesn't keep.
+	 */
+	void ReleaseCPUData();
 	
 
 	std::vector <unsigned int> m_Indicis;
 	std::vector <Vertex> m_Vertices; 
+	std::vector <glm::vec3> m_Locations; /**< Vertex locations kept by CPURetention::Triangles after m_Vertices is released. */
+	size_t m_VertexCount = 0; /**< Number of vertices, kept when the vertices are released. */
+	size_t m_IndexCount = 0; /**< Number of indices, kept when the indices are released. */
+	CPURetention m_Retention = CPURetention::None; /**< Data kept in system memory after the upload. */
 	std::vector <Texture> m_Textures; 
-	static std::vector <Texture> LoadedTextures; 
+	std::vector <std::pair<Texture, TextureImage>> m_PendingTextures; /**< Decoded textures waiting for UploadToGPU. */
+	std::vector <TextureArrayLayer> m_OwnedLayers; /**< Texture array layers acquired by this geometry, released by Unload. */
+	size_t m_TextureBytes = 0; /**< Approximate GPU memory of the acquired layers. */
+	glm::vec3 m_BoundsMin = glm::vec3(0.f); /**< Minimal corner of the local bounds. */
+	glm::vec3 m_BoundsMax = glm::vec3(0.f); /**< Maximal corner of the local bounds. */
+	static RenderStats s_RenderStats; 
 	const std::string m_TexturesFolder = "resources/textures/"; 
 	const std::string m_ModelsFolder = "resources/models/";
-	GLuint VAO; 
-	GLuint VBO; 
-	GLuint EBO; 
+	GLuint VAO = 0; 
+	GLuint VBO = 0; 
+	GLuint EBO = 0; 
+	GLuint m_DepthVAO = 0; /**< Position-only vertex stream sharing the index buffer, used by depth-only passes. */
+	GLuint m_DepthVBO = 0; /**< Tightly packed vertex locations of the depth-only stream. */
 	bool m_IsLoaded = false;
 };
 
@@ -0,0 +1,124 @@
+#include "MicroBenchmark.h"
+#include <iomanip>
+
+const void* volatile MicroBenchmark::s_Sink = nullptr;
+
+MicroBenchmarkState::MicroBenchmarkState(int64_t Arg, uint64_t Iterations)
+	: m_Arg(Arg), m_Iterations(Iterations)
+{
+}
+
+bool MicroBenchmarkState::KeepRunning()
+{
+	if (m_Current == 0)
+		ResumeTiming();
+	if (m_Current < m_Iterations)
+	{
+		m_Current++;
+		return true;
+	}
+	PauseTiming();
+	return false;
+}
+
+int64_t MicroBenchmarkState::GetArg() const
+{
+	return m_Arg;
+}
+
+void MicroBenchmarkState::PauseTiming()
+{
+	if (!m_Running)
+		return;
+	m_Elapsed += std::chrono::steady_clock::now() - m_Start;
+	m_Running = false;
+}
+
+void MicroBenchmarkState::ResumeTiming()
+{
+	if (m_Running)
+		return;
+	m_Start = std::chrono::steady_clock::now();
+	m_Running = true;
+}
+
+void MicroBenchmarkState::SetItemsProcessed(int64_t Items)
+{
+	m_ItemsProcessed = Items;
+}
+
+uint64_t MicroBenchmarkState::GetIterations() const
+{
+	return m_Iterations;
+}
+
+double MicroBenchmarkState::GetElapsedNs() const
+{
+	return (double)std::chrono::duration_cast<std::chrono::nanoseconds>(m_Elapsed).count();
+}
+
+int64_t MicroBenchmarkState::GetItemsProcessed() const
+{
+	return m_ItemsProcessed;
+}
+
+std::vector<MicroBenchmark::Case>& MicroBenchmark::GetCases()
+{
+	static std::vector<Case> Cases;
+	return Cases;
+}
+
+int MicroBenchmark::Register(const std::string& Name, const FixtureFactory& Factory, const std::vector<int64_t>& Args)
+{
+	GetCases().push_back({ Name, Factory, Args.empty() ? std::vector<int64_t>{ 0 } : Args });
+	return 0;
+}
+
+bool MicroBenchmark::RunAll(const std::string& Filter, double MinTime)
+{
+	const double MinTimeNs = MinTime * 1e9;
+	const uint64_t MaxIterations = 1ull << 30;
+	bool AnyRun = false;
+
+	std::cout << std::left << std::setw(56) << "Benchmark" << std::right << std::setw(16) << "Time/iter [ns]"
+		<< std::setw(14) << "Iterations" << std::setw(18) << "Items/s" << std::endl;
+	for (const Case& BenchmarkCase : GetCases())
+	{
+		if (!Filter.empty() && BenchmarkCase.Name.find(Filter) == std::string::npos)
+			continue;
+
+		for (int64_t Arg : BenchmarkCase.Args)
+		{
+			std::unique_ptr<MicroBenchmarkFixture> Fixture = BenchmarkCase.Factory();
+			uint64_t Iterations = 1;
+			double ElapsedNs = 0.0;
+			int64_t Items = 0;
+			while (true)
+			{
+				MicroBenchmarkState State(Arg, Iterations);
+				Fixture->SetUp(State);
+				Fixture->Run(State);
+				Fixture->TearDown(State);
+				ElapsedNs = State.GetElapsedNs();
+				Items = State.GetItemsProcessed();
+				if (ElapsedNs >= MinTimeNs || Iterations >= MaxIterations)
+					break;
+				// grow towards the minimal time, at most 10x per step
+				double Multiplier = ElapsedNs > 0.0 ? MinTimeNs * 1.4 / ElapsedNs : 10.0;
+				Multiplier = Multiplier > 10.0 ? 10.0 : (Multiplier < 2.0 ? 2.0 : Multiplier);
+				Iterations = (uint64_t)(Iterations * Multiplier);
+			}
+
+			std::string FullName = BenchmarkCase.Name + "/" + std::to_string(Arg);
+			std::cout << std::left << std::setw(56) << FullName << std::right << std::setw(16) << std::fixed << std::setprecision(1)
+				<< ElapsedNs / Iterations << std::setw(14) << Iterations;
+			if (Items > 0 && ElapsedNs > 0.0)
+				std::cout << std::setw(18) << std::setprecision(0) << Items / (ElapsedNs * 1e-9);
+			std::cout << std::endl;
+			AnyRun = true;
+		}
+	}
+	if (!AnyRun)
+		std::cerr << "MicroBenchmark::RunAll() => No benchmark matches filter: " << Filter << std::endl;
+	return AnyRun;
+}
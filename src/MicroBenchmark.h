@@ -0,0 +1,174 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <memory>
+#include <functional>
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+/**
+ * @brief Timing state passed to a running micro benchmark.
+ *
+ * Mirrors the Google Benchmark state: the benchmark body loops while KeepRunning() returns true
+ * and may exclude setup work from the measurement with PauseTiming()/ResumeTiming().
+ */
+class MicroBenchmarkState
+{
+public:
+	/**
+	 * @brief Constructs the state for a single measured run.
+	 *
+	 * @param Arg The size parameter of the run.
+	 * @param Iterations The number of iterations to run.
+	 */
+	MicroBenchmarkState(int64_t Arg, uint64_t Iterations);
+
+	/**
+	 * @brief Advances the iteration counter. Starts the timer on the first call and stops it after the last iteration.
+	 *
+	 * @return True while there are iterations left, false otherwise.
+	 */
+	bool KeepRunning();
+
+	/**
+	 * @brief Returns the size parameter of the run.
+	 */
+	int64_t GetArg() const;
+
+	/**
+	 * @brief Stops the timer, e.g. for per iteration setup.
+	 */
+	void PauseTiming();
+
+	/**
+	 * @brief Restarts the timer stopped by PauseTiming().
+	 */
+	void ResumeTiming();
+
+	/**
+	 * @brief Sets the number of processed items, used to report throughput.
+	 *
+	 * @param Items The number of items processed in all iterations together.
+	 */
+	void SetItemsProcessed(int64_t Items);
+
+	/**
+	 * @brief Returns the number of iterations of the run.
+	 */
+	uint64_t GetIterations() const;
+
+	/**
+	 * @brief Returns the measured time in nanoseconds.
+	 */
+	double GetElapsedNs() const;
+
+	/**
+	 * @brief Returns the number of processed items set by the benchmark.
+	 */
+	int64_t GetItemsProcessed() const;
+
+private:
+	int64_t m_Arg; /**< The size parameter of the run. */
+	uint64_t m_Iterations; /**< The number of iterations to run. */
+	uint64_t m_Current = 0; /**< The number of started iterations. */
+	int64_t m_ItemsProcessed = 0; /**< The number of processed items. */
+	bool m_Running = false; /**< Flag indicating the timer is running. */
+	std::chrono::steady_clock::time_point m_Start; /**< Start of the currently timed section. */
+	std::chrono::steady_clock::duration m_Elapsed = {}; /**< Sum of all timed sections. */
+};
+
+/**
+ * @brief Base class of micro benchmark fixtures. SetUp and TearDown run outside of the timed section.
+ */
+class MicroBenchmarkFixture
+{
+public:
+	virtual ~MicroBenchmarkFixture() = default;
+
+	/**
+	 * @brief Prepares the fixture data for the given state.
+	 */
+	virtual void SetUp(MicroBenchmarkState& State) {}
+
+	/**
+	 * @brief Releases the fixture data.
+	 */
+	virtual void TearDown(MicroBenchmarkState& State) {}
+
+	/**
+	 * @brief Runs the benchmark body.
+	 */
+	virtual void Run(MicroBenchmarkState& State) = 0;
+};
+
+/**
+ * @brief Registry and runner of the CPU side micro benchmarks.
+ *
+ * Benchmarks are registered statically with MICROBENCHMARK_F and run without a GL context.
+ * Each benchmark runs once per registered size, the iteration count grows until the run takes at least the minimal time.
+ */
+class MicroBenchmark
+{
+public:
+	using FixtureFactory = std::function<std::unique_ptr<MicroBenchmarkFixture>()>;
+
+	/**
+	 * @brief Registers a benchmark.
+	 *
+	 * @param Name The name of the benchmark.
+	 * @param Factory Function creating a new fixture instance.
+	 * @param Args Sizes the benchmark runs with.
+	 * @return Always 0, used for static registration.
+	 */
+	static int Register(const std::string& Name, const FixtureFactory& Factory, const std::vector<int64_t>& Args);
+
+	/**
+	 * @brief Runs all registered benchmarks whose name contains the filter.
+	 *
+	 * @param Filter Substring of the benchmark names to run, empty runs all benchmarks.
+	 * @param MinTime Minimal measured time of a single run in seconds.
+	 * @return True if at least one benchmark ran, false otherwise.
+	 */
+	static bool RunAll(const std::string& Filter, double MinTime = 0.2);
+
+	/**
+	 * @brief Prevents the compiler from optimizing away the computation of the value.
+	 */
+	template <class T>
+	static void DoNotOptimize(const T& Value)
+	{
+		s_Sink = &Value;
+		// compiler barrier, memory the value depends on must be reloaded in the next iteration
+#if defined(_MSC_VER)
+		_ReadWriteBarrier();
+#else
+		asm volatile("" : : "r,m"(Value) : "memory");
+#endif
+	}
+
+private:
+	struct Case
+	{
+		std::string Name;
+		FixtureFactory Factory;
+		std::vector<int64_t> Args;
+	};
+
+	static std::vector<Case>& GetCases();
+
+	static const void* volatile s_Sink; /**< Sink written by DoNotOptimize. */
+};
+
+#define MICROBENCHMARK_F(Fixture, Name, ...) \
+	class Fixture##_##Name : public Fixture \
+	{ \
+	public: \
+		void Run(MicroBenchmarkState& State) override; \
+	}; \
+	static int Fixture##_##Name##_Registered = MicroBenchmark::Register(#Fixture "/" #Name, \
+		[]() { return std::unique_ptr<MicroBenchmarkFixture>(new Fixture##_##Name()); }, { __VA_ARGS__ }); \
+	void Fixture##_##Name::Run(MicroBenchmarkState& State)
@@ -0,0 +1,459 @@
+#include "MicroBenchmark.h"
+#include "Scene.h"
+#include "Config.h"
+#include <sstream>
+#include <cmath>
+
+/**
+ * @brief Gives the benchmark fixtures access to internals of the benchmarked classes.
+ */
+class MicroBenchmarkAccess
+{
+public:
+	static std::vector<std::shared_ptr<GameObject>>& GetGameObjects(Scene& scene) { return scene.m_GameObjects; }
+	static std::shared_ptr<GameObject> FindObjectByName(const Scene& scene, const std::string& Name) { return scene.FindObjectByName(Name); }
+	static std::map<std::string, std::string>& GetVariables(Config& config) { return config.m_Variables; }
+	static bool LoadGeometryFromAiMesh(MeshGeometry& Geometry, const aiMesh* Mesh) { return Geometry.LoadGeometryFromAiMesh(Mesh); }
+	static size_t GetVertexCount(const MeshGeometry& Geometry) { return Geometry.m_VertexCount; }
+};
+
+/**
+ * @brief Batch of pseudo random transforms.
+ */
+class TransformFixture : public MicroBenchmarkFixture
+{
+public:
+	void SetUp(MicroBenchmarkState& State) override
+	{
+		Transforms.clear();
+		for (int64_t i = 0; i < State.GetArg(); i++)
+		{
+			float f = (float)i;
+			Transforms.emplace_back(glm::vec3(f, f * 0.5f, -f), glm::vec3(f * 7.f, f * 13.f, f * 3.f), glm::vec3(1.f + f * 0.01f));
+		}
+	}
+
+	std::vector<Transform> Transforms;
+};
+
+MICROBENCHMARK_F(TransformFixture, ToMat4, 1, 64, 4096)
+{
+	while (State.KeepRunning())
+	{
+		for (const Transform& t : Transforms)
+		{
+			glm::mat4 M = t.ToMat4();
+			MicroBenchmark::DoNotOptimize(M);
+		}
+	}
+	State.SetItemsProcessed(State.GetIterations() * Transforms.size());
+}
+
+MICROBENCHMARK_F(TransformFixture, InverseMultiply, 1, 64, 4096)
+{
+	while (State.KeepRunning())
+	{
+		for (Transform& t : Transforms)
+		{
+			Transform Result = t.Inverse() * t;
+			MicroBenchmark::DoNotOptimize(Result);
+		}
+	}
+	State.SetItemsProcessed(State.GetIterations() * Transforms.size());
+}
+
+/**
+ * @brief Chain of attached scene objects with a camera at its end. The size is the chain depth.
+ */
+class AttachChainFixture : public MicroBenchmarkFixture
+{
+public:
+	void SetUp(MicroBenchmarkState& State) override
+	{
+		Chain.clear();
+		std::shared_ptr<SceneObject> Parent;
+		for (int64_t i = 0; i < State.GetArg(); i++)
+		{
+			auto Object = std::make_shared<SceneObject>("Link" + std::to_string(i), Transform(glm::vec3(0.f, 0.1f, 0.2f), glm::vec3(0.f, 5.f, 0.f), glm::vec3(1.f)));
+			Object->AttachToObject(Parent.get());
+			Chain.push_back(Object);
+			Parent = Object;
+		}
+		ChainCamera = std::make_shared<Camera>("BenchmarkCamera", glm::vec3(0.f, 1.f, -2.f), 10.f, 20.f);
+		ChainCamera->AttachToObject(Parent.get());
+	}
+
+	std::vector<std::shared_ptr<SceneObject>> Chain;
+	std::shared_ptr<Camera> ChainCamera;
+};
+
+MICROBENCHMARK_F(AttachChainFixture, GetWorldModelMatrix, 1, 8, 64)
+{
+	const SceneObject& Leaf = *Chain.back();
+	while (State.KeepRunning())
+	{
+		glm::mat4 M = Leaf.GetWorldModelMatrix();
+		MicroBenchmark::DoNotOptimize(M);
+	}
+	State.SetItemsProcessed(State.GetIterations());
+}
+
+MICROBENCHMARK_F(AttachChainFixture, CameraGetViewMatrix, 1, 8, 64)
+{
+	while (State.KeepRunning())
+	{
+		glm::mat4 V = ChainCamera->GetViewMatrix();
+		MicroBenchmark::DoNotOptimize(V);
+	}
+	State.SetItemsProcessed(State.GetIterations());
+}
+
+/**
+ * @brief Scene with N mesh-less game objects. The lookup targets the last object, the worst case of the linear search.
+ */
+class SceneObjectsFixture : public MicroBenchmarkFixture
+{
+public:
+	void SetUp(MicroBenchmarkState& State) override
+	{
+		auto& Objects = MicroBenchmarkAccess::GetGameObjects(BenchmarkScene);
+		Objects.clear();
+		for (int64_t i = 0; i < State.GetArg(); i++)
+			Objects.push_back(std::make_shared<GameObject>("Object" + std::to_string(i), nullptr, Transform()));
+		LastName = "Object" + std::to_string(State.GetArg() - 1);
+	}
+
+	Scene BenchmarkScene;
+	std::string LastName;
+};
+
+MICROBENCHMARK_F(SceneObjectsFixture, FindObjectByName, 16, 256, 4096)
+{
+	while (State.KeepRunning())
+	{
+		auto Object = MicroBenchmarkAccess::FindObjectByName(BenchmarkScene, LastName);
+		MicroBenchmark::DoNotOptimize(Object);
+	}
+	State.SetItemsProcessed(State.GetIterations());
+}
+
+/**
+ * @brief N game objects, every fourth one starts a new chain of attached objects. Compares walking the shared object
+ * pointers with the pass over the dense transform and render arrays of the entity store.
+ */
+class EntityIterationFixture : public MicroBenchmarkFixture
+{
+public:
+	void SetUp(MicroBenchmarkState& State) override
+	{
+		Objects.clear();
+		for (int64_t i = 0; i < State.GetArg(); i++)
+		{
+			float f = (float)i;
+			auto Object = std::make_shared<GameObject>("Object" + std::to_string(i), nullptr, Transform(glm::vec3(f, 0.f, -f), glm::vec3(0.f, f, 0.f), glm::vec3(1.f)));
+			if (i % 4 != 0)
+				Object->AttachToObject(Objects.back().get());
+			Objects.push_back(Object);
+		}
+	}
+
+	void TearDown(MicroBenchmarkState& State) override
+	{
+		Objects.clear();
+	}
+
+	std::vector<std::shared_ptr<GameObject>> Objects;
+};
+
+MICROBENCHMARK_F(EntityIterationFixture, GameObjects, 1000, 10000, 100000)
+{
+	while (State.KeepRunning())
+	{
+		for (const auto& Object : Objects)
+		{
+			if (!Object->GetIsVisible())
+				continue;
+			glm::mat4 M = Object->GetWorldModelMatrix();
+			MicroBenchmark::DoNotOptimize(M);
+		}
+	}
+	State.SetItemsProcessed(State.GetIterations() * Objects.size());
+}
+
+MICROBENCHMARK_F(EntityIterationFixture, EntityStore, 1000, 10000, 100000)
+{
+	EntityStore& Entities = EntityStore::Get();
+	while (State.KeepRunning())
+	{
+		Entities.UpdateWorldMatrices();
+		const ComponentArray<RenderComponent>& Renders = Entities.GetRenders();
+		for (size_t i = 0; i < Renders.size(); i++)
+		{
+			if ((Renders[i].Flags & RENDER_VISIBLE) == 0)
+				continue;
+			glm::mat4 M = Entities.GetTransforms().Get(Renders.GetEntity(i))->World;
+			MicroBenchmark::DoNotOptimize(M);
+		}
+	}
+	State.SetItemsProcessed(State.GetIterations() * Objects.size());
+}
+
+/**
+ * @brief Config with N integer variables.
+ */
+class ConfigFixture : public MicroBenchmarkFixture
+{
+public:
+	void SetUp(MicroBenchmarkState& State) override
+	{
+		auto& Variables = MicroBenchmarkAccess::GetVariables(BenchmarkConfig);
+		Variables.clear();
+		for (int64_t i = 0; i < State.GetArg(); i++)
+			Variables["VARIABLE_" + std::to_string(i)] = std::to_string(i * 31);
+		Name = "VARIABLE_" + std::to_string(State.GetArg() / 2);
+	}
+
+	Config BenchmarkConfig;
+	std::string Name;
+};
+
+MICROBENCHMARK_F(ConfigFixture, GetVariableAsInt, 8, 64, 1024)
+{
+	while (State.KeepRunning())
+	{
+		int Value = 0;
+		BenchmarkConfig.GetVariableAsInt(Name, Value);
+		MicroBenchmark::DoNotOptimize(Value);
+	}
+	State.SetItemsProcessed(State.GetIterations());
+}
+
+/**
+ * @brief Text scene file with N object records.
+ */
+class SceneFileFixture : public MicroBenchmarkFixture
+{
+public:
+	void SetUp(MicroBenchmarkState& State) override
+	{
+		std::ostringstream Stream;
+		for (int64_t i = 0; i < State.GetArg(); i++)
+		{
+			Stream << "Object" << i << "\n"
+				<< i * 0.5f << " 0.0 " << i * -0.25f << "\n"
+				<< "0.0 " << (i * 15) % 360 << " 0.0\n"
+				<< "1.0 1.0 1.0\n"
+				<< "western_house.obj\n\n";
+		}
+		Text = Stream.str();
+	}
+
+	std::string Text;
+};
+
+MICROBENCHMARK_F(SceneFileFixture, ParseSceneFile, 16, 1024, 16384)
+{
+	while (State.KeepRunning())
+	{
+		std::istringstream Stream(Text);
+		std::vector<SceneObjectDesc> Objects;
+		Scene::ParseSceneFile(Stream, Objects);
+		MicroBenchmark::DoNotOptimize(Objects);
+	}
+	State.SetItemsProcessed(State.GetIterations() * State.GetArg());
+}
+
+/**
+ * @brief Synthetic triangulated aiMesh with N vertices.
+ */
+class AiMeshFixture : public MicroBenchmarkFixture
+{
+public:
+	void SetUp(MicroBenchmarkState& State) override
+	{
+		const unsigned int Vertices = (unsigned int)State.GetArg();
+		Mesh.reset(new aiMesh());
+		Mesh->mNumVertices = Vertices;
+		Mesh->mVertices = new aiVector3D[Vertices];
+		Mesh->mNormals = new aiVector3D[Vertices];
+		Mesh->mTextureCoords[0] = new aiVector3D[Vertices];
+		for (unsigned int i = 0; i < Vertices; i++)
+		{
+			Mesh->mVertices[i].x = (float)i; Mesh->mVertices[i].y = 0.f; Mesh->mVertices[i].z = (float)(i % 7);
+			Mesh->mNormals[i].x = 0.f; Mesh->mNormals[i].y = 1.f; Mesh->mNormals[i].z = 0.f;
+			Mesh->mTextureCoords[0][i].x = (i % 2) * 1.f; Mesh->mTextureCoords[0][i].y = (i % 3) * 0.5f; Mesh->mTextureCoords[0][i].z = 0.f;
+		}
+		Mesh->mNumFaces = Vertices / 3;
+		Mesh->mFaces = new aiFace[Mesh->mNumFaces];
+		for (unsigned int i = 0; i < Mesh->mNumFaces; i++)
+		{
+			Mesh->mFaces[i].mNumIndices = 3;
+			Mesh->mFaces[i].mIndices = new unsigned int[3] { i * 3, i * 3 + 1, i * 3 + 2 };
+		}
+	}
+
+	void TearDown(MicroBenchmarkState& State) override
+	{
+		Mesh.reset(); // aiMesh releases its arrays
+	}
+
+	std::unique_ptr<aiMesh> Mesh;
+};
+
+MICROBENCHMARK_F(AiMeshFixture, LoadGeometryFromAiMesh, 300, 30000, 300000)
+{
+	while (State.KeepRunning())
+	{
+		MeshGeometry Geometry;
+		MicroBenchmarkAccess::LoadGeometryFromAiMesh(Geometry, Mesh.get());
+		MicroBenchmark::DoNotOptimize(MicroBenchmarkAccess::GetVertexCount(Geometry));
+	}
+	State.SetItemsProcessed(State.GetIterations() * State.GetArg());
+}
+
+/**
+ * @brief Particle system with a pool of long living particles. The size is the number of live particles.
+ */
+class ParticleFixture : public MicroBenchmarkFixture
+{
+public:
+	void SetUp(MicroBenchmarkState& State) override
+	{
+		Particles.reset(new ParticleSystem());
+		ParticleEmitterDesc Desc;
+		Desc.Lifetime = 1.e6f;
+		Desc.SpawnExtent = glm::vec3(10.f);
+		Desc.VelocityVariance = glm::vec3(1.f);
+		Desc.Acceleration = glm::vec3(0.f, -9.81f, 0.f);
+		Desc.Drag = 0.1f;
+		Particles->Burst(Particles->AddEmitter(Desc), (int)State.GetArg());
+	}
+
+	std::unique_ptr<ParticleSystem> Particles;
+};
+
+MICROBENCHMARK_F(ParticleFixture, Update, 1024, 16384, 65536)
+{
+	while (State.KeepRunning())
+	{
+		Particles->Update(1.f / 60.f);
+		MicroBenchmark::DoNotOptimize(Particles->GetLiveCount());
+	}
+	State.SetItemsProcessed(State.GetIterations() * State.GetArg());
+}
+
+/**
+ * @brief N unit boxes spread over a square town, 64 camera sized spheres walking through it. The query cost should
+ * stay flat as N grows, since a sweep only tests the colliders of the cells it touches.
+ */
+class CollisionFixture : public MicroBenchmarkFixture
+{
+public:
+	void SetUp(MicroBenchmarkState& State) override
+	{
+		const int Side = (int)std::ceil(std::sqrt((double)State.GetArg()));
+		for (int64_t i = 0; i < State.GetArg(); i++)
+		{
+			const glm::vec3 Location((float)(i % Side) * 3.f, 0.5f, (float)(i / Side) * 3.f);
+			EntityHandle Entity = EntityStore::Get().Create(Transform(Location, glm::vec3(0.f), glm::vec3(1.f)));
+			Entities.push_back(Entity);
+			World.Add(Entity, glm::vec3(-0.5f), glm::vec3(0.5f));
+		}
+		EntityStore::Get().UpdateWorldMatrices();
+		World.Update();
+		for (int i = 0; i < 64; i++)
+		{
+			SphereSweep Sweep;
+			Sweep.Start = glm::vec3((float)(i * 7 % Side) * 3.f + 1.5f, 0.5f, (float)(i * 13 % Side) * 3.f + 1.5f);
+			Sweep.Delta = glm::vec3(0.f, 0.f, 0.1f);
+			Sweep.Radius = COLLISION_CAMERA_RADIUS;
+			Sweeps.push_back(Sweep);
+		}
+	}
+
+	void TearDown(MicroBenchmarkState& State) override
+	{
+		for (EntityHandle Entity : Entities)
+			EntityStore::Get().Destroy(Entity);
+		Entities.clear();
+		World.Clear();
+		Sweeps.clear();
+	}
+
+	std::vector<EntityHandle> Entities;
+	CollisionWorld World;
+	std::vector<SphereSweep> Sweeps;
+	std::vector<CollisionHit> Hits;
+};
+
+MICROBENCHMARK_F(CollisionFixture, SweepSpheres, 1000, 10000, 100000)
+{
+	while (State.KeepRunning())
+	{
+		World.SweepSpheres(Sweeps, Hits);
+		MicroBenchmark::DoNotOptimize(Hits);
+	}
+	State.SetItemsProcessed(State.GetIterations() * Sweeps.size());
+}
+
+MICROBENCHMARK_F(CollisionFixture, UpdateStatic, 1000, 10000, 100000)
+{
+	while (State.KeepRunning())
+	{
+		World.Update();
+		MicroBenchmark::DoNotOptimize(World.GetRebinnedCount());
+	}
+	State.SetItemsProcessed(State.GetIterations() * Entities.size());
+}
+
+/**
+ * @brief N animated props, a looping door rotation, a ping-pong sign location, a float and a sprite frame track each.
+ */
+class TimelineFixture : public MicroBenchmarkFixture
+{
+public:
+	void SetUp(MicroBenchmarkState& State) override
+	{
+		Values.assign((size_t)State.GetArg(), 0.f);
+		Frames.assign((size_t)State.GetArg(), 0);
+		for (int64_t i = 0; i < State.GetArg(); i++)
+		{
+			float f = (float)i;
+			EntityHandle Entity = EntityStore::Get().Create(Transform(glm::vec3(f, 0.f, -f), glm::vec3(0.f), glm::vec3(1.f)));
+			Entities.push_back(Entity);
+			TrackTiming Timing;
+			Timing.Delay = f * 0.001f;
+			Timing.Duration = 2.f;
+			Timing.Ease = Easing::EaseInOut;
+			Timing.Loop = TrackLoop::Loop;
+			Tracks.AddRotation(Entity, glm::quat(glm::vec3(0.f)), glm::quat(glm::vec3(0.f, glm::radians(90.f), 0.f)), Timing);
+			Timing.Loop = TrackLoop::PingPong;
+			Tracks.AddLocation(Entity, glm::vec3(f, 0.f, -f), glm::vec3(f, 1.f, -f), Timing);
+			Tracks.AddFloat(&Values[i], 0.f, 1.f, Timing);
+			Tracks.AddSpriteFrame(&Frames[i], 0, 16, Timing);
+		}
+	}
+
+	void TearDown(MicroBenchmarkState& State) override
+	{
+		Tracks.Clear();
+		for (EntityHandle Entity : Entities)
+			EntityStore::Get().Destroy(Entity);
+		Entities.clear();
+	}
+
+	std::vector<EntityHandle> Entities;
+	std::vector<float> Values;
+	std::vector<int> Frames;
+	Timeline Tracks;
+};
+
+MICROBENCHMARK_F(TimelineFixture, Update, 1000, 10000, 100000)
+{
+	while (State.KeepRunning())
+	{
+		Tracks.Update(1.f / 60.f);
+		MicroBenchmark::DoNotOptimize(Values);
+	}
+	State.SetItemsProcessed(State.GetIterations() * Tracks.GetTrackCount());
+}
@@ -3,6 +3,8 @@
 #include "glm/gtx/quaternion.hpp"
 #include "stb_image.h"
 #include <iostream>
+#include <cstdint>
+#include <vector>
 #include "Material.h"
 
 /**
@@ -80,26 +82,101 @@ struct Transform
 	}
 };
 
-enum InputAction
+/**
+* @brief Read-only view of a contiguous array owned elsewhere, valid while the owner is not modified
+*/
+template<typename T>
+struct ConstSpan
 {
-	MoveForward, 
-	MoveBackward, 
-	MoveLeft,
-	MoveRight,
-	Fire
+	const T* Data = nullptr; /**< First element. */
+	size_t Size = 0; /**< Number of elements. */
+
+	ConstSpan() = default;
+	template<typename Allocator>
+	ConstSpan(const std::vector<T, Allocator>& Vector) : Data(Vector.data()), Size(Vector.size()) {}
+
+	const T* begin() const { return Data; }
+	const T* end() const { return Data + Size; }
+	size_t size() const { return Size; }
+	bool empty() const { return Size == 0; }
+	const T& operator[](size_t Index) const { return Data[Index]; }
+};
+
+/**
+* @brief Draw statistics collected while rendering a frame
+*/
+struct RenderStats
+{
+	size_t DrawCalls = 0; /**< Number of issued draw calls. */
+	size_t Triangles = 0; /**< Number of submitted triangles. */
+	size_t Objects = 0; /**< Number of rendered game objects. */
+	size_t BufferStalls = 0; /**< Number of waits for the GPU to release stream buffer memory. */
+	double BufferStallTimeMs = 0.0; /**< Time spent in those waits. */
+	size_t OccludedObjects = 0; /**< Number of game objects skipped by occlusion culling. */
+	double DepthPrepassGpuMs = 0.0; /**< GPU time of the depth pre-pass, measured a few frames earlier. */
+	double MainPassGpuMs = 0.0; /**< GPU time of the lit pass of the game objects, measured a few frames earlier. */
+	double SceneGpuMs = 0.0; /**< GPU time of all passes of the scene including the upscale, measured a few frames earlier. */
+	double ResolutionScale = 1.0; /**< Scale of the width and height the scene was rendered at. */
+	size_t StateChanges = 0; /**< Number of GL state calls issued through GLStateCache. */
+	size_t ElidedStateChanges = 0; /**< Number of GL state calls skipped by GLStateCache because the value was in place. */
+	size_t HeapAllocations = 0; /**< Number of heap allocations of the main thread during the frame. */
+	size_t FrameAllocatorBytes = 0; /**< Bytes taken from the frame allocator during the frame. */
+};
+
+#define FRAME_UNIFORM_BINDING 0
+#define OBJECT_UNIFORM_BINDING 1
+#define MATERIAL_UNIFORM_BINDING 2
+
+/**
+* @brief Per frame shader data, std140 layout of the FrameData uniform block
+*/
+struct FrameUniforms
+{
+	glm::mat4 VMatrix; /**< View matrix of the active camera. */
+	glm::vec4 FogColor; /**< Color of the fog. */
+	glm::vec4 DirectionalLightDirection; /**< Direction of the directional light in camera space. */
+	float FogMinDistance; /**< Distance where the fog starts. */
+	float FogMaxDistance; /**< Distance where the fog is opaque. */
+	int32_t IsSpotlightActive; /**< Flag indicating whether the spotlight is active. */
+	float Padding;
+};
+
+/**
+* @brief Per object shader data, std140 layout of the ObjectData uniform block
+*/
+struct ObjectUniforms
+{
+	glm::mat4 PVMMatrix; /**< Model to clip space. */
+	glm::mat4 MMatrix; /**< Model to world space. */
+	glm::mat4 NormalMatrix; /**< Model to camera space for normals. */
+	glm::mat4 WaterTransform; /**< Texture coordinate transform of the water. */
+	int32_t IsWater; /**< Flag indicating whether the object is water. */
+	float AnimationAlpha; /**< Blend factor between two animation frames. */
+	int32_t MaterialId; /**< Index of the object material in the MaterialData uniform block. */
+	float Padding;
 };
 
 /**
-* @brief Defulats materials used in project
+* @brief Material constants, std140 layout of an element of the MaterialData uniform block
 */
-struct MaterialsContainer
+struct MaterialUniforms
 {
-	Material HouseMaterial{ glm::vec3(0.15f), glm::vec3(0.75f), glm::vec3(0.5f), 42 };
-	Material ChurchMaterial{ glm::vec3(0.1f), glm::vec3(0.75f), glm::vec3(0.5f), 36 };
-	Material RevolverMaterial{ glm::vec3(0.1f), glm::vec3(0.85f), glm::vec3(0.5f), 32 };
-	Material DefaultMaterial{ glm::vec3(0.15f), glm::vec3(0.75f), glm::vec3(0.5f), 48 };
+	glm::vec3 AmbientColor; /**< Ambient color. */
+	float Padding0;
+	glm::vec3 DiffuseColor; /**< Diffuse color. */
+	float Padding1;
+	glm::vec3 SpecularColor; /**< Specular color. */
+	float Shininess; /**< Specular exponent. */
 };
 
+enum InputAction
+{
+	MoveForward, 
+	MoveBackward, 
+	MoveLeft,
+	MoveRight,
+	Fire
+};
 
 /**
 * @brief Defulat direction light settings used in project
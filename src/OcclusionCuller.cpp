@@ -0,0 +1,231 @@
+#include "OcclusionCuller.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#if defined(_M_X64) || defined(_M_IX86) || defined(__SSE__)
+#include <xmmintrin.h>
+#define OCCLUSION_USE_SSE 1
+#endif
+
+#define OCCLUSION_TILES_X (OCCLUSION_BUFFER_WIDTH / OCCLUSION_TILE_SIZE)
+#define OCCLUSION_TILES_Y (OCCLUSION_BUFFER_HEIGHT / OCCLUSION_TILE_SIZE)
+#define OCCLUSION_MIN_W 1.e-3f // vertices closer to the camera plane are not projected
+
+static_assert(OCCLUSION_BUFFER_WIDTH % 4 == 0, "Rows are rasterized four pixels at a time");
+static_assert(OCCLUSION_BUFFER_WIDTH % OCCLUSION_TILE_SIZE == 0 && OCCLUSION_BUFFER_HEIGHT % OCCLUSION_TILE_SIZE == 0, "Tiles must cover the buffer");
+
+OcclusionCuller::OcclusionCuller()
+	: m_Depth(OCCLUSION_BUFFER_WIDTH * OCCLUSION_BUFFER_HEIGHT, std::numeric_limits<float>::max())
+	, m_TileDepth(OCCLUSION_TILES_X * OCCLUSION_TILES_Y, std::numeric_limits<float>::max())
+{
+	const int Threads = (int)std::thread::hardware_concurrency();
+	m_BandCount = std::min(std::max(Threads, 1), std::min(OCCLUSION_MAX_THREADS, OCCLUSION_TILES_Y));
+	for (int Band = 1; Band < m_BandCount; Band++)
+		m_Workers.emplace_back(&OcclusionCuller::WorkerThread, this, Band);
+}
+
+OcclusionCuller::~OcclusionCuller()
+{
+	{
+		std::lock_guard<std::mutex> Lock(m_Mutex);
+		m_Stop = true;
+	}
+	m_JobCondition.notify_all();
+	for (std::thread& Worker : m_Workers)
+		Worker.join();
+}
+
+void OcclusionCuller::ClearOccluders()
+{
+	m_Triangles.clear();
+	m_HasDepth = false;
+}
+
+void OcclusionCuller::AddOccluder(const std::vector<glm::vec3>& Triangles)
+{
+	m_Triangles.insert(m_Triangles.end(), Triangles.begin(), Triangles.end() - Triangles.size() % 3);
+}
+
+void OcclusionCuller::RenderOccluders(const glm::mat4& ViewProjection)
+{
+	m_ViewProjection = ViewProjection;
+	m_HasDepth = !m_Triangles.empty();
+	if (!m_HasDepth)
+		return;
+
+	m_ScreenTriangles.clear();
+	for (size_t i = 0; i < m_Triangles.size(); i += 3)
+	{
+		ScreenTriangle Triangle;
+		bool IsProjected = true;
+		for (int v = 0; v < 3 && IsProjected; v++)
+		{
+			glm::vec4 Clip = ViewProjection * glm::vec4(m_Triangles[i + v], 1.f);
+			IsProjected = Clip.w > OCCLUSION_MIN_W; // skipping a triangle only makes the culling less effective
+			Triangle.X[v] = (Clip.x / Clip.w * 0.5f + 0.5f) * OCCLUSION_BUFFER_WIDTH;
+			Triangle.Y[v] = (Clip.y / Clip.w * 0.5f + 0.5f) * OCCLUSION_BUFFER_HEIGHT;
+			Triangle.Z[v] = Clip.z / Clip.w;
+		}
+		if (IsProjected)
+			m_ScreenTriangles.push_back(Triangle);
+	}
+
+	if (m_BandCount > 1)
+	{
+		std::lock_guard<std::mutex> Lock(m_Mutex);
+		m_PendingBands = m_BandCount - 1;
+		m_JobGeneration++;
+	}
+	m_JobCondition.notify_all();
+	RasterizeBand(0);
+	std::unique_lock<std::mutex> Lock(m_Mutex);
+	m_DoneCondition.wait(Lock, [this] { return m_PendingBands == 0; });
+}
+
+bool OcclusionCuller::GetIsVisible(const glm::mat4& Model, const glm::vec3& BoundsMin, const glm::vec3& BoundsMax) const
+{
+	if (!m_HasDepth)
+		return true;
+
+	const glm::mat4 MVP = m_ViewProjection * Model;
+	float MinX = std::numeric_limits<float>::max(), MinY = MinX, MinZ = MinX;
+	float MaxX = std::numeric_limits<float>::lowest(), MaxY = MaxX;
+	for (int Corner = 0; Corner < 8; Corner++)
+	{
+		glm::vec3 Point((Corner & 1) ? BoundsMax.x : BoundsMin.x, (Corner & 2) ? BoundsMax.y : BoundsMin.y, (Corner & 4) ? BoundsMax.z : BoundsMin.z);
+		glm::vec4 Clip = MVP * glm::vec4(Point, 1.f);
+		if (Clip.w <= OCCLUSION_MIN_W)
+			return true; // the bounds cross the camera plane
+		const float X = (Clip.x / Clip.w * 0.5f + 0.5f) * OCCLUSION_BUFFER_WIDTH;
+		const float Y = (Clip.y / Clip.w * 0.5f + 0.5f) * OCCLUSION_BUFFER_HEIGHT;
+		MinX = std::min(MinX, X); MaxX = std::max(MaxX, X);
+		MinY = std::min(MinY, Y); MaxY = std::max(MaxY, Y);
+		MinZ = std::min(MinZ, Clip.z / Clip.w);
+	}
+	if (MaxX < 0.f || MaxY < 0.f || MinX >= OCCLUSION_BUFFER_WIDTH || MinY >= OCCLUSION_BUFFER_HEIGHT)
+		return true; // off screen, left to the other culling
+
+	const int TileX0 = std::max((int)MinX, 0) / OCCLUSION_TILE_SIZE;
+	const int TileY0 = std::max((int)MinY, 0) / OCCLUSION_TILE_SIZE;
+	const int TileX1 = std::min((int)MaxX, OCCLUSION_BUFFER_WIDTH - 1) / OCCLUSION_TILE_SIZE;
+	const int TileY1 = std::min((int)MaxY, OCCLUSION_BUFFER_HEIGHT - 1) / OCCLUSION_TILE_SIZE;
+	for (int TileY = TileY0; TileY <= TileY1; TileY++)
+	{
+		for (int TileX = TileX0; TileX <= TileX1; TileX++)
+		{
+			if (m_TileDepth[TileX + TileY * OCCLUSION_TILES_X] >= MinZ)
+				return true;
+		}
+	}
+	return false;
+}
+
+void OcclusionCuller::RasterizeBand(int Band)
+{
+	const int TileRowsPerBand = (OCCLUSION_TILES_Y + m_BandCount - 1) / m_BandCount;
+	const int BandY0 = std::min(Band * TileRowsPerBand * OCCLUSION_TILE_SIZE, OCCLUSION_BUFFER_HEIGHT);
+	const int BandY1 = std::min(BandY0 + TileRowsPerBand * OCCLUSION_TILE_SIZE, OCCLUSION_BUFFER_HEIGHT);
+	std::fill(m_Depth.begin() + BandY0 * OCCLUSION_BUFFER_WIDTH, m_Depth.begin() + BandY1 * OCCLUSION_BUFFER_WIDTH, std::numeric_limits<float>::max());
+
+	for (const ScreenTriangle& Triangle : m_ScreenTriangles)
+	{
+		float X0 = Triangle.X[0], Y0 = Triangle.Y[0], Z0 = Triangle.Z[0];
+		float X1 = Triangle.X[1], Y1 = Triangle.Y[1], Z1 = Triangle.Z[1];
+		float X2 = Triangle.X[2], Y2 = Triangle.Y[2], Z2 = Triangle.Z[2];
+		float Area = (X1 - X0) * (Y2 - Y0) - (X2 - X0) * (Y1 - Y0);
+		if (Area == 0.f)
+			continue;
+		if (Area < 0.f) // occluders are rasterized regardless of their facing
+		{
+			std::swap(X1, X2); std::swap(Y1, Y2); std::swap(Z1, Z2);
+			Area = -Area;
+		}
+
+		const int MinX = std::max((int)std::floor(std::min(X0, std::min(X1, X2))), 0) & ~3;
+		const int MaxX = std::min((int)std::ceil(std::max(X0, std::max(X1, X2))), OCCLUSION_BUFFER_WIDTH - 1);
+		const int MinY = std::max((int)std::floor(std::min(Y0, std::min(Y1, Y2))), BandY0);
+		const int MaxY = std::min((int)std::ceil(std::max(Y0, std::max(Y1, Y2))), BandY1 - 1);
+		if (MinX > MaxX || MinY > MaxY)
+			continue;
+
+		// edge functions A * x + B * y + C, positive inside, and the depth plane
+		const float A0 = Y1 - Y2, B0 = X2 - X1, C0 = X1 * Y2 - X2 * Y1;
+		const float A1 = Y2 - Y0, B1 = X0 - X2, C1 = X2 * Y0 - X0 * Y2;
+		const float A2 = Y0 - Y1, B2 = X1 - X0, C2 = X0 * Y1 - X1 * Y0;
+		const float DzDx = ((Z1 - Z0) * (Y2 - Y0) - (Z2 - Z0) * (Y1 - Y0)) / Area;
+		const float DzDy = ((Z2 - Z0) * (X1 - X0) - (Z1 - Z0) * (X2 - X0)) / Area;
+		const float Zc = Z0 - DzDx * X0 - DzDy * Y0;
+
+#ifdef OCCLUSION_USE_SSE
+		const __m128 Zero = _mm_setzero_ps();
+		const __m128 LaneX = _mm_setr_ps(0.5f, 1.5f, 2.5f, 3.5f);
+		for (int y = MinY; y <= MaxY; y++)
+		{
+			const float Py = y + 0.5f;
+			float* Row = &m_Depth[y * OCCLUSION_BUFFER_WIDTH];
+			for (int x = MinX; x <= MaxX; x += 4)
+			{
+				const __m128 Px = _mm_add_ps(_mm_set1_ps((float)x), LaneX);
+				__m128 E0 = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(A0), Px), _mm_set1_ps(B0 * Py + C0));
+				__m128 E1 = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(A1), Px), _mm_set1_ps(B1 * Py + C1));
+				__m128 E2 = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(A2), Px), _mm_set1_ps(B2 * Py + C2));
+				__m128 Inside = _mm_and_ps(_mm_and_ps(_mm_cmpge_ps(E0, Zero), _mm_cmpge_ps(E1, Zero)), _mm_cmpge_ps(E2, Zero));
+				if (_mm_movemask_ps(Inside) == 0)
+					continue;
+				__m128 Depth = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(DzDx), Px), _mm_set1_ps(DzDy * Py + Zc));
+				__m128 Current = _mm_loadu_ps(Row + x);
+				__m128 Nearest = _mm_min_ps(Current, Depth);
+				_mm_storeu_ps(Row + x, _mm_or_ps(_mm_and_ps(Inside, Nearest), _mm_andnot_ps(Inside, Current)));
+			}
+		}
+#else
+		for (int y = MinY; y <= MaxY; y++)
+		{
+			const float Py = y + 0.5f;
+			float* Row = &m_Depth[y * OCCLUSION_BUFFER_WIDTH];
+			for (int x = MinX; x <= MaxX; x++)
+			{
+				const float Px = x + 0.5f;
+				if (A0 * Px + B0 * Py + C0 < 0.f || A1 * Px + B1 * Py + C1 < 0.f || A2 * Px + B2 * Py + C2 < 0.f)
+					continue;
+				Row[x] = std::min(Row[x], DzDx * Px + DzDy * Py + Zc);
+			}
+		}
+#endif
+	}
+
+	for (int TileY = BandY0 / OCCLUSION_TILE_SIZE; TileY < BandY1 / OCCLUSION_TILE_SIZE; TileY++)
+	{
+		for (int TileX = 0; TileX < OCCLUSION_TILES_X; TileX++)
+		{
+			float Farthest = std::numeric_limits<float>::lowest();
+			for (int y = TileY * OCCLUSION_TILE_SIZE; y < (TileY + 1) * OCCLUSION_TILE_SIZE; y++)
+			{
+				const float* Row = &m_Depth[y * OCCLUSION_BUFFER_WIDTH + TileX * OCCLUSION_TILE_SIZE];
+				Farthest = std::max(Farthest, *std::max_element(Row, Row + OCCLUSION_TILE_SIZE));
+			}
+			m_TileDepth[TileX + TileY * OCCLUSION_TILES_X] = Farthest;
+		}
+	}
+}
+
+void OcclusionCuller::WorkerThread(int Band)
+{
+	uint64_t Generation = 0;
+	while (true)
+	{
+		{
+			std::unique_lock<std::mutex> Lock(m_Mutex);
+			m_JobCondition.wait(Lock, [this, Generation] { return m_Stop || m_JobGeneration != Generation; });
+			if (m_Stop)
+				return;
+			Generation = m_JobGeneration;
+		}
+		RasterizeBand(Band);
+		{
+			std::lock_guard<std::mutex> Lock(m_Mutex);
+			m_PendingBands--;
+		}
+		m_DoneCondition.notify_one();
+	}
+}
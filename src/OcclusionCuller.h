@@ -0,0 +1,103 @@
+#pragma once
+#include "pgr.h"
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <iostream>
+
+#define OCCLUSION_BUFFER_WIDTH 256 // must be a multiple of 4
+#define OCCLUSION_BUFFER_HEIGHT 144
+#define OCCLUSION_TILE_SIZE 8 // size of the tiles of the hierarchical depth buffer, divides the buffer size
+#define OCCLUSION_MAX_THREADS 4 // rasterizer threads including the render thread
+#define OCCLUSION_MAX_OCCLUDERS 16 // occluders picked automatically from the largest static objects
+#define OCCLUSION_MAX_OCCLUDER_TRIANGLES 2048 // meshes with more triangles need an authored occluder
+#define OCCLUSION_OCCLUDER_SUFFIX "_occluder.obj" // authored occluder of a model: <model name>_occluder.obj
+#define OCCLUSION_DEFAULT_ENABLED 1
+
+/**
+ * @brief Software occlusion culling.
+ *
+ * Occluder triangles are rasterized into a small CPU depth buffer, four pixels at a time with SSE. The screen is split
+ * into horizontal bands rasterized in parallel by worker threads and the render thread. Every band then reduces its
+ * pixels into tiles holding the farthest depth of the tile. An object is occluded if its nearest depth is behind
+ * the farthest depth of every tile its screen bounds touch.
+ */
+class OcclusionCuller
+{
+public:
+	OcclusionCuller();
+	~OcclusionCuller();
+	OcclusionCuller(const OcclusionCuller&) = delete;
+	OcclusionCuller& operator=(const OcclusionCuller&) = delete;
+
+	/**
+	 * @brief Removes all occluders.
+	 */
+	void ClearOccluders();
+
+	/**
+	 * @brief Adds an occluder.
+	 *
+	 * @param Triangles Vertex locations of the occluder triangles in world space, three per triangle.
+	 */
+	void AddOccluder(const std::vector<glm::vec3>& Triangles);
+
+	/**
+	 * @brief Returns the number of occluder triangles.
+	 */
+	size_t GetOccluderTriangleCount() const { return m_Triangles.size() / 3; }
+
+	/**
+	 * @brief Rasterizes the occluders for a camera.
+	 *
+	 * @param ViewProjection The projection matrix multiplied by the view matrix of the camera.
+	 */
+	void RenderOccluders(const glm::mat4& ViewProjection);
+
+	/**
+	 * @brief Tests the bounds of an object against the occluders of the last RenderOccluders call.
+	 *
+	 * @param Model The model matrix of the object.
+	 * @param BoundsMin The minimal corner of the local bounds.
+	 * @param BoundsMax The maximal corner of the local bounds.
+	 * @return False if the occluders hide the whole bounds, true otherwise.
+	 */
+	bool GetIsVisible(const glm::mat4& Model, const glm::vec3& BoundsMin, const glm::vec3& BoundsMax) const;
+
+private:
+	/**
+	 * @brief Triangle in occlusion buffer pixels with NDC depth.
+	 */
+	struct ScreenTriangle
+	{
+		float X[3], Y[3], Z[3];
+	};
+
+	/**
+	 * @brief Rasterizes all triangles into the rows of a band and builds the tiles of the band.
+	 */
+	void RasterizeBand(int Band);
+
+	/**
+	 * @brief Rasterizes bands given out by the render thread until it stops the culler.
+	 */
+	void WorkerThread(int Band);
+
+	std::vector<glm::vec3> m_Triangles; /**< Occluder triangles in world space. */
+	std::vector<ScreenTriangle> m_ScreenTriangles; /**< Occluder triangles of the current frame. */
+	std::vector<float> m_Depth; /**< Nearest depth of every pixel. */
+	std::vector<float> m_TileDepth; /**< Farthest depth of every tile. */
+	glm::mat4 m_ViewProjection = glm::mat4(1.f); /**< Camera of the last RenderOccluders call. */
+	bool m_HasDepth = false; /**< The occluders were rasterized for the current frame. */
+
+	int m_BandCount = 1; /**< Number of bands, one per thread. */
+	std::vector<std::thread> m_Workers; /**< Rasterizer threads of the bands after the first. */
+	std::mutex m_Mutex; /**< Guards the job state. */
+	std::condition_variable m_JobCondition; /**< Signals a new frame to the workers. */
+	std::condition_variable m_DoneCondition; /**< Signals finished bands to the render thread. */
+	uint64_t m_JobGeneration = 0; /**< Incremented for every frame given to the workers. */
+	int m_PendingBands = 0; /**< Bands of the current frame not finished yet. */
+	bool m_Stop = false; /**< Stops the workers. */
+};
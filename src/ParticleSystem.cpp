@@ -0,0 +1,252 @@
+#include "ParticleSystem.h"
+#include "FunctionLibrary.h"
+#include "MeshGeometry.h"
+#include "GLStateCache.h"
+#include "FrameAllocator.h"
+#include <algorithm>
+#include <cstddef>
+#if defined(_M_X64) || defined(_M_IX86) || defined(__SSE__)
+#include <xmmintrin.h>
+#define PARTICLE_USE_SSE 1
+#endif
+
+#define PARTICLE_POOL_SIZE ((PARTICLE_MAX_COUNT + 3) / 4 * 4) // padded, so the last live particles can be simulated as a full group of four
+
+ParticleSystem::ParticleSystem()
+	: m_Random(PARTICLE_RANDOM_SEED)
+{
+	for (std::vector<float>* Pool : { &m_PositionX, &m_PositionY, &m_PositionZ, &m_VelocityX, &m_VelocityY, &m_VelocityZ,
+		&m_AccelerationX, &m_AccelerationY, &m_AccelerationZ, &m_Drag, &m_Age, &m_AgeRate })
+	{
+		Pool->resize(PARTICLE_POOL_SIZE, 0.f);
+	}
+	m_EmitterIndex.resize(PARTICLE_POOL_SIZE, 0);
+}
+
+bool ParticleSystem::Init()
+{
+	m_AtlasTexture = TextureFromFile(PARTICLE_ATLAS_PATH);
+	if (!m_AtlasTexture)
+	{
+		std::cerr << "ParticleSystem::Init() => Can't load particle atlas: " << PARTICLE_ATLAS_PATH << std::endl;
+		return false;
+	}
+
+	// corners of the quad, expanded to a camera facing sprite in the vertex shader
+	const float Corners[] = { -0.5f, -0.5f, 0.5f, -0.5f, -0.5f, 0.5f, 0.5f, 0.5f };
+	glGenVertexArrays(1, &m_VAO);
+	GLStateCache::BindVertexArray(m_VAO);
+	glGenBuffers(1, &m_QuadVBO);
+	GLStateCache::BindBuffer(GL_ARRAY_BUFFER, m_QuadVBO);
+	glBufferData(GL_ARRAY_BUFFER, sizeof(Corners), Corners, GL_STATIC_DRAW);
+	glEnableVertexAttribArray(0);
+	glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 2 * sizeof(float), (void*)0);
+
+	// instance attributes point into the stream buffer, they are set up per frame
+	for (GLuint Attribute = 1; Attribute <= 3; Attribute++)
+	{
+		glEnableVertexAttribArray(Attribute);
+		glVertexAttribDivisor(Attribute, 1);
+	}
+
+	GLStateCache::BindVertexArray(0);
+	CHECK_GL_ERROR();
+	return true;
+}
+
+int ParticleSystem::AddEmitter(const ParticleEmitterDesc& Desc, EntityHandle Parent, const glm::vec3& Offset)
+{
+	Emitter emitter;
+	emitter.Desc = Desc;
+	emitter.Parent = Parent;
+	emitter.Offset = Offset;
+	m_Emitters.push_back(emitter);
+	return (int)m_Emitters.size() - 1;
+}
+
+int ParticleSystem::FindEmitter(const std::string& Name) const
+{
+	for (size_t i = 0; i < m_Emitters.size(); i++)
+	{
+		if (m_Emitters[i].Desc.Name == Name)
+			return (int)i;
+	}
+	return -1;
+}
+
+void ParticleSystem::SetEmitterActive(int Emitter, bool Active)
+{
+	if (Emitter < 0 || Emitter >= (int)m_Emitters.size())
+	{
+		std::cerr << "ParticleSystem::SetEmitterActive() => Invalid emitter " << Emitter << std::endl;
+		return;
+	}
+	m_Emitters[Emitter].Active = Active;
+}
+
+void ParticleSystem::Burst(int Emitter, int Count)
+{
+	if (Emitter < 0 || Emitter >= (int)m_Emitters.size())
+	{
+		std::cerr << "ParticleSystem::Burst() => Invalid emitter " << Emitter << std::endl;
+		return;
+	}
+	Spawn(Emitter, Count);
+}
+
+void ParticleSystem::Update(float dt)
+{
+	for (size_t i = 0; i < m_Emitters.size(); i++)
+	{
+		Emitter& emitter = m_Emitters[i];
+		if (!emitter.Active || emitter.Desc.Rate <= 0.f)
+			continue;
+		emitter.Accumulator += emitter.Desc.Rate * dt;
+		int Count = (int)emitter.Accumulator;
+		emitter.Accumulator -= Count;
+		Spawn((int)i, Count);
+	}
+
+	Simulate(dt);
+
+	for (size_t i = 0; i < m_Count; )
+	{
+		if (m_Age[i] >= 1.f)
+			Kill(i);
+		else
+			i++;
+	}
+}
+
+void ParticleSystem::Render(const Shader& shader, const glm::mat4& View, const glm::mat4& Projection, StreamBuffer& Stream)
+{
+	if (m_Count == 0)
+		return;
+	StreamAllocation Allocation = Stream.Allocate(m_Count * sizeof(ParticleInstance));
+	if (!Allocation.Data)
+		return;
+
+	LinearVector<glm::vec3> Origins(m_Emitters.size(), glm::vec3(0.f), FrameAllocator::GetAdapter<glm::vec3>());
+	for (size_t i = 0; i < m_Emitters.size(); i++)
+	{
+		if (m_Emitters[i].Desc.LocalSpace)
+			Origins[i] = GetEmitterLocation(m_Emitters[i]);
+	}
+
+	ParticleInstance* Instances = static_cast<ParticleInstance*>(Allocation.Data);
+	for (size_t i = 0; i < m_Count; i++)
+	{
+		const ParticleEmitterDesc& Desc = m_Emitters[m_EmitterIndex[i]].Desc;
+		const float Age = m_Age[i];
+		ParticleInstance Instance;
+		Instance.PositionSize = glm::vec4(glm::vec3(m_PositionX[i], m_PositionY[i], m_PositionZ[i]) + Origins[m_EmitterIndex[i]],
+			Desc.StartSize + (Desc.EndSize - Desc.StartSize) * Age);
+		Instance.Color = Desc.StartColor + (Desc.EndColor - Desc.StartColor) * Age;
+		Instance.Frame = Desc.FirstFrame == PARTICLE_SOFT_SPRITE ? (float)PARTICLE_SOFT_SPRITE
+			: (float)(Desc.FirstFrame + std::min((int)(Age * Desc.FrameCount), Desc.FrameCount - 1));
+		Instances[i] = Instance; // written once, the mapping may be write-combined
+	}
+	Stream.Flush();
+
+	GLStateCache::BindVertexArray(m_VAO);
+	GLStateCache::BindBuffer(GL_ARRAY_BUFFER, Stream.GetBuffer());
+	const char* Base = reinterpret_cast<const char*>(Allocation.Offset);
+	glVertexAttribPointer(1, 4, GL_FLOAT, GL_FALSE, sizeof(ParticleInstance), Base + offsetof(ParticleInstance, PositionSize));
+	glVertexAttribPointer(2, 4, GL_FLOAT, GL_FALSE, sizeof(ParticleInstance), Base + offsetof(ParticleInstance, Color));
+	glVertexAttribPointer(3, 1, GL_FLOAT, GL_FALSE, sizeof(ParticleInstance), Base + offsetof(ParticleInstance, Frame));
+
+	shader.UseShader();
+	shader.SetMat4Parameter("PVMatrix", Projection * View);
+	shader.SetVec3Parameter("cameraRight", glm::vec3(View[0][0], View[1][0], View[2][0]));
+	shader.SetVec3Parameter("cameraUp", glm::vec3(View[0][1], View[1][1], View[2][1]));
+	shader.SetIntParameter("texSampler", 0);
+	GLStateCache::BindTexture(0, GL_TEXTURE_2D, m_AtlasTexture);
+
+	glDrawArraysInstanced(GL_TRIANGLE_STRIP, 0, 4, (GLsizei)m_Count);
+	MeshGeometry::CountDrawCall(m_Count * 2);
+	CHECK_GL_ERROR();
+}
+
+glm::vec3 ParticleSystem::GetEmitterLocation(const Emitter& emitter) const
+{
+	if (!EntityStore::Get().GetIsAlive(emitter.Parent))
+		return emitter.Offset;
+	return glm::vec3(EntityStore::Get().GetWorldModelMatrix(emitter.Parent) * glm::vec4(emitter.Offset, 1.f));
+}
+
+void ParticleSystem::Spawn(int EmitterIndex, int Count)
+{
+	const Emitter& emitter = m_Emitters[EmitterIndex];
+	const ParticleEmitterDesc& Desc = emitter.Desc;
+	const glm::vec3 Origin = Desc.LocalSpace ? glm::vec3(0.f) : GetEmitterLocation(emitter);
+	Count = std::min(Count, (int)(PARTICLE_MAX_COUNT - m_Count));
+	for (int n = 0; n < Count; n++)
+	{
+		const size_t i = m_Count++;
+		m_PositionX[i] = Origin.x + Desc.SpawnExtent.x * RandomSigned();
+		m_PositionY[i] = Origin.y + Desc.SpawnExtent.y * RandomSigned();
+		m_PositionZ[i] = Origin.z + Desc.SpawnExtent.z * RandomSigned();
+		m_VelocityX[i] = Desc.Velocity.x + Desc.VelocityVariance.x * RandomSigned();
+		m_VelocityY[i] = Desc.Velocity.y + Desc.VelocityVariance.y * RandomSigned();
+		m_VelocityZ[i] = Desc.Velocity.z + Desc.VelocityVariance.z * RandomSigned();
+		m_AccelerationX[i] = Desc.Acceleration.x;
+		m_AccelerationY[i] = Desc.Acceleration.y;
+		m_AccelerationZ[i] = Desc.Acceleration.z;
+		m_Drag[i] = Desc.Drag;
+		m_Age[i] = 0.f;
+		m_AgeRate[i] = 1.f / std::max(Desc.Lifetime + Desc.LifetimeVariance * RandomSigned(), 0.001f);
+		m_EmitterIndex[i] = (uint16_t)EmitterIndex;
+	}
+}
+
+void ParticleSystem::Simulate(float dt)
+{
+#ifdef PARTICLE_USE_SSE
+	const __m128 Dt = _mm_set1_ps(dt);
+	const __m128 One = _mm_set1_ps(1.f);
+	const __m128 Zero = _mm_setzero_ps();
+	for (size_t i = 0; i < m_Count; i += 4)
+	{
+		const __m128 Damping = _mm_max_ps(Zero, _mm_sub_ps(One, _mm_mul_ps(_mm_loadu_ps(&m_Drag[i]), Dt)));
+		__m128 Vx = _mm_add_ps(_mm_mul_ps(_mm_loadu_ps(&m_VelocityX[i]), Damping), _mm_mul_ps(_mm_loadu_ps(&m_AccelerationX[i]), Dt));
+		__m128 Vy = _mm_add_ps(_mm_mul_ps(_mm_loadu_ps(&m_VelocityY[i]), Damping), _mm_mul_ps(_mm_loadu_ps(&m_AccelerationY[i]), Dt));
+		__m128 Vz = _mm_add_ps(_mm_mul_ps(_mm_loadu_ps(&m_VelocityZ[i]), Damping), _mm_mul_ps(_mm_loadu_ps(&m_AccelerationZ[i]), Dt));
+		_mm_storeu_ps(&m_VelocityX[i], Vx);
+		_mm_storeu_ps(&m_VelocityY[i], Vy);
+		_mm_storeu_ps(&m_VelocityZ[i], Vz);
+		_mm_storeu_ps(&m_PositionX[i], _mm_add_ps(_mm_loadu_ps(&m_PositionX[i]), _mm_mul_ps(Vx, Dt)));
+		_mm_storeu_ps(&m_PositionY[i], _mm_add_ps(_mm_loadu_ps(&m_PositionY[i]), _mm_mul_ps(Vy, Dt)));
+		_mm_storeu_ps(&m_PositionZ[i], _mm_add_ps(_mm_loadu_ps(&m_PositionZ[i]), _mm_mul_ps(Vz, Dt)));
+		_mm_storeu_ps(&m_Age[i], _mm_add_ps(_mm_loadu_ps(&m_Age[i]), _mm_mul_ps(_mm_loadu_ps(&m_AgeRate[i]), Dt)));
+	}
+#else
+	for (size_t i = 0; i < m_Count; i++)
+	{
+		const float Damping = std::max(0.f, 1.f - m_Drag[i] * dt);
+		m_VelocityX[i] = m_VelocityX[i] * Damping + m_AccelerationX[i] * dt;
+		m_VelocityY[i] = m_VelocityY[i] * Damping + m_AccelerationY[i] * dt;
+		m_VelocityZ[i] = m_VelocityZ[i] * Damping + m_AccelerationZ[i] * dt;
+		m_PositionX[i] += m_VelocityX[i] * dt;
+		m_PositionY[i] += m_VelocityY[i] * dt;
+		m_PositionZ[i] += m_VelocityZ[i] * dt;
+		m_Age[i] += m_AgeRate[i] * dt;
+	}
+#endif
+}
+
+void ParticleSystem::Kill(size_t Index)
+{
+	const size_t Last = --m_Count;
+	m_PositionX[Index] = m_PositionX[Last]; m_PositionY[Index] = m_PositionY[Last]; m_PositionZ[Index] = m_PositionZ[Last];
+	m_VelocityX[Index] = m_VelocityX[Last]; m_VelocityY[Index] = m_VelocityY[Last]; m_VelocityZ[Index] = m_VelocityZ[Last];
+	m_AccelerationX[Index] = m_AccelerationX[Last]; m_AccelerationY[Index] = m_AccelerationY[Last]; m_AccelerationZ[Index] = m_AccelerationZ[Last];
+	m_Drag[Index] = m_Drag[Last];
+	m_Age[Index] = m_Age[Last];
+	m_AgeRate[Index] = m_AgeRate[Last];
+	m_EmitterIndex[Index] = m_EmitterIndex[Last];
+}
+
+float ParticleSystem::RandomSigned()
+{
+	return std::uniform_real_distribution<float>(-1.f, 1.f)(m_Random);
+}
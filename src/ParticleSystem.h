@@ -0,0 +1,176 @@
+#pragma once
+#include "pgr.h"
+#include "Shader.h"
+#include "SceneObject.h"
+#include "StreamBuffer.h"
+#include <vector>
+#include <string>
+#include <memory>
+#include <random>
+#include <cstdint>
+#include <iostream>
+
+#define PARTICLE_MAX_COUNT 65536 // capacity of the pool, emission stops while it is full
+#define PARTICLE_ATLAS_PATH "resources/textures/muzzle_flash.png"
+#define PARTICLE_ATLAS_COLUMNS 4
+#define PARTICLE_ATLAS_ROWS 4
+#define PARTICLE_SOFT_SPRITE -1 // frame of particles drawn as a soft round sprite instead of an atlas frame
+#define PARTICLE_RANDOM_SEED 20240601u // fixed, so benchmark runs emit the same particles
+
+/**
+ * @brief Parameters of a particle emitter.
+ */
+struct ParticleEmitterDesc
+{
+	std::string Name; /**< Name used to look the emitter up. */
+	float Rate = 0.f; /**< Particles emitted per second while the emitter is active, 0 emits only bursts. */
+	float Lifetime = 1.f; /**< Lifetime of a particle in seconds. */
+	float LifetimeVariance = 0.f; /**< Maximal random deviation of the lifetime. */
+	glm::vec3 SpawnExtent = glm::vec3(0.f); /**< Half size of the box around the emitter particles spawn in. */
+	glm::vec3 Velocity = glm::vec3(0.f); /**< Initial velocity. */
+	glm::vec3 VelocityVariance = glm::vec3(0.f); /**< Maximal random deviation of the initial velocity per axis. */
+	glm::vec3 Acceleration = glm::vec3(0.f); /**< Constant acceleration, e.g. gravity or buoyancy. */
+	float Drag = 0.f; /**< Fraction of the velocity lost per second. */
+	float StartSize = 1.f; /**< Size of the sprite at birth. */
+	float EndSize = 1.f; /**< Size of the sprite at death. */
+	glm::vec4 StartColor = glm::vec4(1.f); /**< Tint at birth. */
+	glm::vec4 EndColor = glm::vec4(1.f); /**< Tint at death. */
+	int FirstFrame = PARTICLE_SOFT_SPRITE; /**< First atlas frame of the animation, PARTICLE_SOFT_SPRITE for a soft round sprite. */
+	int FrameCount = 1; /**< Number of atlas frames played over the lifetime. */
+	bool LocalSpace = false; /**< Particles move with the attached object instead of staying where they were emitted. */
+};
+
+/**
+ * @brief Pooled particle system.
+ *
+ * Live particles are kept packed at the front of fixed-capacity structure of arrays pools. The simulation advances
+ * four particles at a time with SSE and all particles of all emitters are drawn with one instanced draw call
+ * of camera facing quads textured from a sprite sheet atlas.
+ */
+class ParticleSystem
+{
+public:
+	ParticleSystem();
+	ParticleSystem(const ParticleSystem&) = delete;
+	ParticleSystem& operator=(const ParticleSystem&) = delete;
+
+	/**
+	 * @brief Loads the atlas and creates the quad buffer.
+	 *
+	 * @return True if the resources were created, false otherwise.
+	 */
+	bool Init();
+
+	/**
+	 * @brief Adds an emitter.
+	 *
+	 * @param Desc The parameters of the emitter.
+	 * @param Parent The entity the emitter is attached to, the world origin if invalid or destroyed.
+	 * @param Offset Position of the emitter relative to the parent.
+	 * @return Index of the emitter.
+	 */
+	int AddEmitter(const ParticleEmitterDesc& Desc, EntityHandle Parent = EntityHandle(), const glm::vec3& Offset = glm::vec3(0.f));
+
+	/**
+	 * @brief Returns the index of the emitter with the given name, -1 if there is none.
+	 */
+	int FindEmitter(const std::string& Name) const;
+
+	/**
+	 * @brief Starts or stops the continuous emission of an emitter.
+	 */
+	void SetEmitterActive(int Emitter, bool Active);
+
+	/**
+	 * @brief Emits a number of particles at once.
+	 */
+	void Burst(int Emitter, int Count);
+
+	/**
+	 * @brief Emits new particles and advances and retires the live ones.
+	 *
+	 * @param dt Time step in seconds.
+	 */
+	void Update(float dt);
+
+	/**
+	 * @brief Draws all live particles. Expects alpha blending enabled and depth writes disabled, particles are not sorted.
+	 *
+	 * @param shader The particle shader.
+	 * @param View The view matrix of the camera.
+	 * @param Projection The projection matrix of the camera.
+	 * @param Stream The buffer the instance data of the frame is written to.
+	 */
+	void Render(const Shader& shader, const glm::mat4& View, const glm::mat4& Projection, StreamBuffer& Stream);
+
+	/**
+	 * @brief Returns the number of live particles.
+	 */
+	size_t GetLiveCount() const { return m_Count; }
+
+private:
+	/**
+	 * @brief Emitter with its runtime state.
+	 */
+	struct Emitter
+	{
+		ParticleEmitterDesc Desc;
+		EntityHandle Parent;
+		glm::vec3 Offset;
+		bool Active = false;
+		float Accumulator = 0.f; /**< Fraction of a particle carried over to the next update. */
+	};
+
+	/**
+	 * @brief Per instance vertex data of a particle.
+	 */
+	struct ParticleInstance
+	{
+		glm::vec4 PositionSize;
+		glm::vec4 Color;
+		float Frame;
+	};
+
+	/**
+	 * @brief Returns the world position of an emitter.
+	 */
+	glm::vec3 GetEmitterLocation(const Emitter& emitter) const;
+
+	/**
+	 * @brief Spawns particles of an emitter while the pool has room.
+	 */
+	void Spawn(int EmitterIndex, int Count);
+
+	/**
+	 * @brief Integrates velocities and positions and ages the particles.
+	 */
+	void Simulate(float dt);
+
+	/**
+	 * @brief Moves the last live particle into the slot of a dead one.
+	 */
+	void Kill(size_t Index);
+
+	/**
+	 * @brief Returns a random number in [-1, 1].
+	 */
+	float RandomSigned();
+
+	std::vector<Emitter> m_Emitters; /**< Emitters of the system. */
+
+	// particle pools, the first m_Count entries are alive
+	std::vector<float> m_PositionX, m_PositionY, m_PositionZ;
+	std::vector<float> m_VelocityX, m_VelocityY, m_VelocityZ;
+	std::vector<float> m_AccelerationX, m_AccelerationY, m_AccelerationZ;
+	std::vector<float> m_Drag; /**< Fraction of the velocity lost per second. */
+	std::vector<float> m_Age; /**< Normalized age, the particle dies at 1. */
+	std::vector<float> m_AgeRate; /**< Inverse lifetime. */
+	std::vector<uint16_t> m_EmitterIndex; /**< Emitter of every particle. */
+	size_t m_Count = 0; /**< Number of live particles. */
+
+	std::mt19937 m_Random; /**< Random generator of the emitters. */
+
+	GLuint m_AtlasTexture = 0; /**< Sprite sheet of the atlas frames. */
+	GLuint m_VAO = 0; /**< Quad corners and instance attributes. */
+	GLuint m_QuadVBO = 0; /**< Corners of the quad. */
+};
@@ -0,0 +1,312 @@
+#include "RenderGraph.h"
+#include "GLStateCache.h"
+#include <set>
+#include <algorithm>
+
+namespace
+{
+	bool GetIsDepthFormat(GLenum Format)
+	{
+		return Format == GL_DEPTH_COMPONENT16 || Format == GL_DEPTH_COMPONENT24 || Format == GL_DEPTH_COMPONENT32F
+			|| Format == GL_DEPTH24_STENCIL8 || Format == GL_DEPTH32F_STENCIL8;
+	}
+
+	bool GetIsStencilFormat(GLenum Format)
+	{
+		return Format == GL_DEPTH24_STENCIL8 || Format == GL_DEPTH32F_STENCIL8;
+	}
+}
+
+RenderGraph::~RenderGraph()
+{
+	DeleteFramebuffers();
+	for (const PooledTexture& Pooled : m_Pool)
+		GLStateCache::DeleteTextures(1, &Pooled.Texture);
+}
+
+void RenderGraph::Reset()
+{
+	DeleteFramebuffers();
+	m_Passes.clear();
+	m_Order.clear();
+	m_Targets.clear();
+	m_TargetTextures.clear();
+	m_Outputs = { RENDER_GRAPH_BACKBUFFER };
+}
+
+void RenderGraph::CreateTarget(const std::string& Name, const RenderTargetDesc& Desc)
+{
+	m_Targets[Name] = Desc;
+}
+
+void RenderGraph::AddPass(const std::string& Name, const std::vector<std::string>& Reads, const std::vector<std::string>& Writes,
+	const RenderPassState& State, PassCallback Callback)
+{
+	Pass pass;
+	pass.Name = Name;
+	pass.Reads = Reads;
+	pass.Writes = Writes;
+	pass.State = State;
+	pass.Callback = std::move(Callback);
+	m_Passes.push_back(std::move(pass));
+}
+
+void RenderGraph::SetOutput(const std::string& Resource)
+{
+	if (std::find(m_Outputs.begin(), m_Outputs.end(), Resource) == m_Outputs.end())
+		m_Outputs.push_back(Resource);
+}
+
+bool RenderGraph::Compile()
+{
+	DeleteFramebuffers();
+	m_Order.clear();
+	m_TargetTextures.clear();
+
+	// a pass reading a resource runs after every other pass writing it
+	const int Count = (int)m_Passes.size();
+	std::vector<std::vector<int>> Dependents(Count);
+	std::vector<int> Dependencies(Count, 0);
+	for (int Reader = 0; Reader < Count; Reader++)
+	{
+		for (const std::string& Resource : m_Passes[Reader].Reads)
+		{
+			if (GetIsWriting(m_Passes[Reader], Resource))
+				continue;
+			for (int Writer = 0; Writer < Count; Writer++)
+			{
+				if (Writer != Reader && GetIsWriting(m_Passes[Writer], Resource))
+				{
+					Dependents[Writer].push_back(Reader);
+					Dependencies[Reader]++;
+				}
+			}
+		}
+	}
+
+	// topological sort preferring the declaration order
+	std::vector<int> Sorted;
+	std::vector<bool> IsSorted(Count, false);
+	while ((int)Sorted.size() < Count)
+	{
+		int Next = -1;
+		for (int i = 0; i < Count && Next < 0; i++)
+		{
+			if (!IsSorted[i] && Dependencies[i] == 0)
+				Next = i;
+		}
+		if (Next < 0)
+		{
+			std::cerr << "RenderGraph::Compile() => Passes depend on each other in a cycle" << std::endl;
+			return false;
+		}
+		IsSorted[Next] = true;
+		Sorted.push_back(Next);
+		for (int Dependent : Dependents[Next])
+			Dependencies[Dependent]--;
+	}
+
+	// walk back from the outputs, a pass is kept if something later needs what it writes
+	std::set<std::string> Needed(m_Outputs.begin(), m_Outputs.end());
+	std::vector<int> Reversed;
+	for (auto it = Sorted.rbegin(); it != Sorted.rend(); ++it)
+	{
+		const Pass& pass = m_Passes[*it];
+		bool IsNeeded = false;
+		for (const std::string& Resource : pass.Writes)
+			IsNeeded = IsNeeded || Needed.count(Resource) > 0;
+		if (!IsNeeded)
+			continue;
+		Needed.insert(pass.Reads.begin(), pass.Reads.end());
+		Reversed.push_back(*it);
+	}
+	m_Order.assign(Reversed.rbegin(), Reversed.rend());
+
+	// lifetimes of the transient targets in the execution order
+	std::map<std::string, std::pair<int, int>> Lifetimes;
+	for (int Position = 0; Position < (int)m_Order.size(); Position++)
+	{
+		const Pass& pass = m_Passes[m_Order[Position]];
+		std::vector<std::string> Resources = pass.Reads;
+		Resources.insert(Resources.end(), pass.Writes.begin(), pass.Writes.end());
+		for (const std::string& Resource : Resources)
+		{
+			if (!m_Targets.count(Resource))
+				continue;
+			auto Lifetime = Lifetimes.find(Resource);
+			if (Lifetime == Lifetimes.end())
+				Lifetimes[Resource] = { Position, Position };
+			else
+				Lifetime->second.second = Position;
+		}
+	}
+
+	// targets in the order of their first use take the first pooled texture free by then
+	std::vector<std::pair<std::pair<int, int>, std::string>> ByFirstUse;
+	for (const auto& Lifetime : Lifetimes)
+		ByFirstUse.push_back({ Lifetime.second, Lifetime.first });
+	std::sort(ByFirstUse.begin(), ByFirstUse.end());
+	for (PooledTexture& Pooled : m_Pool)
+		Pooled.FreeAfter = -1;
+	for (const auto& Target : ByFirstUse)
+	{
+		const RenderTargetDesc& Desc = m_Targets[Target.second];
+		int Slot = -1;
+		for (int i = 0; i < (int)m_Pool.size() && Slot < 0; i++)
+		{
+			if (m_Pool[i].Desc == Desc && m_Pool[i].FreeAfter < Target.first.first)
+				Slot = i;
+		}
+		if (Slot < 0)
+		{
+			PooledTexture Pooled;
+			Pooled.Desc = Desc;
+			glGenTextures(1, &Pooled.Texture);
+			GLStateCache::BindTexture(0, GL_TEXTURE_2D, Pooled.Texture);
+			const bool IsDepth = GetIsDepthFormat(Desc.Format);
+			const bool IsStencil = GetIsStencilFormat(Desc.Format);
+			const GLenum Type = Desc.Format == GL_DEPTH24_STENCIL8 ? GL_UNSIGNED_INT_24_8
+				: Desc.Format == GL_DEPTH32F_STENCIL8 ? GL_FLOAT_32_UNSIGNED_INT_24_8_REV : GL_FLOAT;
+			glTexImage2D(GL_TEXTURE_2D, 0, Desc.Format, Desc.Width, Desc.Height, 0,
+				IsStencil ? GL_DEPTH_STENCIL : IsDepth ? GL_DEPTH_COMPONENT : GL_RGBA, Type, nullptr);
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, IsDepth ? GL_NEAREST : GL_LINEAR);
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, IsDepth ? GL_NEAREST : GL_LINEAR);
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+			Slot = (int)m_Pool.size();
+			m_Pool.push_back(Pooled);
+		}
+		m_Pool[Slot].FreeAfter = Target.first.second;
+		m_TargetTextures[Target.second] = Slot;
+	}
+	CHECK_GL_ERROR();
+
+	if (!CreateFramebuffers())
+		return false;
+
+	std::cout << "RenderGraph::Compile() => " << m_Order.size() << " of " << m_Passes.size() << " passes, "
+		<< m_TargetTextures.size() << " targets in " << m_Pool.size() << " textures:";
+	for (int Index : m_Order)
+		std::cout << " " << m_Passes[Index].Name;
+	std::cout << std::endl;
+	return true;
+}
+
+void RenderGraph::Execute()
+{
+	GLint Backbuffer = 0;
+	GLint Viewport[4];
+	glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &Backbuffer);
+	glGetIntegerv(GL_VIEWPORT, Viewport);
+
+	GLuint Bound = (GLuint)Backbuffer;
+	for (int Index : m_Order)
+	{
+		const Pass& pass = m_Passes[Index];
+		const GLuint Framebuffer = pass.Framebuffer ? pass.Framebuffer : (GLuint)Backbuffer;
+		if (Framebuffer != Bound)
+		{
+			glBindFramebuffer(GL_FRAMEBUFFER, Framebuffer);
+			if (pass.Framebuffer)
+				glViewport(0, 0, pass.Viewport.Width, pass.Viewport.Height);
+			else
+				glViewport(Viewport[0], Viewport[1], Viewport[2], Viewport[3]);
+			Bound = Framebuffer;
+		}
+		ApplyState(pass.State);
+		pass.Callback();
+	}
+	if (Bound != (GLuint)Backbuffer)
+	{
+		glBindFramebuffer(GL_FRAMEBUFFER, Backbuffer);
+		glViewport(Viewport[0], Viewport[1], Viewport[2], Viewport[3]);
+	}
+	ApplyState(RenderPassState());
+	CHECK_GL_ERROR();
+}
+
+GLuint RenderGraph::GetTexture(const std::string& Name) const
+{
+	auto Target = m_TargetTextures.find(Name);
+	return Target != m_TargetTextures.end() ? m_Pool[Target->second].Texture : 0;
+}
+
+bool RenderGraph::GetIsWriting(const Pass& pass, const std::string& Resource)
+{
+	return std::find(pass.Writes.begin(), pass.Writes.end(), Resource) != pass.Writes.end();
+}
+
+void RenderGraph::ApplyState(const RenderPassState& State)
+{
+	GLStateCache::SetEnabled(GL_DEPTH_TEST, State.DepthTest);
+	GLStateCache::SetDepthFunc(State.DepthFunc);
+	GLStateCache::SetDepthMask(State.DepthWrite);
+	GLStateCache::SetColorMask(State.ColorWrite);
+	GLStateCache::SetEnabled(GL_BLEND, State.Blend);
+	GLStateCache::SetBlendFunc(State.BlendSrc, State.BlendDst);
+	GLStateCache::SetEnabled(GL_STENCIL_TEST, State.StencilTest);
+}
+
+bool RenderGraph::CreateFramebuffers()
+{
+	GLint Backbuffer = 0;
+	glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &Backbuffer);
+	for (int Index : m_Order)
+	{
+		Pass& pass = m_Passes[Index];
+		const bool IsBackbuffer = GetIsWriting(pass, RENDER_GRAPH_BACKBUFFER) || GetIsWriting(pass, RENDER_GRAPH_DEPTH);
+		std::vector<GLenum> DrawBuffers;
+		for (const std::string& Resource : pass.Writes)
+		{
+			auto Target = m_TargetTextures.find(Resource);
+			if (Target == m_TargetTextures.end())
+				continue;
+			if (IsBackbuffer)
+			{
+				std::cerr << "RenderGraph::Compile() => Pass " << pass.Name << " writes both the backbuffer and transient targets" << std::endl;
+				glBindFramebuffer(GL_FRAMEBUFFER, Backbuffer);
+				return false;
+			}
+			const PooledTexture& Pooled = m_Pool[Target->second];
+			if (!pass.Framebuffer)
+			{
+				glGenFramebuffers(1, &pass.Framebuffer);
+				glBindFramebuffer(GL_FRAMEBUFFER, pass.Framebuffer);
+				pass.Viewport = Pooled.Desc;
+			}
+			GLenum Attachment = GL_COLOR_ATTACHMENT0 + (GLenum)DrawBuffers.size();
+			if (GetIsStencilFormat(Pooled.Desc.Format))
+				Attachment = GL_DEPTH_STENCIL_ATTACHMENT;
+			else if (GetIsDepthFormat(Pooled.Desc.Format))
+				Attachment = GL_DEPTH_ATTACHMENT;
+			else
+				DrawBuffers.push_back(Attachment);
+			glFramebufferTexture2D(GL_FRAMEBUFFER, Attachment, GL_TEXTURE_2D, Pooled.Texture, 0);
+		}
+		if (!pass.Framebuffer)
+			continue;
+		if (DrawBuffers.empty())
+			glDrawBuffer(GL_NONE);
+		else
+			glDrawBuffers((GLsizei)DrawBuffers.size(), DrawBuffers.data());
+		const GLenum Status = glCheckFramebufferStatus(GL_FRAMEBUFFER);
+		glBindFramebuffer(GL_FRAMEBUFFER, Backbuffer);
+		if (Status != GL_FRAMEBUFFER_COMPLETE)
+		{
+			std::cerr << "RenderGraph::Compile() => Framebuffer of pass " << pass.Name << " is not complete" << std::endl;
+			return false;
+		}
+	}
+	CHECK_GL_ERROR();
+	return true;
+}
+
+void RenderGraph::DeleteFramebuffers()
+{
+	for (Pass& pass : m_Passes)
+	{
+		if (pass.Framebuffer)
+			glDeleteFramebuffers(1, &pass.Framebuffer);
+		pass.Framebuffer = 0;
+	}
+}
@@ -0,0 +1,159 @@
+#pragma once
+#include "pgr.h"
+#include <string>
+#include <vector>
+#include <map>
+#include <functional>
+#include <iostream>
+
+#define RENDER_GRAPH_BACKBUFFER "backbuffer" // color of the framebuffer bound when the graph executes
+#define RENDER_GRAPH_DEPTH "depth" // depth and stencil of the framebuffer bound when the graph executes
+
+/**
+ * @brief Fixed function state a render pass runs with, applied by the graph before the pass.
+ */
+struct RenderPassState
+{
+	bool DepthTest = true; /**< Enables the depth test. */
+	GLenum DepthFunc = GL_LESS; /**< Depth comparison. */
+	bool DepthWrite = true; /**< Enables depth writes. */
+	bool ColorWrite = true; /**< Enables color writes. */
+	bool Blend = false; /**< Enables blending. */
+	bool StencilTest = false; /**< Enables the stencil test, the pass sets the stencil function and operations. */
+	GLenum BlendSrc = GL_SRC_ALPHA; /**< Source blend factor. */
+	GLenum BlendDst = GL_ONE_MINUS_SRC_ALPHA; /**< Destination blend factor. */
+};
+
+/**
+ * @brief Description of a transient render target. Targets with equal descriptions share pooled textures.
+ */
+struct RenderTargetDesc
+{
+	GLsizei Width = 0; /**< Width in pixels. */
+	GLsizei Height = 0; /**< Height in pixels. */
+	GLenum Format = GL_RGBA8; /**< Internal format, depth formats are attached as depth. */
+
+	bool operator==(const RenderTargetDesc& Other) const
+	{
+		return Width == Other.Width && Height == Other.Height && Format == Other.Format;
+	}
+};
+
+/**
+ * @brief Declarative sequence of render passes.
+ *
+ * Passes declare the resources they read and write and the state they run with. Compile orders the passes so every
+ * pass reading a resource runs after all other passes writing it, keeping the declaration order otherwise, and culls
+ * passes whose writes are never read nor output. Transient render targets live from their first to their last use
+ * and share pooled textures with targets of equal description whose lifetimes do not overlap.
+ * Execute binds the framebuffer of each pass, applies its state through GLStateCache, which skips the values
+ * already in place, and calls the pass.
+ */
+class RenderGraph
+{
+public:
+	using PassCallback = std::function<void()>;
+
+	RenderGraph() = default;
+	~RenderGraph();
+	RenderGraph(const RenderGraph&) = delete;
+	RenderGraph& operator=(const RenderGraph&) = delete;
+
+	/**
+	 * @brief Removes all passes, targets and outputs. The pooled textures are kept.
+	 */
+	void Reset();
+
+	/**
+	 * @brief Declares a transient render target.
+	 *
+	 * @param Name The name of the target.
+	 * @param Desc The size and format of the target.
+	 */
+	void CreateTarget(const std::string& Name, const RenderTargetDesc& Desc);
+
+	/**
+	 * @brief Adds a pass.
+	 *
+	 * @param Name The name of the pass.
+	 * @param Reads Resources the pass reads. A resource the pass also writes only counts as a write.
+	 * @param Writes Resources the pass writes. Transient targets and the backbuffer can't be mixed in one pass.
+	 * @param State The state the pass runs with.
+	 * @param Callback Issues the draw calls of the pass.
+	 */
+	void AddPass(const std::string& Name, const std::vector<std::string>& Reads, const std::vector<std::string>& Writes,
+		const RenderPassState& State, PassCallback Callback);
+
+	/**
+	 * @brief Marks a resource as used after the graph executes. RENDER_GRAPH_BACKBUFFER is an output by default.
+	 */
+	void SetOutput(const std::string& Resource);
+
+	/**
+	 * @brief Orders and culls the passes and assigns the transient targets. Must be called on the GL thread.
+	 *
+	 * @return True if the passes could be ordered, false if they depend on each other in a cycle.
+	 */
+	bool Compile();
+
+	/**
+	 * @brief Executes the compiled passes into the currently bound framebuffer.
+	 */
+	void Execute();
+
+	/**
+	 * @brief Returns the texture of a transient target, for passes reading it.
+	 */
+	GLuint GetTexture(const std::string& Name) const;
+
+	/**
+	 * @brief Returns the number of passes which are executed.
+	 */
+	size_t GetExecutedPassCount() const { return m_Order.size(); }
+
+private:
+	struct Pass
+	{
+		std::string Name;
+		std::vector<std::string> Reads;
+		std::vector<std::string> Writes;
+		RenderPassState State;
+		PassCallback Callback;
+		GLuint Framebuffer = 0; /**< Framebuffer of the transient targets written, 0 for the backbuffer. */
+		RenderTargetDesc Viewport; /**< Size of the written targets. */
+	};
+
+	struct PooledTexture
+	{
+		RenderTargetDesc Desc;
+		GLuint Texture = 0;
+		int FreeAfter = -1; /**< Position in the order after which the texture is free in the current compile. */
+	};
+
+	/**
+	 * @brief Checks if a pass writes a resource.
+	 */
+	static bool GetIsWriting(const Pass& pass, const std::string& Resource);
+
+	/**
+	 * @brief Applies the state of a pass.
+	 */
+	static void ApplyState(const RenderPassState& State);
+
+	/**
+	 * @brief Creates the framebuffers of the passes writing transient targets.
+	 */
+	bool CreateFramebuffers();
+
+	/**
+	 * @brief Deletes the framebuffers of the passes.
+	 */
+	void DeleteFramebuffers();
+
+	std::vector<Pass> m_Passes; /**< Passes in declaration order. */
+	std::vector<int> m_Order; /**< Indices of the executed passes in execution order. */
+	std::map<std::string, RenderTargetDesc> m_Targets; /**< Declared transient targets. */
+	std::map<std::string, int> m_TargetTextures; /**< Pooled texture of every used transient target. */
+	std::vector<std::string> m_Outputs = { RENDER_GRAPH_BACKBUFFER }; /**< Resources used after the graph. */
+	std::vector<PooledTexture> m_Pool; /**< Textures of the transient targets, kept across compiles. */
+};
@@ -1,38 +1,83 @@
 #include "Scene.h"
+#include "ShaderCache.h"
+#include "GLStateCache.h"
+#include "MaterialLibrary.h"
+#include "FrameAllocator.h"
+#include <algorithm>
+
+namespace
+{
+	// moving or not depth tested, never occluders
+	const char* const OcclusionDynamicObjects[] = { "skybox", "muzzle_flash", "Eagle", "Revolver", "Chest_Top" };
+	// the camera moves through them
+	const char* const CollisionIgnoredObjects[] = { "skybox", "muzzle_flash", "floor", "Water", "ThroughWater" };
+
+	void HashBytes(uint64_t& Hash, const void* Data, size_t Size)
+	{
+		const unsigned char* Bytes = static_cast<const unsigned char*>(Data);
+		for (size_t i = 0; i < Size; i++)
+		{
+			Hash ^= Bytes[i];
+			Hash *= 1099511628211ull;
+		}
+	}
+
+	template<typename T>
+	void HashValue(uint64_t& Hash, const T& Value)
+	{
+		HashBytes(Hash, &Value, sizeof(Value));
+	}
+}
+
+bool Scene::ParseSceneFile(std::istream& Stream, std::vector<SceneObjectDesc>& Objects)
+{
+	SceneObjectDesc Desc;
+	while (Stream >> Desc.Name)
+	{
+		if (!(Stream >> Desc.Location.x >> Desc.Location.y >> Desc.Location.z
+			>> Desc.Rotation.x >> Desc.Rotation.y >> Desc.Rotation.z
+			>> Desc.Scale.x >> Desc.Scale.y >> Desc.Scale.z >> Desc.ModelName)) {
+			std::cerr << "Scene::ParseSceneFile() => Error loading gameobject with name: " << Desc.Name << std::endl;
+			return false;
+		}
+		Objects.push_back(Desc);
+	}
+	return true;
+}
 
 bool Scene::LoadSceneFromFile(const std::string& Filename )
 {
+	ScopedArena LoadArena; // temporaries of the load itself, the meshes use their own nested arenas
+	if (!MaterialLibrary::LoadFromFile(MATERIAL_LIBRARY_FILE))
+		return false;
+	if (BinarySceneFile::IsBinarySceneFilename(Filename))
+		return LoadSceneFromBinaryFile(Filename);
+
 	std::ifstream f(Filename);
 	if (!f)
 	{
 		std::cerr << "Scene::LoadFromFile() => Can't open scene filename with given name: " << Filename << std::endl;
 		return false; 
 	}
-	MaterialsContainer materials;
+	std::vector<SceneObjectDesc> Objects;
+	if (!ParseSceneFile(f, Objects))
+	{
+		std::cerr << "Scene::LoadFromFile() => Error parsing scene file: " << Filename << std::endl;
+	}
+	std::vector<StreamedObjectDesc> StreamedObjects;
 
-	std::string ObjectName; 
-	while (f >> ObjectName)
+	for (const SceneObjectDesc& Desc : Objects)
 	{
-		glm::vec3 ObjectLocation, ObjectRotation, ObjectScale;
-		std::string ModelName;
-		if (!(f >> ObjectLocation.x >> ObjectLocation.y >> ObjectLocation.z
-			>> ObjectRotation.x >> ObjectRotation.y >> ObjectRotation.z
-			>> ObjectScale.x >> ObjectScale.y >> ObjectScale.z >> ModelName)) {
-			std::cerr << "Scene::LoadFromFile() => Error loading gameobject with name: " << ObjectName << std::endl;
+		const std::string& ObjectName = Desc.Name;
+		const std::string& ModelName = Desc.ModelName;
+
+		const Material& ObjectMaterial = MaterialLibrary::GetMaterialForObject(ObjectName);
+		if (GetIsStreamedObject(ObjectName))
+		{
+			StreamedObjects.push_back({ ObjectName, Transform(Desc.Location, Desc.Rotation, Desc.Scale), ModelName, ObjectMaterial });
 			continue;
 		}
 
-		Material ObjectMaterial = {}; // TODO: to level txt not hardcode 
-		if (ObjectName.rfind("Revolver", 0) == 0)
-			ObjectMaterial = materials.RevolverMaterial;
-		else if (ObjectName.rfind("Church", 0) == 0)
-			ObjectMaterial = materials.ChurchMaterial;
-		else if (ObjectName.rfind("House", 0) == 0)
-			ObjectMaterial = materials.HouseMaterial;
-		else
-			ObjectMaterial = materials.DefaultMaterial; 
-
-
 		std::shared_ptr<Mesh> ObjectMesh = nullptr; 
 		size_t MeshIndex = 0; 
 		if (GetIsMeshLoaded(ModelName, MeshIndex))
@@ -42,7 +87,7 @@ bool Scene::LoadSceneFromFile(const std::string& Filename )
 		else
 		{
 			ObjectMesh = std::make_shared<Mesh>(); 
-			if (!ObjectMesh->LoadFromFile(ModelName))
+			if (!LoadObjectMesh(*ObjectMesh, ModelName))
 			{
 				std::cerr << "Scene::LoadSceneFromFile() => Erorr loading mesh of object with name: " << ObjectName << std::endl;
 				continue;
@@ -50,16 +95,188 @@ bool Scene::LoadSceneFromFile(const std::string& Filename )
 			ObjectMesh->SetMaterial(ObjectMaterial); 
 			m_LoadedMeshes.push_back(ObjectMesh); 
 		}
-		Transform ObjectTransform(ObjectLocation, ObjectRotation, ObjectScale); 
+		Transform ObjectTransform(Desc.Location, Desc.Rotation, Desc.Scale); 
 		std::shared_ptr<GameObject> NewObject = std::make_shared <GameObject>(ObjectName, ObjectMesh, ObjectTransform ) ;
 		m_GameObjects.push_back(std::move(NewObject));
 		std::cout << "Succesfully loaded object: " + ObjectName << std::endl; 
 
 	}
+	if (!StreamedObjects.empty())
+		InitStreaming(StreamedObjects);
+	return LoadSceneResources(GetDefaultCameras(), GetDefaultLights());
+}
+
+bool Scene::LoadSceneFromBinaryFile(const std::string& Filename)
+{
+	BinarySceneFile File;
+	if (!File.Open(Filename))
+	{
+		std::cerr << "Scene::LoadSceneFromBinaryFile() => Can't load binary scene with given name: " << Filename << std::endl;
+		return false;
+	}
+	const BinarySceneHeader& Header = File.GetHeader();
+
+	// meshes are indexed by the object records, the material is taken from the first object using the mesh
+	// and resolved by name in the material library
+	LinearVector<std::shared_ptr<Mesh>> Meshes(Header.MeshCount, nullptr, ScopedArena::GetAdapter<std::shared_ptr<Mesh>>());
+	std::vector<StreamedObjectDesc> StreamedObjects;
+	m_GameObjects.reserve(m_GameObjects.size() + Header.ObjectCount);
+	for (uint32_t i = 0; i < Header.ObjectCount; i++)
+	{
+		const BinarySceneObject& Record = File.GetObjects()[i];
+		const char* MaterialName = File.GetString(File.GetMaterials()[Record.Material].Name);
+		const Material* ObjectMaterial = MaterialLibrary::FindMaterial(MaterialName);
+		if (!ObjectMaterial)
+		{
+			std::cerr << "Scene::LoadSceneFromBinaryFile() => Unknown material " << MaterialName << ", using the default material" << std::endl;
+			ObjectMaterial = MaterialLibrary::FindMaterial(MATERIAL_DEFAULT_NAME);
+		}
+		Transform ObjectTransform;
+		ObjectTransform.Location = glm::make_vec3(Record.Location);
+		ObjectTransform.Rotation = glm::quat(Record.Rotation[3], Record.Rotation[0], Record.Rotation[1], Record.Rotation[2]);
+		ObjectTransform.Scale = glm::make_vec3(Record.Scale);
+		const char* ObjectName = File.GetString(Record.Name);
+		const char* ModelName = File.GetString(File.GetMeshes()[Record.Mesh].Path);
+		if (GetIsStreamedObject(ObjectName))
+		{
+			StreamedObjects.push_back({ ObjectName, ObjectTransform, ModelName, *ObjectMaterial });
+			continue;
+		}
+
+		std::shared_ptr<Mesh>& ObjectMesh = Meshes[Record.Mesh];
+		if (!ObjectMesh)
+		{
+			ObjectMesh = std::make_shared<Mesh>();
+			if (!LoadObjectMesh(*ObjectMesh, ModelName))
+			{
+				std::cerr << "Scene::LoadSceneFromBinaryFile() => Erorr loading mesh of object with name: " << ObjectName << std::endl;
+				ObjectMesh.reset();
+				continue;
+			}
+			ObjectMesh->SetMaterial(*ObjectMaterial);
+			m_LoadedMeshes.push_back(ObjectMesh);
+		}
+		m_GameObjects.push_back(std::make_shared<GameObject>(ObjectName, ObjectMesh, ObjectTransform));
+	}
+	std::cout << "Succesfully loaded " << Header.ObjectCount - StreamedObjects.size() << " objects and " << m_LoadedMeshes.size() << " meshes from " << Filename << std::endl;
+	if (!StreamedObjects.empty())
+		InitStreaming(StreamedObjects);
+
+	std::vector<SceneCameraDesc> Cameras;
+	for (uint32_t i = 0; i < Header.CameraCount; i++)
+	{
+		const BinarySceneCamera& Record = File.GetCameras()[i];
+		Cameras.push_back({ File.GetString(Record.Name), glm::make_vec3(Record.Location), Record.Pitch, Record.Yaw, Record.Movable != 0,
+			Record.AttachTo == BINARY_SCENE_NO_PARENT ? std::string() : std::string(File.GetString(Record.AttachTo)) });
+	}
+	std::vector<SceneLightDesc> Lights;
+	for (uint32_t i = 0; i < Header.LightCount; i++)
+	{
+		const BinarySceneLight& Record = File.GetLights()[i];
+		Lights.push_back({ (SceneLightType)Record.Type, glm::make_vec3(Record.Vector), Record.Active != 0 });
+	}
+	File.Close();
+	return LoadSceneResources(Cameras, Lights);
+}
+
+void Scene::SetStreamingSettings(const StreamingSettings& Settings)
+{
+	m_StreamingSettings = Settings;
+}
+
+void Scene::SetDynamicResolution(const DynamicResolutionSettings& Settings)
+{
+	m_DynamicResolution.SetSettings(Settings);
+}
+
+void Scene::SetCameraControls(float Speed, float MouseSensitivity)
+{
+	m_CameraSpeed = Speed;
+	m_MouseSensitivity = MouseSensitivity;
+}
+
+void Scene::SetOcclusionCullingEnabled(bool Enabled)
+{
+	m_IsOcclusionCullingEnabled = Enabled;
+}
+
+void Scene::SetDepthPrepassEnabled(bool Enabled)
+{
+	m_IsDepthPrepassEnabled = Enabled;
+	if (m_RenderGraph.GetExecutedPassCount() > 0) // rebuild a graph of a loaded scene
+		BuildRenderGraph();
+}
+
+bool Scene::GetIsStreamedObject(const std::string& ObjectName) const
+{
+	if (m_StreamingSettings.CellSize <= 0.f)
+		return false;
+	for (const std::string& Prefix : STREAMING_PERSISTENT_OBJECTS)
+	{
+		if (ObjectName.rfind(Prefix, 0) == 0)
+			return false;
+	}
+	return true;
+}
+
+void Scene::InitStreaming(const std::vector<StreamedObjectDesc>& Objects)
+{
+	StreamingSettings Settings = m_StreamingSettings;
+	// streamed buildings are the largest static objects, they must keep their triangles to be picked as occluders
+	Settings.OccluderMaxTriangles = m_IsOcclusionCullingEnabled ? OCCLUSION_MAX_OCCLUDER_TRIANGLES : 0;
+	m_Streamer.Init(Settings, Objects);
+	if (!m_Streamer.GetIsEnabled())
+		return;
+	glm::vec2 Min, Max;
+	m_Streamer.GetWorldBounds(Min, Max);
+	m_WorldBoundsMin.x = glm::min(m_WorldBoundsMin.x, Min.x);
+	m_WorldBoundsMin.z = glm::min(m_WorldBoundsMin.z, Min.y);
+	m_WorldBoundsMax.x = glm::max(m_WorldBoundsMax.x, Max.x);
+	m_WorldBoundsMax.z = glm::max(m_WorldBoundsMax.z, Max.y);
+}
+
+void Scene::UpdateStreaming(float dt)
+{
+	auto ActiveCamera = GetActiveCamera().lock();
+	if (!ActiveCamera || !m_Streamer.GetIsEnabled())
+		return;
+	std::vector<std::shared_ptr<GameObject>> Added, Removed;
+	m_Streamer.Update(ActiveCamera->GetWorldLocation(), dt, Added, Removed);
+	for (const auto& Object : Removed)
+	{
+		m_Collision.Remove(Object->GetEntity());
+		if (Object.get() == m_Eagle)
+			m_Eagle = nullptr;
+		if (Object.get() == m_Skybox)
+			m_Skybox = nullptr;
+	}
+	if (!Removed.empty())
+	{
+		m_GameObjects.erase(std::remove_if(m_GameObjects.begin(), m_GameObjects.end(), [&Removed](const std::shared_ptr<GameObject>& Object)
+			{ return std::find(Removed.begin(), Removed.end(), Object) != Removed.end(); }), m_GameObjects.end());
+	}
+	for (const auto& Object : Added)
+		SetupObjectComponents(*Object);
+	m_GameObjects.insert(m_GameObjects.end(), Added.begin(), Added.end());
+	if (!Added.empty() || !Removed.empty())
+	{
+		SelectOccluders();
+		Invalidate();
+	}
+}
+
+bool Scene::LoadSceneResources(const std::vector<SceneCameraDesc>& Cameras, const std::vector<SceneLightDesc>& Lights)
+{
 	if (!LoadShaders())
 		return false;
+	if (!MaterialLibrary::UploadToGPU())
+		return false;
+	for (const std::string& ShaderName : MaterialLibrary::GetShaderNames())
+	{
+		if (!GetShaderByName(ShaderName).GetIsValid())
+			std::cerr << "Scene::LoadSceneResources() => Unknown material shader " << ShaderName << ", using " << MATERIAL_DEFAULT_SHADER << std::endl;
+	}
 
-	MuzzleFlashTexture = TextureFromFile("resources/textures/muzzle_flash.png");
 	if (!LoadSkybox(SKYBOX_BASE_NAME, SKYBOX_PATH, SKYBOX_SUFFIXES, SKYBOX_EXTENSION))
 	{
 		std::cerr << "Scene::LoadSceneFromFile():: Error loading skybox" << std::endl; 
@@ -79,16 +296,40 @@ bool Scene::LoadSceneFromFile(const std::string& Filename )
 	
 	}
 
-	SetupCameras(); 
-	SetupLights(); 
-	DayStartTime = glutGet(GLUT_ELAPSED_TIME) * 0.001f; 
+	SetupCameras(Cameras); 
+	SetupLights(Lights); 
+	m_Timeline.Clear();
+	DayTime = 0.f;
+	TrackTiming DayCycle;
+	DayCycle.Duration = DayLength + NightLength;
+	DayCycle.Loop = TrackLoop::Loop;
+	m_Timeline.AddFloat(&DayTime, 0.f, DayCycle.Duration, DayCycle);
 
 	auto Eagle = FindObjectByName("Eagle"); 
 	auto MuzzleFlash = FindObjectByName("muzzle_flash"); 
 	if (Eagle && MuzzleFlash)
 	{
-		MuzzleFlash->AttachToObject(Eagle); 
+		MuzzleFlash->AttachToObject(Eagle.get()); 
+	}
+	for (const auto& Object : m_GameObjects)
+		SetupObjectComponents(*Object);
+	if (!m_StreamBuffer.Init(STREAM_BUFFER_FRAME_SIZE))
+	{
+		std::cerr << "Scene::LoadSceneFromFile() Error => failed to create stream buffer" << std::endl; 
+		return false;
 	}
+	if (!SetupParticles())
+	{
+		std::cerr << "Scene::LoadSceneFromFile() Error => failed to set up particles" << std::endl; 
+		return false;
+	}
+	SelectOccluders();
+	if (!BuildRenderGraph())
+	{
+		std::cerr << "Scene::LoadSceneFromFile() Error => failed to build render graph" << std::endl; 
+		return false;
+	}
+	PrintMemoryReport();
 	return true; 
 
 }
@@ -97,7 +338,7 @@ bool Scene::LoadSkybox(const std::string& BaseName, const std::string& SkyboxPat
 {
 	GLuint ID; 
 	glGenTextures(1, &ID); 
-	glBindTexture(GL_TEXTURE_CUBE_MAP, ID); 
+	GLStateCache::BindTexture(0, GL_TEXTURE_CUBE_MAP, ID); 
 
 	int w, h, channels; 
 
@@ -123,7 +364,6 @@ bool Scene::LoadSkybox(const std::string& BaseName, const std::string& SkyboxPat
 	glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
 	glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
 	glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
-	glBindTexture(GL_TEXTURE_CUBE_MAP, 0); 
 	CHECK_GL_ERROR();
 
 	SkyboxTexture = ID; 
@@ -191,35 +431,36 @@ bool Scene::LoadCube()
 #pragma endregion 
 
 	Transform CubeTransform = { { 2.75f, 0.3f, -0.5f, }, { 0.0f, 30.0f, 0.0f, }, { 0.5f, 0.5f, 0.5f } };
-	std::shared_ptr <GameObject> CubeObject = std::make_shared<GameObject> () ;
-	CubeObject->m_Name = "Box";
-	CubeObject->SetWorldTransform(CubeTransform); 
 	std::shared_ptr<Mesh> CubeMesh = std::make_shared<Mesh>();
-	CubeObject->m_Mesh = CubeMesh;
-	MaterialsContainer mats; 
-	CubeMesh->m_Material = mats.DefaultMaterial;
+	CubeMesh->m_Material = MaterialLibrary::GetMaterialForObject("Box");
+	// the mesh gets its material first, the render component of the object takes the material ID on construction
+	std::shared_ptr <GameObject> CubeObject = std::make_shared<GameObject>("Box", CubeMesh, CubeTransform);
 	MeshGeometry cubeGeometry; 
 	cubeGeometry.m_Vertices = cubeVertices; 
 
 	cubeGeometry.LoadGeometryToGPU(); 
 	CHECK_GL_ERROR();
 
-	std::string texture_diffuse_path = "resources/textures/box_diffuse.png"; 
-	std::string texture_specular_path = "resources/textures/box_specular.png";
-	std::string texture_diffuse_type = "texture_diffuse";
-	std::string texture_specular_type = "texture_specular";
-	GLuint cubeDiffuse = TextureFromFile("resources/textures/box_diffuse.png");
-	GLuint cubeSpecular = TextureFromFile("resources/textures/box_specular.png");
-
-	if (cubeDiffuse == 0 || cubeSpecular == 0)
-		return false;
-	Texture cube_diffuse_texture{ cubeDiffuse, texture_diffuse_type, texture_diffuse_path }; 
-	Texture cube_specular_texture{ cubeSpecular, texture_specular_type, texture_specular_path }; 
-
-	cubeGeometry.m_Textures.push_back(cube_diffuse_texture); 
-	cubeGeometry.m_Textures.push_back(cube_specular_texture); 
+	const std::pair<std::string, std::string> cubeTextures[] = {
+		{ "texture_diffuse", "resources/textures/box_diffuse.png" },
+		{ "texture_specular", "resources/textures/box_specular.png" } };
+	for (const auto& cubeTexture : cubeTextures)
+	{
+		TextureImage Image;
+		if (!LoadTextureImage(cubeTexture.second.c_str(), Image))
+			return false;
+		TextureArrayLayer Layer = TextureArrayPool::Acquire(cubeTexture.second, Image);
+		FreeTextureImage(Image);
+		if (!Layer.Texture)
+			return false;
+		Texture texture{ Layer.Texture, cubeTexture.first, cubeTexture.second, Layer.Layer };
+		cubeGeometry.m_Textures.push_back(texture);
+		cubeGeometry.m_OwnedLayers.push_back(Layer);
+		cubeGeometry.m_TextureBytes += TextureArrayPool::GetLayerBytes(Layer);
+	}
+	TextureArrayPool::UpdateMipmaps();
 	cubeGeometry.m_IsLoaded = true; 
-	CubeObject->m_Mesh->m_Geometry.push_back(cubeGeometry); 
+	CubeMesh->m_Geometry.push_back(cubeGeometry); 
 
 	m_GameObjects.push_back(CubeObject);
 	return true;
@@ -251,13 +492,13 @@ bool Scene::LoadShaders()
 	}
 
 	m_Shaders.push_back(std::move(shader_light));
-	Shader shader_muzzle_flash("muzzle_flash"); 
-	if (!shader_muzzle_flash.LoadShaderFromFile("src/shaders/muzzle_flash_vertex.glsl", "src/shaders/muzzle_flash_fragment.glsl"))
+	Shader shader_particle("particle"); 
+	if (!shader_particle.LoadShaderFromFile("src/shaders/particle_vertex.glsl", "src/shaders/particle_fragment.glsl"))
 	{
-		std::cerr << "Scene::LoadShaders() Error loading muzzle flash shader"; 
+		std::cerr << "Scene::LoadShaders() Error loading particle shader"; 
 		return false; 
 	}
-	m_Shaders.push_back(std::move(shader_muzzle_flash));
+	m_Shaders.push_back(std::move(shader_particle));
 	Shader skybox("skybox"); 
 	if (!skybox.LoadShaderFromFile("src/shaders/skybox_vertex.glsl", "src/shaders/skybox_fragment.glsl"))
 	{
@@ -273,6 +514,20 @@ bool Scene::LoadShaders()
 		return false;
 	}
 	m_Shaders.push_back(Eagle); 
+	Shader Depth("depth");
+	if (!Depth.LoadShaderFromFile("src/shaders/depth_vertex.glsl", "src/shaders/depth_fragment.glsl"))
+	{
+		std::cerr << "Scene::LoadShaders() Error loading depth shader" << std::endl;
+		return false;
+	}
+	m_Shaders.push_back(Depth);
+	for (const Shader& shader : m_Shaders)
+	{
+		shader.SetUniformBlockBinding("FrameData", FRAME_UNIFORM_BINDING);
+		shader.SetUniformBlockBinding("ObjectData", OBJECT_UNIFORM_BINDING);
+		shader.SetUniformBlockBinding("MaterialData", MATERIAL_UNIFORM_BINDING);
+	}
+	ShaderCache::PrintStats();
 	return true;
 }
 
@@ -286,11 +541,13 @@ bool Scene::LoadEagle()
 	return eaglePtr->LoadFromFile(BasePath, Suffixes); 
 }
 
-void Scene::ProcessMouseClick(const glm::vec2 & Position, float dt)
+unsigned char Scene::PickObject(const glm::vec2& Position) const
 {
-	unsigned char ObjectID = 0; 
-	glReadPixels((int)Position.x, (int)Position.y, 1,1, GL_STENCIL_INDEX, GL_UNSIGNED_BYTE, &ObjectID);
+	return m_DynamicResolution.ReadStencil(Position);
+}
 
+void Scene::ProcessObjectClick(unsigned char ObjectID, float dt)
+{
 	if (ObjectID == CHEST_TOP_ID)
 	{
 		if (!ChestAnimationActive)
@@ -300,8 +557,10 @@ void Scene::ProcessMouseClick(const glm::vec2 & Position, float dt)
 			{
 				ChestAnimationActive = true;
 				TargetChestRotation = ChestIsOpened ? ChestRotationOpened : ChestRotationClosed; 
-				InitialChestRotation = Chest->GetWorldRotation();
-				ChestAnimationStartTime = glutGet(GLUT_ELAPSED_TIME) * 0.001f; 
+				TrackTiming Timing;
+				Timing.Duration = ChestAnimationTime;
+				Timing.Ease = Easing::EaseInOut;
+				ChestTrack = m_Timeline.AddRotation(Chest->GetEntity(), Chest->GetRelativeTransform().Rotation, TargetChestRotation, Timing);
 			}
 		}
 	}
@@ -309,9 +568,10 @@ void Scene::ProcessMouseClick(const glm::vec2 & Position, float dt)
 	if (ObjectID == REVOLVER_ID)
 	{
 		auto Revolver = FindObjectByName("Revolver"); 
-		if (Revolver && !Revolver -> GetAttachParent())
+		if (Revolver && !Revolver -> GetIsAttached())
 		{
-			Revolver->AttachToObject(GetActiveCamera().lock()); 
+			Revolver->AttachToObject(GetActiveCamera().lock().get()); 
+			m_Collision.Remove(Revolver->GetEntity());
 			Revolver->SetRelativeLocation({ -0.1f, -0.2f, 0.4f });
 			glm::vec3 Rotation = glm::vec3(0.f, glm::radians(180.f), 0.f); 
 			glm::quat Rotation_Quad(Rotation); 
@@ -322,13 +582,13 @@ void Scene::ProcessMouseClick(const glm::vec2 & Position, float dt)
 	if (ObjectID == EAGLE_ID)
 	{
 		auto Revolver = FindObjectByName("Revolver"); 
-		if (Revolver && Revolver->GetAttachParent() )
+		if (Revolver && Revolver->GetIsAttached() )
 		{
 			auto Eagle = FindObjectByName("Eagle"); 
 			if (Eagle && Eagle->GetIsVisible())
 			{
-				MuzzleFlashStartTime = (float)glutGet(GLUT_ELAPSED_TIME) * 0.001f;
-				MuzzleFlashActive = true;
+				m_Particles.Burst(m_MuzzleFlashEmitter, 1);
+				m_Particles.Burst(m_GunSmokeEmitter, GUN_SMOKE_PARTICLES);
 				Eagle->SetVisibility(false);
 			}
 				 
@@ -341,7 +601,7 @@ void Scene::ProcessInputAction(InputAction inputAction, float dt)
 	auto ActiveCamera = GetActiveCamera().lock(); 
 	if (!ActiveCamera || !ActiveCamera -> Movable )
 		return; 
-	glm::vec3 MovementDir; 
+	glm::vec3 MovementDir(0.f); // Fire does not move, the direction must not be left uninitialized for replays
 	switch (inputAction)
 	{
 		case ( InputAction::MoveForward ): 
@@ -374,17 +634,12 @@ void Scene::ProcessInputAction(InputAction inputAction, float dt)
 
 		}
 	}
-	glm::vec3 ResultLocation = ActiveCamera->GetWorldLocation() + MovementDir * dt * ActiveCamera->GetCameraSpeed();
-	if (ResultLocation.x > 20 || ResultLocation.x < -20 || ResultLocation.y < 0.1 || ResultLocation.y > 35 || ResultLocation.z > 20 || ResultLocation.z < -20) // check if not out of bounds
+	const glm::vec3 Delta = m_Collision.MoveSphere(ActiveCamera->GetWorldLocation(), COLLISION_CAMERA_RADIUS, MovementDir * dt * ActiveCamera->GetCameraSpeed());
+	glm::vec3 ResultLocation = ActiveCamera->GetWorldLocation() + Delta;
+	if (ResultLocation.x > m_WorldBoundsMax.x || ResultLocation.x < m_WorldBoundsMin.x || ResultLocation.y < m_WorldBoundsMin.y || ResultLocation.y > m_WorldBoundsMax.y
+		|| ResultLocation.z > m_WorldBoundsMax.z || ResultLocation.z < m_WorldBoundsMin.z) // check if not out of bounds
 		return;
-	auto Eagle = FindObjectByName("Eagle");
-	if (Eagle)
-	{
-		glm::vec3 EagleLocation = Eagle->GetWorldLocation();
-		if (glm::length(EagleLocation - ActiveCamera->GetWorldLocation()) < 0.5) // check if not colliding with eagle
-			return;
-	}
-	ActiveCamera->AddDeltaLocation(MovementDir * dt * ActiveCamera->GetCameraSpeed());
+	ActiveCamera->AddDeltaLocation(Delta);
 }
 
 void Scene::ProcessMouseMovement(const glm::vec2& Offset, float dt)
@@ -405,14 +660,15 @@ std::weak_ptr<Camera> Scene::GetActiveCamera() const
 	return m_Cameras[m_ActiveCameraIndex];
 }
 
-Shader Scene::GetShaderByName(const std::string& ShaderName) const
+const Shader& Scene::GetShaderByName(const std::string& ShaderName) const
 {
+	static const Shader Invalid = Shader();
 	for (auto& Shader : m_Shaders)
 	{
 		if (Shader.GetShaderName() == ShaderName)
 			return Shader;
 	}
-	return Shader();
+	return Invalid;
 }
 
 std::shared_ptr<GameObject> Scene::FindObjectByName(const std::string& PartialName) const
@@ -433,67 +689,48 @@ void Scene::Render()
 		return;
 	}
 
-	RenderSkybox();
-	RenderEagle(); 
+	m_StreamBuffer.BeginFrame();
+	BindFrameUniforms();
+	MaterialLibrary::Bind();
 	auto Camera = GetActiveCamera().lock();
 
-	if (MuzzleFlashActive)
-	{
-		RenderBillboard(FindObjectByName("muzzle_flash"));
-	}
-
 
 	glm::mat4 P = Camera->GetProjectionMatrix();
 	glm::mat4 V = Camera->GetViewMatrix();
-	Shader shader_light = GetShaderByName("light");
-	shader_light.UseShader();
-	SetSceneUniforms(shader_light);
-	bool StencilOn = false;
-	for (const auto& GameObject : m_GameObjects)
+	UpdateClusteredLights(V, P);
+	if (m_IsOcclusionCullingEnabled)
+		m_OcclusionCuller.RenderOccluders(P * V);
+	// the pass runs over the dense render components, the world matrices are computed once for all entities before
+	EntityStore& Entities = EntityStore::Get();
+	Entities.UpdateWorldMatrices();
+	const ComponentArray<RenderComponent>& Renders = Entities.GetRenders();
+	m_MainPassDraws.clear();
+	for (size_t i = 0; i < Renders.size(); i++)
 	{
-		if (!GameObject->m_IsVisible)
+		const RenderComponent& Render = Renders[i];
+		if (!Render.Geometry || (Render.Flags & RENDER_VISIBLE) == 0)
 			continue;
-		if (GameObject->GetName().rfind("muzzle_flash", 0) == 0
-			|| GameObject->GetName().rfind("skybox", 0) == 0) // skybox and muzzle flash are rendered in different pass 
-		{
+		if (Render.Flags & RENDER_OWN_PASS) // skybox, muzzle flash and eagle are rendered in different pass 
 			continue;
-		}
-
-		if (GameObject->GetName().rfind("Revolver", 0) == 0)
-		{
-
-			 glEnable (GL_STENCIL_TEST);	
-			 glStencilOp(GL_KEEP, GL_KEEP, GL_REPLACE); 
-			 glStencilFunc(GL_ALWAYS, REVOLVER_ID, 0xff);
-			 StencilOn = true; 
-		}
-
-		if (GameObject->GetName().rfind("Chest_Top", 0) == 0)
-		{
-			glEnable(GL_STENCIL_TEST);
-			glStencilOp(GL_KEEP, GL_KEEP, GL_REPLACE);
-			glStencilFunc(GL_ALWAYS, CHEST_TOP_ID, 0xff);
-			StencilOn = true;
-		}
-
-		if (GameObject->GetName().rfind("Eagle", 0) == 0)
+		const uint32_t Entity = Renders.GetEntity(i);
+		const glm::mat4& M = Entities.GetTransforms().Get(Entity)->World;
+		if (GetIsOccluded(*Render.Geometry, M))
 		{
-			continue; 
-		}
-
-		if (GameObject->GetName().rfind("Box", 0) == 0)
-		{
-			int a = 0;
+			MeshGeometry::CountOccludedObject();
+			continue;
 		}
 
-		glm::mat4 M = GameObject -> GetWorldModelMatrix();
-		shader_light.SetMat4Parameter("PVMMatrix", P * V * M); 
-		shader_light.SetMat4Parameter("MMatrix", M);
+		ObjectUniforms Object = {};
+		Object.PVMMatrix = P * V * M;
+		Object.MMatrix = M;
+		Object.NormalMatrix = glm::mat4(glm::mat3(V) * glm::transpose(glm::inverse(glm::mat3(M))));
+		Object.WaterTransform = glm::mat4(1.0f);
+		Object.MaterialId = Render.MaterialId;
 
-		if (GameObject->GetName().rfind("Water", 0) == 0)
+		if (Render.Flags & RENDER_WATER)
 		{
 			glm::mat4 texTransform(1.0f);
-			float timeAlpha = glm::abs ( glm::sin(glutGet(GLUT_ELAPSED_TIME) * 0.0001f) );
+			float timeAlpha = glm::abs ( glm::sin(m_SceneTime * 0.1f) );
 			glm::vec3 translate0{ 0.f, 0.f, 0.f }; 
 			glm::vec3 translate1{ 1.f, 0.f, 0.f }; 
 			glm::quat rotation0(glm::vec3(0.f, 0.f, 0.f));
@@ -503,23 +740,102 @@ void Scene::Render()
 
 			texTransform = glm::toMat4(slerpRotation) * texTransform;
 			texTransform = glm::translate(texTransform, lerpLocation );
-			shader_light.SetMat4Parameter("WaterTransform", texTransform); 
-			shader_light.SetBoolParameter("IsWater", true);
+			Object.WaterTransform = texTransform; 
+			Object.IsWater = true;
 
 		}
+		const PickableComponent* Pickable = Entities.GetPickables().Get(Entity);
+		const uint64_t SortKey = MaterialLibrary::GetSortKey(Render.MaterialId, -(V * M)[3].z);
+		m_MainPassDraws.push_back({ Render.Geometry, m_StreamBuffer.WriteUniformBlock(Object), SortKey, Pickable ? Pickable->StencilId : (uint8_t)0 });
+	}
+	std::sort(m_MainPassDraws.begin(), m_MainPassDraws.end(), [](const MainPassDraw& A, const MainPassDraw& B) { return A.SortKey < B.SortKey; });
+
+	const float ResolutionScale = m_DynamicResolution.GetScale();
+	m_DynamicResolution.BeginScene();
+	m_RenderGraph.Execute();
+	m_DynamicResolution.EndScene();
+	MeshGeometry::CountPassGpuTime(m_IsDepthPrepassEnabled ? m_DepthPrepassTimer.GetLastTimeMs() : 0.0, m_MainPassTimer.GetLastTimeMs());
+	MeshGeometry::CountSceneGpuTime(m_DynamicResolution.GetGpuTimeMs(), ResolutionScale);
+	m_StreamBuffer.EndFrame();
+	CHECK_GL_ERROR();
 
-		GameObject->Render(shader_light);
-		shader_light.SetBoolParameter("IsWater", false);
+	// the frame spans the updates since the previous render and this render
+	MeshGeometry::CountFrameMemory(FrameAllocator::GetHeapAllocations(), FrameAllocator::Get().GetUsedBytes());
+	FrameAllocator::Reset();
+}
 
+bool Scene::BuildRenderGraph()
+{
+	m_RenderGraph.Reset();
+	// the opaque objects and the eagle write their pick ids into the stencil buffer
+	RenderPassState Opaque;
+	Opaque.StencilTest = true;
+	if (m_IsDepthPrepassEnabled)
+	{
+		RenderPassState DepthOnly;
+		DepthOnly.ColorWrite = false;
+		m_RenderGraph.AddPass("depth_prepass", {}, { RENDER_GRAPH_DEPTH }, DepthOnly, [this]()
+			{
+				m_DepthPrepassTimer.Begin();
+				RenderDepthPrepass();
+				m_DepthPrepassTimer.End();
+			});
+
+		// the depth is final, shade only the fragments which won
+		Opaque.DepthFunc = GL_EQUAL;
+		Opaque.DepthWrite = false;
+		m_RenderGraph.AddPass("opaque", { RENDER_GRAPH_DEPTH }, { RENDER_GRAPH_BACKBUFFER }, Opaque, [this]() { RenderMainPass(); });
+	}
+	else
+		m_RenderGraph.AddPass("opaque", {}, { RENDER_GRAPH_BACKBUFFER, RENDER_GRAPH_DEPTH }, Opaque, [this]() { RenderMainPass(); });
+	RenderPassState EaglePass;
+	EaglePass.StencilTest = true;
+	m_RenderGraph.AddPass("eagle", {}, { RENDER_GRAPH_BACKBUFFER, RENDER_GRAPH_DEPTH }, EaglePass, [this]() { RenderEagle(); });
+
+	// the skybox is drawn at the far plane behind everything, only where no object covered the pixel
+	RenderPassState Skybox;
+	Skybox.DepthFunc = GL_LEQUAL;
+	Skybox.DepthWrite = false;
+	m_RenderGraph.AddPass("skybox", { RENDER_GRAPH_DEPTH }, { RENDER_GRAPH_BACKBUFFER }, Skybox, [this]() { RenderSkybox(); });
+
+	// particles are blended without sorting, so they must not hide each other in the depth buffer
+	RenderPassState Particles;
+	Particles.DepthWrite = false;
+	Particles.Blend = true;
+	m_RenderGraph.AddPass("particles", { RENDER_GRAPH_DEPTH }, { RENDER_GRAPH_BACKBUFFER }, Particles, [this]()
+		{
+			auto Camera = GetActiveCamera().lock();
+			m_Particles.Render(GetShaderByName("particle"), Camera->GetViewMatrix(), Camera->GetProjectionMatrix(), m_StreamBuffer);
+		});
+	return m_RenderGraph.Compile();
+}
 
-		if (StencilOn)
+void Scene::RenderMainPass()
+{
+	m_MainPassTimer.Begin();
+	// the draws are sorted by shader, the program only changes between groups
+	const Shader* shader_light = nullptr;
+	size_t ShaderIndex = SIZE_MAX;
+	// the stencil test stays on for the whole pass, objects which can't be picked write 0 and only the reference changes
+	GLStateCache::SetStencilOp(GL_KEEP, GL_KEEP, GL_REPLACE);
+	for (const auto& Draw : m_MainPassDraws)
+	{
+		if (MaterialLibrary::GetSortKeyShader(Draw.SortKey) != ShaderIndex)
 		{
-			glDisable(GL_STENCIL_TEST); 
-			StencilOn = false; 
+			ShaderIndex = MaterialLibrary::GetSortKeyShader(Draw.SortKey);
+			shader_light = &GetShaderByName(MaterialLibrary::GetShaderNames()[ShaderIndex]);
+			if (!shader_light->GetIsValid())
+				shader_light = &GetShaderByName(MATERIAL_DEFAULT_SHADER);
+			shader_light->UseShader();
+			SetSceneUniforms(*shader_light);
 		}
+		GLStateCache::SetStencilFunc(GL_ALWAYS, Draw.StencilId, 0xff);
+
+		m_StreamBuffer.BindUniformBlock(OBJECT_UNIFORM_BINDING, Draw.Uniforms);
+		Draw.Geometry->Render(*shader_light);
+		MeshGeometry::CountObject();
 	}
-	CHECK_GL_ERROR();
-	
+	m_MainPassTimer.End();
 }
 
 void Scene::RenderSkybox()
@@ -532,15 +848,14 @@ void Scene::RenderSkybox()
 	}
 
 
-	auto Skybox = FindObjectByName("skybox"); 
+	GameObject* Skybox = m_Skybox;
 	if (!Skybox)
 	{
 		// std::cerr << "Scene::RenderSkybox() Error: Invalid skybox" << std::endl; 
 		return; 
 	}
 
-	Shader SkyboxShader = GetShaderByName("skybox"); 
-	glDisable(GL_DEPTH_TEST);
+	const Shader& SkyboxShader = GetShaderByName("skybox"); 
 	glm::mat4 V = glm::mat4(glm::mat3(Camera->GetViewMatrix())); 
 	glm::mat4 P = Camera->GetProjectionMatrix(); 
 	SkyboxShader.UseShader();
@@ -548,19 +863,10 @@ void Scene::RenderSkybox()
 	SkyboxShader.SetMat4Parameter("M", Skybox->GetWorldModelMatrix());
 	SkyboxShader.SetMat4Parameter("V", Camera->GetViewMatrix());
 
-	FogDayDefualts fd;
-	FogNightDefaults fn;
-	SkyboxShader.SetVec4Parameter("fogColor", isNight ? fn.color : fd.color);
-	SkyboxShader.SetFloatParameter("fogMaxDistance", isNight ? fn.maxDistance : fd.maxDistance);
-	SkyboxShader.SetFloatParameter("fogMinDistance", isNight ? fn.minDistance : fd.minDistance);
-
 
-	glActiveTexture(GL_TEXTURE0);
 	SkyboxShader.SetIntParameter("skyboxTexture", 0); 
-	glBindTexture(GL_TEXTURE_CUBE_MAP, SkyboxTexture); 
+	GLStateCache::BindTexture(0, GL_TEXTURE_CUBE_MAP, SkyboxTexture); 
 	Skybox->Render(); 
-	glBindTexture(GL_TEXTURE_CUBE_MAP, 0); 
-	glEnable(GL_DEPTH_TEST);
 	CHECK_GL_ERROR(); 
 	return; 
 }
@@ -573,7 +879,7 @@ void Scene::RenderEagle()
 {
 
 	auto Camera = GetActiveCamera().lock();
-	auto Eagle = FindObjectByName("Eagle");
+	::Eagle* Eagle = m_Eagle;
 
 	if (!Camera || !Eagle)
 		return; 
@@ -585,83 +891,19 @@ void Scene::RenderEagle()
 	glm::mat4 P = Camera->GetProjectionMatrix();
 	glm::mat4 M = Eagle->GetWorldModelMatrix(); 
 
-	glm::mat4 PVM = P * V * M;
-
 	// Set matrices parameters
-	auto EagleShader = GetShaderByName("Eagle"); 
+	const Shader& EagleShader = GetShaderByName("Eagle"); 
 	EagleShader.UseShader();
-	EagleShader.SetMat4Parameter("PVMMatrix", P * V * M);
-	EagleShader.SetMat4Parameter("MMatrix", M);
-	EagleShader.SetMat4Parameter("VMatrix", V);
-	// Set fog parameters
-	FogDayDefualts fd;
-	FogNightDefaults fn;
-	EagleShader.SetVec4Parameter("fogColor", isNight ? fn.color : fd.color);
-	EagleShader.SetFloatParameter("fogMaxDistance", isNight ? fn.maxDistance : fd.maxDistance);
-	EagleShader.SetFloatParameter("fogMinDistance", isNight ? fn.minDistance : fd.minDistance);
-	glEnable(GL_STENCIL_TEST);
-	glStencilOp(GL_KEEP, GL_KEEP, GL_REPLACE);
-	glStencilFunc(GL_ALWAYS, EAGLE_ID, 0xff);
+	ObjectUniforms Object = {};
+	Object.PVMMatrix = P * V * M;
+	Object.MMatrix = M;
+	Object.AnimationAlpha = Eagle->GetAnimationAlpha();
+	BindObjectUniforms(Object);
+	GLStateCache::SetStencilOp(GL_KEEP, GL_KEEP, GL_REPLACE);
+	GLStateCache::SetStencilFunc(GL_ALWAYS, EAGLE_ID, 0xff);
 	Eagle->Render(EagleShader); 
-	glDisable(GL_STENCIL_TEST);
 }
 
-void Scene::RenderBillboard(const std::shared_ptr<GameObject>& object) const
-{
-	if (!object)
-	{
-		std::cerr << "Scene::RenderBillboard() Error: invalid object" << std::endl; 
-		return; 
-	}
-	auto Camera = GetActiveCamera().lock(); 
-
-	Shader shader_muzzle_flash = GetShaderByName("muzzle_flash");
-	shader_muzzle_flash.UseShader();
-	glEnable(GL_BLEND);
-	glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
-
-
-	const glm::mat4 V = Camera->GetViewMatrix(); 
-	const glm::mat4 P = Camera->GetProjectionMatrix(); 
-
-	// just take 3x3 rotation part of the view transform
-	glm::mat4 billboardRotationMatrix = glm::mat4(
-		V[0],
-		V[1],
-		V[2],
-		glm::vec4(0.0f, 0.0f, 0.0f, 1.0f)
-	);
-	// inverse view rotation
-	billboardRotationMatrix = glm::rotate(billboardRotationMatrix, glm::radians(90.f), Camera->GetLeftVector()); // rotate plane to face camera
-	billboardRotationMatrix = glm::transpose(billboardRotationMatrix);
-
-	glm::mat4 matrix = glm::mat4(1.0f);
-	
-	matrix = glm::translate(matrix, object->GetWorldLocation());
-	
-	matrix = glm::scale(matrix, object->GetWorldTransform().Scale);
-
-	matrix = matrix * billboardRotationMatrix; // make billboard to face the camera
-
-	// Compute the final PVM matrix
-	glm::mat4 PVM = P * V * matrix;
-
-	//matrix = glm::mat4_cast(object->GetWorldRotation()) * matrix; 
-	auto loc = object->GetWorldLocation();
-
-	std::cout << "Muzzle flash location: " << loc.x << " , " << loc.y << " , " << loc.z << std::endl;
-
-	shader_muzzle_flash.SetMat4Parameter("PVMMatrix", PVM);
-	shader_muzzle_flash.SetIntParameter("frame", MuzzleFlashFrame);
-	glActiveTexture(GL_TEXTURE0);
-	shader_muzzle_flash.SetIntParameter("texSampler", 0);
-	glBindTexture(GL_TEXTURE_2D, MuzzleFlashTexture);
-	object->Render();
-
-	glBindTexture(GL_TEXTURE_2D, 0);
-	glDisable(GL_BLEND);
-	CHECK_GL_ERROR();
-}
 void Scene::SetSceneUniforms( const Shader & shader )
 {
 
@@ -671,107 +913,148 @@ void Scene::SetSceneUniforms( const Shader & shader )
 		std::cerr << "Scene::SetSceneUniforms() Error: not valid active camera" << std::endl; 
 		return; 
 	}
-	shader.SetMat4Parameter("VMatrix", ActiveCamera -> GetViewMatrix() );
-	shader.SetBoolParameter("isSpotlightActive", m_isSpotlightActive);
 	shader.SetVec3Parameter("spotLight.direction", -ActiveCamera->GetFrontVector()); 
 	// std::cout << "[" << ActiveCamera->GetFrontVector().x << " : "  << ActiveCamera->GetFrontVector().y << " : " << ActiveCamera->GetFrontVector().z << "]" << std::endl;
-	shader.SetVec3Parameter("directionalLight.direction", m_DirectionalLightDirection);
 
+	GLint Viewport[4];
+	glGetIntegerv(GL_VIEWPORT, Viewport);
+	m_ClusteredLighting.Bind(shader, glm::vec2(Viewport[2], Viewport[3]));
+
+
+}
+void Scene::BindFrameUniforms()
+{
+	auto ActiveCamera = GetActiveCamera().lock();
 	FogDayDefualts fd; 
 	FogNightDefaults fn; 
-	shader.SetVec4Parameter("fogColor", isNight ? fn.color : fd.color);
-	shader.SetFloatParameter("fogMaxDistance", isNight ? fn.maxDistance : fd.maxDistance); 
-	shader.SetFloatParameter("fogMinDistance", isNight ? fn.minDistance : fd.minDistance);
+	FrameUniforms Frame = {};
+	Frame.VMatrix = ActiveCamera->GetViewMatrix();
+	Frame.FogColor = isNight ? fn.color : fd.color;
+	Frame.DirectionalLightDirection = glm::vec4(glm::normalize(glm::vec3(Frame.VMatrix * glm::vec4(m_DirectionalLightDirection, 0.f))), 0.f);
+	Frame.FogMinDistance = isNight ? fn.minDistance : fd.minDistance;
+	Frame.FogMaxDistance = isNight ? fn.maxDistance : fd.maxDistance;
+	Frame.IsSpotlightActive = m_isSpotlightActive;
+	m_StreamBuffer.BindUniformBlock(FRAME_UNIFORM_BINDING, m_StreamBuffer.WriteUniformBlock(Frame));
+}
 
+void Scene::BindObjectUniforms(const ObjectUniforms& Object)
+{
+	m_StreamBuffer.BindUniformBlock(OBJECT_UNIFORM_BINDING, m_StreamBuffer.WriteUniformBlock(Object));
+}
 
-	for (size_t i = 0; i < m_PointLights.size(); i++)
+void Scene::RenderDepthPrepass()
+{
+	GetShaderByName("depth").UseShader();
+	for (const auto& Draw : m_MainPassDraws)
 	{
-		std::string i_str = std::to_string(i); 
-		shader.SetVec3Parameter("pointLights[" + i_str + "].position", m_PointLights[i].first);
-		shader.SetBoolParameter("isPointLightActive[" + i_str + "]", m_PointLights[i].second);
+		m_StreamBuffer.BindUniformBlock(OBJECT_UNIFORM_BINDING, Draw.Uniforms);
+		Draw.Geometry->RenderDepth();
 	}
-
-
 }
+
 void Scene::Update( float dt )
 {
+	m_SceneTime += dt; 
+	UpdateStreaming(dt);
 	for (auto& object : m_GameObjects)
 		object->Update(dt); 
 
 	auto ActiveCamera = GetActiveCamera().lock(); 
 	glm::vec3 Location = ActiveCamera->GetWorldTransform().Location;
 
-	if (MuzzleFlashActive)
+	m_Particles.Update(dt);
+	m_Timeline.Update(dt);
+	EntityStore::Get().UpdateWorldMatrices();
+	m_Collision.Update();
+	// the track is removed when the rotation reaches its target or the chest is destroyed
+	if (ChestAnimationActive && !m_Timeline.GetIsPlaying(ChestTrack))
 	{
-		float ElapsedTime = (float)(glutGet(GLUT_ELAPSED_TIME) * 0.001f) - MuzzleFlashStartTime;
-		const float MuzzleFlashLifetime = MuzzleFlashTotalFrames * MuzzleFlashFrameDuration; 
-		if (ElapsedTime >= MuzzleFlashLifetime)
-			MuzzleFlashActive = false;
-		if ( MuzzleFlashActive )
-		{
-			MuzzleFlashFrame = (int)((ElapsedTime / MuzzleFlashLifetime) * MuzzleFlashTotalFrames); 
-		}
+		ChestIsOpened = !ChestIsOpened; 
+		ChestAnimationActive = false;
+	}
 
+	const bool IsNightNow = DayTime >= DayLength;
+	if (IsNightNow != isNight)
+	{
+		isNight = IsNightNow;
+		Invalidate();
 	}
-	if (ChestAnimationActive)
+}
+uint64_t Scene::GetStateHash() const
+{
+	uint64_t Hash = 14695981039346656037ull;
+	HashValue(Hash, m_SceneTime);
+	HashValue(Hash, m_ActiveCameraIndex);
+	const bool Flags[] = { isNight, m_isSpotlightActive, ChestIsOpened, ChestAnimationActive };
+	HashBytes(Hash, Flags, sizeof(Flags));
+	for (const auto& Light : m_PointLights)
+		HashValue(Hash, Light.second);
+	for (const auto& Camera : m_Cameras)
 	{
-		auto Chest = FindObjectByName("Chest_Top"); 
-		if (Chest)
-		{
-			float ElapsedTime = (float)(glutGet(GLUT_ELAPSED_TIME) * 0.001f) - ChestAnimationStartTime;
-			Chest->SetWorldRotation(glm::slerp(InitialChestRotation, TargetChestRotation, ElapsedTime));
-			auto Rot = Chest->GetWorldRotation(); 
-			if (ElapsedTime >= ChestAnimationTime)
-			{
-				ChestIsOpened = !ChestIsOpened; 
-				ChestAnimationActive = false;
-			}
-		}
+		HashValue(Hash, Camera->GetPitch());
+		HashValue(Hash, Camera->GetYaw());
 	}
 
-	// UpdateTime 
+	// the fields are hashed one by one, so padding bytes never reach the hash
+	const EntityStore& Entities = EntityStore::Get();
+	const ComponentArray<TransformComponent>& Transforms = Entities.GetTransforms();
+	for (size_t i = 0; i < Transforms.size(); i++)
 	{
-		float CurrentTime = (float)glutGet(GLUT_ELAPSED_TIME) * 0.001f;
-		float ElapsedTime = CurrentTime - DayStartTime;
-		if (!isNight && ElapsedTime >= DayLength )
-		{
-			isNight = true;
-			DayStartTime = CurrentTime; 
-
-		}
-		else if (isNight && ElapsedTime >= NightLength)
-		{
-			isNight = false; 
-			DayStartTime = CurrentTime; 
-		}
+		const Transform& Local = Transforms[i].Local;
+		HashValue(Hash, Transforms.GetEntity(i));
+		HashValue(Hash, Local.Location);
+		HashValue(Hash, Local.Rotation);
+		HashValue(Hash, Local.Scale);
+		HashValue(Hash, Transforms[i].Parent.Index);
 	}
-}
-void Scene::SetupCameras() // TODO: rework. Read cameras from scene file 
-{
-	glm::vec3 Camera0Location(3.0f, 1.0f, -5.0f);
-	glm::vec3 Camera1Location(3.41f, 6.9f, 9.8f); 
-	glm::vec3 Camera2Location(4.44f, 1.7f, -13.0f); 
-	glm::vec3 CameraEagleLocation(0.0f, -0.2f, 0.0f);
-	std::unique_ptr <Camera> Camera0 = std::make_unique <Camera>( "Camera0", Camera0Location, 0.0f, 0.f);
-	std::unique_ptr <Camera> Camera1 = std::make_unique <Camera>( "Camera1", Camera1Location, 29.4f, -180.5f);
-	std::unique_ptr <Camera> Camera2 = std::make_unique <Camera>( "Camera2", Camera2Location, 2.8f, -1.9f);
-	std::unique_ptr <Camera> CameraEagle = std::make_unique<Camera>("CameraEagle", CameraEagleLocation, 45.f, 0.0f);
-	auto Eagle = FindObjectByName("Eagle"); 
-	if (Eagle)
+	const ComponentArray<RenderComponent>& Renders = Entities.GetRenders();
+	for (size_t i = 0; i < Renders.size(); i++)
 	{
-		CameraEagle->AttachToObject(Eagle); 
+		HashValue(Hash, Renders.GetEntity(i));
+		HashValue(Hash, Renders[i].Flags);
 	}
-	Camera1->Movable = false; 
-	Camera2->Movable = false; 
-	CameraEagle->Movable = false;
+	HashValue(Hash, m_Timeline.GetTrackCount());
+	HashValue(Hash, DayTime);
+	HashValue(Hash, m_Particles.GetLiveCount());
+	return Hash;
+}
 
+std::vector<SceneCameraDesc> Scene::GetDefaultCameras()
+{
+	return {
+		{ "Camera0", glm::vec3(3.0f, 1.0f, -5.0f), 0.0f, 0.f, true, "" },
+		{ "Camera1", glm::vec3(3.41f, 6.9f, 9.8f), 29.4f, -180.5f, false, "" },
+		{ "Camera2", glm::vec3(4.44f, 1.7f, -13.0f), 2.8f, -1.9f, false, "" },
+		{ "CameraEagle", glm::vec3(0.0f, -0.2f, 0.0f), 45.f, 0.0f, false, "Eagle" },
+	};
+}
+
+std::vector<SceneLightDesc> Scene::GetDefaultLights()
+{
+	DirectionalLightDefaults params; 
+	return {
+		{ SceneLightType::Directional, params.direction, true },
+		{ SceneLightType::Point, glm::vec3(4.0f, 2.0f, 0.f), true },
+		{ SceneLightType::Point, glm::vec3(3.41f, 6.9f, 9.8f), true },
+	};
+}
 
-	m_Cameras.push_back(std::move(Camera0));
-	m_Cameras.push_back(std::move(Camera1)); 
-	m_Cameras.push_back(std::move(Camera2));
-	m_Cameras.push_back(std::move(CameraEagle));
+void Scene::SetupCameras(const std::vector<SceneCameraDesc>& Cameras)
+{
+	for (const SceneCameraDesc& Desc : Cameras)
+	{
+		std::shared_ptr <Camera> NewCamera = std::make_shared <Camera>(Desc.Name, Desc.Location, Desc.Pitch, Desc.Yaw);
+		NewCamera->Movable = Desc.Movable; 
+		NewCamera->SetControls(m_CameraSpeed, m_MouseSensitivity);
+		if (!Desc.AttachTo.empty())
+		{
+			auto Parent = FindObjectByName(Desc.AttachTo); 
+			if (Parent)
+				NewCamera->AttachToObject(Parent.get()); 
+		}
+		m_Cameras.push_back(std::move(NewCamera));
+	}
 	m_ActiveCameraIndex = 0; 
-	return; 
 }
 
 void Scene::ToggleSpotlight()
@@ -786,36 +1069,249 @@ void Scene::SetCamerasAspectRation( float aspect )
 		Camera->SetProjectionParameters(45.f, aspect, 0.1f, 1500.f);
 	}
 }
-void Scene::SetupLights()
+void Scene::SetupLights(const std::vector<SceneLightDesc>& Lights)
 {
-	// Spotlight
-	DirectionalLightDefaults params; 
-	m_DirectionalLightDirection = params.direction;
-	//TODO: point lights
-	std::pair<glm::vec3, bool> pl = { {4.0f, 2.0f, 0.f}, true };
-	std::pair<glm::vec3, bool> pl1 = { {3.41f, 6.9f, 9.8f}, true };
-	//std::pair<glm::vec3, bool> pl2 = { {50.f, 50.f, 50.f}, true };
-	//std::pair<glm::vec3, bool> pl3 = { {-50.f, 50.f, 50.f}, true };
-	m_PointLights.push_back(pl); 
-	m_PointLights.push_back(pl1);
-	//m_PointLights.push_back(pl2);
-	//m_PointLights.push_back(pl3);
-
+	for (const SceneLightDesc& Light : Lights)
+	{
+		if (Light.Type == SceneLightType::Directional)
+			m_DirectionalLightDirection = Light.Vector;
+		else
+			m_PointLights.push_back({ Light.Vector, Light.Active });
+	}
 
+	m_ClusteredLighting.Init();
 	SetLightDefaultUniforms(); 
 }
 
+bool Scene::SetupParticles()
+{
+	if (!m_Particles.Init())
+		return false;
+
+	// the muzzle flash object only anchors the flash, it is not rendered itself
+	auto MuzzleFlash = FindObjectByName("muzzle_flash");
+	ParticleEmitterDesc Flash;
+	Flash.Name = "muzzle_flash";
+	Flash.Lifetime = MUZZLE_FLASH_FRAMES * MUZZLE_FLASH_FRAME_DURATION;
+	Flash.StartSize = Flash.EndSize = MuzzleFlash ? MuzzleFlash->GetWorldTransform().Scale.x : 1.f;
+	Flash.FirstFrame = 0;
+	Flash.FrameCount = MUZZLE_FLASH_FRAMES;
+	Flash.LocalSpace = true;
+	m_MuzzleFlashEmitter = m_Particles.AddEmitter(Flash, MuzzleFlash ? MuzzleFlash->GetEntity() : EntityHandle());
+
+	ParticleEmitterDesc Smoke;
+	Smoke.Name = "gun_smoke";
+	Smoke.Lifetime = 2.5f;
+	Smoke.LifetimeVariance = 0.8f;
+	Smoke.SpawnExtent = glm::vec3(0.1f);
+	Smoke.Velocity = glm::vec3(0.f, 0.6f, 0.f);
+	Smoke.VelocityVariance = glm::vec3(0.5f, 0.3f, 0.5f);
+	Smoke.Acceleration = glm::vec3(0.f, 0.3f, 0.f);
+	Smoke.Drag = 0.8f;
+	Smoke.StartSize = 0.2f;
+	Smoke.EndSize = 1.4f;
+	Smoke.StartColor = glm::vec4(0.6f, 0.6f, 0.6f, 0.5f);
+	Smoke.EndColor = glm::vec4(0.8f, 0.8f, 0.8f, 0.f);
+	m_GunSmokeEmitter = m_Particles.AddEmitter(Smoke, MuzzleFlash ? MuzzleFlash->GetEntity() : EntityHandle());
+
+	// dust drifting over the whole walkable area
+	ParticleEmitterDesc Dust;
+	Dust.Name = "dust";
+	Dust.Rate = 60.f;
+	Dust.Lifetime = 8.f;
+	Dust.LifetimeVariance = 3.f;
+	Dust.SpawnExtent = glm::vec3((m_WorldBoundsMax.x - m_WorldBoundsMin.x) * 0.5f, 1.5f, (m_WorldBoundsMax.z - m_WorldBoundsMin.z) * 0.5f);
+	Dust.Velocity = glm::vec3(0.3f, 0.f, 0.1f);
+	Dust.VelocityVariance = glm::vec3(0.2f, 0.05f, 0.2f);
+	Dust.StartSize = 0.04f;
+	Dust.EndSize = 0.08f;
+	Dust.StartColor = glm::vec4(0.8f, 0.7f, 0.55f, 0.5f);
+	Dust.EndColor = glm::vec4(0.8f, 0.7f, 0.55f, 0.f);
+	const glm::vec3 DustCenter = glm::vec3((m_WorldBoundsMin.x + m_WorldBoundsMax.x) * 0.5f, m_WorldBoundsMin.y + 1.5f, (m_WorldBoundsMin.z + m_WorldBoundsMax.z) * 0.5f);
+	m_Particles.SetEmitterActive(m_Particles.AddEmitter(Dust, EntityHandle(), DustCenter), true);
+	return true;
+}
+
+bool Scene::LoadObjectMesh(Mesh& ObjectMesh, const std::string& ModelName) const
+{
+	// the temporaries of a mesh are released before the next one loads, so the load peak is set by the largest mesh
+	ScopedArena MeshArena;
+	if (!ObjectMesh.LoadDataFromFile(ModelName))
+		return false;
+	if (m_IsOcclusionCullingEnabled && ObjectMesh.GetTriangleCount() <= OCCLUSION_MAX_OCCLUDER_TRIANGLES)
+		ObjectMesh.SetCPURetention(CPURetention::Triangles);
+	ObjectMesh.UploadToGPU();
+	return true;
+}
+
+void Scene::SelectOccluders()
+{
+	struct OccluderCandidate
+	{
+		std::shared_ptr<GameObject> Object;
+		float Volume;
+	};
+	std::vector<OccluderCandidate> Candidates;
+	for (const auto& Object : m_GameObjects)
+	{
+		bool IsDynamic = Object->GetIsAttached();
+		for (const char* Prefix : OcclusionDynamicObjects)
+			IsDynamic = IsDynamic || Object->GetName().rfind(Prefix, 0) == 0;
+		glm::vec3 Min, Max;
+		if (IsDynamic || !Object->m_Mesh || !Object->m_Mesh->GetBounds(Min, Max))
+			continue;
+		const glm::vec3 Size = (Max - Min) * Object->GetWorldTransform().Scale;
+		Candidates.push_back({ Object, std::abs(Size.x * Size.y * Size.z) });
+	}
+	std::sort(Candidates.begin(), Candidates.end(), [](const OccluderCandidate& a, const OccluderCandidate& b) { return a.Volume > b.Volume; });
+
+	m_OcclusionCuller.ClearOccluders();
+	std::map<std::string, std::shared_ptr<Mesh>> AuthoredOccluders; // by model path, null if the model has none
+	int Occluders = 0;
+	for (const OccluderCandidate& Candidate : Candidates)
+	{
+		if (Occluders >= OCCLUSION_MAX_OCCLUDERS)
+			break;
+		const std::shared_ptr<Mesh>& ObjectMesh = Candidate.Object->m_Mesh;
+		const std::string Path = ObjectMesh->GetPath();
+		if (!AuthoredOccluders.count(Path))
+		{
+			std::string Filename = Path.substr(ObjectMesh->m_ModelsFolder.size());
+			Filename = Filename.substr(0, Filename.find_last_of('.')) + OCCLUSION_OCCLUDER_SUFFIX;
+			std::shared_ptr<Mesh> Occluder;
+			if (std::ifstream(ObjectMesh->m_ModelsFolder + Filename))
+			{
+				Occluder = std::make_shared<Mesh>();
+				if (!Occluder->LoadDataFromFile(Filename))
+					Occluder.reset();
+			}
+			AuthoredOccluders[Path] = Occluder;
+		}
+		const std::shared_ptr<Mesh>& Occluder = AuthoredOccluders[Path] ? AuthoredOccluders[Path] : ObjectMesh;
+		if (Occluder->GetTriangleCount() > OCCLUSION_MAX_OCCLUDER_TRIANGLES)
+			continue;
+
+		std::vector<glm::vec3> Triangles;
+		Occluder->AppendTriangles(Triangles);
+		if (Triangles.empty()) // loaded without occlusion culling, the triangles were released
+			continue;
+		const glm::mat4 M = Candidate.Object->GetWorldModelMatrix();
+		for (glm::vec3& Location : Triangles)
+			Location = glm::vec3(M * glm::vec4(Location, 1.f));
+		m_OcclusionCuller.AddOccluder(Triangles);
+		Occluders++;
+	}
+}
+
+void Scene::PrintMemoryReport() const
+{
+	const double KB = 1.0 / (1 << 10);
+	size_t CPUBytes = 0;
+	size_t GPUBytes = 0;
+	std::cout << "Scene::PrintMemoryReport() =>" << std::endl;
+	for (const auto& LoadedMesh : m_LoadedMeshes)
+	{
+		const size_t MeshCPUBytes = LoadedMesh->GetCPUMemoryUsage();
+		const size_t MeshGPUBytes = LoadedMesh->GetGPUMemoryUsage();
+		std::cout << "  " << LoadedMesh->GetPath() << ": CPU " << MeshCPUBytes * KB << " KB, GPU " << MeshGPUBytes * KB << " KB" << std::endl;
+		CPUBytes += MeshCPUBytes;
+		GPUBytes += MeshGPUBytes;
+	}
+	std::cout << "  " << m_LoadedMeshes.size() << " meshes: CPU " << CPUBytes * KB << " KB, GPU " << GPUBytes * KB << " KB";
+	if (m_Streamer.GetIsEnabled())
+		std::cout << ", streamed meshes " << m_Streamer.GetMemoryUsage() * KB << " KB";
+	std::cout << std::endl;
+	std::cout << "  " << EntityStore::Get().GetEntityCount() << " entities: " << EntityStore::Get().GetMemoryUsage() * KB << " KB" << std::endl;
+	if (m_IsOcclusionCullingEnabled)
+		std::cout << "  " << m_OcclusionCuller.GetOccluderTriangleCount() << " occluder triangles" << std::endl;
+	std::cout << "  " << m_Timeline.GetTrackCount() << " timeline tracks: " << m_Timeline.GetMemoryUsage() * KB << " KB" << std::endl;
+	TextureArrayPool::PrintReport();
+}
+
+bool Scene::GetIsOccluded(const Mesh& ObjectMesh, const glm::mat4& ModelMatrix) const
+{
+	glm::vec3 Min, Max;
+	if (!m_IsOcclusionCullingEnabled || !ObjectMesh.GetBounds(Min, Max))
+		return false;
+	return !m_OcclusionCuller.GetIsVisible(ModelMatrix, Min, Max);
+}
+
+bool Scene::GetIsAnimating() const
+{
+	if (m_HasWater || ChestAnimationActive || m_Particles.GetLiveCount() > 0)
+		return true;
+	return m_Eagle && m_Eagle->GetIsVisible();
+}
+
+bool Scene::ConsumeRedraw()
+{
+	const bool IsRedrawNeeded = m_IsRedrawNeeded || GetIsAnimating();
+	m_IsRedrawNeeded = false;
+	return IsRedrawNeeded;
+}
+
+void Scene::SetupObjectComponents(GameObject& Object)
+{
+	EntityStore& Entities = EntityStore::Get();
+	const uint32_t Entity = Object.GetEntity().Index;
+	RenderComponent* Render = Entities.GetRenders().Get(Entity);
+	const std::string& Name = Object.GetName();
+	if (Render && (Name.rfind("muzzle_flash", 0) == 0 || Name.rfind("skybox", 0) == 0 || Name.rfind("Eagle", 0) == 0))
+		Render->Flags |= RENDER_OWN_PASS;
+	if (!m_Eagle && Name.rfind("Eagle", 0) == 0)
+		m_Eagle = dynamic_cast<Eagle*>(&Object);
+	if (!m_Skybox && Name.rfind("skybox", 0) == 0)
+		m_Skybox = &Object;
+	if (Render && Name.rfind("Water", 0) == 0)
+	{
+		Render->Flags |= RENDER_WATER;
+		m_HasWater = true;
+	}
+
+	PickableComponent Pickable;
+	if (Name.rfind("Revolver", 0) == 0)
+		Pickable.StencilId = REVOLVER_ID;
+	else if (Name.rfind("Chest_Top", 0) == 0)
+		Pickable.StencilId = CHEST_TOP_ID;
+	if (Pickable.StencilId)
+		Entities.GetPickables().Add(Entity, Pickable);
+
+	// attached objects move with their parent, the revolver in the hand of the camera must not block it
+	bool IsCollidable = !Object.GetIsAttached();
+	for (const char* Prefix : CollisionIgnoredObjects)
+		IsCollidable = IsCollidable && Name.rfind(Prefix, 0) != 0;
+	glm::vec3 Min, Max;
+	if (IsCollidable && Object.GetLocalBounds(Min, Max))
+		m_Collision.Add(Object.GetEntity(), Min, Max);
+}
+
+void Scene::UpdateClusteredLights(const glm::mat4& View, const glm::mat4& Projection)
+{
+	PointLightDefaults plDefaults;
+	const glm::vec3 MaxColor = plDefaults.ambientColor + plDefaults.diffuseColor + plDefaults.specularColor;
+	const float Radius = ClusteredLighting::ComputeLightRadius(plDefaults.constant, plDefaults.linear, plDefaults.quadratic,
+		std::max(MaxColor.x, std::max(MaxColor.y, MaxColor.z)));
+
+	LinearVector<ClusterLight> Lights(FrameAllocator::GetAdapter<ClusterLight>());
+	Lights.reserve(m_PointLights.size());
+	for (const auto& pl : m_PointLights)
+	{
+		if (pl.second)
+			Lights.push_back({ pl.first, Radius });
+	}
+	m_ClusteredLighting.Update(View, Projection, Lights);
+}
+
 void Scene::SetLightDefaultUniforms()
 {
 	SpotlightDefaults slDefaults; 
 	PointLightDefaults plDefaults;
 	DirectionalLightDefaults dlDefaults; 
 
-	Shader shader = GetShaderByName("light"); 
+	const Shader& shader = GetShaderByName("light"); 
 	shader.UseShader(); 
 	// Directional light
 	
-	shader.SetVec3Parameter("directionalLight.direction", dlDefaults.direction);
 	shader.SetVec3Parameter("directionalLight.ambientColor", dlDefaults.ambientColor);
 	shader.SetVec3Parameter("directionalLight.diffuseColor", dlDefaults.diffuseColor);
 	shader.SetVec3Parameter("directionalLight.specularColor", dlDefaults.specularColor);
@@ -823,21 +1319,14 @@ void Scene::SetLightDefaultUniforms()
 	
 	// Point lights 
 
-	shader.SetIntParameter("nOfPointLights", m_PointLights.size()); 
-	for (size_t i = 0; i < m_PointLights.size(); i ++ )
-	{
-		std::string i_str = std::to_string(i);
-		shader.SetVec3Parameter("pointLights[" + i_str + "].ambientColor", plDefaults.ambientColor);
-		shader.SetVec3Parameter("pointLights[" + i_str + "].diffuseColor", plDefaults.diffuseColor);
-		shader.SetVec3Parameter("pointLights[" + i_str + "].specularColor", plDefaults.specularColor);
-		shader.SetFloatParameter("pointLights[" + i_str + "].constant", plDefaults.constant);
-		shader.SetFloatParameter("pointLights[" + i_str + "].linear", plDefaults.linear);
-		shader.SetFloatParameter("pointLights[" + i_str + "].quadratic", plDefaults.quadratic);
-
-	}
+	shader.SetVec3Parameter("pointLight.ambientColor", plDefaults.ambientColor);
+	shader.SetVec3Parameter("pointLight.diffuseColor", plDefaults.diffuseColor);
+	shader.SetVec3Parameter("pointLight.specularColor", plDefaults.specularColor);
+	shader.SetFloatParameter("pointLight.constant", plDefaults.constant);
+	shader.SetFloatParameter("pointLight.linear", plDefaults.linear);
+	shader.SetFloatParameter("pointLight.quadratic", plDefaults.quadratic);
 
 	// Spotlights
-	shader.SetBoolParameter("isSpotlightActive", m_isSpotlightActive);
 	shader.SetVec3Parameter("spotLight.ambientColor", slDefaults.ambientColor);
 	shader.SetVec3Parameter("spotLight.diffuseColor", slDefaults.diffuseColor);
 	shader.SetVec3Parameter("spotLight.specularColor", slDefaults.specularColor);
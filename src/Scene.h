@@ -10,6 +10,17 @@
 #include "Shader.h"
 #include "Eagle.h"
 #include "FunctionLibrary.h"
+#include "BinaryScene.h"
+#include "SceneStreamer.h"
+#include "ClusteredLighting.h"
+#include "ParticleSystem.h"
+#include "StreamBuffer.h"
+#include "OcclusionCuller.h"
+#include "GpuTimer.h"
+#include "RenderGraph.h"
+#include "DynamicResolution.h"
+#include "CollisionWorld.h"
+#include "Timeline.h"
 
 #define REVOLVER_ID 1
 #define CHEST_TOP_ID 2
@@ -18,46 +29,136 @@
 #define SKYBOX_BASE_NAME "sk"
 #define SKYBOX_SUFFIXES std::vector<std::string> {"right",  "left", "top", "bottom",  "front", "back"  }
 #define SKYBOX_EXTENSION ".jpg"
+#define STREAMING_PERSISTENT_OBJECTS std::vector<std::string> { "skybox", "muzzle_flash", "Revolver", "Chest" } // referenced by gameplay, never streamed out
+#define WORLD_BOUNDS_MIN glm::vec3(-20.f, 0.1f, -20.f)
+#define WORLD_BOUNDS_MAX glm::vec3(20.f, 35.f, 20.f)
+#define MUZZLE_FLASH_FRAME_DURATION 0.08f
+#define MUZZLE_FLASH_FRAMES 16
+#define GUN_SMOKE_PARTICLES 48 // emitted per shot
+#define DEPTH_PREPASS_DEFAULT_ENABLED 1
 
 
 class Application; 
+class MicroBenchmarkAccess; 
+
+/**
+ * @brief Object record of the text scene file.
+ */
+struct SceneObjectDesc
+{
+	std::string Name; /**< The name of the object. */
+	glm::vec3 Location; /**< The location of the object. */
+	glm::vec3 Rotation; /**< The rotation of the object in degrees. */
+	glm::vec3 Scale; /**< The scale of the object. */
+	std::string ModelName; /**< The model file of the object. */
+};
+
+/**
+ * @brief Camera record of a scene.
+ */
+struct SceneCameraDesc
+{
+	std::string Name; /**< The name of the camera. */
+	glm::vec3 Location; /**< The location of the camera, relative to the attach parent if any. */
+	float Pitch; /**< The pitch of the camera in degrees. */
+	float Yaw; /**< The yaw of the camera in degrees. */
+	bool Movable; /**< Flag indicating the camera can be moved by the player. */
+	std::string AttachTo; /**< Name prefix of the object the camera is attached to, empty for none. */
+};
+
+enum class SceneLightType
+{
+	Directional,
+	Point
+};
+
+/**
+ * @brief Light record of a scene.
+ */
+struct SceneLightDesc
+{
+	SceneLightType Type; /**< The type of the light. */
+	glm::vec3 Vector; /**< Direction of a directional light, position of a point light. */
+	bool Active; /**< Flag indicating the light is switched on. */
+};
 
 class Scene
 {
 	friend Application;  
+	friend MicroBenchmarkAccess; 
 
 public:
 
 	friend Application;
 
-public:
 	/**
-	 * @brief Duration of each frame of the muzzle flash animation.
+	 * @brief Parses object records of the text scene file. Does not touch GL.
+	 *
+	 * @param Stream The stream to parse.
+	 * @param Objects Output vector the parsed records are appended to.
+	 * @return True if the whole stream was parsed, false on a malformed record.
 	 */
-	float MuzzleFlashFrameDuration = 0.08f;
+	static bool ParseSceneFile(std::istream& Stream, std::vector<SceneObjectDesc>& Objects);
 
 	/**
-	 * @brief Start time of the muzzle flash animation.
+	 * @brief Returns the cameras used by scenes that don't define their own.
 	 */
-	float MuzzleFlashStartTime = 0.f;
+	static std::vector<SceneCameraDesc> GetDefaultCameras();
 
 	/**
-	 * @brief Indicates whether the muzzle flash animation is active.
-	 * @note TODO: Move to muzzle flash class.
+	 * @brief Returns the lights used by scenes that don't define their own.
 	 */
-	bool MuzzleFlashActive = false;
+	static std::vector<SceneLightDesc> GetDefaultLights();
 
 	/**
-	 * @brief Current frame of the muzzle flash animation.
+	 * @brief Sets the world streaming parameters. Must be called before the scene is loaded, a zero cell size loads every object at startup.
+	 *
+	 * @param Settings The streaming parameters.
 	 */
-	int MuzzleFlashFrame = 0;
+	void SetStreamingSettings(const StreamingSettings& Settings);
 
 	/**
-	 * @brief Total number of frames in the muzzle flash animation.
+	 * @brief Enables or disables software occlusion culling of game objects.
+	 *
+	 * @param Enabled True to skip objects hidden behind the occluders.
 	 */
-	int MuzzleFlashTotalFrames = 16;
+	void SetOcclusionCullingEnabled(bool Enabled);
 
-	GLint MuzzleFlashTexture; /**< Texture used for the muzzle flash animation. */
+	/**
+	 * @brief Sets the dynamic resolution parameters of the scene rendering.
+	 *
+	 * @param Settings The dynamic resolution parameters.
+	 */
+	void SetDynamicResolution(const DynamicResolutionSettings& Settings);
+
+	/**
+	 * @brief Sets the movement speed and the mouse sensitivity of the cameras. Must be called before the scene is loaded.
+	 *
+	 * @param Speed The movement speed in world units per second.
+	 * @param MouseSensitivity The rotation per pixel of mouse movement.
+	 */
+	void SetCameraControls(float Speed, float MouseSensitivity);
+
+	/**
+	 * @brief Enables or disables the depth pre-pass of the game objects.
+	 *
+	 * @param Enabled True to lay down depth first and shade only the visible fragments with GL_EQUAL depth testing.
+	 */
+	void SetDepthPrepassEnabled(bool Enabled);
+
+	/**
+	 * @brief Marks the scene as changed, the next ConsumeRedraw requests a frame.
+	 */
+	void Invalidate() { m_IsRedrawNeeded = true; }
+
+	/**
+	 * @brief Checks if a frame has to be rendered and resets the change flag.
+	 *
+	 * @return True if the scene changed since the last call or something on screen is animating, false otherwise.
+	 */
+	bool ConsumeRedraw();
+
+public:
 
 
 
@@ -76,23 +177,22 @@ public:
 	 */
 	float ChestAnimationTime = 1.0f;
 
-	/**
-	 * @brief Start time of the chest animation.
-	 */
-	float ChestAnimationStartTime = 0.f;
-
 	glm::quat ChestRotationClosed = glm::vec3(glm::radians(0.f), glm::radians(90.f), 0.f); /**< Quaternion representing the closed chest rotation. */
 	glm::quat ChestRotationOpened = glm::vec3(glm::radians(-45.f), glm::radians(90.f), 0.f);  /**< Quaternion representing the opened chest rotation. */
 	glm::quat TargetChestRotation = {}; /**< Quaternion representing the target chest rotation. */
-	glm::quat InitialChestRotation = {}; /**< Quaternion representing the initial chest rotation. */
+	TrackHandle ChestTrack; /**< Timeline track rotating the chest lid. */
 
 	GLuint SkyboxTexture; /**< Texture ID for the skybox. */
 
-	float DayStartTime; 
+	float DayTime = 0.f; /**< Time since the start of the day in seconds, looped over the day and the night by the timeline. */
 	float DayLength = 16.f;
 	float NightLength = 8.f;
 	bool isNight = false;
 
+	/**
+	 * @brief Simulation time of the scene in seconds. Advanced only by Update, so runs with fixed dt are repeatable.
+	 */
+	float m_SceneTime = 0.f;
 
 
 	private: 
@@ -111,6 +211,45 @@ public:
 		*/
 	bool LoadSceneFromFile(const std::string& Filename);
 
+	/**
+		* @brief Loads the scene from a compiled binary scene file.
+		*
+		* @param Filename The name of the binary scene file.
+		* @return True if the scene was loaded successfully, false otherwise.
+		*/
+	bool LoadSceneFromBinaryFile(const std::string& Filename);
+
+	/**
+		* @brief Loads resources shared by all scenes (shaders, skybox, eagle) and sets up cameras and lights.
+		*
+		* @param Cameras The cameras of the scene.
+		* @param Lights The lights of the scene.
+		* @return True if the resources were loaded successfully, false otherwise.
+		*/
+	bool LoadSceneResources(const std::vector<SceneCameraDesc>& Cameras, const std::vector<SceneLightDesc>& Lights);
+
+	/**
+		* @brief Checks if an object of the scene file is streamed instead of loaded at startup.
+		*
+		* @param ObjectName The name of the object.
+		* @return True if streaming is enabled and the object is not referenced by gameplay, false otherwise.
+		*/
+	bool GetIsStreamedObject(const std::string& ObjectName) const;
+
+	/**
+		* @brief Starts streaming the given objects and extends the world bounds to the streamed cells.
+		*
+		* @param Objects The streamed objects.
+		*/
+	void InitStreaming(const std::vector<StreamedObjectDesc>& Objects);
+
+	/**
+		* @brief Adds objects of newly streamed cells to the scene and removes objects of unloaded cells.
+		*
+		* @param dt The time elapsed since the last frame.
+		*/
+	void UpdateStreaming(float dt);
+
 	/**
 		* @brief Loads the skybox textures.
 		*
@@ -174,11 +313,52 @@ public:
 	std::shared_ptr<GameObject> FindObjectByName(const std::string& PartialName) const;
 
 	/**
-	 * @brief Renders a billboard for a given game object.
+	 * @brief Creates the particle emitters of the muzzle flash, the gun smoke and the ambient dust.
+	 *
+	 * @return True if the particle system was initialized, false otherwise.
+	 */
+	bool SetupParticles();
+
+	/**
+	 * @brief Loads a mesh of a scene object and uploads it. Meshes small enough to be occluders keep their triangles
+	 * in system memory when occlusion culling is enabled, the others release their CPU copies.
+	 *
+	 * @param ObjectMesh The mesh to load.
+	 * @param ModelName The model file of the mesh.
+	 * @return True if the mesh was loaded, false otherwise.
+	 */
+	bool LoadObjectMesh(Mesh& ObjectMesh, const std::string& ModelName) const;
+
+	/**
+	 * @brief Picks the occluders among the largest static game objects, using their authored occluder meshes if present.
+	 */
+	void SelectOccluders();
+
+	/**
+	 * @brief Prints the CPU and GPU memory of every loaded mesh and of the packed textures.
+	 */
+	void PrintMemoryReport() const;
+
+	/**
+	 * @brief Checks if software occlusion culling hides a mesh.
 	 *
-	 * @param object The game object to render the billboard for.
+	 * @param ObjectMesh The mesh to test.
+	 * @param ModelMatrix The world matrix of the mesh.
+	 * @return True if the mesh is hidden behind the occluders, false otherwise.
 	 */
-	void RenderBillboard(const std::shared_ptr<GameObject>& object) const;
+	bool GetIsOccluded(const Mesh& ObjectMesh, const glm::mat4& ModelMatrix) const;
+
+	/**
+	 * @brief Sets the render flags and pickable component of a game object from its name.
+	 *
+	 * @param Object The game object added to the scene.
+	 */
+	void SetupObjectComponents(GameObject& Object);
+
+	/**
+	 * @brief Checks if the scene changes every update: the eagle flies, particles live, the chest opens or water flows.
+	 */
+	bool GetIsAnimating() const;
 
 	/**
 	 * @brief Sets the scene-specific uniforms in the shader.
@@ -187,6 +367,35 @@ public:
 	 */
 	void SetSceneUniforms(const Shader& shader);
 
+	/**
+	 * @brief Writes the per-frame shader data into the stream buffer and binds it to FRAME_UNIFORM_BINDING.
+	 */
+	void BindFrameUniforms();
+
+	/**
+	 * @brief Writes per-object shader data into the stream buffer and binds it to OBJECT_UNIFORM_BINDING.
+	 *
+	 * @param Object The per-object shader data.
+	 */
+	void BindObjectUniforms(const ObjectUniforms& Object);
+
+	/**
+	 * @brief Renders the depth of the collected main pass draws with the position-only shader.
+	 */
+	void RenderDepthPrepass();
+
+	/**
+	 * @brief Renders the collected main pass draws with the Phong shader.
+	 */
+	void RenderMainPass();
+
+	/**
+	 * @brief Declares the render passes of the frame and compiles the render graph.
+	 *
+	 * @return True if the graph compiled, false otherwise.
+	 */
+	bool BuildRenderGraph();
+
 	/**
 	 * @brief Checks if a mesh is already loaded.
 	 *
@@ -213,12 +422,28 @@ public:
 	void ProcessMouseMovement(const glm::vec2& Offset, float dt);
 
 	/**
-	 * @brief Processes mouse click input.
+	 * @brief Returns the pickable object drawn in the last frame under a window position.
 	 *
-	 * @param Position The mouse click position.
+	 * @param Position The position with the origin in the lower left corner.
+	 * @return The stencil id of the object, 0 if no pickable object is there.
+	 */
+	unsigned char PickObject(const glm::vec2& Position) const;
+
+	/**
+	 * @brief Processes a mouse click on a picked object.
+	 *
+	 * @param ObjectID The stencil id returned by PickObject.
 	 * @param dt The time elapsed since the last frame.
 	 */
-	void ProcessMouseClick(const glm::vec2& Position, float dt);
+	void ProcessObjectClick(unsigned char ObjectID, float dt);
+
+	/**
+	 * @brief Hashes the simulated state: time, cameras, entity transforms and flags, particles and toggles.
+	 * Replays compare it per tick to detect divergence, so it covers no render-only state.
+	 *
+	 * @return The 64 bit FNV-1a hash of the state.
+	 */
+	uint64_t GetStateHash() const;
 
 	/**
 	 * @brief Toggles the spotlight.
@@ -237,19 +462,31 @@ public:
 
 	/**
 	 * @brief Sets up the cameras for the scene.
+	 *
+	 * @param Cameras The camera records to create cameras from.
 	 */
-	void SetupCameras();
+	void SetupCameras(const std::vector<SceneCameraDesc>& Cameras);
 
 	/**
 	 * @brief Sets up the lights for the scene.
+	 *
+	 * @param Lights The light records to create lights from.
 	 */
-	void SetupLights();
+	void SetupLights(const std::vector<SceneLightDesc>& Lights);
 
 	/**
 	 * @brief Sets the default uniforms for the lights.
 	 */
 	void SetLightDefaultUniforms();
 
+	/**
+	 * @brief Assigns the active point lights to the light clusters of the camera.
+	 *
+	 * @param View The view matrix of the active camera.
+	 * @param Projection The projection matrix of the active camera.
+	 */
+	void UpdateClusteredLights(const glm::mat4& View, const glm::mat4& Projection);
+
 	/**
 	 * @brief Returns the active camera in the scene.
 	 *
@@ -265,7 +502,7 @@ public:
 	 * @param ShaderName The name of the shader.
 	 * @return The shader with the given name if found, an empty shader otherwise.
 	 */
-	Shader GetShaderByName(const std::string& ShaderName) const;
+	const Shader& GetShaderByName(const std::string& ShaderName) const;
 
 	std::vector<Shader> m_Shaders; /**< Vector of shaders used in the scene. */
 
@@ -277,11 +514,72 @@ public:
 
 	std::vector<std::pair<glm::vec3, bool>> m_PointLights; /**< Vector of point lights in the scene. Each pair consists of the light position and a flag indicating whether the light is active. */
 
+	OcclusionCuller m_OcclusionCuller; /**< Rasterizes the occluders and tests game objects against them. */
+
+	CollisionWorld m_Collision; /**< Bounding boxes of the game objects the camera collides with. */
+
+	Timeline m_Timeline; /**< Scripted animations of the chest lid and the day/night cycle. */
+
+	bool m_IsOcclusionCullingEnabled = OCCLUSION_DEFAULT_ENABLED; /**< Flag indicating whether hidden objects are skipped. */
+
+	bool m_IsDepthPrepassEnabled = DEPTH_PREPASS_DEFAULT_ENABLED; /**< Flag indicating whether the lit pass is preceded by a depth-only pass. */
+
+	bool m_IsRedrawNeeded = true; /**< Flag indicating the scene changed since the last rendered frame. */
+
+	bool m_HasWater = false; /**< Flag indicating a game object has the animated water texture. */
+
+	Eagle* m_Eagle = nullptr; /**< The eagle, found once by SetupObjectComponents so the render and idle check don't search by name. */
+
+	GameObject* m_Skybox = nullptr; /**< The skybox, found once by SetupObjectComponents. */
+
+	/**
+	 * @brief Visible entity of the frame with its per-object data.
+	 */
+	struct MainPassDraw
+	{
+		Mesh* Geometry;
+		StreamAllocation Uniforms;
+		uint64_t SortKey; /**< Shader, material and depth order, see MaterialLibrary::GetSortKey. */
+		uint8_t StencilId; /**< Value written to the stencil buffer for picking, 0 if the entity is not pickable. */
+	};
+
+	std::vector<MainPassDraw> m_MainPassDraws; /**< Visible game objects of the frame sorted by their sort keys. */
+
+	RenderGraph m_RenderGraph; /**< Passes of the frame with their state, executed by Render. */
+
+	GpuTimer m_DepthPrepassTimer; /**< GPU time of the depth pre-pass. */
+
+	GpuTimer m_MainPassTimer; /**< GPU time of the lit pass of the game objects. */
+
+	DynamicResolution m_DynamicResolution; /**< Renders the passes at a resolution holding the GPU time target. */
+
+	StreamBuffer m_StreamBuffer; /**< Ring buffer of the per-frame and per-object shader data. */
+
+	ParticleSystem m_Particles; /**< Muzzle flash, smoke and dust particles. */
+
+	int m_MuzzleFlashEmitter = -1; /**< Emitter of the muzzle flash. */
+
+	int m_GunSmokeEmitter = -1; /**< Emitter of the smoke after a shot. */
+
+	ClusteredLighting m_ClusteredLighting; /**< Assigns the point lights to view frustum clusters for the light shader. */
+
 	glm::vec3 m_DirectionalLightDirection; /**< Direction of the directional light in the scene. */
 
 	size_t m_ActiveCameraIndex; /**< Index of the active camera in the scene. */
 
 	bool m_isSpotlightActive = true; /**< Flag indicating whether the spotlight is active in the scene. */
+
+	StreamingSettings m_StreamingSettings; /**< The world streaming parameters. */
+
+	float m_CameraSpeed = CAMERA_MOVE_SPEED; /**< Movement speed of the cameras created by SetupCameras. */
+
+	float m_MouseSensitivity = MOUSE_SENSIBILITY; /**< Mouse sensitivity of the cameras created by SetupCameras. */
+
+	SceneStreamer m_Streamer; /**< Streams the objects of the scene file by camera distance. */
+
+	glm::vec3 m_WorldBoundsMin = WORLD_BOUNDS_MIN; /**< Minimal corner of the area the camera can move in. */
+
+	glm::vec3 m_WorldBoundsMax = WORLD_BOUNDS_MAX; /**< Maximal corner of the area the camera can move in. */
 	
 
 	
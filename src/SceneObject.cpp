@@ -3,148 +3,165 @@
 
 glm::mat4 SceneObject::GetWorldModelMatrix() const
 {
-	if (m_AttachParent)
+	return EntityStore::Get().GetWorldModelMatrix(m_Entity);
+}
+
+SceneObject::SceneObject(const std::string& Name, const Transform& transform)
+	: m_Entity(EntityStore::Get().Create(transform)), m_Name(Name)
+{
+}
+
+SceneObject::SceneObject()
+	: m_Entity(EntityStore::Get().Create(Transform()))
+{
+}
+
+SceneObject::SceneObject(const SceneObject& Other)
+	: m_Entity(EntityStore::Get().Create(Other.GetLocal())), m_Name(Other.m_Name)
+{
+	EntityStore::Get().GetTransform(m_Entity)->Parent = EntityStore::Get().GetParent(Other.m_Entity);
+}
+
+SceneObject& SceneObject::operator=(const SceneObject& Other)
+{
+	if (this != &Other)
 	{
-		return m_AttachParent->GetWorldModelMatrix() * m_RelativeTransform.ToMat4(); 
+		TransformComponent* Component = EntityStore::Get().GetTransform(m_Entity);
+		Component->Local = Other.GetLocal();
+		Component->Parent = EntityStore::Get().GetParent(Other.m_Entity);
+		m_Name = Other.m_Name;
 	}
-	return m_RelativeTransform.ToMat4();
+	return *this;
 }
 
-SceneObject::SceneObject(const std::string& Name, const Transform& transform)
-	: m_Name(Name), m_RelativeTransform(transform)
+SceneObject::~SceneObject()
 {
+	EntityStore::Get().Destroy(m_Entity);
 }
 
 void SceneObject::Update(float dt)
 {
 }
 
+Transform& SceneObject::GetLocal()
+{
+	return EntityStore::Get().GetTransform(m_Entity)->Local;
+}
+
+const Transform& SceneObject::GetLocal() const
+{
+	return EntityStore::Get().GetTransform(m_Entity)->Local;
+}
+
 glm::mat4 SceneObject::GetRelativeModelMatrix() const
 {
-	return m_RelativeTransform.ToMat4();
+	return GetLocal().ToMat4();
 }
 
 Transform SceneObject::GetWorldTransform() const
 {
-	if (m_AttachParent)
-	{
-		return m_AttachParent->GetWorldTransform() * m_RelativeTransform; 
-	}
-	return m_RelativeTransform;
+	return EntityStore::Get().GetWorldTransform(m_Entity);
 }
 
 Transform SceneObject::GetRelativeTransform() const
 {
-	return m_RelativeTransform;
+	return GetLocal();
 }
 
 glm::vec3 SceneObject::GetWorldLocation() const
 {
-	if (m_AttachParent)
-	{
-		return m_RelativeTransform.Location + m_AttachParent->GetWorldLocation(); 
-	}
-	return m_RelativeTransform.Location;
+	return EntityStore::Get().GetWorldLocation(m_Entity);
 }
 
 glm::quat SceneObject::GetWorldRotation() const
 {
-	if (m_AttachParent)
-	{
-		return m_AttachParent->GetWorldRotation() * m_RelativeTransform.Rotation; 
-	}
-	return m_RelativeTransform.Rotation;
+	return EntityStore::Get().GetWorldRotation(m_Entity);
 }
 
 void SceneObject::AddDeltaLocation(const glm::vec3& deltaLocation)
 {
-	m_RelativeTransform.Location += deltaLocation;
+	GetLocal().Location += deltaLocation;
 }
 
 void SceneObject::AddDeltaRotation(const glm::vec3& deltaRotation)
 {
 	glm::quat deltaQuat = glm::quat(deltaRotation);
-	m_RelativeTransform.Rotation = deltaQuat * m_RelativeTransform.Rotation;
+	GetLocal().Rotation = deltaQuat * GetLocal().Rotation;
 }
 
 void SceneObject::SetWorldTransform(const Transform& transform)
 {
-	if (m_AttachParent)
+	const EntityHandle Parent = EntityStore::Get().GetParent(m_Entity);
+	if (Parent.Index != ENTITY_INVALID_INDEX)
 	{
-		Transform parentWorldInverse = m_AttachParent->GetWorldTransform().Inverse();
-		m_RelativeTransform = parentWorldInverse * transform; 
+		Transform parentWorldInverse = EntityStore::Get().GetWorldTransform(Parent).Inverse();
+		GetLocal() = parentWorldInverse * transform; 
 		return; 
 	}
-	m_RelativeTransform = transform;
+	GetLocal() = transform;
 }
 
 void SceneObject::SetWorldLocation(const glm::vec3& location)
 {
-	if (m_AttachParent)
+	const EntityHandle Parent = EntityStore::Get().GetParent(m_Entity);
+	if (Parent.Index != ENTITY_INVALID_INDEX)
 	{
-		glm::vec3 parentWorldLocation = m_AttachParent->GetWorldLocation(); 
-		m_RelativeTransform.Location = location - parentWorldLocation;
+		glm::vec3 parentWorldLocation = EntityStore::Get().GetWorldLocation(Parent); 
+		GetLocal().Location = location - parentWorldLocation;
 		return;
 	}
-	m_RelativeTransform.Location = location;
+	GetLocal().Location = location;
 }
 
 void SceneObject::SetWorldRotation(const glm::vec3& rotation)
 {
-	glm::quat rotation_quad(rotation);
-	if (m_AttachParent)
-	{
-		glm::quat parentRotationInversed = glm::inverse(m_AttachParent->GetWorldRotation()); 
-		m_RelativeTransform.Rotation = parentRotationInversed * rotation_quad; 
-		return; 
-	}
-	m_RelativeTransform.Rotation = rotation_quad;
+	SetWorldRotation(glm::quat(rotation));
 }
 
 void SceneObject::SetWorldRotation(const glm::quat& rotation)
 {
-	if (m_AttachParent)
+	const EntityHandle Parent = EntityStore::Get().GetParent(m_Entity);
+	if (Parent.Index != ENTITY_INVALID_INDEX)
 	{
-		glm::quat parentRotationInversed = glm::inverse(m_AttachParent->GetWorldRotation());
-		m_RelativeTransform.Rotation = parentRotationInversed * rotation;
+		glm::quat parentRotationInversed = glm::inverse(EntityStore::Get().GetWorldRotation(Parent));
+		GetLocal().Rotation = parentRotationInversed * rotation;
 		return;
 	}
-	m_RelativeTransform.Rotation = rotation;
+	GetLocal().Rotation = rotation;
 }
 
 void SceneObject::SetRelativeLocation(const glm::vec3& location)
 {
-	m_RelativeTransform.Location = location;	
+	GetLocal().Location = location;	
 }
 
 void SceneObject::SetRelativeRotation(const glm::quat& rotation)
 {
-	m_RelativeTransform.Rotation = rotation; 
+	GetLocal().Rotation = rotation; 
 }
 
 void SceneObject::SetRelativeTransform(const Transform& transform)
 {
-	m_RelativeTransform = transform; 
+	GetLocal() = transform; 
 }
 
-void SceneObject::AttachToObject(const std::shared_ptr<SceneObject>& object)
+void SceneObject::AttachToObject(const SceneObject* object)
 {
 	if ( object )
-		m_AttachParent = object; 
+		EntityStore::Get().GetTransform(m_Entity)->Parent = object->m_Entity; 
 }
 
 glm::vec3 SceneObject::GetFrontVector() const
 {
-	return m_RelativeTransform.Rotation * glm::vec3(0.0f, 0.0f, 1.0f);
+	return GetLocal().Rotation * glm::vec3(0.0f, 0.0f, 1.0f);
 }
 
 glm::vec3 SceneObject::GetUpVector() const
 {
-	return m_RelativeTransform.Rotation * glm::vec3(0.0f, 1.0f, 0.0f);
+	return GetLocal().Rotation * glm::vec3(0.0f, 1.0f, 0.0f);
 }
 
 glm::vec3 SceneObject::GetLeftVector() const
 {
-	return m_RelativeTransform.Rotation * glm::vec3(1.0f, 0.0f, 0.0f);
+	return GetLocal().Rotation * glm::vec3(1.0f, 0.0f, 0.0f);
 }
-
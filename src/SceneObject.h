@@ -1,6 +1,7 @@
 #pragma once
 #include "pgr.h"
 #include "Misc.h"
+#include "EntityStore.h"
 
 class Scene; 
 class SceneObject
@@ -10,7 +11,10 @@ public:
 	friend Scene; 
 
 	SceneObject(const std::string& Name, const Transform& transform ); 
-	SceneObject() = default; 
+	SceneObject(); 
+	SceneObject(const SceneObject& Other);
+	SceneObject& operator=(const SceneObject& Other);
+	virtual ~SceneObject();
 
 	virtual void Update(float dt);
 
@@ -39,15 +43,21 @@ public:
 	glm::vec3 GetFrontVector() const;
 	glm::vec3 GetUpVector() const;
 	glm::vec3 GetLeftVector() const;
-	void AttachToObject(const std::shared_ptr<SceneObject>& object); 
-	std::shared_ptr<SceneObject> GetAttachParent() const { return m_AttachParent;  }
-	std::string GetName() const { return m_Name; }
+	void AttachToObject(const SceneObject* object); 
+	bool GetIsAttached() const { return EntityStore::Get().GetParent(m_Entity).Index != ENTITY_INVALID_INDEX; }
+	EntityHandle GetEntity() const { return m_Entity; }
+	const std::string& GetName() const { return m_Name; }
 	void SetName(const std::string& name) { m_Name = name; }
 
 
 private:
-	std::shared_ptr<SceneObject> m_AttachParent; 
-	Transform m_RelativeTransform;	
+	/**
+	 * @brief Returns the transform relative to the attach parent, stored in the entity.
+	 */
+	Transform& GetLocal();
+	const Transform& GetLocal() const;
+
+	EntityHandle m_Entity; /**< Entity holding the transform and attach parent. */
 	std::string m_Name;
 };
 
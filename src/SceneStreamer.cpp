@@ -0,0 +1,305 @@
+#include "SceneStreamer.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+SceneStreamer::~SceneStreamer()
+{
+	Shutdown();
+}
+
+void SceneStreamer::Init(const StreamingSettings& Settings, const std::vector<StreamedObjectDesc>& Objects)
+{
+	Shutdown();
+	m_Settings = Settings;
+	m_Objects = Objects;
+	m_Cells.clear();
+	m_MeshSources.clear();
+	if (m_Settings.CellSize <= 0.f)
+	{
+		std::cerr << "SceneStreamer::Init() => Invalid cell size: " << m_Settings.CellSize << std::endl;
+		return;
+	}
+
+	for (size_t i = 0; i < m_Objects.size(); i++)
+	{
+		const glm::vec3& Location = m_Objects[i].ObjectTransform.Location;
+		CellKey Key((int)std::floor(Location.x / m_Settings.CellSize), (int)std::floor(Location.z / m_Settings.CellSize));
+		Cell& cell = m_Cells[Key];
+		cell.Min = glm::vec2(Key.first * m_Settings.CellSize, Key.second * m_Settings.CellSize);
+		cell.Objects.push_back(i);
+		const std::string MeshKey = GetMeshKey(m_Objects[i]);
+		m_MeshSources.insert({ MeshKey, i });
+		if (std::find(cell.Meshes.begin(), cell.Meshes.end(), MeshKey) == cell.Meshes.end())
+			cell.Meshes.push_back(MeshKey);
+	}
+
+	m_Enabled = true;
+	m_HasCameraLocation = false;
+	m_CameraVelocity = glm::vec3(0.f);
+	if (!m_Settings.Synchronous)
+	{
+		m_StopWorker = false;
+		m_Worker = std::thread(&SceneStreamer::WorkerLoop, this);
+	}
+	std::cout << "SceneStreamer: " << m_Objects.size() << " objects in " << m_Cells.size() << " cells of size " << m_Settings.CellSize << std::endl;
+}
+
+bool SceneStreamer::GetIsEnabled() const
+{
+	return m_Enabled;
+}
+
+void SceneStreamer::Shutdown()
+{
+	if (m_Worker.joinable())
+	{
+		{
+			std::lock_guard<std::mutex> Lock(m_Mutex);
+			m_StopWorker = true;
+			m_Requests.clear();
+		}
+		m_Condition.notify_all();
+		m_Worker.join();
+	}
+	for (auto& Result : m_Completed)
+		if (Result.second)
+			Result.second->Unload();
+	m_Completed.clear();
+	m_Enabled = false;
+}
+
+void SceneStreamer::Update(const glm::vec3& CameraLocation, float dt, std::vector<std::shared_ptr<GameObject>>& Added, std::vector<std::shared_ptr<GameObject>>& Removed)
+{
+	if (!m_Enabled)
+		return;
+
+	if (m_HasCameraLocation && dt > 0.f)
+		m_CameraVelocity = glm::mix(m_CameraVelocity, (CameraLocation - m_LastCameraLocation) / dt, 0.2f);
+	m_LastCameraLocation = CameraLocation;
+	m_HasCameraLocation = true;
+	const glm::vec2 Camera(CameraLocation.x, CameraLocation.z);
+	const glm::vec2 Predicted = Camera + glm::vec2(m_CameraVelocity.x, m_CameraVelocity.z) * m_Settings.LookAheadTime;
+
+	// cells ordered by distance to the camera or to its predicted location, whichever is closer
+	std::vector<std::pair<float, Cell*>>& Cells = m_SortedCells;
+	Cells.clear();
+	for (auto& Entry : m_Cells)
+	{
+		float Distance = std::min(DistanceToCell(Entry.second, Camera), DistanceToCell(Entry.second, Predicted));
+		Cells.push_back({ Distance, &Entry.second });
+	}
+	std::sort(Cells.begin(), Cells.end(), [](const std::pair<float, Cell*>& a, const std::pair<float, Cell*>& b) { return a.first < b.first; });
+
+	for (auto& Entry : Cells)
+	{
+		if (Entry.second->State != CellState::Unloaded && Entry.first > m_Settings.UnloadRadius)
+			UnloadCell(*Entry.second, Removed);
+	}
+	for (auto& Entry : Cells)
+	{
+		if (Entry.first > m_Settings.LoadRadius || m_MemoryUsage >= m_Settings.MemoryBudget)
+			break;
+		if (Entry.second->State == CellState::Unloaded)
+			LoadCell(*Entry.second);
+	}
+
+	CollectLoadedMeshes();
+
+	// upload the meshes of the closest cells first
+	int Uploads = 0;
+	for (auto& Entry : Cells)
+	{
+		if (Entry.second->State != CellState::Loading)
+			continue;
+		bool Ready = true;
+		for (const std::string& Key : Entry.second->Meshes)
+		{
+			MeshEntry& Mesh = m_Meshes[Key];
+			if (Mesh.State == MeshState::Loaded && (m_Settings.Synchronous || Uploads < m_Settings.UploadsPerFrame))
+			{
+				if (m_Settings.OccluderMaxTriangles > 0 && Mesh.Data->GetTriangleCount() <= m_Settings.OccluderMaxTriangles)
+					Mesh.Data->SetCPURetention(CPURetention::Triangles);
+				Mesh.Data->UploadToGPU();
+				Mesh.Bytes = Mesh.Data->GetMemoryUsage();
+				Mesh.State = MeshState::Uploaded;
+				m_MemoryUsage += Mesh.Bytes;
+				Uploads++;
+			}
+			Ready = Ready && (Mesh.State == MeshState::Uploaded || Mesh.State == MeshState::Failed);
+		}
+		if (!Ready)
+			continue;
+
+		Cell& cell = *Entry.second;
+		for (size_t Index : cell.Objects)
+		{
+			const StreamedObjectDesc& Desc = m_Objects[Index];
+			const MeshEntry& Mesh = m_Meshes[GetMeshKey(Desc)];
+			if (Mesh.State == MeshState::Failed)
+				continue;
+			auto Object = std::make_shared<GameObject>(Desc.Name, Mesh.Data, Desc.ObjectTransform);
+			cell.Instances.push_back(Object);
+			Added.push_back(std::move(Object));
+		}
+		cell.State = CellState::Loaded;
+	}
+
+	// over budget, drop the farthest cells kept only by the unload hysteresis, cells in the load radius stay
+	for (auto It = Cells.rbegin(); It != Cells.rend() && m_MemoryUsage > m_Settings.MemoryBudget; ++It)
+	{
+		if (It->first > m_Settings.LoadRadius && It->second->State == CellState::Loaded)
+			UnloadCell(*It->second, Removed);
+	}
+}
+
+void SceneStreamer::GetWorldBounds(glm::vec2& Min, glm::vec2& Max) const
+{
+	if (m_Cells.empty())
+	{
+		Min = Max = glm::vec2(0.f);
+		return;
+	}
+	Min = glm::vec2(std::numeric_limits<float>::max());
+	Max = glm::vec2(std::numeric_limits<float>::lowest());
+	for (const auto& Entry : m_Cells)
+	{
+		Min = glm::min(Min, Entry.second.Min);
+		Max = glm::max(Max, Entry.second.Min + glm::vec2(m_Settings.CellSize));
+	}
+}
+
+size_t SceneStreamer::GetMemoryUsage() const
+{
+	return m_MemoryUsage;
+}
+
+float SceneStreamer::DistanceToCell(const Cell& cell, const glm::vec2& Point) const
+{
+	glm::vec2 Closest = glm::clamp(Point, cell.Min, cell.Min + glm::vec2(m_Settings.CellSize));
+	return glm::length(Point - Closest);
+}
+
+std::string SceneStreamer::GetMeshKey(const StreamedObjectDesc& Desc)
+{
+	return Desc.ModelName + '#' + std::to_string(Desc.ObjectMaterial.m_Id);
+}
+
+void SceneStreamer::LoadCell(Cell& cell)
+{
+	for (const std::string& Key : cell.Meshes)
+		RequestMesh(Key);
+	cell.State = CellState::Loading;
+}
+
+void SceneStreamer::UnloadCell(Cell& cell, std::vector<std::shared_ptr<GameObject>>& Removed)
+{
+	Removed.insert(Removed.end(), cell.Instances.begin(), cell.Instances.end());
+	cell.Instances.clear();
+	for (const std::string& Key : cell.Meshes)
+		ReleaseMesh(Key);
+	cell.State = CellState::Unloaded;
+}
+
+void SceneStreamer::RequestMesh(const std::string& Key)
+{
+	auto It = m_Meshes.find(Key);
+	if (It != m_Meshes.end())
+	{
+		It->second.Users++;
+		return;
+	}
+	const StreamedObjectDesc& Source = m_Objects[m_MeshSources[Key]];
+	MeshEntry& Entry = m_Meshes[Key];
+	Entry.Users = 1;
+	Entry.ModelName = Source.ModelName;
+	Entry.MeshMaterial = Source.ObjectMaterial;
+	if (m_Settings.Synchronous)
+	{
+		std::shared_ptr<Mesh> Data = std::make_shared<Mesh>();
+		m_Completed.push_back({ Key, Data->LoadDataFromFile(Entry.ModelName) ? Data : nullptr });
+		return;
+	}
+	{
+		std::lock_guard<std::mutex> Lock(m_Mutex);
+		m_Requests.push_back({ Key, Entry.ModelName });
+	}
+	m_Condition.notify_one();
+}
+
+void SceneStreamer::ReleaseMesh(const std::string& Key)
+{
+	auto It = m_Meshes.find(Key);
+	if (It == m_Meshes.end() || --It->second.Users > 0)
+		return;
+	if (It->second.State == MeshState::Queued)
+	{
+		// drop the request if the loader thread hasn't started it, otherwise the mesh is dropped when it's finished
+		std::lock_guard<std::mutex> Lock(m_Mutex);
+		auto Request = std::find_if(m_Requests.begin(), m_Requests.end(), [&Key](const std::pair<std::string, std::string>& Queued) { return Queued.first == Key; });
+		if (Request == m_Requests.end())
+			return;
+		m_Requests.erase(Request);
+	}
+	if (It->second.Data)
+		It->second.Data->Unload();
+	m_MemoryUsage -= It->second.Bytes;
+	m_Meshes.erase(It);
+}
+
+void SceneStreamer::CollectLoadedMeshes()
+{
+	std::vector<std::pair<std::string, std::shared_ptr<Mesh>>> Completed;
+	if (m_Settings.Synchronous)
+		Completed.swap(m_Completed);
+	else
+	{
+		std::lock_guard<std::mutex> Lock(m_Mutex);
+		Completed.swap(m_Completed);
+	}
+
+	for (auto& Result : Completed)
+	{
+		auto It = m_Meshes.find(Result.first);
+		if (It == m_Meshes.end() || It->second.Users <= 0)
+		{
+			if (Result.second)
+				Result.second->Unload();
+			if (It != m_Meshes.end())
+				m_Meshes.erase(It);
+			continue;
+		}
+		if (!Result.second)
+		{
+			std::cerr << "SceneStreamer::CollectLoadedMeshes() => Error loading streamed mesh: " << It->second.ModelName << std::endl;
+			It->second.State = MeshState::Failed;
+			continue;
+		}
+		Result.second->SetMaterial(It->second.MeshMaterial);
+		It->second.Data = std::move(Result.second);
+		It->second.State = MeshState::Loaded;
+	}
+}
+
+void SceneStreamer::WorkerLoop()
+{
+	while (true)
+	{
+		std::pair<std::string, std::string> Request;
+		{
+			std::unique_lock<std::mutex> Lock(m_Mutex);
+			m_Condition.wait(Lock, [this]() { return m_StopWorker || !m_Requests.empty(); });
+			if (m_StopWorker)
+				return;
+			Request = std::move(m_Requests.front());
+			m_Requests.pop_front();
+		}
+
+		std::shared_ptr<Mesh> Data = std::make_shared<Mesh>();
+		if (!Data->LoadDataFromFile(Request.second))
+			Data.reset();
+
+		std::lock_guard<std::mutex> Lock(m_Mutex);
+		m_Completed.push_back({ Request.first, std::move(Data) });
+	}
+}
@@ -0,0 +1,201 @@
+#pragma once
+#include "GameObject.h"
+#include "Mesh.h"
+#include "Misc.h"
+#include <string>
+#include <vector>
+#include <map>
+#include <unordered_map>
+#include <deque>
+#include <memory>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+#define STREAMING_DEFAULT_CELL_SIZE 0 // 0 disables streaming, every object is loaded at startup
+#define STREAMING_DEFAULT_LOAD_RADIUS 30
+#define STREAMING_DEFAULT_UNLOAD_RADIUS 40
+#define STREAMING_DEFAULT_MEMORY_BUDGET_MB 512
+#define STREAMING_DEFAULT_LOOKAHEAD_MS 1000
+#define STREAMING_DEFAULT_UPLOADS_PER_FRAME 2
+
+/**
+ * @brief Parameters of the world streaming.
+ */
+struct StreamingSettings
+{
+	float CellSize = 0.f; /**< Edge length of a grid cell in world units, 0 disables streaming. */
+	float LoadRadius = 0.f; /**< Cells closer than this to the camera are loaded. */
+	float UnloadRadius = 0.f; /**< Cells farther than this from the camera are unloaded. Larger than LoadRadius to avoid thrashing at cell borders. */
+	size_t MemoryBudget = 0; /**< Budget of the streamed mesh data in bytes. */
+	float LookAheadTime = 0.f; /**< Cells around the camera location predicted this many seconds ahead are loaded as well. */
+	int UploadsPerFrame = 1; /**< Maximal number of meshes uploaded to the GPU per frame. */
+	bool Synchronous = false; /**< Loads cells on the main thread within the frame they are requested, used for repeatable benchmark runs. */
+	size_t OccluderMaxTriangles = 0; /**< Meshes with at most this many triangles keep them in system memory to become occluders, 0 keeps none. */
+};
+
+/**
+ * @brief Object placed into a streaming cell.
+ */
+struct StreamedObjectDesc
+{
+	std::string Name; /**< The name of the object. */
+	Transform ObjectTransform; /**< The world transform of the object. */
+	std::string ModelName; /**< The model file of the object. */
+	Material ObjectMaterial; /**< The material of the object mesh. */
+};
+
+/**
+ * @brief Streams scene objects in and out by distance from the camera.
+ *
+ * The world is split into square cells on the XZ plane. Each cell owns the objects located in it and depends on their meshes.
+ * Meshes are read and decoded on a worker thread and uploaded to the GPU on the main thread with a per frame limit.
+ * A cell is instantiated once all of its meshes are uploaded; meshes shared by several cells are loaded once and released
+ * with the last cell using them. When the streamed data exceeds the memory budget, no new cells are requested and
+ * the farthest cells are unloaded first.
+ */
+class SceneStreamer
+{
+public:
+	SceneStreamer() = default;
+	~SceneStreamer();
+	SceneStreamer(const SceneStreamer&) = delete;
+	SceneStreamer& operator=(const SceneStreamer&) = delete;
+
+	/**
+	 * @brief Splits the objects into cells and starts the loader thread.
+	 *
+	 * @param Settings The streaming parameters.
+	 * @param Objects The streamed objects.
+	 */
+	void Init(const StreamingSettings& Settings, const std::vector<StreamedObjectDesc>& Objects);
+
+	/**
+	 * @brief Checks if the streaming is initialized.
+	 */
+	bool GetIsEnabled() const;
+
+	/**
+	 * @brief Loads and unloads cells around the camera.
+	 *
+	 * @param CameraLocation The world location of the active camera.
+	 * @param dt The time elapsed since the last update.
+	 * @param Added Objects of the cells that finished loading.
+	 * @param Removed Objects of the unloaded cells.
+	 */
+	void Update(const glm::vec3& CameraLocation, float dt, std::vector<std::shared_ptr<GameObject>>& Added, std::vector<std::shared_ptr<GameObject>>& Removed);
+
+	/**
+	 * @brief Returns the XZ bounds of all cells.
+	 *
+	 * @param Min The minimal corner of the bounds.
+	 * @param Max The maximal corner of the bounds.
+	 */
+	void GetWorldBounds(glm::vec2& Min, glm::vec2& Max) const;
+
+	/**
+	 * @brief Returns the memory of the uploaded streamed meshes in bytes.
+	 */
+	size_t GetMemoryUsage() const;
+
+	/**
+	 * @brief Stops the loader thread. Pending requests are dropped.
+	 */
+	void Shutdown();
+
+private:
+	enum class CellState
+	{
+		Unloaded,
+		Loading,
+		Loaded
+	};
+
+	enum class MeshState
+	{
+		Queued,    /**< Waiting for or being read by the loader thread. */
+		Loaded,    /**< Read into CPU memory, waiting for the upload. */
+		Uploaded,  /**< GPU resources are created. */
+		Failed     /**< The mesh file couldn't be loaded. */
+	};
+
+	struct Cell
+	{
+		glm::vec2 Min; /**< The minimal XZ corner of the cell. */
+		std::vector<size_t> Objects; /**< Indices of the objects in the cell. */
+		std::vector<std::string> Meshes; /**< Keys of the meshes the cell depends on, each listed once. */
+		std::vector<std::shared_ptr<GameObject>> Instances; /**< Objects of the loaded cell. */
+		CellState State = CellState::Unloaded;
+	};
+
+	struct MeshEntry
+	{
+		std::shared_ptr<Mesh> Data;
+		std::string ModelName; /**< The model file of the mesh. */
+		Material MeshMaterial; /**< The material applied to the mesh once it is read. */
+		MeshState State = MeshState::Queued;
+		int Users = 0; /**< Number of loading or loaded cells depending on the mesh. */
+		size_t Bytes = 0; /**< Memory of the uploaded mesh. */
+	};
+
+	using CellKey = std::pair<int, int>;
+
+	/**
+	 * @brief Returns the distance from a point to the closest point of a cell.
+	 */
+	float DistanceToCell(const Cell& cell, const glm::vec2& Point) const;
+
+	/**
+	 * @brief Returns the key of the mesh of an object. Objects share a mesh only if they have the same model and material.
+	 */
+	static std::string GetMeshKey(const StreamedObjectDesc& Desc);
+
+	/**
+	 * @brief Requests the meshes of a cell.
+	 */
+	void LoadCell(Cell& cell);
+
+	/**
+	 * @brief Releases the meshes and objects of a cell.
+	 */
+	void UnloadCell(Cell& cell, std::vector<std::shared_ptr<GameObject>>& Removed);
+
+	/**
+	 * @brief Adds a user to a mesh, queueing its load if it isn't loaded yet.
+	 */
+	void RequestMesh(const std::string& Key);
+
+	/**
+	 * @brief Removes a user from a mesh, unloading it when no cell uses it anymore.
+	 */
+	void ReleaseMesh(const std::string& Key);
+
+	/**
+	 * @brief Takes meshes finished by the loader thread.
+	 */
+	void CollectLoadedMeshes();
+
+	/**
+	 * @brief Body of the loader thread.
+	 */
+	void WorkerLoop();
+
+	StreamingSettings m_Settings; /**< The streaming parameters. */
+	std::vector<StreamedObjectDesc> m_Objects; /**< All streamed objects. */
+	std::map<CellKey, Cell> m_Cells; /**< Non empty cells by their grid coordinates. */
+	std::unordered_map<std::string, size_t> m_MeshSources; /**< Index of the first object using every mesh key. */
+	std::unordered_map<std::string, MeshEntry> m_Meshes; /**< Requested meshes by mesh key. Accessed by the main thread only. */
+	std::vector<std::pair<float, Cell*>> m_SortedCells; /**< Cells by distance, reused by every Update. Update runs every tick, also without a render resetting the frame allocator. */
+	size_t m_MemoryUsage = 0; /**< Memory of the uploaded meshes in bytes. */
+	glm::vec3 m_LastCameraLocation = glm::vec3(0.f); /**< Camera location of the previous update. */
+	glm::vec3 m_CameraVelocity = glm::vec3(0.f); /**< Smoothed camera velocity, used for the load ahead. */
+	bool m_HasCameraLocation = false; /**< Flag indicating m_LastCameraLocation is valid. */
+	bool m_Enabled = false; /**< Flag indicating the streaming is initialized. */
+
+	std::thread m_Worker; /**< The loader thread. */
+	std::mutex m_Mutex; /**< Guards the request and completion queues. */
+	std::condition_variable m_Condition; /**< Wakes the loader thread on new requests. */
+	std::deque<std::pair<std::string, std::string>> m_Requests; /**< Mesh keys and model files waiting for the loader thread. */
+	std::vector<std::pair<std::string, std::shared_ptr<Mesh>>> m_Completed; /**< Meshes read by the loader thread by mesh key, null on failure. */
+	bool m_StopWorker = false; /**< Flag asking the loader thread to exit. */
+};
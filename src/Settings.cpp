@@ -0,0 +1,226 @@
+#include "Settings.h"
+#include "Application.h"
+#include <cstdlib>
+#include <cerrno>
+#include <map>
+
+namespace
+{
+	enum class SettingType
+	{
+		Bool,
+		Int,
+		Float,
+		String
+	};
+
+	/**
+	 * @brief Declared setting, exactly one of the fields is set.
+	 */
+	struct SettingDesc
+	{
+		const char* Name;
+		SettingType Type;
+		bool AppSettings::* BoolField;
+		int AppSettings::* IntField;
+		float AppSettings::* FloatField;
+		std::string AppSettings::* StringField;
+		double Default;
+		const char* DefaultString;
+		double Min;
+		double Max;
+		bool IsRequired; /**< Some source must define it, the default is not used. */
+	};
+
+	SettingDesc Required(SettingDesc Desc)
+	{
+		Desc.IsRequired = true;
+		return Desc;
+	}
+
+	SettingDesc BoolSetting(const char* Name, bool AppSettings::* Field, bool Default)
+	{
+		return { Name, SettingType::Bool, Field, nullptr, nullptr, nullptr, (double)Default, "", 0.0, 1.0, false };
+	}
+
+	SettingDesc IntSetting(const char* Name, int AppSettings::* Field, int Default, int Min, int Max)
+	{
+		return { Name, SettingType::Int, nullptr, Field, nullptr, nullptr, (double)Default, "", (double)Min, (double)Max, false };
+	}
+
+	SettingDesc FloatSetting(const char* Name, float AppSettings::* Field, float Default, float Min, float Max)
+	{
+		return { Name, SettingType::Float, nullptr, nullptr, Field, nullptr, (double)Default, "", (double)Min, (double)Max, false };
+	}
+
+	SettingDesc StringSetting(const char* Name, std::string AppSettings::* Field, const char* Default)
+	{
+		return { Name, SettingType::String, nullptr, nullptr, nullptr, Field, 0.0, Default, 0.0, 0.0, false };
+	}
+
+	const std::vector<SettingDesc>& GetSettingDescs()
+	{
+		static const std::vector<SettingDesc> Descs = {
+			Required(IntSetting("WINDOW_WIDTH", &AppSettings::WindowWidth, 0, 1, 16384)),
+			Required(IntSetting("WINDOW_HEIGHT", &AppSettings::WindowHeight, 0, 1, 16384)),
+			Required(StringSetting("WINDOW_TITLE", &AppSettings::WindowTitle, "")),
+			Required(StringSetting("SCENE_FILENAME", &AppSettings::SceneFilename, "")),
+			Required(IntSetting("TARGET_TICKRATE", &AppSettings::TargetTickrate, 0, 1, 1000)),
+			FloatSetting("CAMERA_SPEED", &AppSettings::CameraSpeed, CAMERA_MOVE_SPEED, 0.f, 1000.f),
+			FloatSetting("MOUSE_SENSITIVITY", &AppSettings::MouseSensitivity, MOUSE_SENSIBILITY, 0.f, 100.f),
+
+			IntSetting("STREAMING_CELL_SIZE", &AppSettings::StreamingCellSize, STREAMING_DEFAULT_CELL_SIZE, 0, 100000),
+			IntSetting("STREAMING_LOAD_RADIUS", &AppSettings::StreamingLoadRadius, STREAMING_DEFAULT_LOAD_RADIUS, 0, 100000),
+			IntSetting("STREAMING_UNLOAD_RADIUS", &AppSettings::StreamingUnloadRadius, STREAMING_DEFAULT_UNLOAD_RADIUS, 0, 100000),
+			IntSetting("STREAMING_MEMORY_BUDGET_MB", &AppSettings::StreamingMemoryBudgetMb, STREAMING_DEFAULT_MEMORY_BUDGET_MB, 1, 1 << 20),
+			IntSetting("STREAMING_LOOKAHEAD_MS", &AppSettings::StreamingLookAheadMs, STREAMING_DEFAULT_LOOKAHEAD_MS, 0, 60000),
+			IntSetting("STREAMING_UPLOADS_PER_FRAME", &AppSettings::StreamingUploadsPerFrame, STREAMING_DEFAULT_UPLOADS_PER_FRAME, 1, 1024),
+			BoolSetting("OCCLUSION_CULLING", &AppSettings::OcclusionCulling, OCCLUSION_DEFAULT_ENABLED),
+			BoolSetting("DEPTH_PREPASS", &AppSettings::DepthPrepass, DEPTH_PREPASS_DEFAULT_ENABLED),
+			BoolSetting("DYNAMIC_RESOLUTION", &AppSettings::DynamicResolution, DYNAMIC_RESOLUTION_DEFAULT_ENABLED),
+			FloatSetting("DYNAMIC_RESOLUTION_TARGET_MS", &AppSettings::DynamicResolutionTargetMs, DYNAMIC_RESOLUTION_DEFAULT_TARGET_MS, 0.1f, 1000.f),
+			IntSetting("DYNAMIC_RESOLUTION_MIN_SCALE_PERCENT", &AppSettings::DynamicResolutionMinScalePercent, DYNAMIC_RESOLUTION_DEFAULT_MIN_SCALE_PERCENT, 10, 100),
+
+			IntSetting("MAX_FPS", &AppSettings::MaxFps, FRAME_LIMITER_DEFAULT_MAX_FPS, 0, 1000),
+			IntSetting("IDLE_TIMEOUT_MS", &AppSettings::IdleTimeoutMs, IDLE_DEFAULT_TIMEOUT_MS, 0, 24 * 3600 * 1000),
+			StringSetting("CAPTURE_FORMAT", &AppSettings::CaptureFormat, ""),
+			StringSetting("CAPTURE_PATH", &AppSettings::CapturePath, FRAME_CAPTURE_DEFAULT_PATH),
+
+			IntSetting("BENCHMARK_FRAMES", &AppSettings::BenchmarkFrames, BENCHMARK_DEFAULT_FRAMES, 1, 10000000),
+			IntSetting("BENCHMARK_WARMUP_FRAMES", &AppSettings::BenchmarkWarmupFrames, BENCHMARK_DEFAULT_WARMUP_FRAMES, 0, 10000000),
+			IntSetting("BENCHMARK_DT_MS", &AppSettings::BenchmarkDtMs, BENCHMARK_DEFAULT_DT_MS, 1, 1000),
+			StringSetting("BENCHMARK_CAMERA_PATH", &AppSettings::BenchmarkCameraPath, BENCHMARK_DEFAULT_CAMERA_PATH),
+			StringSetting("BENCHMARK_OUTPUT", &AppSettings::BenchmarkOutput, BENCHMARK_DEFAULT_OUTPUT),
+			StringSetting("REPLAY_OUTPUT", &AppSettings::ReplayOutput, REPLAY_DEFAULT_OUTPUT),
+		};
+		return Descs;
+	}
+
+	const SettingDesc* FindSettingDesc(const std::string& Name)
+	{
+		for (const SettingDesc& Desc : GetSettingDescs())
+		{
+			if (Name == Desc.Name)
+				return &Desc;
+		}
+		return nullptr;
+	}
+
+	void SetDefault(const SettingDesc& Desc, AppSettings& Resolved)
+	{
+		switch (Desc.Type)
+		{
+		case SettingType::Bool: Resolved.*Desc.BoolField = Desc.Default != 0.0; break;
+		case SettingType::Int: Resolved.*Desc.IntField = (int)Desc.Default; break;
+		case SettingType::Float: Resolved.*Desc.FloatField = (float)Desc.Default; break;
+		default: Resolved.*Desc.StringField = Desc.DefaultString; break;
+		}
+	}
+
+	/**
+	 * @brief Parses a value into its field, checking the type and the range.
+	 */
+	bool ParseSetting(const SettingDesc& Desc, const std::string& Value, AppSettings& Resolved)
+	{
+		if (Desc.Type == SettingType::String)
+		{
+			Resolved.*Desc.StringField = Value;
+			return true;
+		}
+		if (Desc.Type == SettingType::Bool && (Value == "true" || Value == "false"))
+		{
+			Resolved.*Desc.BoolField = Value == "true";
+			return true;
+		}
+
+		char* End = nullptr;
+		errno = 0;
+		const double Number = Desc.Type == SettingType::Float ? std::strtod(Value.c_str(), &End) : (double)std::strtol(Value.c_str(), &End, 10);
+		if (Value.empty() || *End != '\0' || errno == ERANGE || Number < Desc.Min || Number > Desc.Max)
+			return false;
+		if (Desc.Type == SettingType::Bool)
+			Resolved.*Desc.BoolField = Number != 0.0;
+		else if (Desc.Type == SettingType::Int)
+			Resolved.*Desc.IntField = (int)Number;
+		else
+			Resolved.*Desc.FloatField = (float)Number;
+		return true;
+	}
+
+	const char* GetTypeName(SettingType Type)
+	{
+		switch (Type)
+		{
+		case SettingType::Bool: return "0, 1, true or false";
+		case SettingType::Int: return "an integer";
+		case SettingType::Float: return "a number";
+		default: return "a string";
+		}
+	}
+}
+
+bool Settings::Resolve(const Config& File, const std::vector<std::string>& Overrides, AppSettings& Resolved)
+{
+	std::map<std::string, std::string> CommandLine;
+	for (const std::string& Override : Overrides)
+	{
+		const size_t Separator = Override.find('=');
+		const std::string Name = Override.substr(0, Separator);
+		if (Separator == std::string::npos || !FindSettingDesc(Name))
+		{
+			std::cerr << "Settings::Resolve() => Unknown setting override " << Override << ", expected NAME=VALUE of a declared setting" << std::endl;
+			return false;
+		}
+		CommandLine[Name] = Override.substr(Separator + 1);
+	}
+	for (const auto& Variable : File.m_Variables)
+	{
+		if (!FindSettingDesc(Variable.first))
+			std::cerr << "Settings::Resolve() => Config variable " << Variable.first << " is not a declared setting and is ignored" << std::endl;
+	}
+
+	bool IsValid = true;
+	for (const SettingDesc& Desc : GetSettingDescs())
+	{
+		std::string Value;
+		const char* Source = "config";
+		const auto Override = CommandLine.find(Desc.Name);
+		const char* Environment = std::getenv((std::string(SETTINGS_ENV_PREFIX) + Desc.Name).c_str());
+		if (Override != CommandLine.end())
+		{
+			Value = Override->second;
+			Source = "command line";
+		}
+		else if (Environment)
+		{
+			Value = Environment;
+			Source = "environment";
+		}
+		else if (File.HasVariable(Desc.Name))
+			File.GetVariableAsString(Desc.Name, Value);
+		else if (Desc.IsRequired)
+		{
+			std::cerr << "Settings::Resolve() => Required setting " << Desc.Name << " is not defined" << std::endl;
+			IsValid = false;
+			continue;
+		}
+		else
+		{
+			SetDefault(Desc, Resolved);
+			continue;
+		}
+
+		if (!ParseSetting(Desc, Value, Resolved))
+		{
+			std::cerr << "Settings::Resolve() => Invalid value " << Value << " of " << Desc.Name << " from the " << Source
+				<< ", expected " << GetTypeName(Desc.Type);
+			if (Desc.Type == SettingType::Int || Desc.Type == SettingType::Float)
+				std::cerr << " in [" << Desc.Min << ", " << Desc.Max << "]";
+			std::cerr << std::endl;
+			IsValid = false;
+		}
+		else if (Override != CommandLine.end() || Environment)
+			std::cout << "Settings::Resolve() => " << Desc.Name << " = " << Value << " from the " << Source << std::endl;
+	}
+	return IsValid;
+}
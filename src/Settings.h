@@ -0,0 +1,67 @@
+#pragma once
+#include "Config.h"
+#include <string>
+#include <vector>
+
+#define SETTINGS_ENV_PREFIX "WESTERN_CITY_" // environment variable overriding a setting is the prefix followed by its name
+
+/**
+ * @brief Settings of the application, resolved once at startup.
+ *
+ * Code reads the plain fields, no lookup or parsing happens after Settings::Resolve.
+ */
+struct AppSettings
+{
+	int WindowWidth = 0;
+	int WindowHeight = 0;
+	std::string WindowTitle;
+	std::string SceneFilename;
+	int TargetTickrate = 0; /**< Interval of the simulation ticks in milliseconds. */
+	float CameraSpeed = 0.f; /**< Movement speed of the cameras in world units per second. */
+	float MouseSensitivity = 0.f; /**< Rotation of the cameras per pixel of mouse movement. */
+
+	int StreamingCellSize = 0;
+	int StreamingLoadRadius = 0;
+	int StreamingUnloadRadius = 0;
+	int StreamingMemoryBudgetMb = 0;
+	int StreamingLookAheadMs = 0;
+	int StreamingUploadsPerFrame = 0;
+	bool OcclusionCulling = false;
+	bool DepthPrepass = false;
+	bool DynamicResolution = false;
+	float DynamicResolutionTargetMs = 0.f;
+	int DynamicResolutionMinScalePercent = 0;
+
+	int MaxFps = 0;
+	int IdleTimeoutMs = 0;
+	std::string CaptureFormat;
+	std::string CapturePath;
+
+	int BenchmarkFrames = 0;
+	int BenchmarkWarmupFrames = 0;
+	int BenchmarkDtMs = 0;
+	std::string BenchmarkCameraPath;
+	std::string BenchmarkOutput;
+	std::string ReplayOutput;
+};
+
+/**
+ * @brief Registry of the declared settings with their types, defaults and ranges.
+ *
+ * Every setting is resolved from the first source defining it: a command line override, an environment variable
+ * named SETTINGS_ENV_PREFIX followed by the setting name, the config file, and the declared default. A value of the
+ * wrong type or out of range fails the resolution, so a mistyped tuning run does not silently use the default.
+ */
+class Settings
+{
+public:
+	/**
+	 * @brief Resolves all declared settings.
+	 *
+	 * @param File The loaded config file.
+	 * @param Overrides Command line overrides in the form NAME=VALUE.
+	 * @param Resolved The resolved settings.
+	 * @return True if every setting resolved to a valid value and every required setting is defined, false otherwise.
+	 */
+	static bool Resolve(const Config& File, const std::vector<std::string>& Overrides, AppSettings& Resolved);
+};
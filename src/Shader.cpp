@@ -1,5 +1,9 @@
 #include "Shader.h"
-#include "Shader.h"
+#include "ShaderCache.h"
+#include "GLStateCache.h"
+#include <chrono>
+#include <sstream>
+#include <fstream>
 
 Shader::Shader(const std::string& ShaderName)
     : m_ShaderName ( ShaderName ) 
@@ -8,36 +12,84 @@ Shader::Shader(const std::string& ShaderName)
 
 bool Shader::LoadShaderFromFile(const std::string& VSPath, const std::string& FSPath)
 {
-    GLuint VS_ID = pgr::createShaderFromFile(GL_VERTEX_SHADER, VSPath); 
+    auto LoadStart = std::chrono::steady_clock::now();
+    std::string VSSource, FSSource;
+    if (!ReadSourceFile(VSPath, VSSource) || !ReadSourceFile(FSPath, FSSource))
+        return false;
+
+    const bool CacheSupported = ShaderCache::GetIsSupported();
+    const uint64_t CacheKey = CacheSupported ? ShaderCache::ComputeKey(VSSource, FSSource) : 0;
+    GLuint ProgramID = CacheSupported ? ShaderCache::LoadProgram(CacheKey) : 0;
+    const bool CacheHit = ProgramID != 0;
+
+    if (!CacheHit)
+    {
+        ProgramID = CompileProgram(VSPath, VSSource, FSPath, FSSource, CacheSupported);
+        if (!ProgramID)
+            return false;
+        if (CacheSupported)
+            ShaderCache::StoreProgram(CacheKey, ProgramID);
+    }
+
+    CHECK_GL_ERROR();
+    m_ProgramID = ProgramID; 
+    m_IsLoaded = true; 
+
+    std::chrono::duration<double, std::milli> LoadTime = std::chrono::steady_clock::now() - LoadStart;
+    ShaderCache::AddLoadTime(CacheHit, LoadTime.count());
+    std::cout << "Shader " << m_ShaderName << (CacheHit ? " loaded from cache in " : " compiled in ") << LoadTime.count() << " ms" << std::endl;
+    return true;
+}
+
+bool Shader::ReadSourceFile(const std::string& Path, std::string& Source)
+{
+    std::ifstream f(Path, std::ios::binary);
+    if (!f)
+    {
+        std::cerr << "Shader::LoadShaderFromFile() Error: Can't open shader file with given path: " << Path << std::endl;
+        return false;
+    }
+    std::ostringstream Stream;
+    Stream << f.rdbuf();
+    Source = Stream.str();
+    return true;
+}
+
+GLuint Shader::CompileProgram(const std::string& VSPath, const std::string& VSSource, const std::string& FSPath, const std::string& FSSource, bool Retrievable)
+{
+    GLuint VS_ID = pgr::createShaderFromSource(GL_VERTEX_SHADER, VSSource); 
     if (!VS_ID)
     {
         std::cerr << "Shader::LoadShaderFromFile() Error: Can't create vertex shader with given path: " << VSPath << std::endl;
-        return false;
+        return 0;
     }
 
-    GLuint FS_ID = pgr::createShaderFromFile(GL_FRAGMENT_SHADER, FSPath); 
+    GLuint FS_ID = pgr::createShaderFromSource(GL_FRAGMENT_SHADER, FSSource); 
     if (!FS_ID)
     {
         std::cerr << "Shader::LoadShaderFromFile() Error: Can't create fragment shader with given path: " << FSPath << std::endl;
-        return false;
+        glDeleteShader(VS_ID);
+        return 0;
     }
 
-    GLuint shaders[3];
-    shaders[0] = VS_ID; 
-    shaders[1] = FS_ID;
-    shaders[2] = 0; 
-    GLuint ProgramID = pgr::createProgram(shaders); 
-    if (!ProgramID)
+    GLuint ProgramID = glCreateProgram();
+    glAttachShader(ProgramID, VS_ID);
+    glAttachShader(ProgramID, FS_ID);
+    if (Retrievable)
+        glProgramParameteri(ProgramID, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE); // must be set before linking
+    const bool IsLinked = pgr::linkProgram(ProgramID);
+    // the program keeps its linked code, the shader objects are not needed after linking either way
+    glDetachShader(ProgramID, VS_ID);
+    glDetachShader(ProgramID, FS_ID);
+    glDeleteShader(VS_ID);
+    glDeleteShader(FS_ID);
+    if (!IsLinked)
     {
         std::cerr << "Shader::LoadShaderFromFile() Error: Can't create shader program from given shaders: " << VSPath << " , " << FSPath << std::endl; 
-        return false;
+        glDeleteProgram(ProgramID);
+        return 0;
     }
-    
-    CHECK_GL_ERROR();
-    m_ProgramID = ProgramID; 
-    m_IsLoaded = true; 
-
-    return true;
+    return ProgramID;
 }
 
 void Shader::UseShader() const
@@ -45,7 +97,7 @@ void Shader::UseShader() const
     if (!GetIsValid()) {
         std::cerr << "Shader::UseShader() Error : Can't use shader. Shader is not loaded " << std::endl; 
     }
-    glUseProgram(m_ProgramID);
+    GLStateCache::UseProgram(m_ProgramID);
 }
 
 bool Shader::GetIsValid() const
@@ -53,23 +105,22 @@ bool Shader::GetIsValid() const
     return m_IsLoaded; 
 }
 
-std::string Shader::GetShaderName() const
+const std::string& Shader::GetShaderName() const
 {
     return m_ShaderName; 
 }
 
-void Shader::BindMaterial(const Material& mat) const
+void Shader::SetUniformBlockBinding(const std::string& BlockName, GLuint Binding) const
 {
-    SetVec3Parameter("material.ambientColor", mat.m_AmbientColor); 
-    SetVec3Parameter("material.diffuseColor", mat.m_DiffuseColor); 
-    SetVec3Parameter("material.specularColor", mat.m_SpecularColor);
-    SetFloatParameter("material.shininess", mat.m_Shininess); 
+    GLuint BlockIndex = glGetUniformBlockIndex(m_ProgramID, BlockName.c_str());
+    if (BlockIndex == GL_INVALID_INDEX)
+        return;
+    glUniformBlockBinding(m_ProgramID, BlockIndex, Binding);
 }
 
-
-void Shader::SetBoolParameter(const std::string& ParameterName, bool value) const
+void Shader::SetBoolParameter(const char* ParameterName, bool value) const
 {
-    GLint UniformLocation = glGetUniformLocation(m_ProgramID, ParameterName.c_str());
+    GLint UniformLocation = glGetUniformLocation(m_ProgramID, ParameterName);
     if (UniformLocation == -1)
     {
         std::cerr << "Shader::SetBoolParameter() Error: Can't find parameter with given name: " << ParameterName << std::endl; 
@@ -78,9 +129,9 @@ void Shader::SetBoolParameter(const std::string& ParameterName, bool value) cons
     glUniform1i(UniformLocation, static_cast<GLint> ( value ) );
 }
 
-void Shader::SetIntParameter(const std::string& ParameterName, int value) const
+void Shader::SetIntParameter(const char* ParameterName, int value) const
 {
-    GLint UniformLocation = glGetUniformLocation(m_ProgramID, ParameterName.c_str());
+    GLint UniformLocation = glGetUniformLocation(m_ProgramID, ParameterName);
     if (UniformLocation == -1)
     {
         std::cerr << "Shader::SetIntParameter() Error: Can't find parameter with given name: " << ParameterName << std::endl;
@@ -89,9 +140,9 @@ void Shader::SetIntParameter(const std::string& ParameterName, int value) const
     glUniform1i(UniformLocation, value);
 }
 
-void Shader::SetFloatParameter(const std::string& ParameterName, float value) const
+void Shader::SetFloatParameter(const char* ParameterName, float value) const
 {
-    GLint UniformLocation = glGetUniformLocation(m_ProgramID, ParameterName.c_str());
+    GLint UniformLocation = glGetUniformLocation(m_ProgramID, ParameterName);
     if (UniformLocation == -1)
     {
         std::cerr << "Shader::SetFloatParameter() Error: Can't find parameter with given name: " << ParameterName << std::endl;
@@ -101,9 +152,9 @@ void Shader::SetFloatParameter(const std::string& ParameterName, float value) co
     CHECK_GL_ERROR();
 }
 
-void Shader::SetVec3Parameter(const std::string& ParameterName, const glm::vec3& value) const
+void Shader::SetVec3Parameter(const char* ParameterName, const glm::vec3& value) const
 {
-    GLint UniformLocation = glGetUniformLocation(m_ProgramID, ParameterName.c_str());
+    GLint UniformLocation = glGetUniformLocation(m_ProgramID, ParameterName);
     if (UniformLocation == -1)
     {
         std::cerr << "Shader::SetVec3Parameter() Error: Can't find parameter with given name: " << ParameterName << std::endl;
@@ -112,9 +163,9 @@ void Shader::SetVec3Parameter(const std::string& ParameterName, const glm::vec3&
     glUniform3fv(UniformLocation, 1, glm::value_ptr(value)); 
 }
 
-void Shader::SetVec4Parameter(const std::string& ParameterName, const glm::vec4 & Value) const
+void Shader::SetVec4Parameter(const char* ParameterName, const glm::vec4 & Value) const
 {
-    GLint UniformLocation = glGetUniformLocation(m_ProgramID, ParameterName.c_str());
+    GLint UniformLocation = glGetUniformLocation(m_ProgramID, ParameterName);
     if (UniformLocation == -1)
     {
         std::cerr << "Shader::SetVec3Parameter() Error: Can't find parameter with given name: " << ParameterName << std::endl;
@@ -123,9 +174,9 @@ void Shader::SetVec4Parameter(const std::string& ParameterName, const glm::vec4
     glUniform4fv(UniformLocation, 1, glm::value_ptr(Value));
 }
 
-void Shader::SetMat4Parameter(const std::string& ParameterName, const glm::mat4& value) const
+void Shader::SetMat4Parameter(const char* ParameterName, const glm::mat4& value) const
 {
-    GLint UniformLocation = glGetUniformLocation(m_ProgramID, ParameterName.c_str());
+    GLint UniformLocation = glGetUniformLocation(m_ProgramID, ParameterName);
     if (UniformLocation == -1)
     {
         std::cerr << "Shader::SetMat4Parameter() Error: Can't find parameter with given name: " << ParameterName << std::endl;
@@ -134,9 +185,9 @@ void Shader::SetMat4Parameter(const std::string& ParameterName, const glm::mat4&
     glUniformMatrix4fv(UniformLocation, 1, false, glm::value_ptr ( value ));
 }
 
-void Shader::SetMat3Parameter(const std::string& ParameterName, const glm::mat3& value) const
+void Shader::SetMat3Parameter(const char* ParameterName, const glm::mat3& value) const
 {
-    GLint UniformLocation = glGetUniformLocation(m_ProgramID,ParameterName.c_str());
+    GLint UniformLocation = glGetUniformLocation(m_ProgramID,ParameterName);
     if (UniformLocation == -1)
     {
         std::cerr << "Shader::SetMat3Parameter() Error: Can't find parameter with given name: " << ParameterName << std::endl;
@@ -46,14 +46,15 @@ public:
 	 *
 	 * @return The name of the shader.
 	 */
-	std::string GetShaderName() const;
+	const std::string& GetShaderName() const;
 
 	/**
-	 * @brief Binds the material properties to the shader program.
+	 * @brief Assigns a uniform block of the shader program to a binding point. Blocks the program doesn't use are skipped.
 	 *
-	 * @param mat The material properties to bind.
+	 * @param BlockName The name of the uniform block.
+	 * @param Binding The uniform buffer binding point.
 	 */
-	void BindMaterial(const Material& mat) const;
+	void SetUniformBlockBinding(const std::string& BlockName, GLuint Binding) const;
 
 	/**
 	 * @brief Sets a boolean parameter in the shader program.
@@ -61,7 +62,7 @@ public:
 	 * @param ParameterName The name of the boolean parameter.
 	 * @param Value The value to set.
 	 */
-	void SetBoolParameter(const std::string& ParameterName, bool Value) const;
+	void SetBoolParameter(const char* ParameterName, bool Value) const;
 
 	/**
 	 * @brief Sets an integer parameter in the shader program.
@@ -69,7 +70,7 @@ public:
 	 * @param ParameterName The name of the integer parameter.
 	 * @param Value The value to set.
 	 */
-	void SetIntParameter(const std::string& ParameterName, int Value) const;
+	void SetIntParameter(const char* ParameterName, int Value) const;
 
 	/**
 	 * @brief Sets a floating-point parameter in the shader program.
@@ -77,7 +78,7 @@ public:
 	 * @param ParameterName The name of the floating-point parameter.
 	 * @param Value The value to set.
 	 */
-	void SetFloatParameter(const std::string& ParameterName, float Value) const;
+	void SetFloatParameter(const char* ParameterName, float Value) const;
 
 	/**
 	 * @brief Sets a 3D vector parameter in the shader program.
@@ -85,7 +86,7 @@ public:
 	 * @param ParameterName The name of the vector parameter.
 	 * @param Value The value to set.
 	 */
-	void SetVec3Parameter(const std::string& ParameterName, const glm::vec3& Value) const;
+	void SetVec3Parameter(const char* ParameterName, const glm::vec3& Value) const;
 
 	/**
 	 * @brief Sets a 4D vector parameter in the shader program.
@@ -93,7 +94,7 @@ public:
 	 * @param ParameterName The name of the vector parameter.
 	 * @param Value The value to set.
 	 */
-	void SetVec4Parameter(const std::string& ParameterName, const glm::vec4& Value) const;
+	void SetVec4Parameter(const char* ParameterName, const glm::vec4& Value) const;
 
 	/**
 	 * @brief Sets a 4x4 matrix parameter in the shader program.
@@ -101,15 +102,32 @@ public:
 	 * @param ParameterName The name of the matrix parameter.
 	 * @param Value The value to set.
 	 */
-	void SetMat4Parameter(const std::string& ParameterName, const glm::mat4& Value) const;
+	void SetMat4Parameter(const char* ParameterName, const glm::mat4& Value) const;
 
 	/**
 	 * @brief Sets a 3x3 matrix parameter in the shader program.
 	 *
 	 */
-	void SetMat3Parameter(const std::string& ParameterName, const glm::mat3& Value) const;
+	void SetMat3Parameter(const char* ParameterName, const glm::mat3& Value) const;
 	
 private:
+	/**
+	 * @brief Reads the whole shader source file.
+	 *
+	 * @param Path The path to the shader file.
+	 * @param Source The read source.
+	 * @return True if the file was read, false otherwise.
+	 */
+	static bool ReadSourceFile(const std::string& Path, std::string& Source);
+
+	/**
+	 * @brief Compiles and links the shader program from source.
+	 *
+	 * @param Retrievable Flag requesting the driver to keep the program binary for the shader cache.
+	 * @return The linked program, 0 on failure.
+	 */
+	static GLuint CompileProgram(const std::string& VSPath, const std::string& VSSource, const std::string& FSPath, const std::string& FSSource, bool Retrievable);
+
 	std::string m_ShaderName; 
 	GLuint m_ProgramID; 
 	bool m_IsLoaded = false;
@@ -0,0 +1,151 @@
+#include "ShaderCache.h"
+#include <vector>
+#include <cstdio>
+#include <cstring>
+#ifdef _WIN32
+#include <direct.h>
+#else
+#include <sys/stat.h>
+#endif
+
+int ShaderCache::s_Hits = 0;
+int ShaderCache::s_Compiled = 0;
+double ShaderCache::s_HitTimeMs = 0.0;
+double ShaderCache::s_CompileTimeMs = 0.0;
+
+namespace
+{
+	void HashBytes(uint64_t& Hash, const char* Data, size_t Size)
+	{
+		for (size_t i = 0; i < Size; i++)
+		{
+			Hash ^= (unsigned char)Data[i];
+			Hash *= 1099511628211ull;
+		}
+	}
+
+	void HashString(uint64_t& Hash, const char* String)
+	{
+		if (String)
+			HashBytes(Hash, String, std::strlen(String));
+		HashBytes(Hash, "", 1); // separator, so moving text between strings changes the key
+	}
+}
+
+bool ShaderCache::GetIsSupported()
+{
+	GLint Formats = 0;
+	glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &Formats);
+	while (glGetError() != GL_NO_ERROR); // the query is invalid on drivers without program binaries
+	return Formats > 0;
+}
+
+uint64_t ShaderCache::ComputeKey(const std::string& VSSource, const std::string& FSSource)
+{
+	uint64_t Hash = 14695981039346656037ull;
+	HashString(Hash, VSSource.c_str());
+	HashString(Hash, FSSource.c_str());
+	HashString(Hash, reinterpret_cast<const char*>(glGetString(GL_VENDOR)));
+	HashString(Hash, reinterpret_cast<const char*>(glGetString(GL_RENDERER)));
+	HashString(Hash, reinterpret_cast<const char*>(glGetString(GL_VERSION)));
+	return Hash;
+}
+
+GLuint ShaderCache::LoadProgram(uint64_t Key)
+{
+	const std::string Filename = GetEntryFilename(Key);
+	std::ifstream f(Filename, std::ios::binary);
+	if (!f)
+		return 0;
+
+	EntryHeader Header = {};
+	std::vector<char> Binary;
+	if (f.read(reinterpret_cast<char*>(&Header), sizeof(Header)) && Header.Magic == SHADER_CACHE_MAGIC)
+	{
+		Binary.resize(Header.Length);
+		f.read(Binary.data(), Binary.size());
+	}
+	if (!f || Binary.empty())
+	{
+		std::cerr << "ShaderCache::LoadProgram() => Invalid cache entry: " << Filename << std::endl;
+		f.close();
+		std::remove(Filename.c_str());
+		return 0;
+	}
+
+	GLuint ProgramID = glCreateProgram();
+	glProgramBinary(ProgramID, Header.Format, Binary.data(), (GLsizei)Binary.size());
+	GLint LinkStatus = GL_FALSE;
+	glGetProgramiv(ProgramID, GL_LINK_STATUS, &LinkStatus);
+	if (LinkStatus != GL_TRUE)
+	{
+		std::cerr << "ShaderCache::LoadProgram() => Cached binary rejected by the driver, recompiling: " << Filename << std::endl;
+		glDeleteProgram(ProgramID);
+		while (glGetError() != GL_NO_ERROR);
+		f.close();
+		std::remove(Filename.c_str());
+		return 0;
+	}
+	return ProgramID;
+}
+
+bool ShaderCache::StoreProgram(uint64_t Key, GLuint ProgramID)
+{
+	GLint Length = 0;
+	glGetProgramiv(ProgramID, GL_PROGRAM_BINARY_LENGTH, &Length);
+	if (Length <= 0)
+		return false;
+
+	std::vector<char> Binary(Length);
+	GLenum Format = 0;
+	glGetProgramBinary(ProgramID, Length, nullptr, &Format, Binary.data());
+	if (glGetError() != GL_NO_ERROR)
+	{
+		std::cerr << "ShaderCache::StoreProgram() => Can't get program binary" << std::endl;
+		return false;
+	}
+
+#ifdef _WIN32
+	_mkdir(SHADER_CACHE_DIRECTORY);
+#else
+	mkdir(SHADER_CACHE_DIRECTORY, 0755);
+#endif
+	const std::string Filename = GetEntryFilename(Key);
+	std::ofstream f(Filename, std::ios::binary);
+	EntryHeader Header = { SHADER_CACHE_MAGIC, Format, (uint32_t)Length };
+	f.write(reinterpret_cast<const char*>(&Header), sizeof(Header));
+	f.write(Binary.data(), Binary.size());
+	if (!f)
+	{
+		std::cerr << "ShaderCache::StoreProgram() => Can't write cache entry: " << Filename << std::endl;
+		return false;
+	}
+	return true;
+}
+
+void ShaderCache::AddLoadTime(bool CacheHit, double Milliseconds)
+{
+	if (CacheHit)
+	{
+		s_Hits++;
+		s_HitTimeMs += Milliseconds;
+	}
+	else
+	{
+		s_Compiled++;
+		s_CompileTimeMs += Milliseconds;
+	}
+}
+
+void ShaderCache::PrintStats()
+{
+	std::cout << "Shader programs: " << s_Hits << " loaded from cache in " << s_HitTimeMs << " ms, "
+		<< s_Compiled << " compiled in " << s_CompileTimeMs << " ms" << std::endl;
+}
+
+std::string ShaderCache::GetEntryFilename(uint64_t Key)
+{
+	char Name[17];
+	std::snprintf(Name, sizeof(Name), "%016llx", (unsigned long long)Key);
+	return std::string(SHADER_CACHE_DIRECTORY) + Name + SHADER_CACHE_EXTENSION;
+}
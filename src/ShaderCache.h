@@ -0,0 +1,86 @@
+#pragma once
+#include "pgr.h"
+#include <string>
+#include <cstdint>
+#include <iostream>
+#include <fstream>
+
+#define SHADER_CACHE_DIRECTORY "shader_cache/"
+#define SHADER_CACHE_EXTENSION ".bin"
+#define SHADER_CACHE_MAGIC 0x48435357u // "WSCH" in little endian
+
+/**
+ * @brief On-disk cache of linked program binaries (glGetProgramBinary / glProgramBinary).
+ *
+ * Entries are keyed by a hash of the shader sources and the GL vendor, renderer and version strings,
+ * so a driver update or an edited shader results in a new entry. A binary rejected by the driver is deleted
+ * and the caller compiles the program from source.
+ */
+class ShaderCache
+{
+public:
+	/**
+	 * @brief Checks if the driver supports program binaries. Requires a current GL context.
+	 */
+	static bool GetIsSupported();
+
+	/**
+	 * @brief Computes the cache key of a program.
+	 *
+	 * @param VSSource The source of the vertex shader.
+	 * @param FSSource The source of the fragment shader.
+	 * @return The 64 bit FNV-1a hash of the sources and the driver strings.
+	 */
+	static uint64_t ComputeKey(const std::string& VSSource, const std::string& FSSource);
+
+	/**
+	 * @brief Creates a program from a cached binary.
+	 *
+	 * @param Key The cache key of the program.
+	 * @return The linked program, 0 if there is no entry or the driver rejected it.
+	 */
+	static GLuint LoadProgram(uint64_t Key);
+
+	/**
+	 * @brief Stores the binary of a linked program.
+	 *
+	 * @param Key The cache key of the program.
+	 * @param ProgramID The linked program.
+	 * @return True if the binary was written, false otherwise.
+	 */
+	static bool StoreProgram(uint64_t Key, GLuint ProgramID);
+
+	/**
+	 * @brief Adds a program load to the statistics.
+	 *
+	 * @param CacheHit True if the program was loaded from the cache, false if it was compiled.
+	 * @param Milliseconds Time of the load.
+	 */
+	static void AddLoadTime(bool CacheHit, double Milliseconds);
+
+	/**
+	 * @brief Prints the number of cache hits and compiled programs with their total times.
+	 */
+	static void PrintStats();
+
+private:
+	/**
+	 * @brief Header of a cache entry, followed by the program binary.
+	 */
+	struct EntryHeader
+	{
+		uint32_t Magic;
+		uint32_t Format;
+		uint32_t Length;
+	};
+
+	/**
+	 * @brief Returns the file name of a cache entry.
+	 */
+	static std::string GetEntryFilename(uint64_t Key);
+
+	static int s_Hits; /**< Number of programs loaded from the cache. */
+	static int s_Compiled; /**< Number of programs compiled from source. */
+	static double s_HitTimeMs; /**< Total time of the cache hits. */
+	static double s_CompileTimeMs; /**< Total time of the compiled programs. */
+};
@@ -0,0 +1,56 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+
+/**
+ * @brief Fixed size lock-free queue with one producer and one consumer thread.
+ *
+ * The producer only writes the tail and the consumer only writes the head, each publishes its index with release
+ * and reads the other with acquire, so no locks or compare-and-swap loops are needed. The capacity must be a power of two.
+ */
+template<typename T, size_t Capacity>
+class SpscRing
+{
+	static_assert(Capacity > 0 && (Capacity & (Capacity - 1)) == 0, "SpscRing capacity must be a power of two");
+
+public:
+	/**
+	 * @brief Appends an element, called only by the producer.
+	 *
+	 * @return True if the element was queued, false if the ring is full.
+	 */
+	bool Push(const T& Element)
+	{
+		const size_t Tail = m_Tail.load(std::memory_order_relaxed);
+		if (Tail - m_Head.load(std::memory_order_acquire) == Capacity)
+			return false;
+		m_Elements[Tail & (Capacity - 1)] = Element;
+		m_Tail.store(Tail + 1, std::memory_order_release);
+		return true;
+	}
+
+	/**
+	 * @brief Removes the oldest element, called only by the consumer.
+	 *
+	 * @return True if an element was removed, false if the ring is empty.
+	 */
+	bool Pop(T& Element)
+	{
+		const size_t Head = m_Head.load(std::memory_order_relaxed);
+		if (Head == m_Tail.load(std::memory_order_acquire))
+			return false;
+		Element = m_Elements[Head & (Capacity - 1)];
+		m_Head.store(Head + 1, std::memory_order_release);
+		return true;
+	}
+
+	/**
+	 * @brief Returns the number of queued elements, exact only on the producer or consumer thread.
+	 */
+	size_t size() const { return m_Tail.load(std::memory_order_acquire) - m_Head.load(std::memory_order_acquire); }
+
+private:
+	T m_Elements[Capacity];
+	alignas(64) std::atomic<size_t> m_Head{ 0 }; /**< Index of the next element to pop, written by the consumer. */
+	alignas(64) std::atomic<size_t> m_Tail{ 0 }; /**< Index of the next element to push, written by the producer. */
+};
@@ -0,0 +1,138 @@
+#include "StreamBuffer.h"
+#include "MeshGeometry.h"
+#include "GLStateCache.h"
+#include <chrono>
+
+bool StreamBuffer::Init(GLsizeiptr FrameSize)
+{
+	m_FrameSize = FrameSize;
+	glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &m_UniformAlignment);
+	const GLsizeiptr Size = FrameSize * STREAM_BUFFER_FRAMES;
+
+	glGenBuffers(1, &m_Buffer);
+	GLStateCache::BindBuffer(GL_COPY_WRITE_BUFFER, m_Buffer);
+	m_IsPersistent = GetIsBufferStorageSupported();
+	if (m_IsPersistent)
+	{
+		const GLbitfield Flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+		glBufferStorage(GL_COPY_WRITE_BUFFER, Size, nullptr, Flags);
+		m_Mapped = static_cast<char*>(glMapBufferRange(GL_COPY_WRITE_BUFFER, 0, Size, Flags));
+		if (!m_Mapped)
+		{
+			std::cerr << "StreamBuffer::Init() => Can't map buffer persistently, staging writes instead" << std::endl;
+			GLStateCache::DeleteBuffers(1, &m_Buffer);
+			glGenBuffers(1, &m_Buffer);
+			GLStateCache::BindBuffer(GL_COPY_WRITE_BUFFER, m_Buffer);
+			m_IsPersistent = false;
+		}
+	}
+	if (!m_IsPersistent)
+	{
+		glBufferData(GL_COPY_WRITE_BUFFER, Size, nullptr, GL_STREAM_DRAW);
+		m_Staging.resize(FrameSize);
+	}
+	CHECK_GL_ERROR();
+	std::cout << "StreamBuffer::Init() => " << STREAM_BUFFER_FRAMES << " x " << FrameSize / 1024 << " KB, "
+		<< (m_IsPersistent ? "persistent mapping" : "staged writes") << std::endl;
+	return m_Buffer != 0;
+}
+
+void StreamBuffer::BeginFrame()
+{
+	GLsync& Fence = m_Fences[m_Frame];
+	if (Fence)
+	{
+		GLenum Result = glClientWaitSync(Fence, 0, 0);
+		if (Result == GL_TIMEOUT_EXPIRED)
+		{
+			// the CPU caught up with the GPU, wait for the region to be released
+			auto WaitStart = std::chrono::steady_clock::now();
+			do
+			{
+				Result = glClientWaitSync(Fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000);
+			} while (Result == GL_TIMEOUT_EXPIRED);
+			std::chrono::duration<double, std::milli> WaitTime = std::chrono::steady_clock::now() - WaitStart;
+			m_StallCount++;
+			m_StallTimeMs += WaitTime.count();
+			MeshGeometry::CountBufferStall(WaitTime.count());
+		}
+		if (Result == GL_WAIT_FAILED)
+			std::cerr << "StreamBuffer::BeginFrame() => Waiting for the frame fence failed" << std::endl;
+		glDeleteSync(Fence);
+		Fence = nullptr;
+	}
+	m_Head = 0;
+	m_Flushed = 0;
+}
+
+void StreamBuffer::EndFrame()
+{
+	Flush();
+	m_Fences[m_Frame] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+	m_Frame = (m_Frame + 1) % STREAM_BUFFER_FRAMES;
+}
+
+StreamAllocation StreamBuffer::Allocate(GLsizeiptr Size, GLsizeiptr Alignment)
+{
+	StreamAllocation Allocation;
+	const GLsizeiptr Start = (m_Head + Alignment - 1) / Alignment * Alignment;
+	if (Start + Size > m_FrameSize)
+	{
+		if (!m_OverflowReported)
+			std::cerr << "StreamBuffer::Allocate() => Frame region of " << m_FrameSize << " bytes is full" << std::endl;
+		m_OverflowReported = true;
+		return Allocation;
+	}
+	m_Head = Start + Size;
+	Allocation.Offset = m_FrameSize * m_Frame + Start;
+	Allocation.Size = Size;
+	Allocation.Data = m_IsPersistent ? m_Mapped + Allocation.Offset : m_Staging.data() + Start;
+	return Allocation;
+}
+
+void StreamBuffer::BindUniformBlock(GLuint Binding, const StreamAllocation& Allocation)
+{
+	if (!Allocation.Data)
+		return;
+	Flush();
+	GLStateCache::BindUniformBufferRange(Binding, m_Buffer, Allocation.Offset, Allocation.Size);
+}
+
+void StreamBuffer::Flush()
+{
+	if (m_IsPersistent || m_Flushed == m_Head)
+		return;
+
+	// the fence guarantees the GPU no longer reads the region, so the map does not need to synchronize
+	const GLsizeiptr Size = m_Head - m_Flushed;
+	GLStateCache::BindBuffer(GL_COPY_WRITE_BUFFER, m_Buffer);
+	void* Target = glMapBufferRange(GL_COPY_WRITE_BUFFER, m_FrameSize * m_Frame + m_Flushed, Size,
+		GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT | GL_MAP_UNSYNCHRONIZED_BIT);
+	if (Target)
+	{
+		std::memcpy(Target, m_Staging.data() + m_Flushed, Size);
+		glUnmapBuffer(GL_COPY_WRITE_BUFFER);
+	}
+	else
+		std::cerr << "StreamBuffer::Flush() => Can't map buffer range" << std::endl;
+	m_Flushed = m_Head;
+}
+
+bool StreamBuffer::GetIsBufferStorageSupported()
+{
+	GLint Major = 0, Minor = 0;
+	glGetIntegerv(GL_MAJOR_VERSION, &Major);
+	glGetIntegerv(GL_MINOR_VERSION, &Minor);
+	if (Major > 4 || (Major == 4 && Minor >= 4))
+		return true;
+
+	GLint Extensions = 0;
+	glGetIntegerv(GL_NUM_EXTENSIONS, &Extensions);
+	for (GLint i = 0; i < Extensions; i++)
+	{
+		const char* Name = reinterpret_cast<const char*>(glGetStringi(GL_EXTENSIONS, i));
+		if (Name && std::strcmp(Name, "GL_ARB_buffer_storage") == 0)
+			return true;
+	}
+	return false;
+}
@@ -0,0 +1,126 @@
+#pragma once
+#include "pgr.h"
+#include <vector>
+#include <cstring>
+#include <iostream>
+
+#define STREAM_BUFFER_FRAMES 3 // frames the CPU may run ahead of the GPU
+#define STREAM_BUFFER_FRAME_SIZE (8 << 20) // bytes of per-frame data, allocations beyond it fail
+
+/**
+ * @brief Range of the stream buffer written by the CPU during the current frame.
+ */
+struct StreamAllocation
+{
+	void* Data = nullptr; /**< Write pointer, nullptr if the allocation failed. */
+	GLintptr Offset = 0; /**< Offset of the range in the GL buffer. */
+	GLsizeiptr Size = 0; /**< Size of the range in bytes. */
+};
+
+/**
+ * @brief Ring buffer for per-frame and per-object data written linearly by the CPU.
+ *
+ * The buffer is split into STREAM_BUFFER_FRAMES regions, one per frame in flight. The region of a frame is
+ * fenced when the frame ends and waited for before it is reused, so writes never synchronize in the driver.
+ * With glBufferStorage the whole buffer is mapped once with GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT and
+ * allocations are written in place. Without it allocations are staged and copied to the buffer with an
+ * unsynchronized glMapBufferRange on Flush.
+ */
+class StreamBuffer
+{
+public:
+	StreamBuffer() = default;
+	StreamBuffer(const StreamBuffer&) = delete;
+	StreamBuffer& operator=(const StreamBuffer&) = delete;
+
+	/**
+	 * @brief Creates and maps the buffer.
+	 *
+	 * @param FrameSize Size of the region of one frame in bytes.
+	 * @return True if the buffer was created, false otherwise.
+	 */
+	bool Init(GLsizeiptr FrameSize);
+
+	/**
+	 * @brief Waits until the GPU is done with the region of the frame and starts writing into it.
+	 */
+	void BeginFrame();
+
+	/**
+	 * @brief Flushes the writes of the frame and fences its region.
+	 */
+	void EndFrame();
+
+	/**
+	 * @brief Allocates a range of the current frame.
+	 *
+	 * @param Size Size of the range in bytes.
+	 * @param Alignment Alignment of the range offset.
+	 * @return The allocated range, with a null write pointer if the frame region is full.
+	 */
+	StreamAllocation Allocate(GLsizeiptr Size, GLsizeiptr Alignment = 16);
+
+	/**
+	 * @brief Allocates a uniform block and copies a value into it.
+	 */
+	template<typename T>
+	StreamAllocation WriteUniformBlock(const T& Value)
+	{
+		StreamAllocation Allocation = Allocate(sizeof(T), m_UniformAlignment);
+		if (Allocation.Data)
+			std::memcpy(Allocation.Data, &Value, sizeof(T));
+		return Allocation;
+	}
+
+	/**
+	 * @brief Binds an allocation to a uniform block binding point.
+	 */
+	void BindUniformBlock(GLuint Binding, const StreamAllocation& Allocation);
+
+	/**
+	 * @brief Makes the writes since the last flush visible to the GPU. Called before draws reading the buffer.
+	 */
+	void Flush();
+
+	/**
+	 * @brief Returns the GL buffer.
+	 */
+	GLuint GetBuffer() const { return m_Buffer; }
+
+	/**
+	 * @brief Checks if the buffer is persistently mapped.
+	 */
+	bool GetIsPersistent() const { return m_IsPersistent; }
+
+	/**
+	 * @brief Returns the number of frames the CPU had to wait for the GPU.
+	 */
+	size_t GetStallCount() const { return m_StallCount; }
+
+	/**
+	 * @brief Returns the time the CPU waited for the GPU in milliseconds.
+	 */
+	double GetStallTime() const { return m_StallTimeMs; }
+
+private:
+	/**
+	 * @brief Checks if the driver exposes glBufferStorage.
+	 */
+	static bool GetIsBufferStorageSupported();
+
+	GLuint m_Buffer = 0; /**< The GL buffer. */
+	GLsizeiptr m_FrameSize = 0; /**< Size of the region of one frame. */
+	GLint m_UniformAlignment = 256; /**< GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT. */
+	bool m_IsPersistent = false; /**< The buffer is mapped persistently, otherwise writes are staged. */
+	char* m_Mapped = nullptr; /**< Persistent mapping of the whole buffer. */
+	std::vector<char> m_Staging; /**< Staged writes of the current frame without persistent mapping. */
+
+	GLsync m_Fences[STREAM_BUFFER_FRAMES] = {}; /**< Fence of the last use of every region. */
+	int m_Frame = 0; /**< Region of the current frame. */
+	GLsizeiptr m_Head = 0; /**< Next free byte of the current region. */
+	GLsizeiptr m_Flushed = 0; /**< Bytes of the current region already copied to the buffer. */
+
+	size_t m_StallCount = 0; /**< Frames the CPU waited for the GPU. */
+	double m_StallTimeMs = 0.0; /**< Total time of the waits. */
+	bool m_OverflowReported = false; /**< A full region was already reported. */
+};
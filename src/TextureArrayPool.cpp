@@ -0,0 +1,244 @@
+#include "TextureArrayPool.h"
+#include "GLStateCache.h"
+#include <algorithm>
+
+std::vector<TextureArrayPool::Page> TextureArrayPool::s_Pages = {};
+std::map<std::string, TextureArrayLayer> TextureArrayPool::s_Layers = {};
+
+namespace
+{
+	GLenum GetInternalFormat(int Components)
+	{
+		switch (Components)
+		{
+		case 1: return GL_R8;
+		case 2: return GL_RG8;
+		case 3:
+		case 4: return GL_RGBA8;
+		default: return GL_NONE;
+		}
+	}
+
+	GLenum GetPixelFormat(int Components)
+	{
+		switch (Components)
+		{
+		case 1: return GL_RED;
+		case 2: return GL_RG;
+		case 3: return GL_RGB;
+		default: return GL_RGBA;
+		}
+	}
+
+	size_t GetPixelBytes(GLenum InternalFormat)
+	{
+		return InternalFormat == GL_R8 ? 1 : InternalFormat == GL_RG8 ? 2 : 4;
+	}
+
+	const char* GetFormatName(GLenum InternalFormat)
+	{
+		return InternalFormat == GL_R8 ? "R8" : InternalFormat == GL_RG8 ? "RG8" : "RGBA8";
+	}
+}
+
+TextureArrayLayer TextureArrayPool::Acquire(const std::string& Path, const TextureImage& Image)
+{
+	auto Packed = s_Layers.find(Path);
+	if (Packed != s_Layers.end())
+	{
+		s_Pages[FindPage(Packed->second.Texture)].References[Packed->second.Layer]++;
+		return Packed->second;
+	}
+
+	const GLenum InternalFormat = GetInternalFormat(Image.Components);
+	if (InternalFormat == GL_NONE || Image.Width <= 0 || Image.Height <= 0)
+	{
+		std::cerr << "TextureArrayPool::Acquire() => Unsupported image: " << Path << std::endl;
+		return TextureArrayLayer();
+	}
+
+	// first free layer of a page with the same size and format
+	int PageIndex = -1;
+	int LayerIndex = -1;
+	for (int i = 0; i < (int)s_Pages.size() && LayerIndex < 0; i++)
+	{
+		const Page& page = s_Pages[i];
+		if (!page.Texture || page.Width != Image.Width || page.Height != Image.Height || page.InternalFormat != InternalFormat)
+			continue;
+		auto Free = std::find(page.References.begin(), page.References.end(), 0);
+		if (Free != page.References.end())
+		{
+			PageIndex = i;
+			LayerIndex = (int)(Free - page.References.begin());
+		}
+	}
+	if (LayerIndex < 0)
+	{
+		PageIndex = CreatePage(Image.Width, Image.Height, InternalFormat);
+		if (PageIndex < 0)
+			return TextureArrayLayer();
+		LayerIndex = 0;
+	}
+
+	Page& page = s_Pages[PageIndex];
+	GLStateCache::BindTexture(0, GL_TEXTURE_2D_ARRAY, page.Texture);
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+	glTexSubImage3D(GL_TEXTURE_2D_ARRAY, 0, 0, 0, LayerIndex, Image.Width, Image.Height, 1,
+		GetPixelFormat(Image.Components), GL_UNSIGNED_BYTE, Image.Data);
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+	CHECK_GL_ERROR();
+	page.Paths[LayerIndex] = Path;
+	page.References[LayerIndex] = 1;
+	page.IsMipmapDirty = true;
+
+	TextureArrayLayer Layer;
+	Layer.Texture = page.Texture;
+	Layer.Layer = LayerIndex;
+	s_Layers[Path] = Layer;
+	return Layer;
+}
+
+void TextureArrayPool::Release(const TextureArrayLayer& Layer)
+{
+	const int PageIndex = FindPage(Layer.Texture);
+	if (PageIndex < 0 || Layer.Layer < 0)
+		return;
+	Page& page = s_Pages[PageIndex];
+	if (--page.References[Layer.Layer] > 0)
+		return;
+	s_Layers.erase(page.Paths[Layer.Layer]);
+	page.Paths[Layer.Layer].clear();
+	if (std::count(page.References.begin(), page.References.end(), 0) == (int)page.References.size())
+	{
+		GLStateCache::DeleteTextures(1, &page.Texture);
+		page = Page();
+	}
+}
+
+void TextureArrayPool::UpdateMipmaps()
+{
+	for (Page& page : s_Pages)
+	{
+		if (!page.Texture || !page.IsMipmapDirty)
+			continue;
+		GLStateCache::BindTexture(0, GL_TEXTURE_2D_ARRAY, page.Texture);
+		glGenerateMipmap(GL_TEXTURE_2D_ARRAY);
+		page.IsMipmapDirty = false;
+	}
+	CHECK_GL_ERROR();
+}
+
+size_t TextureArrayPool::GetLayerBytes(const TextureArrayLayer& Layer)
+{
+	const int PageIndex = FindPage(Layer.Texture);
+	return PageIndex < 0 ? 0 : GetLayerBytes(s_Pages[PageIndex]);
+}
+
+size_t TextureArrayPool::GetAllocatedBytes()
+{
+	size_t Bytes = 0;
+	for (const Page& page : s_Pages)
+		Bytes += GetLayerBytes(page) * page.References.size();
+	return Bytes;
+}
+
+size_t TextureArrayPool::GetWastedBytes()
+{
+	size_t Bytes = 0;
+	for (const Page& page : s_Pages)
+		Bytes += GetLayerBytes(page) * std::count(page.References.begin(), page.References.end(), 0);
+	return Bytes;
+}
+
+void TextureArrayPool::PrintReport()
+{
+	const double MB = 1.0 / (1 << 20);
+	int Pages = 0;
+	size_t Layers = 0;
+	std::cout << "TextureArrayPool::PrintReport() =>" << std::endl;
+	for (const Page& page : s_Pages)
+	{
+		if (!page.Texture)
+			continue;
+		const size_t Used = page.References.size() - std::count(page.References.begin(), page.References.end(), 0);
+		std::cout << "  " << page.Width << "x" << page.Height << " " << GetFormatName(page.InternalFormat) << ": "
+			<< Used << "/" << page.References.size() << " layers, " << GetLayerBytes(page) * page.References.size() * MB
+			<< " MB, wasted " << GetLayerBytes(page) * (page.References.size() - Used) * MB << " MB" << std::endl;
+		for (size_t Layer = 0; Layer < page.Paths.size(); Layer++)
+		{
+			if (page.References[Layer] > 0)
+				std::cout << "    " << page.Paths[Layer] << ": " << GetLayerBytes(page) * MB << " MB, " << page.References[Layer] << " references" << std::endl;
+		}
+		Pages++;
+		Layers += Used;
+	}
+	const size_t Allocated = GetAllocatedBytes();
+	const size_t Wasted = GetWastedBytes();
+	std::cout << "  " << Layers << " textures in " << Pages << " pages, " << Allocated * MB << " MB allocated, "
+		<< Wasted * MB << " MB wasted (" << (Allocated ? 100.0 * Wasted / Allocated : 0.0) << "%)" << std::endl;
+}
+
+size_t TextureArrayPool::GetLayerBytes(const Page& page)
+{
+	// base level plus a third for the mip chain
+	return (size_t)page.Width * page.Height * GetPixelBytes(page.InternalFormat) * 4 / 3;
+}
+
+int TextureArrayPool::CreatePage(GLsizei Width, GLsizei Height, GLenum InternalFormat)
+{
+	Page page;
+	page.Width = Width;
+	page.Height = Height;
+	page.InternalFormat = InternalFormat;
+
+	// every further page of a size doubles the layers, so few pages hold many textures without wasting much
+	int Layers = TEXTURE_ARRAY_MIN_LAYERS / 2;
+	for (const Page& Other : s_Pages)
+	{
+		if (Other.Texture && Other.Width == Width && Other.Height == Height && Other.InternalFormat == InternalFormat)
+			Layers = std::max(Layers, (int)Other.References.size());
+	}
+	GLint MaxLayers = TEXTURE_ARRAY_MAX_LAYERS;
+	glGetIntegerv(GL_MAX_ARRAY_TEXTURE_LAYERS, &MaxLayers);
+	const int ByteLimit = (int)std::max<size_t>(1, TEXTURE_ARRAY_MAX_PAGE_BYTES / GetLayerBytes(page));
+	Layers = std::min({ Layers * 2, TEXTURE_ARRAY_MAX_LAYERS, (int)MaxLayers, ByteLimit });
+	page.Paths.resize(Layers);
+	page.References.resize(Layers, 0);
+
+	glGenTextures(1, &page.Texture);
+	GLStateCache::BindTexture(0, GL_TEXTURE_2D_ARRAY, page.Texture);
+	glTexImage3D(GL_TEXTURE_2D_ARRAY, 0, InternalFormat, Width, Height, Layers, 0, GL_RED, GL_UNSIGNED_BYTE, nullptr);
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_REPEAT);
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_REPEAT);
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+	CHECK_GL_ERROR();
+	if (!page.Texture)
+	{
+		std::cerr << "TextureArrayPool::CreatePage() => Can't create " << Width << "x" << Height << " texture array" << std::endl;
+		return -1;
+	}
+
+	for (int i = 0; i < (int)s_Pages.size(); i++)
+	{
+		if (!s_Pages[i].Texture)
+		{
+			s_Pages[i] = page;
+			return i;
+		}
+	}
+	s_Pages.push_back(page);
+	return (int)s_Pages.size() - 1;
+}
+
+int TextureArrayPool::FindPage(GLuint Texture)
+{
+	if (!Texture)
+		return -1;
+	for (int i = 0; i < (int)s_Pages.size(); i++)
+	{
+		if (s_Pages[i].Texture == Texture)
+			return i;
+	}
+	return -1;
+}
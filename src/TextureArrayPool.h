@@ -0,0 +1,103 @@
+#pragma once
+#include "pgr.h"
+#include "FunctionLibrary.h"
+#include <string>
+#include <vector>
+#include <map>
+#include <iostream>
+
+#define TEXTURE_ARRAY_MIN_LAYERS 2 // layers of the first page of a size and format
+#define TEXTURE_ARRAY_MAX_LAYERS 32 // further pages of a size and format double their layers up to this
+#define TEXTURE_ARRAY_MAX_PAGE_BYTES (256 << 20) // large textures get pages with fewer layers
+
+/**
+ * @brief Layer of a pooled texture array.
+ */
+struct TextureArrayLayer
+{
+	GLuint Texture = 0; /**< The GL_TEXTURE_2D_ARRAY, 0 if the layer is not valid. */
+	int Layer = -1; /**< Index of the layer in the array. */
+};
+
+/**
+ * @brief Packs the material textures into GL_TEXTURE_2D_ARRAY pages shared by all meshes.
+ *
+ * Textures with the same size and format class (R8, RG8 or RGBA8, RGB images are stored as RGBA8) go into the same
+ * pages, so draws of different meshes sample from the same array with a per-draw layer index and don't rebind
+ * textures. Textures are deduplicated by path and reference counted, a page is deleted when its last layer is released.
+ */
+class TextureArrayPool
+{
+public:
+	/**
+	 * @brief Packs a decoded image into a free layer, or references the layer of an already packed path.
+	 *
+	 * @param Path The path identifying the texture.
+	 * @param Image The decoded image.
+	 * @return The layer holding the texture, invalid if the image can't be packed.
+	 */
+	static TextureArrayLayer Acquire(const std::string& Path, const TextureImage& Image);
+
+	/**
+	 * @brief Releases a reference to a layer. The layer is reused once all its references are released.
+	 */
+	static void Release(const TextureArrayLayer& Layer);
+
+	/**
+	 * @brief Regenerates the mip chains of the pages which got new layers. Called after a batch of Acquire calls.
+	 */
+	static void UpdateMipmaps();
+
+	/**
+	 * @brief Returns the GPU memory of a layer in bytes, including its mip chain.
+	 */
+	static size_t GetLayerBytes(const TextureArrayLayer& Layer);
+
+	/**
+	 * @brief Returns the GPU memory of all pages in bytes.
+	 */
+	static size_t GetAllocatedBytes();
+
+	/**
+	 * @brief Returns the GPU memory of the unused layers of all pages in bytes.
+	 */
+	static size_t GetWastedBytes();
+
+	/**
+	 * @brief Prints the pages with their textures, used layers and wasted space. The decoded images are freed once packed,
+	 * so textures hold no system memory.
+	 */
+	static void PrintReport();
+
+private:
+	struct Page
+	{
+		GLuint Texture = 0;
+		GLsizei Width = 0;
+		GLsizei Height = 0;
+		GLenum InternalFormat = GL_RGBA8;
+		std::vector<std::string> Paths; /**< Path of every layer, empty if the layer is free. */
+		std::vector<int> References; /**< References of every layer. */
+		bool IsMipmapDirty = false; /**< Layers were written since the mip chain was generated. */
+	};
+
+	/**
+	 * @brief Returns the memory of one layer of a page, including its mip chain.
+	 */
+	static size_t GetLayerBytes(const Page& page);
+
+	/**
+	 * @brief Creates a page for a size and format.
+	 *
+	 * @return The index of the page, -1 if it can't be created.
+	 */
+	static int CreatePage(GLsizei Width, GLsizei Height, GLenum InternalFormat);
+
+	/**
+	 * @brief Returns the page of an array texture, -1 if none.
+	 */
+	static int FindPage(GLuint Texture);
+
+	static std::vector<Page> s_Pages; /**< All pages, deleted pages have no texture. */
+	static std::map<std::string, TextureArrayLayer> s_Layers; /**< Packed textures by path. */
+};
@@ -0,0 +1,255 @@
+#include "Timeline.h"
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+	float ApplyEasing(Easing Ease, float t)
+	{
+		switch (Ease)
+		{
+		case Easing::EaseIn: return t * t;
+		case Easing::EaseOut: return t * (2.f - t);
+		case Easing::EaseInOut: return t * t * (3.f - 2.f * t);
+		case Easing::Step: return t >= 1.f ? 1.f : 0.f;
+		default: return t;
+		}
+	}
+}
+
+TrackHandle Timeline::AddLocation(EntityHandle Entity, const glm::vec3& From, const glm::vec3& To, const TrackTiming& Timing)
+{
+	const TrackHandle Track = AllocateSlot(TrackType::Location, m_Locations.Times.size());
+	m_Locations.Add(Timing, Track.Index, Entity, From, To);
+	return Track;
+}
+
+TrackHandle Timeline::AddRotation(EntityHandle Entity, const glm::quat& From, const glm::quat& To, const TrackTiming& Timing)
+{
+	const TrackHandle Track = AllocateSlot(TrackType::Rotation, m_Rotations.Times.size());
+	m_Rotations.Add(Timing, Track.Index, Entity, From, To);
+	return Track;
+}
+
+TrackHandle Timeline::AddFloat(float* Target, float From, float To, const TrackTiming& Timing)
+{
+	const TrackHandle Track = AllocateSlot(TrackType::Float, m_Floats.Times.size());
+	m_Floats.Add(Timing, Track.Index, Target, From, To);
+	return Track;
+}
+
+TrackHandle Timeline::AddSpriteFrame(int* Target, int FirstFrame, int FrameCount, const TrackTiming& Timing)
+{
+	const TrackHandle Track = AllocateSlot(TrackType::SpriteFrame, m_SpriteFrames.Times.size());
+	m_SpriteFrames.Add(Timing, Track.Index, Target, FirstFrame, std::max(FrameCount, 1));
+	return Track;
+}
+
+void Timeline::Stop(TrackHandle Track)
+{
+	if (!GetIsPlaying(Track))
+		return;
+	const TrackSlot& Slot = m_Slots[Track.Index];
+	switch (Slot.Type)
+	{
+	case TrackType::Location: RemoveTrack(m_Locations, Slot.Dense); break;
+	case TrackType::Rotation: RemoveTrack(m_Rotations, Slot.Dense); break;
+	case TrackType::Float: RemoveTrack(m_Floats, Slot.Dense); break;
+	default: RemoveTrack(m_SpriteFrames, Slot.Dense); break;
+	}
+}
+
+bool Timeline::GetIsPlaying(TrackHandle Track) const
+{
+	return Track.Index < m_Slots.size() && m_Slots[Track.Index].IsUsed && m_Slots[Track.Index].Generation == Track.Generation;
+}
+
+void Timeline::Update(float dt)
+{
+	EntityStore& Entities = EntityStore::Get();
+
+	AdvanceTimes(m_Locations.Times, dt);
+	for (size_t i = 0; i < m_Locations.Times.size(); i++)
+	{
+		TransformComponent* Transform = Entities.GetTransform(m_Locations.Targets[i]);
+		if (!Transform)
+			m_Finished.push_back((uint32_t)i); // the entity was destroyed, the track ends with it
+		else if (m_Alphas[i] >= 0.f)
+			Transform->Local.Location = glm::mix(m_Locations.From[i], m_Locations.To[i], m_Alphas[i]);
+	}
+	std::sort(m_Finished.begin(), m_Finished.end());
+	m_Finished.erase(std::unique(m_Finished.begin(), m_Finished.end()), m_Finished.end());
+	RemoveFinished(m_Locations);
+
+	AdvanceTimes(m_Rotations.Times, dt);
+	for (size_t i = 0; i < m_Rotations.Times.size(); i++)
+	{
+		TransformComponent* Transform = Entities.GetTransform(m_Rotations.Targets[i]);
+		if (!Transform)
+			m_Finished.push_back((uint32_t)i);
+		else if (m_Alphas[i] >= 0.f)
+			Transform->Local.Rotation = glm::slerp(m_Rotations.From[i], m_Rotations.To[i], m_Alphas[i]);
+	}
+	std::sort(m_Finished.begin(), m_Finished.end());
+	m_Finished.erase(std::unique(m_Finished.begin(), m_Finished.end()), m_Finished.end());
+	RemoveFinished(m_Rotations);
+
+	AdvanceTimes(m_Floats.Times, dt);
+	for (size_t i = 0; i < m_Floats.Times.size(); i++)
+	{
+		if (m_Alphas[i] >= 0.f)
+			*m_Floats.Targets[i] = m_Floats.From[i] + (m_Floats.To[i] - m_Floats.From[i]) * m_Alphas[i];
+	}
+	RemoveFinished(m_Floats);
+
+	AdvanceTimes(m_SpriteFrames.Times, dt);
+	for (size_t i = 0; i < m_SpriteFrames.Times.size(); i++)
+	{
+		if (m_Alphas[i] >= 0.f)
+			*m_SpriteFrames.Targets[i] = m_SpriteFrames.From[i] + std::min((int)(m_Alphas[i] * m_SpriteFrames.To[i]), m_SpriteFrames.To[i] - 1);
+	}
+	RemoveFinished(m_SpriteFrames);
+}
+
+void Timeline::Clear()
+{
+	m_Locations = TrackPool<glm::vec3, EntityHandle>();
+	m_Rotations = TrackPool<glm::quat, EntityHandle>();
+	m_Floats = TrackPool<float, float*>();
+	m_SpriteFrames = TrackPool<int, int*>();
+	// the generations are kept, so handles of the cleared tracks stay invalid
+	m_FreeSlots.clear();
+	for (uint32_t Slot = 0; Slot < (uint32_t)m_Slots.size(); Slot++)
+	{
+		if (m_Slots[Slot].IsUsed)
+			m_Slots[Slot].Generation++;
+		m_Slots[Slot].IsUsed = false;
+		m_FreeSlots.push_back(Slot);
+	}
+}
+
+size_t Timeline::GetMemoryUsage() const
+{
+	return m_Locations.GetMemoryUsage() + m_Rotations.GetMemoryUsage() + m_Floats.GetMemoryUsage() + m_SpriteFrames.GetMemoryUsage()
+		+ m_Slots.capacity() * sizeof(TrackSlot) + m_FreeSlots.capacity() * sizeof(uint32_t);
+}
+
+void Timeline::TrackTimes::Add(const TrackTiming& Timing, uint32_t Slot)
+{
+	Elapsed.push_back(0.f);
+	Delay.push_back(std::max(Timing.Delay, 0.f));
+	// a zero duration jumps to the end value on the first update
+	InvDuration.push_back(Timing.Duration > 0.f ? 1.f / Timing.Duration : 1e30f);
+	Ease.push_back(Timing.Ease);
+	Loop.push_back(Timing.Loop);
+	Slots.push_back(Slot);
+}
+
+void Timeline::TrackTimes::Remove(size_t Dense)
+{
+	Elapsed[Dense] = Elapsed.back();
+	Delay[Dense] = Delay.back();
+	InvDuration[Dense] = InvDuration.back();
+	Ease[Dense] = Ease.back();
+	Loop[Dense] = Loop.back();
+	Slots[Dense] = Slots.back();
+	Elapsed.pop_back();
+	Delay.pop_back();
+	InvDuration.pop_back();
+	Ease.pop_back();
+	Loop.pop_back();
+	Slots.pop_back();
+}
+
+size_t Timeline::TrackTimes::GetMemoryUsage() const
+{
+	return (Elapsed.capacity() + Delay.capacity() + InvDuration.capacity()) * sizeof(float) + Ease.capacity() * sizeof(Easing)
+		+ Loop.capacity() * sizeof(TrackLoop) + Slots.capacity() * sizeof(uint32_t);
+}
+
+TrackHandle Timeline::AllocateSlot(TrackType Type, size_t Dense)
+{
+	TrackHandle Track;
+	if (!m_FreeSlots.empty())
+	{
+		Track.Index = m_FreeSlots.back();
+		m_FreeSlots.pop_back();
+	}
+	else
+	{
+		Track.Index = (uint32_t)m_Slots.size();
+		m_Slots.emplace_back();
+	}
+	TrackSlot& Slot = m_Slots[Track.Index];
+	Slot.Type = Type;
+	Slot.Dense = (uint32_t)Dense;
+	Slot.IsUsed = true;
+	Track.Generation = Slot.Generation;
+	return Track;
+}
+
+void Timeline::AdvanceTimes(TrackTimes& Times, float dt)
+{
+	const size_t Count = Times.size();
+	m_Alphas.resize(Count);
+	m_Finished.clear();
+	for (size_t i = 0; i < Count; i++)
+	{
+		Times.Elapsed[i] += dt;
+		float t = (Times.Elapsed[i] - Times.Delay[i]) * Times.InvDuration[i];
+		if (t < 0.f)
+		{
+			m_Alphas[i] = -1.f;
+			continue;
+		}
+		switch (Times.Loop[i])
+		{
+		case TrackLoop::Once:
+			if (t >= 1.f)
+			{
+				t = 1.f;
+				m_Finished.push_back((uint32_t)i);
+			}
+			break;
+		case TrackLoop::Loop:
+			if (t >= 1.f)
+			{
+				// the elapsed time is wrapped, so it does not lose precision over a long session
+				t -= std::floor(t);
+				Times.Elapsed[i] = Times.Delay[i] + t / Times.InvDuration[i];
+			}
+			break;
+		default:
+			if (t >= 2.f)
+			{
+				t -= 2.f * std::floor(t * 0.5f);
+				Times.Elapsed[i] = Times.Delay[i] + t / Times.InvDuration[i];
+			}
+			if (t > 1.f)
+				t = 2.f - t;
+			break;
+		}
+		m_Alphas[i] = ApplyEasing(Times.Ease[i], t);
+	}
+}
+
+template<typename TPool>
+void Timeline::RemoveFinished(TPool& Pool)
+{
+	for (size_t i = m_Finished.size(); i-- > 0; )
+		RemoveTrack(Pool, m_Finished[i]);
+	m_Finished.clear();
+}
+
+template<typename TPool>
+void Timeline::RemoveTrack(TPool& Pool, size_t Dense)
+{
+	TrackSlot& Slot = m_Slots[Pool.Times.Slots[Dense]];
+	Slot.IsUsed = false;
+	Slot.Generation++;
+	m_FreeSlots.push_back(Pool.Times.Slots[Dense]);
+	Pool.Remove(Dense);
+	// the last track of the pool moved into the hole
+	if (Dense < Pool.Times.size())
+		m_Slots[Pool.Times.Slots[Dense]].Dense = (uint32_t)Dense;
+}
@@ -0,0 +1,215 @@
+#pragma once
+#include "pgr.h"
+#include "EntityStore.h"
+#include <vector>
+#include <cstdint>
+
+/**
+ * @brief Curve mapping the linear progress of a track to the interpolation factor.
+ */
+enum class Easing : uint8_t
+{
+	Linear,
+	EaseIn, /**< Quadratic, starts slow. */
+	EaseOut, /**< Quadratic, ends slow. */
+	EaseInOut, /**< Smoothstep, starts and ends slow. */
+	Step /**< Holds the start value until the end. */
+};
+
+/**
+ * @brief What a track does after reaching its end.
+ */
+enum class TrackLoop : uint8_t
+{
+	Once, /**< Writes the end value and is removed. */
+	Loop, /**< Starts again from the start value. */
+	PingPong /**< Plays backwards to the start value, then forwards again. */
+};
+
+/**
+ * @brief Timing of a track.
+ */
+struct TrackTiming
+{
+	float Delay = 0.f; /**< Time before the track starts in seconds, it writes nothing until then. */
+	float Duration = 1.f; /**< Length of one play in seconds. */
+	Easing Ease = Easing::Linear;
+	TrackLoop Loop = TrackLoop::Once;
+};
+
+/**
+ * @brief Generational handle of a track. A handle of a finished or stopped track stays invalid even when its slot is reused.
+ */
+struct TrackHandle
+{
+	uint32_t Index = UINT32_MAX; /**< Slot of the track. */
+	uint32_t Generation = 0; /**< Generation of the slot the handle was created in. */
+};
+
+/**
+ * @brief Tracks animating entity transforms and plain values, evaluated in one batched pass per tick.
+ *
+ * Every track type has its own pool of structure of arrays: the timing pass runs over the packed times of a pool and
+ * computes the eased factors of all its tracks, then a second pass writes the interpolated values to the targets.
+ * Removing a track moves the last track of its pool into the hole, so both passes always run over contiguous memory.
+ * Location and rotation tracks write the local transform of an entity and end with it. Float and sprite frame tracks
+ * write through a pointer, which must stay valid while the track plays.
+ */
+class Timeline
+{
+public:
+	/**
+	 * @brief Adds a track moving the local location of an entity.
+	 */
+	TrackHandle AddLocation(EntityHandle Entity, const glm::vec3& From, const glm::vec3& To, const TrackTiming& Timing);
+
+	/**
+	 * @brief Adds a track rotating the local rotation of an entity along the shortest arc.
+	 */
+	TrackHandle AddRotation(EntityHandle Entity, const glm::quat& From, const glm::quat& To, const TrackTiming& Timing);
+
+	/**
+	 * @brief Adds a track interpolating a float.
+	 */
+	TrackHandle AddFloat(float* Target, float From, float To, const TrackTiming& Timing);
+
+	/**
+	 * @brief Adds a track stepping a sprite frame index through FrameCount frames starting at FirstFrame.
+	 */
+	TrackHandle AddSpriteFrame(int* Target, int FirstFrame, int FrameCount, const TrackTiming& Timing);
+
+	/**
+	 * @brief Removes a track, leaving its target at the current value.
+	 */
+	void Stop(TrackHandle Track);
+
+	/**
+	 * @brief Checks if a track is still playing.
+	 */
+	bool GetIsPlaying(TrackHandle Track) const;
+
+	/**
+	 * @brief Advances all tracks, writes their values and removes the finished ones.
+	 *
+	 * @param dt The time step in seconds.
+	 */
+	void Update(float dt);
+
+	/**
+	 * @brief Removes all tracks.
+	 */
+	void Clear();
+
+	/**
+	 * @brief Returns the number of playing tracks.
+	 */
+	size_t GetTrackCount() const { return m_Slots.size() - m_FreeSlots.size(); }
+
+	/**
+	 * @brief Returns the memory of the track pools in bytes.
+	 */
+	size_t GetMemoryUsage() const;
+
+private:
+	enum class TrackType : uint8_t
+	{
+		Location,
+		Rotation,
+		Float,
+		SpriteFrame
+	};
+
+	/**
+	 * @brief Timing of the tracks of one pool, one element per track in every array.
+	 */
+	struct TrackTimes
+	{
+		std::vector<float> Elapsed; /**< Time since the track was added, wrapped for looping tracks. */
+		std::vector<float> Delay;
+		std::vector<float> InvDuration;
+		std::vector<Easing> Ease;
+		std::vector<TrackLoop> Loop;
+		std::vector<uint32_t> Slots; /**< Slot of every track, updated when a track moves. */
+
+		void Add(const TrackTiming& Timing, uint32_t Slot);
+		void Remove(size_t Dense);
+		size_t size() const { return Elapsed.size(); }
+		size_t GetMemoryUsage() const;
+	};
+
+	/**
+	 * @brief Tracks of one type with their targets and end values.
+	 */
+	template<typename TValue, typename TTarget>
+	struct TrackPool
+	{
+		TrackTimes Times;
+		std::vector<TTarget> Targets;
+		std::vector<TValue> From;
+		std::vector<TValue> To;
+
+		void Add(const TrackTiming& Timing, uint32_t Slot, TTarget Target, const TValue& FromValue, const TValue& ToValue)
+		{
+			Times.Add(Timing, Slot);
+			Targets.push_back(Target);
+			From.push_back(FromValue);
+			To.push_back(ToValue);
+		}
+
+		void Remove(size_t Dense)
+		{
+			Times.Remove(Dense);
+			Targets[Dense] = Targets.back();
+			From[Dense] = From.back();
+			To[Dense] = To.back();
+			Targets.pop_back();
+			From.pop_back();
+			To.pop_back();
+		}
+
+		size_t GetMemoryUsage() const
+		{
+			return Times.GetMemoryUsage() + Targets.capacity() * sizeof(TTarget) + (From.capacity() + To.capacity()) * sizeof(TValue);
+		}
+	};
+
+	struct TrackSlot
+	{
+		uint32_t Generation = 0;
+		TrackType Type = TrackType::Float;
+		uint32_t Dense = 0; /**< Index of the track in the pool of its type. */
+		bool IsUsed = false;
+	};
+
+	/**
+	 * @brief Reserves a slot for a new track of a pool.
+	 */
+	TrackHandle AllocateSlot(TrackType Type, size_t Dense);
+
+	/**
+	 * @brief Advances the times of a pool and computes the eased factors into m_Alphas.
+	 * A track before its delay gets a negative factor, a finished track is listed in m_Finished.
+	 */
+	void AdvanceTimes(TrackTimes& Times, float dt);
+
+	/**
+	 * @brief Removes the tracks listed in m_Finished from a pool, from the last one so the listed indices stay valid.
+	 */
+	template<typename TPool>
+	void RemoveFinished(TPool& Pool);
+
+	/**
+	 * @brief Removes a track from its pool and frees its slot.
+	 */
+	template<typename TPool>
+	void RemoveTrack(TPool& Pool, size_t Dense);
+
+	TrackPool<glm::vec3, EntityHandle> m_Locations;
+	TrackPool<glm::quat, EntityHandle> m_Rotations;
+	TrackPool<float, float*> m_Floats;
+	TrackPool<int, int*> m_SpriteFrames; /**< From is the first frame, To the frame count. */
+	std::vector<TrackSlot> m_Slots; /**< Slots of the track handles. */
+	std::vector<uint32_t> m_FreeSlots; /**< Slots of finished and stopped tracks. */
+	std::vector<float> m_Alphas; /**< Eased factors of the pool being updated. */
+	std::vector<uint32_t> m_Finished; /**< Ascending indices of the finished tracks of the pool being updated. */
+};
@@ -0,0 +1,24 @@
+#version 330 core
+
+
+layout (location = 0) in vec3 aPos;
+
+// must match ObjectUniforms in Misc.h
+layout (std140) uniform ObjectData
+{
+	mat4 PVMMatrix; 
+	mat4 MMatrix; 
+	mat4 NormalMatrix; 
+	mat4 WaterTransform; 
+	bool IsWater; 
+	float AnimationAlpha; 
+	int MaterialId; // index into MaterialData
+};
+
+// the lit pass tests against this depth with GL_EQUAL, both passes must compute the same position
+invariant gl_Position;
+
+void main()
+{
+    gl_Position = PVMMatrix * vec4 ( aPos, 1 );
+}
@@ -5,12 +5,20 @@ out vec4 fragColor;
 in vec2 texCoords; 
 in vec3 fragPosition;
 
-uniform sampler2D texture_diffuse1;
+uniform sampler2DArray texture_diffuse1;
+uniform int textureLayer; // layer of the texture in the array
 
 
-uniform float fogMaxDistance = 20; 
-uniform float fogMinDistance = 0.1;
-uniform vec4 fogColor = vec4 ( 0.5, 0.5, 0.5, 1); 
+// must match FrameUniforms in Misc.h
+layout (std140) uniform FrameData
+{
+	mat4 VMatrix; 
+	vec4 fogColor; 
+	vec4 directionalLightDirection; // camera space
+	float fogMinDistance; 
+	float fogMaxDistance; 
+	bool isSpotlightActive; 
+};
 
 
 void main()
@@ -22,7 +30,7 @@ void main()
 	float distanceToFragment = length ( fragPosition ); // distance to fragment in camera space
 	float fogImpact = ( fogMaxDistance - distanceToFragment ) / ( fogMaxDistance - fogMinDistance ); 
 	fogImpact = clamp ( fogImpact, 0.0, 1.0); 
-	vec4 TextureColor = texture ( texture_diffuse1, texCoords ); 
+	vec4 TextureColor = texture ( texture_diffuse1, vec3 ( texCoords, textureLayer ) ); 
 
 	fragColor = mix( fogColor, TextureColor, fogImpact );
 	// fragColor = vec4 (ResultColor, 1);
@@ -6,12 +6,28 @@ layout (location = 1) in vec3 aNextPos;
 layout (location = 2) in vec2 aTexCoords;
 
 
-uniform mat4 PVMMatrix; 
-uniform mat4 PMatrix; 
-uniform mat4 VMatrix; 
-uniform mat4 MMatrix; 
- 
-uniform float AnimationAlpha; 
+// must match FrameUniforms in Misc.h
+layout (std140) uniform FrameData
+{
+	mat4 VMatrix; 
+	vec4 fogColor; 
+	vec4 directionalLightDirection; // camera space
+	float fogMinDistance; 
+	float fogMaxDistance; 
+	bool isSpotlightActive; 
+};
+
+// must match ObjectUniforms in Misc.h
+layout (std140) uniform ObjectData
+{
+	mat4 PVMMatrix; 
+	mat4 MMatrix; 
+	mat4 NormalMatrix; // model to camera space for normals
+	mat4 WaterTransform; 
+	bool IsWater; 
+	float AnimationAlpha; 
+	int MaterialId; // index into MaterialData
+};
 
 out vec2 texCoords; 
 out vec3 normal; 
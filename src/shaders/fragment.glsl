@@ -5,16 +5,24 @@ out vec4 fragColor;
 in vec2 texCoords; 
 in vec3 fragPosition;
 in vec3 normal; 
+flat in int materialId; 
 
 
 uniform vec3 cameraPosition; 
-uniform mat4 VMatrix; 
+// must match FrameUniforms in Misc.h
+layout (std140) uniform FrameData
+{
+	mat4 VMatrix; 
+	vec4 fogColor; 
+	vec4 directionalLightDirection; // camera space
+	float fogMinDistance; 
+	float fogMaxDistance; 
+	bool isSpotlightActive; 
+};
 
 // Lights 
 struct PointLight
 {
-	vec3 position; 
-
 	vec3 ambientColor; 
 	vec3 diffuseColor; 
 	vec3 specularColor; 
@@ -43,8 +51,6 @@ struct SpotLight
 
 struct DirectionalLight
 {
-	vec3 direction; 
-	
 	vec3 ambientColor; 
 	vec3 diffuseColor; 
 	vec3 specularColor; 
@@ -55,32 +61,45 @@ struct DirectionalLight
 
 struct Material
 {
-	sampler2D texture_diffuse1;
-	sampler2D texture_specular1;
+	sampler2DArray texture_diffuse1; // texture arrays shared by all meshes, see TextureArrayPool
+	sampler2DArray texture_specular1;
+	int diffuseLayer; // layer of the diffuse texture, -1 if the mesh has none
+	int specularLayer;
 	bool hasSpecular;
-	
+};
+uniform Material material; 
+
+// constants of all materials, indexed by the material ID of the object
+#define MATERIAL_MAX_COUNT 256 // must match MaterialLibrary.h
+// must match MaterialUniforms in Misc.h
+struct MaterialConstants
+{
 	vec3 ambientColor;
 	vec3 diffuseColor;
 	vec3 specularColor;
 	float shininess;
 };
-uniform Material material; 
-uniform float fogMaxDistance = 20; 
-uniform float fogMinDistance = 0.1;
-uniform vec4 fogColor = vec4 ( 0.5, 0.5, 0.5, 1); 
+layout (std140) uniform MaterialData
+{
+	MaterialConstants materials[MATERIAL_MAX_COUNT]; 
+};
 
 
 
 
-// Point lights
-#define MAX_POINT_LIGHTS 16
-uniform int nOfPointLights; 
-uniform PointLight pointLights [MAX_POINT_LIGHTS]; 
-uniform bool isPointLightActive[MAX_POINT_LIGHTS]; // TODO: move to light struct
+// Point lights, assigned to view frustum clusters on the CPU
+#define CLUSTER_GRID_X 16 // must match ClusteredLighting.h
+#define CLUSTER_GRID_Y 9
+#define CLUSTER_GRID_Z 24
+uniform PointLight pointLight; // parameters shared by all point lights
+uniform samplerBuffer clusterLightData; // per light: camera space position, radius
+uniform usamplerBuffer clusterGrid; // per cluster: offset into clusterLightIndices, light count
+uniform usamplerBuffer clusterLightIndices; 
+uniform vec3 clusterScale; // tiles per pixel in x and y, depth slices per log(depth) in z
+uniform float clusterSliceBias; 
 
 // Directional lights
 uniform DirectionalLight directionalLight; 
-uniform bool isSpotlightActive; 
 // Spotlights. TODO: make variable number of spot lights
 uniform SpotLight spotLight; 
 
@@ -88,42 +107,40 @@ uniform SpotLight spotLight;
 
 vec3 CalculateDirectionalLightImpact ( DirectionalLight light, vec3 normal, vec3 viewDir, vec3 textureDiffuse, vec3 textureSpecular )
 {
-	vec3 lightDirCameraSpace = normalize((VMatrix * vec4(light.direction, 0)).xyz);
-	vec3 L = normalize(lightDirCameraSpace); // light direction 
+	vec3 L = normalize(directionalLightDirection.xyz); // light direction 
     vec3 R = reflect(-L, normal); // reflected light direction
 	vec3 V = viewDir; // direction to viewer
 
 	float diffuseImpact = max(dot(L, normal), 0.0); 
-	float specularImpact = pow(max(dot(V, R), 0.0), material.shininess);
+	float specularImpact = pow(max(dot(V, R), 0.0), materials[materialId].shininess);
 
-    vec3 ambient  = light.ambientColor * material.ambientColor * textureDiffuse; 
-    vec3 diffuse  = light.diffuseColor  * diffuseImpact * material.diffuseColor * textureDiffuse; 
+    vec3 ambient  = light.ambientColor * materials[materialId].ambientColor * textureDiffuse; 
+    vec3 diffuse  = light.diffuseColor  * diffuseImpact * materials[materialId].diffuseColor * textureDiffuse; 
 	vec3 specular; 
 	if ( material.hasSpecular ) 
 		specular = light.specularColor * specularImpact * textureSpecular;
 	else
-		specular = light.specularColor * specularImpact * material.specularColor;
+		specular = light.specularColor * specularImpact * materials[materialId].specularColor;
     return vec3(ambient + diffuse + specular);
 };
 
 
-vec3 CalculatePointLightImpact ( PointLight light, vec3 normal, vec3 viewDir, vec3 textureDiffuse, vec3 textureSpecular ) 
+vec3 CalculatePointLightImpact ( PointLight light, vec3 lightPositionCameraSpace, vec3 normal, vec3 viewDir, vec3 textureDiffuse, vec3 textureSpecular ) 
 {
-	vec3 lightPositionCameraSpace = (VMatrix * vec4(light.position,1)).xyz;
 	vec3 L = normalize(lightPositionCameraSpace - fragPosition); // light direction 
     vec3 R = reflect(-L, normal); // reflected light direction
 	vec3 V = viewDir; // direction to viewer
 
 	float diffuseImpact = max(dot(L, normal), 0.0); 
-	float specularImpact = pow(max(dot(V, R), 0.0), material.shininess);
+	float specularImpact = pow(max(dot(V, R), 0.0), materials[materialId].shininess);
 
-    vec3 ambient  = light.ambientColor * material.ambientColor * textureDiffuse; 
-    vec3 diffuse  = light.diffuseColor  * diffuseImpact * material.diffuseColor * textureDiffuse; 
+    vec3 ambient  = light.ambientColor * materials[materialId].ambientColor * textureDiffuse; 
+    vec3 diffuse  = light.diffuseColor  * diffuseImpact * materials[materialId].diffuseColor * textureDiffuse; 
     vec3 specular; 
 	if ( material.hasSpecular ) 
 		specular = light.specularColor * specularImpact * textureSpecular;
 	else
-		specular = light.specularColor * specularImpact * material.specularColor;
+		specular = light.specularColor * specularImpact * materials[materialId].specularColor;
 
 	float distanceToLight = distance ( lightPositionCameraSpace, fragPosition );  
     float attenuation = 1.0 / (light.constant + light.linear * distanceToLight + 
@@ -156,16 +173,16 @@ vec3 CalculateSpotlightImpact ( SpotLight light, vec3 normal, vec3 viewDir, vec3
 
 
 	float diffuseImpact = max(dot(L, normal), 0.0); 
-	float specularImpact = pow(max(dot(V, R), 0.0), material.shininess);
+	float specularImpact = pow(max(dot(V, R), 0.0), materials[materialId].shininess);
 
-    vec3 ambient  = light.ambientColor * material.ambientColor * textureDiffuse; 
-    vec3 diffuse  = light.diffuseColor  * diffuseImpact * material.diffuseColor * textureDiffuse; 
+    vec3 ambient  = light.ambientColor * materials[materialId].ambientColor * textureDiffuse; 
+    vec3 diffuse  = light.diffuseColor  * diffuseImpact * materials[materialId].diffuseColor * textureDiffuse; 
 
 	vec3 specular; 
 	if ( material.hasSpecular ) 
 		specular = light.specularColor * specularImpact * textureSpecular;
 	else
-		specular = light.specularColor * specularImpact * material.specularColor;
+		specular = light.specularColor * specularImpact * materials[materialId].specularColor;
 
     float distanceToLight = distance ( vec3(0), fragPosition );  
     float attenuation = 1.0 / (light.constant + light.linear * distanceToLight + light.quadratic * (distanceToLight * distanceToLight)); 
@@ -182,18 +199,24 @@ void main()
 	vec3 nNormal = normalize ( normal ); 
 	vec3 viewDir = normalize ( -fragPosition ); 
 	
-	vec3 textureDiffuse = vec3(texture(material.texture_diffuse1, texCoords)); 
+	vec3 textureDiffuse = vec3 ( 1 );
+	if ( material.diffuseLayer >= 0 ) 
+		textureDiffuse = vec3(texture(material.texture_diffuse1, vec3(texCoords, material.diffuseLayer))); 
 	vec3 textureSpecular = vec3 ( 1 );
 	if ( material.hasSpecular ) 
-		textureSpecular = vec3(texture(material.texture_specular1, texCoords));
+		textureSpecular = vec3(texture(material.texture_specular1, vec3(texCoords, material.specularLayer)));
 
 
 	// Apply lights 
 	ResultColor += CalculateDirectionalLightImpact ( directionalLight, nNormal, viewDir, textureDiffuse, textureSpecular ); 
-	for ( int i = 0; i < nOfPointLights; i ++ ) 
+	ivec3 cluster = ivec3 ( gl_FragCoord.xy * clusterScale.xy, log ( -fragPosition.z ) * clusterScale.z + clusterSliceBias ); 
+	cluster = clamp ( cluster, ivec3 ( 0 ), ivec3 ( CLUSTER_GRID_X - 1, CLUSTER_GRID_Y - 1, CLUSTER_GRID_Z - 1 ) ); 
+	uvec2 clusterLights = texelFetch ( clusterGrid, cluster.x + cluster.y * CLUSTER_GRID_X + cluster.z * CLUSTER_GRID_X * CLUSTER_GRID_Y ).xy; 
+	for ( uint i = 0u; i < clusterLights.y; i ++ ) 
 	{
-		if ( isPointLightActive [ i ] )
-			ResultColor += CalculatePointLightImpact ( pointLights[i], nNormal, viewDir, textureDiffuse, textureSpecular ); 
+		vec4 light = texelFetch ( clusterLightData, int ( texelFetch ( clusterLightIndices, int ( clusterLights.x + i ) ).x ) ); 
+		if ( distance ( light.xyz, fragPosition ) < light.w ) 
+			ResultColor += CalculatePointLightImpact ( pointLight, light.xyz, nNormal, viewDir, textureDiffuse, textureSpecular ); 
 	}
 	if ( isSpotlightActive ) 
 	{
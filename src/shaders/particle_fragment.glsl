@@ -0,0 +1,32 @@
+#version 330 core
+out vec4 fragColor; 
+in vec2 texCoords; 
+in vec4 color; 
+flat in int frame; 
+uniform sampler2D texSampler; 
+
+uniform ivec2 pattern = ivec2 (4,4); 
+
+void main () 
+{
+	if ( frame < 0 ) // soft round sprite
+	{
+		float falloff = 1.0 - clamp ( length ( texCoords - vec2 ( 0.5 ) ) * 2.0, 0.0, 1.0 ); 
+		fragColor = vec4 ( color.rgb, color.a * falloff * falloff ); 
+	}
+	else
+	{
+		float x = frame % pattern.x; 
+		float y = frame / pattern.x; 
+		
+		x += texCoords.x; 
+		y += texCoords.y; 
+
+
+		vec2 coords = vec2( x / pattern.x, y / pattern.y ); 
+
+		fragColor = texture ( texSampler, coords ) * color; 
+	}
+	if ( fragColor.a < 0.01 ) 
+	    discard;
+}
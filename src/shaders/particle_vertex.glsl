@@ -0,0 +1,27 @@
+#version 330 core
+
+layout (location = 0) in vec2 aCorner; 
+layout (location = 1) in vec4 aPositionSize; // world position, sprite size
+layout (location = 2) in vec4 aColor; 
+layout (location = 3) in float aFrame; 
+
+uniform mat4 PVMatrix; 
+uniform vec3 cameraRight; 
+uniform vec3 cameraUp; 
+
+
+
+out vec2 texCoords; 
+out vec4 color; 
+flat out int frame; 
+
+
+void main () 
+{
+	vec3 position = aPositionSize.xyz + ( cameraRight * aCorner.x + cameraUp * aCorner.y ) * aPositionSize.w; // face the camera
+	gl_Position = PVMatrix * vec4 ( position, 1 ); 
+
+	texCoords = aCorner + vec2 ( 0.5 ); 
+	color = aColor; 
+	frame = int ( aFrame ); 
+}
@@ -6,9 +6,16 @@ in vec3 TexCoords;
 uniform samplerCube skyboxTexture; 
 in vec3 fragPosition;
 
-uniform float fogMaxDistance = 20; 
-uniform float fogMinDistance = 0.1;
-uniform vec4 fogColor = vec4 ( 0.5, 0.5, 0.5, 1); 
+// must match FrameUniforms in Misc.h
+layout (std140) uniform FrameData
+{
+	mat4 VMatrix; 
+	vec4 fogColor; 
+	vec4 directionalLightDirection; // camera space
+	float fogMinDistance; 
+	float fogMaxDistance; 
+	bool isSpotlightActive; 
+};
 
 void main() 
 {
@@ -16,6 +16,6 @@ void main()
 {
 	TexCoords = aPos; 
 	fragPosition = (V * M * vec4(aPos,1)).xyz; 
-	gl_Position = PVM * vec4 ( aPos, 1.0); 
+	gl_Position = ( PVM * vec4 ( aPos, 1.0) ).xyww; // at the far plane, drawn last with GL_LEQUAL
 	
 }
\ No newline at end of file
@@ -5,20 +5,41 @@ layout (location = 0) in vec3 aPos;
 layout (location = 1) in vec3 aNormal; 
 layout (location = 2) in vec2 aTexCoords; 
 
-uniform mat4 PVMMatrix; 
-uniform mat4 PMatrix; 
-uniform mat4 VMatrix; 
-uniform mat4 MMatrix; 
-uniform bool IsWater; 
-uniform mat4 WaterTransform; 
+// must match FrameUniforms in Misc.h
+layout (std140) uniform FrameData
+{
+	mat4 VMatrix; 
+	vec4 fogColor; 
+	vec4 directionalLightDirection; // camera space
+	float fogMinDistance; 
+	float fogMaxDistance; 
+	bool isSpotlightActive; 
+};
+
+// must match ObjectUniforms in Misc.h
+layout (std140) uniform ObjectData
+{
+	mat4 PVMMatrix; 
+	mat4 MMatrix; 
+	mat4 NormalMatrix; // model to camera space for normals
+	mat4 WaterTransform; 
+	bool IsWater; 
+	float AnimationAlpha; 
+	int MaterialId; // index into MaterialData
+};
 
 out vec2 texCoords; 
 out vec3 normal; 
 out vec3 fragPosition; 
+flat out int materialId; 
+
+// must match the depth pre-pass, the lit pass tests its depth with GL_EQUAL
+invariant gl_Position;
 
 void main()
 {
-    normal = mat3(VMatrix) * mat3(transpose(inverse(MMatrix))) * aNormal; 
+    normal = mat3(NormalMatrix) * aNormal; 
+    materialId = MaterialId; 
     if ( !IsWater )
     {
         texCoords = aTexCoords;